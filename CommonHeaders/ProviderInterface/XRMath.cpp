@@ -7,6 +7,17 @@
 #include <cassert>
 #include <cmath>
 
+// SIMD paths for the per-frame operations, chosen at compile time. They do
+// the same multiplies and adds in the same order as the scalar code, without
+// fused multiply-adds, so their results are bit-identical to it (0 ULP).
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define XRMATH_SSE2
+#include <emmintrin.h>
+#elif defined( __aarch64__ ) || defined( _M_ARM64 )
+#define XRMATH_NEON
+#include <arm_neon.h>
+#endif
+
 XRVector3 XRVector3::zero( 0.0f, 0.0f, 0.0f );
 XRVector3 XRVector3::one( 1.0f, 1.0f, 1.0f );
 
@@ -47,13 +58,41 @@ XRQuaternion &XRQuaternion::operator*=( const float        aScalar )
 
 XRQuaternion &XRQuaternion::operator*=( const XRQuaternion &rhs )
 {
+#if defined( XRMATH_SSE2 )
+	// Each lane sums the same four products as the scalar code below, in the
+	// same order; subtracting is adding the negated product.
+	const __m128 l = _mm_loadu_ps( &x );
+	const __m128 r = _mm_loadu_ps( &rhs.x );
+	const __m128 negW = _mm_castsi128_ps( _mm_set_epi32( int( 0x80000000 ), 0, 0, 0 ) );
+	const __m128 negAll = _mm_castsi128_ps( _mm_set1_epi32( int( 0x80000000 ) ) );
+	// w * ( rx, ry, rz, rw )
+	__m128 acc = _mm_mul_ps( _mm_shuffle_ps( l, l, _MM_SHUFFLE( 3, 3, 3, 3 ) ), r );
+	// ( x, y, z, -x ) * ( rw, rw, rw, rx )
+	acc = _mm_add_ps( acc, _mm_xor_ps( _mm_mul_ps( _mm_shuffle_ps( l, l, _MM_SHUFFLE( 0, 2, 1, 0 ) ), _mm_shuffle_ps( r, r, _MM_SHUFFLE( 0, 3, 3, 3 ) ) ), negW ) );
+	// ( y, z, x, -y ) * ( rz, rx, ry, ry )
+	acc = _mm_add_ps( acc, _mm_xor_ps( _mm_mul_ps( _mm_shuffle_ps( l, l, _MM_SHUFFLE( 1, 0, 2, 1 ) ), _mm_shuffle_ps( r, r, _MM_SHUFFLE( 1, 1, 0, 2 ) ) ), negW ) );
+	// -( z, x, y, z ) * ( ry, rz, rx, rz )
+	acc = _mm_add_ps( acc, _mm_xor_ps( _mm_mul_ps( _mm_shuffle_ps( l, l, _MM_SHUFFLE( 2, 1, 0, 2 ) ), _mm_shuffle_ps( r, r, _MM_SHUFFLE( 2, 0, 2, 1 ) ) ), negAll ) );
+	_mm_storeu_ps( &x, acc );
+	return *this;
+#elif defined( XRMATH_NEON )
+	const float l2[4] = { x, y, z, -x }, r2[4] = { rhs.w, rhs.w, rhs.w, rhs.x };
+	const float l3[4] = { y, z, x, -y }, r3[4] = { rhs.z, rhs.x, rhs.y, rhs.y };
+	const float l4[4] = { z, x, y, z }, r4[4] = { rhs.y, rhs.z, rhs.x, rhs.z };
+	float32x4_t acc = vmulq_n_f32( vld1q_f32( &rhs.x ), w );
+	acc = vaddq_f32( acc, vmulq_f32( vld1q_f32( l2 ), vld1q_f32( r2 ) ) );
+	acc = vaddq_f32( acc, vmulq_f32( vld1q_f32( l3 ), vld1q_f32( r3 ) ) );
+	acc = vsubq_f32( acc, vmulq_f32( vld1q_f32( l4 ), vld1q_f32( r4 ) ) );
+	vst1q_f32( &x, acc );
+	return *this;
+#else
 	float tempx = w * rhs.x + x * rhs.w + y * rhs.z - z * rhs.y;
 	float tempy = w * rhs.y + y * rhs.w + z * rhs.x - x * rhs.z;
 	float tempz = w * rhs.z + z * rhs.w + x * rhs.y - y * rhs.x;
 	float tempw = w * rhs.w - x * rhs.x - y * rhs.y - z * rhs.z;
 	x = tempx; y = tempy; z = tempz; w = tempw;
 	return *this;
-
+#endif
 }
 
 static XRMatrix3x3 identity( 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f );
@@ -105,7 +144,35 @@ XRMatrix4x4 XRMatrix4x4::identity(
 
 static void MultiplyMatrices4x4( const XRMatrix4x4 &inA, const XRMatrix4x4 &inB, XRMatrix4x4 &out )
 {
-	// TODO: Non-Performant. Look to replace with SIMD?
+#if defined( XRMATH_SSE2 )
+	// Row r of the product is the rows of B weighted by row r of A
+	const __m128 b0 = _mm_loadu_ps( inB.m[0] );
+	const __m128 b1 = _mm_loadu_ps( inB.m[1] );
+	const __m128 b2 = _mm_loadu_ps( inB.m[2] );
+	const __m128 b3 = _mm_loadu_ps( inB.m[3] );
+	for ( int row = 0; row < 4; ++row )
+	{
+		__m128 acc = _mm_mul_ps( _mm_set1_ps( inA.m[row][0] ), b0 );
+		acc = _mm_add_ps( acc, _mm_mul_ps( _mm_set1_ps( inA.m[row][1] ), b1 ) );
+		acc = _mm_add_ps( acc, _mm_mul_ps( _mm_set1_ps( inA.m[row][2] ), b2 ) );
+		acc = _mm_add_ps( acc, _mm_mul_ps( _mm_set1_ps( inA.m[row][3] ), b3 ) );
+		_mm_storeu_ps( out.m[row], acc );
+	}
+#elif defined( XRMATH_NEON )
+	const float32x4_t b0 = vld1q_f32( inB.m[0] );
+	const float32x4_t b1 = vld1q_f32( inB.m[1] );
+	const float32x4_t b2 = vld1q_f32( inB.m[2] );
+	const float32x4_t b3 = vld1q_f32( inB.m[3] );
+	for ( int row = 0; row < 4; ++row )
+	{
+		// vmulq then vaddq rather than vmlaq/vfmaq, which may fuse
+		float32x4_t acc = vmulq_n_f32( b0, inA.m[row][0] );
+		acc = vaddq_f32( acc, vmulq_n_f32( b1, inA.m[row][1] ) );
+		acc = vaddq_f32( acc, vmulq_n_f32( b2, inA.m[row][2] ) );
+		acc = vaddq_f32( acc, vmulq_n_f32( b3, inA.m[row][3] ) );
+		vst1q_f32( out.m[row], acc );
+	}
+#else
 	for ( int col = 0; col < 4; ++col )
 	{
 		for ( int row = 0; row < 4; ++row )
@@ -113,6 +180,7 @@ static void MultiplyMatrices4x4( const XRMatrix4x4 &inA, const XRMatrix4x4 &inB,
 			out.m[row][col] = XRVector4::Dot( inA.GetRow( row ), inB.GetCol( col ) );
 		}
 	}
+#endif
 }
 
 XRMatrix4x4 &XRMatrix4x4::operator*=( const XRMatrix4x4 &inM )
@@ -284,6 +352,24 @@ XRMatrix4x4 XRMatrix4x4::FastOrthonormalInverse( const XRMatrix4x4 &m )
 	return res;
 }
 
+float Determinant( const XRMatrix4x4 &m )
+{
+	// Laplace expansion along the 2x2 minors of the top and bottom rows
+	const float s0 = m.m[0][0] * m.m[1][1] - m.m[0][1] * m.m[1][0];
+	const float s1 = m.m[0][0] * m.m[1][2] - m.m[0][2] * m.m[1][0];
+	const float s2 = m.m[0][0] * m.m[1][3] - m.m[0][3] * m.m[1][0];
+	const float s3 = m.m[0][1] * m.m[1][2] - m.m[0][2] * m.m[1][1];
+	const float s4 = m.m[0][1] * m.m[1][3] - m.m[0][3] * m.m[1][1];
+	const float s5 = m.m[0][2] * m.m[1][3] - m.m[0][3] * m.m[1][2];
+	const float c0 = m.m[2][0] * m.m[3][1] - m.m[2][1] * m.m[3][0];
+	const float c1 = m.m[2][0] * m.m[3][2] - m.m[2][2] * m.m[3][0];
+	const float c2 = m.m[2][0] * m.m[3][3] - m.m[2][3] * m.m[3][0];
+	const float c3 = m.m[2][1] * m.m[3][2] - m.m[2][2] * m.m[3][1];
+	const float c4 = m.m[2][1] * m.m[3][3] - m.m[2][3] * m.m[3][1];
+	const float c5 = m.m[2][2] * m.m[3][3] - m.m[2][3] * m.m[3][2];
+	return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+}
+
 void MatrixToTranslationRotation( const XRMatrix4x4 &matrix, XRVector3 &unityTranslation, XRQuaternion &unityRotation )
 {
 	unityTranslation.x = matrix.Get( 3, 0 );
@@ -292,3 +378,27 @@ void MatrixToTranslationRotation( const XRMatrix4x4 &matrix, XRVector3 &unityTra
 
 	MatrixToQuaternion( matrix, unityRotation );
 }
+
+// The inverse of MatrixToQuaternion: m[0][1] - m[1][0] is 4wz, and so on.
+// q must be normalized.
+void QuaternionToMatrix( const XRQuaternion &q, XRMatrix3x3 &m )
+{
+	const float x2 = q.x * q.x, y2 = q.y * q.y, z2 = q.z * q.z;
+	const float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+	const float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+	m = XRMatrix3x3(
+		1.0f - 2.0f * y2 - 2.0f * z2, 2.0f * xy + 2.0f * wz, 2.0f * xz - 2.0f * wy,
+		2.0f * xy - 2.0f * wz, 1.0f - 2.0f * x2 - 2.0f * z2, 2.0f * yz + 2.0f * wx,
+		2.0f * xz + 2.0f * wy, 2.0f * yz - 2.0f * wx, 1.0f - 2.0f * x2 - 2.0f * y2 );
+}
+
+void QuaternionToMatrix( const XRQuaternion &q, XRMatrix4x4 &m )
+{
+	XRMatrix3x3 rot;
+	QuaternionToMatrix( q, rot );
+	m = XRMatrix4x4(
+		rot.m[0][0], rot.m[0][1], rot.m[0][2], 0.0f,
+		rot.m[1][0], rot.m[1][1], rot.m[1][2], 0.0f,
+		rot.m[2][0], rot.m[2][1], rot.m[2][2], 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f );
+}
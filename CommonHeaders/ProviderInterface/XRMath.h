@@ -217,6 +217,8 @@ void MatrixToQuaternion( const XRMatrix4x4 &m, XRQuaternion &q );
 void MatrixToQuaternion( const XRMatrix3x3 &kRot, XRQuaternion &q );
 void MatrixToTranslationRotation( const XRMatrix4x4 &windowsMatrix, XRVector3 &unityTranslation, XRQuaternion &unityRotation );
 
+float Determinant( const XRMatrix4x4 &m );
+
 void QuaternionToMatrix( const XRQuaternion &q, XRMatrix3x3 &m );
 void QuaternionToMatrix( const XRQuaternion &q, XRMatrix4x4 &m );
 
@@ -0,0 +1,191 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#include "Blitter.h"
+
+#include <d3dcompiler.h>
+
+#include <stdexcept>
+#include <string>
+
+namespace metaview {
+
+static const char BlitShaderSource[] = R"(
+cbuffer BlitConstants : register(b0) {
+    // Homography from output to source rect coordinates, by rows
+    float4 warpRow0;
+    float4 warpRow1;
+    float4 warpRow2;
+    float4 sourceRect;
+    float arraySlice;
+};
+
+Texture2DArray source : register(t0);
+SamplerState linearSampler : register(s0);
+
+struct VSOut {
+    float4 position : SV_Position;
+    float2 uv : TEXCOORD0;
+};
+
+// Fullscreen triangle, no vertex buffer needed.
+VSOut vsMain(uint id : SV_VertexID) {
+    VSOut ret;
+    float2 uv = float2((id << 1) & 2, id & 2);
+    ret.position = float4(uv * float2(2, -2) + float2(-1, 1), 0, 1);
+    ret.uv = uv;
+    return ret;
+}
+
+float4 psMain(VSOut input) : SV_Target {
+    float3 p = float3(input.uv, 1);
+    float3 s = float3(dot(warpRow0.xyz, p), dot(warpRow1.xyz, p),
+                      dot(warpRow2.xyz, p));
+    float2 warped = s.xy / s.z;
+    if (s.z <= 0 || any(warped < 0) || any(warped > 1)) {
+        return float4(0, 0, 0, 1);
+    }
+    float2 uv = sourceRect.xy + warped * sourceRect.zw;
+    return source.SampleLevel(linearSampler, float3(uv, arraySlice), 0);
+}
+)";
+
+struct BlitConstants {
+    float warp[3][4];
+    float sourceRect[4];
+    float arraySlice;
+    float padding[3];
+};
+
+static winrt::com_ptr<ID3DBlob> compileShader(const char* entryPoint,
+                                              const char* target) {
+    winrt::com_ptr<ID3DBlob> code;
+    winrt::com_ptr<ID3DBlob> errors;
+    HRESULT hr = D3DCompile(BlitShaderSource, sizeof(BlitShaderSource) - 1,
+                            "Blitter", nullptr, nullptr, entryPoint, target,
+                            D3DCOMPILE_OPTIMIZATION_LEVEL3, 0, code.put(),
+                            errors.put());
+    if (FAILED(hr)) {
+        std::string message = "Could not compile blit shader";
+        if (errors) {
+            message += ": ";
+            message += static_cast<const char*>(errors->GetBufferPointer());
+        }
+        throw std::runtime_error(message);
+    }
+    return code;
+}
+
+DXGI_FORMAT getTypedFormat(DXGI_FORMAT format) {
+    switch (format) {
+        case DXGI_FORMAT_R8G8B8A8_TYPELESS:
+            return DXGI_FORMAT_R8G8B8A8_UNORM;
+        case DXGI_FORMAT_B8G8R8A8_TYPELESS:
+            return DXGI_FORMAT_B8G8R8A8_UNORM;
+        case DXGI_FORMAT_R10G10B10A2_TYPELESS:
+            return DXGI_FORMAT_R10G10B10A2_UNORM;
+        case DXGI_FORMAT_R16G16B16A16_TYPELESS:
+            return DXGI_FORMAT_R16G16B16A16_FLOAT;
+        default:
+            return format;
+    }
+}
+
+Blitter::Blitter(ID3D11Device* device) {
+    device_.copy_from(device);
+
+    auto vsCode = compileShader("vsMain", "vs_5_0");
+    winrt::check_hresult(device_->CreateVertexShader(
+        vsCode->GetBufferPointer(), vsCode->GetBufferSize(), nullptr,
+        vertexShader_.put()));
+    auto psCode = compileShader("psMain", "ps_5_0");
+    winrt::check_hresult(device_->CreatePixelShader(
+        psCode->GetBufferPointer(), psCode->GetBufferSize(), nullptr,
+        pixelShader_.put()));
+
+    D3D11_SAMPLER_DESC samplerDesc = {};
+    samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+    samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+    winrt::check_hresult(
+        device_->CreateSamplerState(&samplerDesc, sampler_.put()));
+
+    D3D11_RASTERIZER_DESC rasterizerDesc = {};
+    rasterizerDesc.FillMode = D3D11_FILL_SOLID;
+    rasterizerDesc.CullMode = D3D11_CULL_NONE;
+    rasterizerDesc.DepthClipEnable = TRUE;
+    winrt::check_hresult(
+        device_->CreateRasterizerState(&rasterizerDesc, rasterizer_.put()));
+
+    D3D11_BUFFER_DESC bufferDesc = {};
+    bufferDesc.ByteWidth = sizeof(BlitConstants);
+    bufferDesc.Usage = D3D11_USAGE_DEFAULT;
+    bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    winrt::check_hresult(
+        device_->CreateBuffer(&bufferDesc, nullptr, constants_.put()));
+}
+
+winrt::com_ptr<ID3D11ShaderResourceView> Blitter::createSourceView(
+    ID3D11Texture2D* texture) const {
+    D3D11_TEXTURE2D_DESC texDesc;
+    texture->GetDesc(&texDesc);
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+    viewDesc.Format = getTypedFormat(texDesc.Format);
+    viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+    viewDesc.Texture2DArray.MostDetailedMip = 0;
+    viewDesc.Texture2DArray.MipLevels = 1;
+    viewDesc.Texture2DArray.FirstArraySlice = 0;
+    viewDesc.Texture2DArray.ArraySize = texDesc.ArraySize;
+
+    winrt::com_ptr<ID3D11ShaderResourceView> view;
+    winrt::check_hresult(
+        device_->CreateShaderResourceView(texture, &viewDesc, view.put()));
+    return view;
+}
+
+void Blitter::blit(ID3D11DeviceContext* context,
+                   ID3D11ShaderResourceView* source, uint32_t arraySlice,
+                   ID3D11RenderTargetView* target,
+                   D3D11_VIEWPORT const& targetViewport,
+                   BlitRect const& sourceRect, Mat3f const& warp) {
+    BlitConstants constants = {
+        {},
+        {sourceRect.x, sourceRect.y, sourceRect.width, sourceRect.height},
+        static_cast<float>(arraySlice),
+        {}};
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) {
+            constants.warp[r][c] = warp.m[r][c];
+        }
+    }
+    context->UpdateSubresource(constants_.get(), 0, nullptr, &constants, 0,
+                               0);
+
+    context->IASetInputLayout(nullptr);
+    context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    context->VSSetShader(vertexShader_.get(), nullptr, 0);
+    context->PSSetShader(pixelShader_.get(), nullptr, 0);
+    ID3D11Buffer* buffers[] = {constants_.get()};
+    context->PSSetConstantBuffers(0, 1, buffers);
+    ID3D11SamplerState* samplers[] = {sampler_.get()};
+    context->PSSetSamplers(0, 1, samplers);
+    context->PSSetShaderResources(0, 1, &source);
+    context->RSSetState(rasterizer_.get());
+    context->RSSetViewports(1, &targetViewport);
+    context->OMSetRenderTargets(1, &target, nullptr);
+    context->OMSetBlendState(nullptr, nullptr, 0xffffffff);
+    context->OMSetDepthStencilState(nullptr, 0);
+
+    context->Draw(3, 0);
+
+    // Unbind so the source can be rendered to again.
+    ID3D11ShaderResourceView* nullView = nullptr;
+    context->PSSetShaderResources(0, 1, &nullView);
+}
+
+}  // namespace metaview
@@ -0,0 +1,89 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include "PoseMath.h"
+
+#include <d3d11.h>
+#include <winrt/base.h>
+
+#include <cstdint>
+
+namespace metaview {
+
+/**
+ * @brief Normalized rectangle of a texture: origin and size in [0, 1].
+ */
+struct BlitRect {
+    float x = 0.f;
+    float y = 0.f;
+    float width = 1.f;
+    float height = 1.f;
+};
+
+/**
+ * @brief Get the UNORM (or FLOAT) format to view a typeless format as, or the
+ * format itself if it's typed.
+ */
+DXGI_FORMAT getTypedFormat(DXGI_FORMAT format);
+
+/**
+ * @brief Draws (a region of) a texture into a viewport of a render target,
+ * with bilinear filtering.
+ *
+ * Used where CopySubresourceRegion won't do: when source and destination
+ * differ in size, or the source needs reprojecting on the way. Sources are
+ * viewed as texture arrays, so a single slice of a texture array can be drawn
+ * just like a plain texture.
+ *
+ * Changes pipeline state on the context and does not restore it.
+ */
+class Blitter {
+  public:
+    /**
+     * @brief Construct a new Blitter object, compiling its shaders.
+     *
+     * @param device Device to create resources on.
+     */
+    explicit Blitter(ID3D11Device* device);
+
+    /**
+     * @brief Create a shader resource view suitable for blit() on a texture.
+     *
+     * Typeless formats are viewed as their UNORM equivalent, so the result is
+     * the same as a copy would produce.
+     */
+    winrt::com_ptr<ID3D11ShaderResourceView> createSourceView(
+        ID3D11Texture2D* texture) const;
+
+    /**
+     * @brief Draw a texture into a viewport of a render target.
+     *
+     * @param context Context to record on.
+     * @param source View created by createSourceView()
+     * @param arraySlice Which array slice of the source to draw.
+     * @param target Render target to draw into.
+     * @param targetViewport Region of the target to fill, in pixels.
+     * @param sourceRect Region of the source to draw, normalized.
+     * @param warp Homography from target viewport to source rect coordinates
+     * (both normalized, top left origin), as from computeOrientationWarp().
+     * Parts that map outside the source rect are black.
+     */
+    void blit(ID3D11DeviceContext* context, ID3D11ShaderResourceView* source,
+              uint32_t arraySlice, ID3D11RenderTargetView* target,
+              D3D11_VIEWPORT const& targetViewport,
+              BlitRect const& sourceRect = {}, Mat3f const& warp = {});
+
+  private:
+    winrt::com_ptr<ID3D11Device> device_;
+    winrt::com_ptr<ID3D11VertexShader> vertexShader_;
+    winrt::com_ptr<ID3D11PixelShader> pixelShader_;
+    winrt::com_ptr<ID3D11SamplerState> sampler_;
+    winrt::com_ptr<ID3D11RasterizerState> rasterizer_;
+    winrt::com_ptr<ID3D11Buffer> constants_;
+};
+
+}  // namespace metaview
@@ -0,0 +1,80 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#include "Clock.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+#include <chrono>
+#include <thread>
+
+namespace metaview {
+
+//! How long before the deadline we stop relying on the OS wait and spin.
+static constexpr int64_t SpinThresholdNs = 1'000'000;
+
+#ifdef _WIN32
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+/**
+ * @brief Sleep for a relative duration using a high resolution waitable timer.
+ *
+ * The default Windows timer resolution (~15.6ms) is far too coarse for frame
+ * pacing, so std::this_thread::sleep_for is not usable here.
+ */
+static void coarseSleep(int64_t durationNs) {
+    thread_local HANDLE timer = CreateWaitableTimerExW(
+        nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION,
+        TIMER_ALL_ACCESS);
+    if (timer == nullptr) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(durationNs));
+        return;
+    }
+    LARGE_INTEGER dueTime;
+    // negative means relative, in 100ns units
+    dueTime.QuadPart = -(durationNs / 100);
+    if (SetWaitableTimer(timer, &dueTime, 0, nullptr, nullptr, FALSE)) {
+        WaitForSingleObject(timer, INFINITE);
+    }
+}
+#else
+static void coarseSleep(int64_t durationNs) {
+    std::this_thread::sleep_for(std::chrono::nanoseconds(durationNs));
+}
+#endif
+
+int64_t SteadyClock::now() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void SteadyClock::sleepUntil(int64_t timeNs) {
+    int64_t remaining = timeNs - now();
+    if (remaining > SpinThresholdNs) {
+        coarseSleep(remaining - SpinThresholdNs);
+    }
+    while (now() < timeNs) {
+        std::this_thread::yield();
+    }
+}
+
+void sleepCoarse(int64_t durationNs) {
+    if (durationNs > 0) {
+        coarseSleep(durationNs);
+    }
+}
+
+SteadyClock& SteadyClock::instance() {
+    static SteadyClock clock;
+    return clock;
+}
+
+}  // namespace metaview
@@ -0,0 +1,62 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include <cstdint>
+
+namespace metaview {
+
+/**
+ * @brief Abstract monotonic clock, in nanoseconds.
+ *
+ * Exists so that timing-sensitive logic (frame pacing, etc) can be driven by a
+ * simulated clock rather than the real one.
+ */
+class IClock {
+  public:
+    virtual ~IClock() = default;
+
+    /**
+     * @brief Get the current time in nanoseconds.
+     *
+     * The epoch is unspecified, but is constant for the life of the clock.
+     */
+    virtual int64_t now() const = 0;
+
+    /**
+     * @brief Block the calling thread until at least the given time.
+     *
+     * Returns immediately if that time is already past.
+     *
+     * @param timeNs Absolute time, in the same timebase as now()
+     */
+    virtual void sleepUntil(int64_t timeNs) = 0;
+};
+
+/**
+ * @brief Real clock, based on std::chrono::steady_clock.
+ *
+ * sleepUntil() uses a coarse OS wait followed by a short spin, so the wake-up
+ * is precise enough for running-start style frame pacing.
+ */
+class SteadyClock : public IClock {
+  public:
+    int64_t now() const override;
+    void sleepUntil(int64_t timeNs) override;
+
+    /**
+     * @brief Get a shared instance: the clock has no state, so one is enough.
+     */
+    static SteadyClock& instance();
+};
+
+/**
+ * @brief Sleep for about @p durationNs without spinning, for background
+ * polling where waking a little late does no harm.
+ */
+void sleepCoarse(int64_t durationNs);
+
+}  // namespace metaview
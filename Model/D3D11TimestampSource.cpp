@@ -0,0 +1,67 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#include "D3D11TimestampSource.h"
+
+namespace metaview {
+
+D3D11TimestampSource::D3D11TimestampSource(ID3D11Device* device,
+                                           ID3D11DeviceContext* context,
+                                           size_t numSlots, size_t numPoints)
+    : slots_(numSlots) {
+    context_.copy_from(context);
+    D3D11_QUERY_DESC disjointDesc = {D3D11_QUERY_TIMESTAMP_DISJOINT, 0};
+    D3D11_QUERY_DESC timestampDesc = {D3D11_QUERY_TIMESTAMP, 0};
+    for (auto& slot : slots_) {
+        winrt::check_hresult(
+            device->CreateQuery(&disjointDesc, slot.disjoint.put()));
+        slot.timestamps.resize(numPoints);
+        for (auto& query : slot.timestamps) {
+            winrt::check_hresult(
+                device->CreateQuery(&timestampDesc, query.put()));
+        }
+    }
+}
+
+void D3D11TimestampSource::begin(size_t slot) {
+    context_->Begin(slots_[slot].disjoint.get());
+}
+
+void D3D11TimestampSource::timestamp(size_t slot, size_t point) {
+    context_->End(slots_[slot].timestamps[point].get());
+}
+
+void D3D11TimestampSource::end(size_t slot) {
+    context_->End(slots_[slot].disjoint.get());
+}
+
+bool D3D11TimestampSource::tryRead(size_t slot, uint32_t writtenMask,
+                                   uint64_t* ticks, uint64_t& frequency,
+                                   bool& disjoint) {
+    SlotQueries& queries = slots_[slot];
+    D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjointData;
+    if (context_->GetData(queries.disjoint.get(), &disjointData,
+                          sizeof(disjointData),
+                          D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) {
+        return false;
+    }
+    for (size_t i = 0; i < queries.timestamps.size(); ++i) {
+        if (((writtenMask >> i) & 1u) == 0) {
+            continue;
+        }
+        UINT64 value = 0;
+        if (context_->GetData(queries.timestamps[i].get(), &value,
+                              sizeof(value),
+                              D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) {
+            return false;
+        }
+        ticks[i] = value;
+    }
+    frequency = disjointData.Frequency;
+    disjoint = disjointData.Disjoint != FALSE;
+    return true;
+}
+
+}  // namespace metaview
@@ -0,0 +1,50 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include "TimestampQueryRing.h"
+
+#include <d3d11.h>
+#include <winrt/base.h>
+
+#include <vector>
+
+namespace metaview {
+
+/**
+ * @brief D3D11 timestamp queries: a TIMESTAMP_DISJOINT query and a set of
+ * TIMESTAMP queries per slot, read back with DONOTFLUSH.
+ */
+class D3D11TimestampSource : public ITimestampQuerySource {
+  public:
+    /**
+     * @brief Construct a new D3D11 Timestamp Source object
+     *
+     * @param device Device to create queries on.
+     * @param context Context queries are issued and read on. Must be the one
+     * the measured work is recorded on.
+     * @param numSlots Number of frames of queries.
+     * @param numPoints Timestamps per frame.
+     */
+    D3D11TimestampSource(ID3D11Device* device, ID3D11DeviceContext* context,
+                         size_t numSlots, size_t numPoints);
+
+    void begin(size_t slot) override;
+    void timestamp(size_t slot, size_t point) override;
+    void end(size_t slot) override;
+    bool tryRead(size_t slot, uint32_t writtenMask, uint64_t* ticks,
+                 uint64_t& frequency, bool& disjoint) override;
+
+  private:
+    struct SlotQueries {
+        winrt::com_ptr<ID3D11Query> disjoint;
+        std::vector<winrt::com_ptr<ID3D11Query>> timestamps;
+    };
+    winrt::com_ptr<ID3D11DeviceContext> context_;
+    std::vector<SlotQueries> slots_;
+};
+
+}  // namespace metaview
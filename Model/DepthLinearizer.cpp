@@ -0,0 +1,207 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#include "DepthLinearizer.h"
+
+#include <d3dcompiler.h>
+
+#include <stdexcept>
+#include <string>
+
+namespace metaview {
+
+static const char LinearizeShaderSource[] = R"(
+cbuffer LinearizeConstants : register(b0) {
+    float4 sourceRect;
+    float arraySlice;
+    float zNear;
+    float zFar;
+    float reversedZ;
+};
+
+Texture2DArray<float> source : register(t0);
+SamplerState pointSampler : register(s0);
+
+struct VSOut {
+    float4 position : SV_Position;
+    float2 uv : TEXCOORD0;
+};
+
+// Fullscreen triangle, no vertex buffer needed.
+VSOut vsMain(uint id : SV_VertexID) {
+    VSOut ret;
+    float2 uv = float2((id << 1) & 2, id & 2);
+    ret.position = float4(uv * float2(2, -2) + float2(-1, 1), 0, 1);
+    ret.uv = uv;
+    return ret;
+}
+
+float psMain(VSOut input) : SV_Target {
+    float2 uv = sourceRect.xy + input.uv * sourceRect.zw;
+    float value = source.SampleLevel(pointSampler, float3(uv, arraySlice), 0);
+    if (reversedZ != 0) {
+        value = 1 - value;
+    }
+    if (value >= 1) {
+        // Far plane: nothing drawn there
+        return 0;
+    }
+    return zNear * zFar / (zFar - value * (zFar - zNear));
+}
+)";
+
+struct LinearizeConstants {
+    float sourceRect[4];
+    float arraySlice;
+    float zNear;
+    float zFar;
+    float reversedZ;
+};
+
+static winrt::com_ptr<ID3DBlob> compileShader(const char* entryPoint,
+                                              const char* target) {
+    winrt::com_ptr<ID3DBlob> code;
+    winrt::com_ptr<ID3DBlob> errors;
+    HRESULT hr = D3DCompile(
+        LinearizeShaderSource, sizeof(LinearizeShaderSource) - 1,
+        "DepthLinearizer", nullptr, nullptr, entryPoint, target,
+        D3DCOMPILE_OPTIMIZATION_LEVEL3, 0, code.put(), errors.put());
+    if (FAILED(hr)) {
+        std::string message = "Could not compile depth linearize shader";
+        if (errors) {
+            message += ": ";
+            message += static_cast<const char*>(errors->GetBufferPointer());
+        }
+        throw std::runtime_error(message);
+    }
+    return code;
+}
+
+/**
+ * @brief Get the format to view the depth of a depth buffer format as, or
+ * DXGI_FORMAT_UNKNOWN if it has no depth.
+ */
+static DXGI_FORMAT getDepthViewFormat(DXGI_FORMAT format) {
+    switch (format) {
+        case DXGI_FORMAT_R32_TYPELESS:
+        case DXGI_FORMAT_D32_FLOAT:
+        case DXGI_FORMAT_R32_FLOAT:
+            return DXGI_FORMAT_R32_FLOAT;
+        case DXGI_FORMAT_R24G8_TYPELESS:
+        case DXGI_FORMAT_D24_UNORM_S8_UINT:
+            return DXGI_FORMAT_R24_UNORM_X8_TYPELESS;
+        case DXGI_FORMAT_R32G8X24_TYPELESS:
+        case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
+            return DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS;
+        case DXGI_FORMAT_R16_TYPELESS:
+        case DXGI_FORMAT_D16_UNORM:
+        case DXGI_FORMAT_R16_UNORM:
+            return DXGI_FORMAT_R16_UNORM;
+        default:
+            return DXGI_FORMAT_UNKNOWN;
+    }
+}
+
+DepthLinearizer::DepthLinearizer(ID3D11Device* device) {
+    device_.copy_from(device);
+
+    auto vsCode = compileShader("vsMain", "vs_5_0");
+    winrt::check_hresult(device_->CreateVertexShader(
+        vsCode->GetBufferPointer(), vsCode->GetBufferSize(), nullptr,
+        vertexShader_.put()));
+    auto psCode = compileShader("psMain", "ps_5_0");
+    winrt::check_hresult(device_->CreatePixelShader(
+        psCode->GetBufferPointer(), psCode->GetBufferSize(), nullptr,
+        pixelShader_.put()));
+
+    D3D11_SAMPLER_DESC samplerDesc = {};
+    samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_POINT;
+    samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+    winrt::check_hresult(
+        device_->CreateSamplerState(&samplerDesc, sampler_.put()));
+
+    D3D11_RASTERIZER_DESC rasterizerDesc = {};
+    rasterizerDesc.FillMode = D3D11_FILL_SOLID;
+    rasterizerDesc.CullMode = D3D11_CULL_NONE;
+    rasterizerDesc.DepthClipEnable = TRUE;
+    winrt::check_hresult(
+        device_->CreateRasterizerState(&rasterizerDesc, rasterizer_.put()));
+
+    D3D11_BUFFER_DESC bufferDesc = {};
+    bufferDesc.ByteWidth = sizeof(LinearizeConstants);
+    bufferDesc.Usage = D3D11_USAGE_DEFAULT;
+    bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    winrt::check_hresult(
+        device_->CreateBuffer(&bufferDesc, nullptr, constants_.put()));
+}
+
+winrt::com_ptr<ID3D11ShaderResourceView> DepthLinearizer::createSourceView(
+    ID3D11Texture2D* texture) const {
+    D3D11_TEXTURE2D_DESC texDesc;
+    texture->GetDesc(&texDesc);
+    const DXGI_FORMAT format = getDepthViewFormat(texDesc.Format);
+    if (format == DXGI_FORMAT_UNKNOWN ||
+        (texDesc.BindFlags & D3D11_BIND_SHADER_RESOURCE) == 0) {
+        return nullptr;
+    }
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+    viewDesc.Format = format;
+    viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+    viewDesc.Texture2DArray.MostDetailedMip = 0;
+    viewDesc.Texture2DArray.MipLevels = 1;
+    viewDesc.Texture2DArray.FirstArraySlice = 0;
+    viewDesc.Texture2DArray.ArraySize = texDesc.ArraySize;
+
+    winrt::com_ptr<ID3D11ShaderResourceView> view;
+    if (FAILED(device_->CreateShaderResourceView(texture, &viewDesc,
+                                                 view.put()))) {
+        return nullptr;
+    }
+    return view;
+}
+
+void DepthLinearizer::linearize(ID3D11DeviceContext* context,
+                                ID3D11ShaderResourceView* source,
+                                uint32_t arraySlice,
+                                ID3D11RenderTargetView* target,
+                                D3D11_VIEWPORT const& targetViewport,
+                                BlitRect const& sourceRect, float zNear,
+                                float zFar, bool reversedZ) {
+    LinearizeConstants constants = {
+        {sourceRect.x, sourceRect.y, sourceRect.width, sourceRect.height},
+        static_cast<float>(arraySlice),
+        zNear,
+        zFar,
+        reversedZ ? 1.f : 0.f};
+    context->UpdateSubresource(constants_.get(), 0, nullptr, &constants, 0,
+                               0);
+
+    context->IASetInputLayout(nullptr);
+    context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    context->VSSetShader(vertexShader_.get(), nullptr, 0);
+    context->PSSetShader(pixelShader_.get(), nullptr, 0);
+    ID3D11Buffer* buffers[] = {constants_.get()};
+    context->PSSetConstantBuffers(0, 1, buffers);
+    ID3D11SamplerState* samplers[] = {sampler_.get()};
+    context->PSSetSamplers(0, 1, samplers);
+    context->PSSetShaderResources(0, 1, &source);
+    context->RSSetState(rasterizer_.get());
+    context->RSSetViewports(1, &targetViewport);
+    context->OMSetRenderTargets(1, &target, nullptr);
+    context->OMSetBlendState(nullptr, nullptr, 0xffffffff);
+    context->OMSetDepthStencilState(nullptr, 0);
+
+    context->Draw(3, 0);
+
+    // Unbind so the source can be rendered to again.
+    ID3D11ShaderResourceView* nullView = nullptr;
+    context->PSSetShaderResources(0, 1, &nullView);
+}
+
+}  // namespace metaview
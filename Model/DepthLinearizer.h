@@ -0,0 +1,74 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include "Blitter.h"
+
+#include <d3d11.h>
+#include <winrt/base.h>
+
+#include <cstdint>
+
+namespace metaview {
+
+/**
+ * @brief Converts (a region of) a depth buffer to linear depth in meters,
+ * drawn into a viewport of an R32_FLOAT render target.
+ *
+ * Used to hand the app's depth to the timewarp compositor in a format that
+ * can be shared across devices and doesn't depend on the app's clip planes.
+ * See linearizeDepth() for the conversion. Texels at the far plane come out
+ * as 0, meaning "at infinity".
+ *
+ * Changes pipeline state on the context and does not restore it.
+ */
+class DepthLinearizer {
+  public:
+    /**
+     * @brief Construct a new Depth Linearizer object, compiling its shaders.
+     *
+     * @param device Device to create resources on.
+     */
+    explicit DepthLinearizer(ID3D11Device* device);
+
+    /**
+     * @brief Create a shader resource view of the depth of a depth buffer.
+     *
+     * @return nullptr if the format can't be read as depth, or the texture
+     * can't be bound as a shader resource.
+     */
+    winrt::com_ptr<ID3D11ShaderResourceView> createSourceView(
+        ID3D11Texture2D* texture) const;
+
+    /**
+     * @brief Draw linear depth into a viewport of a render target.
+     *
+     * @param context Context to record on.
+     * @param source View created by createSourceView()
+     * @param arraySlice Which array slice of the source to draw.
+     * @param target R32_FLOAT render target to draw into.
+     * @param targetViewport Region of the target to fill, in pixels.
+     * @param sourceRect Region of the source to draw, normalized.
+     * @param zNear,zFar Clip planes the depth was rendered with.
+     * @param reversedZ Whether the near plane is at 1.
+     */
+    void linearize(ID3D11DeviceContext* context,
+                   ID3D11ShaderResourceView* source, uint32_t arraySlice,
+                   ID3D11RenderTargetView* target,
+                   D3D11_VIEWPORT const& targetViewport,
+                   BlitRect const& sourceRect, float zNear, float zFar,
+                   bool reversedZ);
+
+  private:
+    winrt::com_ptr<ID3D11Device> device_;
+    winrt::com_ptr<ID3D11VertexShader> vertexShader_;
+    winrt::com_ptr<ID3D11PixelShader> pixelShader_;
+    winrt::com_ptr<ID3D11SamplerState> sampler_;
+    winrt::com_ptr<ID3D11RasterizerState> rasterizer_;
+    winrt::com_ptr<ID3D11Buffer> constants_;
+};
+
+}  // namespace metaview
@@ -0,0 +1,87 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace metaview {
+
+//! Bound on the integral term, so it can't wind up while the scale is pinned
+//! at a limit.
+static constexpr double MaxIntegral = 2.0;
+
+DynamicResolutionController::DynamicResolutionController(
+    DynamicResolutionConfig const& config)
+    : config_(config), scale_(config.maxScale) {}
+
+void DynamicResolutionController::setConfig(
+    DynamicResolutionConfig const& config) {
+    config_ = config;
+    scale_ = std::min(std::max(scale_, config_.minScale), config_.maxScale);
+}
+
+void DynamicResolutionController::reset() {
+    scale_ = config_.maxScale;
+    smoothedMs_ = 0;
+    haveSample_ = false;
+    integral_ = 0;
+    lastError_ = 0;
+    framesUnderTarget_ = 0;
+}
+
+double DynamicResolutionController::update(double gpuFrameMs) {
+    const double target = getTargetMs();
+    if (gpuFrameMs <= 0 || target <= 0) {
+        return scale_;
+    }
+    if (haveSample_) {
+        smoothedMs_ += config_.smoothing * (gpuFrameMs - smoothedMs_);
+    } else {
+        smoothedMs_ = gpuFrameMs;
+        haveSample_ = true;
+    }
+
+    // Positive error: headroom, can raise the scale.
+    double error = (target - smoothedMs_) / target;
+    if (std::abs(error) < config_.deadband) {
+        framesUnderTarget_ = 0;
+        lastError_ = error;
+        return scale_;
+    }
+
+    integral_ =
+        std::min(std::max(integral_ + error, -MaxIntegral), MaxIntegral);
+    const double derivative = error - lastError_;
+    lastError_ = error;
+    const double u =
+        config_.kp * error + config_.ki * integral_ + config_.kd * derivative;
+
+    // Pixel count (and so GPU time) goes with the square of the scale.
+    const double desired = std::min(
+        std::max(scale_ * std::sqrt(std::max(1.0 + u, 0.01)), config_.minScale),
+        config_.maxScale);
+
+    if (desired > scale_) {
+        // Hysteresis: only raise after a run of frames with headroom.
+        if (++framesUnderTarget_ < config_.raiseDelayFrames) {
+            return scale_;
+        }
+    } else {
+        framesUnderTarget_ = 0;
+    }
+
+    const bool atLimit =
+        desired == config_.minScale || desired == config_.maxScale;
+    if (std::abs(desired - scale_) >= config_.minStep ||
+        (atLimit && desired != scale_)) {
+        scale_ = desired;
+        framesUnderTarget_ = 0;
+    }
+    return scale_;
+}
+
+}  // namespace metaview
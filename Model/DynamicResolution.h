@@ -0,0 +1,119 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include <cstdint>
+
+namespace metaview {
+
+/**
+ * @brief Tuning parameters for a DynamicResolutionController.
+ */
+struct DynamicResolutionConfig {
+    //! Fraction of the frame budget the GPU frame time should settle at.
+    double targetFraction = 0.85;
+
+    //! Lowest resolution scale the controller will pick.
+    double minScale = 0.5;
+
+    //! Highest resolution scale the controller will pick.
+    double maxScale = 1.0;
+
+    //! Proportional gain, on the error as a fraction of the target.
+    double kp = 0.4;
+
+    //! Integral gain.
+    double ki = 0.05;
+
+    //! Derivative gain.
+    double kd = 0.0;
+
+    //! Errors smaller than this fraction of the target are ignored.
+    double deadband = 0.05;
+
+    //! Scale changes smaller than this are not applied, to avoid churning.
+    double minStep = 0.02;
+
+    //! How many consecutive frames must be under target before the scale is
+    //! raised. Lowering it happens right away.
+    uint32_t raiseDelayFrames = 10;
+
+    //! Weight of each new sample in the smoothed GPU time, in (0, 1].
+    double smoothing = 0.3;
+};
+
+/**
+ * @brief Picks a render resolution scale to hold GPU frame time at a fraction
+ * of the frame budget.
+ *
+ * A PID loop on the (smoothed) GPU time error, with a deadband, a minimum
+ * step and a delay before raising the scale so it doesn't oscillate. GPU time
+ * is assumed to be roughly proportional to the number of pixels, that is to
+ * the square of the scale.
+ *
+ * Pure logic: feed it GPU frame times from whatever source, one per frame.
+ */
+class DynamicResolutionController {
+  public:
+    explicit DynamicResolutionController(
+        DynamicResolutionConfig const& config = {});
+
+    /**
+     * @brief Set the time available per frame, typically the refresh period.
+     */
+    void setFrameBudget(double budgetMs) noexcept { budgetMs_ = budgetMs; }
+
+    double getFrameBudget() const noexcept { return budgetMs_; }
+
+    /**
+     * @brief Get the GPU time the controller aims for.
+     */
+    double getTargetMs() const noexcept {
+        return budgetMs_ * config_.targetFraction;
+    }
+
+    /**
+     * @brief Feed the GPU time of a completed frame.
+     *
+     * @param gpuFrameMs GPU time of the frame, in milliseconds, measured at
+     * the scale that was in effect for it.
+     * @return the scale to render subsequent frames at.
+     */
+    double update(double gpuFrameMs);
+
+    /**
+     * @brief Get the current scale.
+     */
+    double getScale() const noexcept { return scale_; }
+
+    /**
+     * @brief Get the smoothed GPU frame time.
+     */
+    double getSmoothedGpuMs() const noexcept { return smoothedMs_; }
+
+    DynamicResolutionConfig const& getConfig() const noexcept {
+        return config_;
+    }
+
+    void setConfig(DynamicResolutionConfig const& config);
+
+    /**
+     * @brief Go back to the maximum scale and forget all history.
+     */
+    void reset();
+
+  private:
+    DynamicResolutionConfig config_;
+    double budgetMs_ = 1000.0 / 90.0;
+    double scale_;
+    double smoothedMs_ = 0;
+    bool haveSample_ = false;
+    double integral_ = 0;
+    double lastError_ = 0;
+    uint32_t framesUnderTarget_ = 0;
+};
+
+}  // namespace metaview
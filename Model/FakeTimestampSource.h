@@ -0,0 +1,109 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include "TimestampQueryRing.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace metaview {
+
+/**
+ * @brief A timestamp query backend with no GPU behind it.
+ *
+ * Timestamps are taken from a counter the caller advances, and a slot only
+ * becomes readable once the caller says the "GPU" has caught up with it, so
+ * latency and stalls can be simulated deterministically.
+ */
+class FakeTimestampSource : public ITimestampQuerySource {
+  public:
+    /**
+     * @brief Construct a new Fake Timestamp Source object
+     *
+     * @param numSlots Number of frames of queries.
+     * @param numPoints Timestamps per frame.
+     * @param frequency Ticks per second to report.
+     */
+    FakeTimestampSource(size_t numSlots, size_t numPoints,
+                        uint64_t frequency = 1'000'000'000)
+        : frequency_(frequency), slots_(numSlots) {
+        for (auto& slot : slots_) {
+            slot.ticks.resize(numPoints);
+        }
+    }
+
+    /**
+     * @brief Move the fake GPU clock forward.
+     */
+    void advance(uint64_t ticks) { now_ += ticks; }
+
+    /**
+     * @brief Make results of every frame ended so far readable.
+     */
+    void completeAll() { completedSeq_ = endSeq_; }
+
+    /**
+     * @brief Make results readable for frames ended up to @p count frames
+     * ago.
+     */
+    void completeAllBut(uint64_t count) {
+        completedSeq_ = endSeq_ > count ? endSeq_ - count : 0;
+    }
+
+    /**
+     * @brief Mark the next frame to be ended as disjoint.
+     */
+    void setNextDisjoint() { nextDisjoint_ = true; }
+
+    void begin(size_t slot) override { slots_[slot].disjoint = false; }
+
+    void timestamp(size_t slot, size_t point) override {
+        slots_[slot].ticks[point] = now_;
+    }
+
+    void end(size_t slot) override {
+        slots_[slot].seq = ++endSeq_;
+        slots_[slot].disjoint = nextDisjoint_;
+        nextDisjoint_ = false;
+    }
+
+    bool tryRead(size_t slot, uint32_t writtenMask, uint64_t* ticks,
+                 uint64_t& frequency, bool& disjoint) override {
+        ++reads_;
+        Slot const& s = slots_[slot];
+        if (s.seq > completedSeq_) {
+            return false;
+        }
+        for (size_t i = 0; i < s.ticks.size(); ++i) {
+            if ((writtenMask >> i) & 1u) {
+                ticks[i] = s.ticks[i];
+            }
+        }
+        frequency = frequency_;
+        disjoint = s.disjoint;
+        return true;
+    }
+
+    //! Number of tryRead() calls, to check nobody polls excessively.
+    uint64_t getReadCount() const { return reads_; }
+
+  private:
+    struct Slot {
+        std::vector<uint64_t> ticks;
+        uint64_t seq = 0;
+        bool disjoint = false;
+    };
+    uint64_t frequency_;
+    uint64_t now_ = 0;
+    uint64_t endSeq_ = 0;
+    uint64_t completedSeq_ = 0;
+    uint64_t reads_ = 0;
+    bool nextDisjoint_ = false;
+    std::vector<Slot> slots_;
+};
+
+}  // namespace metaview
@@ -0,0 +1,134 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#include "FrameClassifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace metaview {
+
+FrameClassifier::FrameClassifier(size_t historySize) {
+    history_.reserve(historySize < 1 ? 1 : historySize);
+}
+
+void FrameClassifier::onFrameSubmitted(uint64_t fenceValue,
+                                       int64_t targetVBlankNs,
+                                       int64_t periodNs,
+                                       uint32_t frameInterval) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // By default, aim at the next vblank
+    int64_t targetIndex = vblankIndex_ + 1;
+    if (targetVBlankNs != 0 && periodNs > 0 && vblankIndex_ > 0) {
+        const double periods =
+            static_cast<double>(targetVBlankNs - lastVBlankNs_) / periodNs;
+        targetIndex =
+            vblankIndex_ + std::max<int64_t>(std::llround(periods), 1);
+    }
+    pending_.push_back(PendingFrame{fenceValue, targetIndex,
+                                    std::max<uint32_t>(frameInterval, 1)});
+}
+
+void FrameClassifier::onVBlank(int64_t timestampNs,
+                               uint64_t completedFenceValue) {
+    MissCallback callback;
+    uint32_t consecutiveLate = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++vblankIndex_;
+        lastVBlankNs_ = timestampNs;
+
+        // The newest frame rendered by now is the one scanned out; any older
+        // ones still pending were never shown.
+        auto newest = pending_.end();
+        for (auto it = pending_.begin(); it != pending_.end(); ++it) {
+            if (it->fenceValue > completedFenceValue) {
+                break;
+            }
+            newest = it;
+        }
+        if (newest == pending_.end()) {
+            if (haveShown_ && ++shown_.refreshes > shown_.frameInterval) {
+                ++counters_.repeatedVBlanks;
+            }
+            return;
+        }
+        counters_.skipped += std::distance(pending_.begin(), newest);
+        PendingFrame const frame = *newest;
+        pending_.erase(pending_.begin(), newest + 1);
+
+        bool fire = false;
+        if (haveShown_) {
+            fire = finishShownFrame();
+        }
+        haveShown_ = true;
+        shown_.targetIndex = frame.targetIndex;
+        shown_.shownIndex = vblankIndex_;
+        shown_.refreshes = 1;
+        shown_.frameInterval = frame.frameInterval;
+        if (fire) {
+            callback = missCallback_;
+            consecutiveLate = consecutiveLate_;
+        }
+    }
+    if (callback) {
+        callback(consecutiveLate);
+    }
+}
+
+bool FrameClassifier::finishShownFrame() {
+    const int64_t vblanksLate =
+        std::max<int64_t>(shown_.shownIndex - shown_.targetIndex, 0);
+    if (vblanksLate > 0) {
+        ++counters_.late;
+        ++consecutiveLate_;
+    } else {
+        if (shown_.refreshes > shown_.frameInterval) {
+            ++counters_.repeated;
+        } else {
+            ++counters_.onTime;
+        }
+        consecutiveLate_ = 0;
+    }
+
+    const uint8_t bucket = static_cast<uint8_t>(
+        std::min<int64_t>(vblanksLate, HistogramBuckets - 1));
+    if (history_.size() < history_.capacity()) {
+        history_.push_back(bucket);
+    } else {
+        --histogram_[history_[historyNext_]];
+        history_[historyNext_] = bucket;
+        historyNext_ = (historyNext_ + 1) % history_.size();
+    }
+    ++histogram_[bucket];
+
+    return missThreshold_ > 0 && consecutiveLate_ > 0 &&
+           consecutiveLate_ % missThreshold_ == 0;
+}
+
+void FrameClassifier::setMissCallback(uint32_t threshold,
+                                      MissCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    missThreshold_ = threshold;
+    missCallback_ = std::move(callback);
+}
+
+FrameClassifierCounters FrameClassifier::getCounters() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return counters_;
+}
+
+FrameClassifier::Histogram FrameClassifier::getHistogram() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return histogram_;
+}
+
+uint32_t FrameClassifier::getConsecutiveLate() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return consecutiveLate_;
+}
+
+}  // namespace metaview
@@ -0,0 +1,158 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace metaview {
+
+/**
+ * @brief How a frame made it to the screen.
+ */
+enum class FrameResult {
+    //! Shown on the vblank it was aimed at, for one refresh.
+    OnTime,
+    //! Shown on a later vblank than the one it was aimed at.
+    Late,
+    //! Shown on time, but stayed up for longer than its frame interval
+    //! (usually one refresh) because the next frame was late.
+    Repeated,
+};
+
+/**
+ * @brief Running totals kept by a FrameClassifier.
+ */
+struct FrameClassifierCounters {
+    uint64_t onTime = 0;
+    uint64_t late = 0;
+    uint64_t repeated = 0;
+    //! Frames replaced by a newer one before they were ever shown.
+    uint64_t skipped = 0;
+    //! Vblanks on which no new frame was shown, not counting those a frame
+    //! was meant to stay up for.
+    uint64_t repeatedVBlanks = 0;
+};
+
+/**
+ * @brief Works out from vblank timestamps and fence progress which vblank
+ * each submitted frame was first shown on, and classifies it.
+ *
+ * A frame is submitted along with the fence value its rendering signals and
+ * the time of the vblank it is aimed at. Scanouts wait for that fence, so a
+ * frame is taken as shown on the first vblank at which its fence has
+ * completed. It is classified once the next frame is shown, as only then is
+ * it known how long it stayed up.
+ *
+ * Pure logic driven by timestamps. Thread-safe: vblanks are typically
+ * reported from a vblank thread and frames from the render thread.
+ */
+class FrameClassifier {
+  public:
+    //! Histogram buckets: frames 0, 1, 2, ... vblanks late, the last bucket
+    //! also counting anything later.
+    static constexpr size_t HistogramBuckets = 5;
+    using Histogram = std::array<uint32_t, HistogramBuckets>;
+
+    /**
+     * @brief Called with the length of the run when the given number of
+     * frames in a row were late. Called on the thread reporting vblanks,
+     * with no locks held.
+     */
+    using MissCallback = std::function<void(uint32_t consecutiveLate)>;
+
+    /**
+     * @brief Construct a new Frame Classifier object
+     *
+     * @param historySize Number of recent frames the histogram covers.
+     */
+    explicit FrameClassifier(size_t historySize = 120);
+
+    /**
+     * @brief Report that a frame was submitted.
+     *
+     * @param fenceValue Fence value signaled once the frame is rendered.
+     * Must increase from frame to frame.
+     * @param targetVBlankNs Time of the vblank the frame is aimed at, or 0
+     * for the first vblank after now.
+     * @param periodNs Refresh period, for telling vblanks apart. 0 if
+     * unknown, in which case @p targetVBlankNs is ignored.
+     * @param frameInterval How many vblanks the frame is meant to stay up.
+     */
+    void onFrameSubmitted(uint64_t fenceValue, int64_t targetVBlankNs,
+                          int64_t periodNs, uint32_t frameInterval = 1);
+
+    /**
+     * @brief Report a vblank.
+     *
+     * @param timestampNs When it happened.
+     * @param completedFenceValue Fence value completed by then.
+     */
+    void onVBlank(int64_t timestampNs, uint64_t completedFenceValue);
+
+    /**
+     * @brief Fire a callback every time @p threshold frames in a row are
+     * late. A threshold of 0 disables it.
+     */
+    void setMissCallback(uint32_t threshold, MissCallback callback);
+
+    FrameClassifierCounters getCounters() const;
+
+    /**
+     * @brief Get how late each of the recent frames was, in vblanks.
+     */
+    Histogram getHistogram() const;
+
+    /**
+     * @brief Get the number of late frames in the current run.
+     */
+    uint32_t getConsecutiveLate() const;
+
+  private:
+    struct PendingFrame {
+        uint64_t fenceValue;
+        //! Index of the target vblank.
+        int64_t targetIndex;
+        uint32_t frameInterval;
+    };
+
+    struct ShownFrame {
+        int64_t targetIndex = 0;
+        int64_t shownIndex = 0;
+        uint32_t refreshes = 0;
+        uint32_t frameInterval = 1;
+    };
+
+    //! Classify the frame on screen, now being replaced. Lock must be held.
+    //! @return whether the miss callback should fire.
+    bool finishShownFrame();
+
+    mutable std::mutex mutex_;
+    std::deque<PendingFrame> pending_;
+    //! Frame currently on screen, if any.
+    bool haveShown_ = false;
+    ShownFrame shown_;
+
+    //! Vblanks seen so far, and when the last one was.
+    int64_t vblankIndex_ = 0;
+    int64_t lastVBlankNs_ = 0;
+
+    FrameClassifierCounters counters_;
+    //! How many vblanks late recent frames were, oldest first.
+    std::vector<uint8_t> history_;
+    size_t historyNext_ = 0;
+    Histogram histogram_{};
+
+    uint32_t consecutiveLate_ = 0;
+    uint32_t missThreshold_ = 0;
+    MissCallback missCallback_;
+};
+
+}  // namespace metaview
@@ -0,0 +1,55 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#include "FrameIntervalController.h"
+
+namespace metaview {
+
+uint32_t FrameIntervalController::update(uint32_t droppedFrames,
+                                         double cpuFrameMs, double gpuFrameMs,
+                                         double periodMs) {
+    if (periodMs <= 0) {
+        return interval_;
+    }
+    if (interval_ == 1) {
+        ++windowCount_;
+        if (droppedFrames > 0) {
+            ++windowDrops_;
+        }
+        if (windowCount_ < config_.windowFrames) {
+            return interval_;
+        }
+        if (windowDrops_ >= config_.throttleDropFraction * windowCount_) {
+            interval_ = 2;
+            streak_ = 0;
+        }
+        windowCount_ = 0;
+        windowDrops_ = 0;
+        return interval_;
+    }
+
+    if (cpuFrameMs < 0 || gpuFrameMs <= 0) {
+        return interval_;
+    }
+    const double load = (cpuFrameMs + gpuFrameMs) / periodMs;
+    if (load >= config_.unthrottleLoad) {
+        streak_ = 0;
+        return interval_;
+    }
+    if (++streak_ >= config_.unthrottleFrames) {
+        interval_ = 1;
+        streak_ = 0;
+    }
+    return interval_;
+}
+
+void FrameIntervalController::reset() {
+    interval_ = 1;
+    windowCount_ = 0;
+    windowDrops_ = 0;
+    streak_ = 0;
+}
+
+}  // namespace metaview
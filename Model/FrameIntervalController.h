@@ -0,0 +1,78 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include <cstdint>
+
+namespace metaview {
+
+/**
+ * @brief Tuning parameters for a FrameIntervalController.
+ */
+struct FrameIntervalConfig {
+    //! Frames over which dropped frames are counted before deciding.
+    uint32_t windowFrames = 90;
+
+    //! Drop to half rate if at least this fraction of the frames in a window
+    //! were late enough to drop a vblank.
+    double throttleDropFraction = 0.1;
+
+    //! Go back to full rate once CPU plus GPU time is under this fraction of
+    //! the refresh period...
+    double unthrottleLoad = 0.7;
+
+    //! ...for this many frames in a row. Long, since going back and forth is
+    //! more noticeable than staying at half rate.
+    uint32_t unthrottleFrames = 450;
+};
+
+/**
+ * @brief Decides when to render at half the refresh rate, leaving timewarp
+ * to fill in every other vblank, and when to go back to full rate.
+ *
+ * At full rate the decision is driven by dropped frames: once too many
+ * frames in a window miss their vblank, the app can't keep up and a steady
+ * half rate with synthesized frames in between beats a stutter. At half rate
+ * nothing is dropped, so going back is driven by load instead: the CPU and
+ * GPU time of a frame must fit comfortably in a single period for a while.
+ *
+ * Pure logic: feed it one frame's measurements at a time.
+ */
+class FrameIntervalController {
+  public:
+    explicit FrameIntervalController(FrameIntervalConfig const& config = {})
+        : config_(config) {}
+
+    /**
+     * @brief Feed the measurements of a frame.
+     *
+     * @param droppedFrames Extra vblanks the previous frame stayed up for.
+     * @param cpuFrameMs CPU time spent producing the frame.
+     * @param gpuFrameMs GPU time spent rendering it.
+     * @param periodMs Refresh period.
+     * @return the frame interval to use from now on: 1 or 2 vblanks.
+     */
+    uint32_t update(uint32_t droppedFrames, double cpuFrameMs,
+                    double gpuFrameMs, double periodMs);
+
+    uint32_t getInterval() const noexcept { return interval_; }
+
+    /**
+     * @brief Go back to full rate and forget all history.
+     */
+    void reset();
+
+  private:
+    FrameIntervalConfig config_;
+    uint32_t interval_ = 1;
+    //! Frames and frames with drops so far in the current window.
+    uint32_t windowCount_ = 0;
+    uint32_t windowDrops_ = 0;
+    //! Consecutive light frames at half rate.
+    uint32_t streak_ = 0;
+};
+
+}  // namespace metaview
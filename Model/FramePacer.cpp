@@ -0,0 +1,239 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace metaview {
+
+//! Fit residual, as a fraction of the period, below which we consider the
+//! estimate locked.
+static constexpr double LockedResidualFraction = 0.1;
+
+//! Fit residual, as a fraction of the period, above which we assume the
+//! display timing changed and start over.
+static constexpr double ResetResidualFraction = 0.25;
+
+FramePacer::FramePacer(IClock& clock, FramePacerConfig const& config)
+    : clock_(clock),
+      config_(config),
+      history_(std::max<size_t>(config.historySize, 2)) {
+    periodNs_ = static_cast<double>(config_.nominalPeriodNs);
+}
+
+void FramePacer::recordVBlank(int64_t timestampNs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Sample sample{0, timestampNs};
+    if (historyCount_ > 0) {
+        int64_t delta = timestampNs - last_.timestampNs;
+        if (delta <= 0) {
+            // duplicate or out of order, ignore
+            return;
+        }
+        double period = periodNs_ > 0 ? periodNs_ : static_cast<double>(delta);
+        // Account for any vblanks we didn't get to observe.
+        int64_t steps = std::max<int64_t>(
+            1, std::llround(static_cast<double>(delta) / period));
+        sample.index = last_.index + steps;
+    }
+    history_[historyNext_] = sample;
+    historyNext_ = (historyNext_ + 1) % history_.size();
+    historyCount_ = std::min(historyCount_ + 1, history_.size());
+    last_ = sample;
+    refit();
+
+    if (historyCount_ >= config_.minSamplesForLock &&
+        residualNs_ > periodNs_ * ResetResidualFraction) {
+        // Timing no longer fits a single period: mode change or similar.
+        // Start over from this sample, still counting from it.
+        history_[0] = sample;
+        historyNext_ = 1;
+        historyCount_ = 1;
+        last_ = history_[0];
+        periodNs_ = static_cast<double>(config_.nominalPeriodNs);
+        refit();
+    }
+}
+
+void FramePacer::refit() {
+    const size_t n = historyCount_;
+    if (n == 0) {
+        return;
+    }
+    if (n == 1) {
+        anchorNs_ = static_cast<double>(last_.timestampNs);
+        residualNs_ = 0;
+        return;
+    }
+    const size_t capacity = history_.size();
+    const size_t start = (n < capacity) ? 0 : historyNext_;
+    Sample const& first = history_[start];
+
+    // Least-squares fit of timestamp against vblank index, relative to the
+    // oldest sample to keep the doubles well-conditioned.
+    double sumX = 0, sumY = 0;
+    for (size_t i = 0; i < n; ++i) {
+        Sample const& s = history_[(start + i) % capacity];
+        sumX += static_cast<double>(s.index - first.index);
+        sumY += static_cast<double>(s.timestampNs - first.timestampNs);
+    }
+    const double meanX = sumX / n;
+    const double meanY = sumY / n;
+    double sxx = 0, sxy = 0;
+    for (size_t i = 0; i < n; ++i) {
+        Sample const& s = history_[(start + i) % capacity];
+        double dx = static_cast<double>(s.index - first.index) - meanX;
+        double dy = static_cast<double>(s.timestampNs - first.timestampNs) -
+                    meanY;
+        sxx += dx * dx;
+        sxy += dx * dy;
+    }
+    if (sxx <= 0) {
+        return;
+    }
+    const double slope = sxy / sxx;
+    const double intercept = meanY - slope * meanX;
+
+    double sumSq = 0;
+    for (size_t i = 0; i < n; ++i) {
+        Sample const& s = history_[(start + i) % capacity];
+        double x = static_cast<double>(s.index - first.index);
+        double y = static_cast<double>(s.timestampNs - first.timestampNs);
+        double err = y - (intercept + slope * x);
+        sumSq += err * err;
+    }
+    periodNs_ = slope;
+    residualNs_ = std::sqrt(sumSq / n);
+    anchorNs_ = static_cast<double>(first.timestampNs) + intercept +
+                slope * static_cast<double>(last_.index - first.index);
+}
+
+bool FramePacer::isLocked() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return isLockedLocked();
+}
+
+bool FramePacer::isLockedLocked() const {
+    return historyCount_ >= config_.minSamplesForLock && periodNs_ > 0 &&
+           residualNs_ < periodNs_ * LockedResidualFraction;
+}
+
+int64_t FramePacer::getPeriod() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::llround(periodNs_);
+}
+
+int64_t FramePacer::predictVBlankAtOrAfter(int64_t timeNs) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return predictLocked(timeNs);
+}
+
+int64_t FramePacer::predictLocked(int64_t timeNs) const {
+    if (historyCount_ == 0) {
+        return 0;
+    }
+    if (periodNs_ <= 0) {
+        return std::llround(anchorNs_);
+    }
+    double periods = std::ceil((static_cast<double>(timeNs) - anchorNs_) /
+                               periodNs_);
+    return std::llround(anchorNs_ + periods * periodNs_);
+}
+
+int64_t FramePacer::getVBlankCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return historyCount_ > 0 ? last_.index + 1 : 0;
+}
+
+int64_t FramePacer::vblankToTime(int64_t vblankCount) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!isLockedLocked()) {
+        return 0;
+    }
+    const double steps = static_cast<double>(vblankCount - 1 - last_.index);
+    return std::llround(anchorNs_ + steps * periodNs_);
+}
+
+double FramePacer::timeToVBlank(int64_t timeNs) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!isLockedLocked()) {
+        return 0;
+    }
+    return static_cast<double>(last_.index + 1) +
+           (static_cast<double>(timeNs) - anchorNs_) / periodNs_;
+}
+
+int64_t FramePacer::targetLocked(int64_t nowNs) const {
+    int64_t target = predictLocked(nowNs + config_.runningStartNs);
+    // Half a period short of the interval, to be robust to jitter
+    const int64_t minSpacing = std::llround(
+        periodNs_ * (std::max<uint32_t>(config_.frameInterval, 1) - 0.5));
+    if (lastTargetNs_ != 0 && target < lastTargetNs_ + minSpacing) {
+        // Don't aim two frames at the same vblank, nor closer than the
+        // frame interval.
+        target = predictLocked(lastTargetNs_ + minSpacing);
+    }
+    return target;
+}
+
+void FramePacer::computeWakeTime(int64_t nowNs, int64_t& wakeNs,
+                                 int64_t& targetVBlankNs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const int64_t target = targetLocked(nowNs);
+    lastTargetNs_ = target;
+    targetVBlankNs = target;
+    wakeNs = target - config_.runningStartNs;
+}
+
+int64_t FramePacer::predictNextTarget(int64_t nowNs) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!isLockedLocked()) {
+        return 0;
+    }
+    return targetLocked(nowNs);
+}
+
+int64_t FramePacer::waitForRunningStart() {
+    int64_t wake = 0;
+    int64_t target = 0;
+    computeWakeTime(clock_.now(), wake, target);
+    clock_.sleepUntil(wake);
+    return target;
+}
+
+void FramePacer::setRunningStart(int64_t runningStartNs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    config_.runningStartNs = runningStartNs;
+}
+
+int64_t FramePacer::getRunningStart() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return config_.runningStartNs;
+}
+
+void FramePacer::setFrameInterval(uint32_t vblanks) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    config_.frameInterval = std::max<uint32_t>(vblanks, 1);
+}
+
+uint32_t FramePacer::getFrameInterval() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return config_.frameInterval;
+}
+
+void FramePacer::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    historyNext_ = 0;
+    historyCount_ = 0;
+    last_ = Sample{0, 0};
+    periodNs_ = static_cast<double>(config_.nominalPeriodNs);
+    anchorNs_ = 0;
+    residualNs_ = 0;
+    lastTargetNs_ = 0;
+}
+
+}  // namespace metaview
@@ -0,0 +1,221 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include "Clock.h"
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace metaview {
+
+/**
+ * @brief Configuration for a FramePacer.
+ */
+struct FramePacerConfig {
+    //! How long before the target vblank the render thread should be woken,
+    //! in nanoseconds.
+    int64_t runningStartNs = 2'000'000;
+
+    //! Expected refresh period, if known, in nanoseconds. Only used to seed the
+    //! estimate before enough vblanks have been observed. 0 means unknown.
+    int64_t nominalPeriodNs = 0;
+
+    //! How many recent vblank timestamps are used to estimate period and phase.
+    size_t historySize = 64;
+
+    //! How many vblank timestamps must be seen before the estimate is trusted.
+    size_t minSamplesForLock = 8;
+
+    //! How many vblanks each frame is aimed to last: 1 to render at the
+    //! refresh rate, 2 for half rate, etc.
+    uint32_t frameInterval = 1;
+};
+
+/**
+ * @brief Estimates the display refresh period and phase from observed vblank
+ * timestamps, and wakes the render thread a "running start" offset before the
+ * next vblank.
+ *
+ * Timestamps may be recorded from one thread (typically a thread dedicated to
+ * waiting on vblank) while another thread calls waitForRunningStart(). Missed
+ * vblanks (gaps in the recorded sequence) are tolerated.
+ *
+ * All times are in nanoseconds in the timebase of the supplied IClock.
+ */
+class FramePacer {
+  public:
+    /**
+     * @brief Construct a new Frame Pacer object
+     *
+     * @param clock Clock to use for reading time and sleeping. Must outlive
+     * this object.
+     * @param config Tuning parameters.
+     */
+    explicit FramePacer(IClock& clock, FramePacerConfig const& config = {});
+
+    /**
+     * @brief Record that a vblank occurred at the given time.
+     *
+     * Thread-safe.
+     */
+    void recordVBlank(int64_t timestampNs);
+
+    /**
+     * @brief Record that a vblank occurred now, according to our clock.
+     */
+    void recordVBlank() { recordVBlank(clock_.now()); }
+
+    /**
+     * @brief Whether enough consistent vblanks have been observed to predict
+     * future ones.
+     */
+    bool isLocked() const;
+
+    /**
+     * @brief Get the estimated refresh period in nanoseconds, or 0 if no
+     * estimate exists yet.
+     */
+    int64_t getPeriod() const;
+
+    /**
+     * @brief Get the predicted time of the first vblank at or after the given
+     * time.
+     *
+     * @pre isLocked() (otherwise the result is only a rough guess, or 0 if no
+     * vblank has been observed)
+     */
+    int64_t predictVBlankAtOrAfter(int64_t timeNs) const;
+
+    /**
+     * @brief Get the number of vblanks since the first one recorded,
+     * including it, or 0 before any.
+     *
+     * Derived from the timestamps, so vblanks that were not recorded are
+     * counted too. Keeps counting across a mode change; only reset() starts
+     * it again.
+     */
+    int64_t getVBlankCount() const;
+
+    /**
+     * @brief Get when the vblank with the given count happened or will
+     * happen, or 0 if not locked.
+     */
+    int64_t vblankToTime(int64_t vblankCount) const;
+
+    /**
+     * @brief Get the (fractional) vblank count at a time, or 0 if not
+     * locked.
+     */
+    double timeToVBlank(int64_t timeNs) const;
+
+    /**
+     * @brief Compute when to wake the render thread for its next frame.
+     *
+     * The target vblank is the first one whose running-start wake time is not
+     * in the past, and is always at least the frame interval after the target
+     * returned by the previous call, so two frames never aim at the same
+     * vblank.
+     *
+     * @param nowNs Current time.
+     * @param[out] wakeNs When the render thread should be woken.
+     * @param[out] targetVBlankNs The vblank that frame is aimed at.
+     */
+    void computeWakeTime(int64_t nowNs, int64_t& wakeNs,
+                         int64_t& targetVBlankNs);
+
+    /**
+     * @brief Predict the vblank the next frame will be aimed at: what
+     * computeWakeTime() would return at @p nowNs, without recording it.
+     *
+     * Used to predict when the frame about to be set up reaches the display.
+     *
+     * @return 0 if not locked.
+     */
+    int64_t predictNextTarget(int64_t nowNs) const;
+
+    /**
+     * @brief Sleep until the running start point before the next vblank.
+     *
+     * @pre isLocked()
+     *
+     * @return the predicted time of the vblank the frame is aimed at.
+     */
+    int64_t waitForRunningStart();
+
+    /**
+     * @brief Change the running start offset.
+     */
+    void setRunningStart(int64_t runningStartNs);
+
+    /**
+     * @brief Get the running start offset.
+     */
+    int64_t getRunningStart() const;
+
+    /**
+     * @brief Change how many vblanks each frame is aimed to last. Clamped to
+     * at least 1.
+     */
+    void setFrameInterval(uint32_t vblanks);
+
+    /**
+     * @brief Get how many vblanks each frame is aimed to last.
+     */
+    uint32_t getFrameInterval() const;
+
+    /**
+     * @brief Discard all observations, e.g. after a display mode change.
+     */
+    void reset();
+
+  private:
+    struct Sample {
+        //! Vblank index relative to the first sample recorded since
+        //! reset(): getVBlankCount() - 1.
+        int64_t index;
+        int64_t timestampNs;
+    };
+
+    //! Re-fit period and phase to the samples in history. Lock must be held.
+    void refit();
+
+    //! Lock-held version of isLocked()
+    bool isLockedLocked() const;
+
+    //! Lock-held version of predictVBlankAtOrAfter()
+    int64_t predictLocked(int64_t timeNs) const;
+
+    //! Lock-held target selection shared by computeWakeTime() and
+    //! predictNextTarget()
+    int64_t targetLocked(int64_t nowNs) const;
+
+    IClock& clock_;
+    FramePacerConfig config_;
+
+    mutable std::mutex mutex_;
+    //! Ring buffer of recent samples.
+    std::vector<Sample> history_;
+    //! Next slot to write in history_.
+    size_t historyNext_ = 0;
+    //! Number of valid entries in history_.
+    size_t historyCount_ = 0;
+    //! Most recent sample, for computing the index of the next one.
+    Sample last_{0, 0};
+
+    //! Estimated period, or 0 if unknown.
+    double periodNs_ = 0;
+    //! Fitted timestamp of the most recent vblank: the phase reference.
+    double anchorNs_ = 0;
+    //! Root-mean-square fit residual.
+    double residualNs_ = 0;
+
+    //! The vblank most recently targeted by computeWakeTime(), or 0.
+    int64_t lastTargetNs_ = 0;
+};
+
+}  // namespace metaview
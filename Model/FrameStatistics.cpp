@@ -0,0 +1,45 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#include "FrameStatistics.h"
+
+namespace metaview {
+
+static double toMs(int64_t ns) { return static_cast<double>(ns) / 1e6; }
+
+void FrameStatistics::endWait(int64_t nowNs, int64_t targetVBlankNs,
+                              uint64_t vblankCount, uint32_t frameInterval) {
+    current_ = FrameTiming{};
+    current_.frameIndex = counters_.frames;
+    current_.vblankWaitMs = toMs(nowNs - waitBeginNs_);
+    renderBeginNs_ = nowNs;
+    targetVBlankNs_ = targetVBlankNs;
+
+    // Each frame should be on screen for exactly frameInterval vblanks: any
+    // more since the previous frame started means it was scanned out again.
+    if (frameInterval < 1) {
+        frameInterval = 1;
+    }
+    if (lastVBlankCount_ != 0 &&
+        vblankCount > lastVBlankCount_ + frameInterval) {
+        current_.droppedFrames = static_cast<uint32_t>(
+            vblankCount - lastVBlankCount_ - frameInterval);
+        counters_.droppedFrames += current_.droppedFrames;
+    }
+    lastVBlankCount_ = vblankCount;
+}
+
+void FrameStatistics::endSubmit(int64_t nowNs) {
+    current_.cpuFrameMs = toMs(nowNs - renderBeginNs_);
+    current_.cpuSubmitMs = toMs(nowNs - submitBeginNs_);
+    if (targetVBlankNs_ != 0 && nowNs > targetVBlankNs_) {
+        current_.missedVBlank = true;
+        ++counters_.missedVBlanks;
+    }
+    ++counters_.frames;
+    last_ = current_;
+}
+
+}  // namespace metaview
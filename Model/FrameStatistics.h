@@ -0,0 +1,117 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace metaview {
+
+/**
+ * @brief CPU-side timing of one frame, as seen by the renderer.
+ */
+struct FrameTiming {
+    //! Frames completed before this one.
+    uint64_t frameIndex = 0;
+    //! How long waitFrame() blocked, in milliseconds.
+    double vblankWaitMs = 0;
+    //! Time from waitFrame() returning to endFrame() returning.
+    double cpuFrameMs = 0;
+    //! Time spent in endFrame() submitting the frame.
+    double cpuSubmitMs = 0;
+    //! Extra vblanks the previous frame stayed on screen for, beyond the
+    //! frame interval, because this one started late.
+    uint32_t droppedFrames = 0;
+    //! Whether the frame was submitted after the vblank it was aimed at.
+    bool missedVBlank = false;
+};
+
+/**
+ * @brief Running totals since the renderer started.
+ */
+struct FrameCounters {
+    uint64_t frames = 0;
+    uint64_t presents = 0;
+    uint64_t droppedFrames = 0;
+    uint64_t missedVBlanks = 0;
+};
+
+/**
+ * @brief Turns the renderer's frame loop timestamps into per-frame timing and
+ * running totals.
+ *
+ * The frame loop calls beginWait(), endWait(), beginSubmit() and endSubmit()
+ * in order, all on one thread, which is also the thread reading the results.
+ * recordPresent() may be called from any thread.
+ *
+ * All times are in nanoseconds on a common clock.
+ */
+class FrameStatistics {
+  public:
+    /**
+     * @brief The frame loop is about to wait for the next frame.
+     */
+    void beginWait(int64_t nowNs) { waitBeginNs_ = nowNs; }
+
+    /**
+     * @brief The wait is over and rendering starts.
+     *
+     * @param nowNs Current time.
+     * @param targetVBlankNs Vblank the frame is aimed at, or 0 if unknown.
+     * @param vblankCount Number of vblanks seen so far.
+     * @param frameInterval How many vblanks each frame is meant to last.
+     */
+    void endWait(int64_t nowNs, int64_t targetVBlankNs, uint64_t vblankCount,
+                 uint32_t frameInterval = 1);
+
+    /**
+     * @brief The frame is about to be submitted.
+     */
+    void beginSubmit(int64_t nowNs) { submitBeginNs_ = nowNs; }
+
+    /**
+     * @brief The frame has been submitted. Completes its FrameTiming.
+     */
+    void endSubmit(int64_t nowNs);
+
+    /**
+     * @brief A scanout has been scheduled. Thread-safe.
+     */
+    void recordPresent() {
+        presents_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the timing of the most recently submitted frame.
+     */
+    FrameTiming const& getLastFrame() const noexcept { return last_; }
+
+    /**
+     * @brief Get the running totals.
+     */
+    FrameCounters getCounters() const noexcept {
+        FrameCounters counters = counters_;
+        counters.presents = presents_.load(std::memory_order_relaxed);
+        return counters;
+    }
+
+  private:
+    //! Timing of the frame being rendered.
+    FrameTiming current_;
+    //! Timing of the last frame submitted.
+    FrameTiming last_;
+    FrameCounters counters_;
+    std::atomic<uint64_t> presents_{0};
+
+    int64_t waitBeginNs_ = 0;
+    int64_t renderBeginNs_ = 0;
+    int64_t submitBeginNs_ = 0;
+    int64_t targetVBlankNs_ = 0;
+    //! vblankCount passed to the previous endWait(), or 0 before the first.
+    uint64_t lastVBlankCount_ = 0;
+};
+
+}  // namespace metaview
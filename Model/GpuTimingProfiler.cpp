@@ -0,0 +1,33 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#include "GpuTimingProfiler.h"
+
+#include <stdexcept>
+#include <utility>
+
+namespace metaview {
+
+GpuTimingProfiler::GpuTimingProfiler(ITimestampQuerySource& source,
+                                     size_t depth, size_t numPoints,
+                                     std::vector<GpuTimingScope> scopes,
+                                     size_t window)
+    : ring_(source, depth, numPoints),
+      scopes_(std::move(scopes)),
+      stats_(scopes_.size(), RollingStats(window)) {
+    for (auto const& scope : scopes_) {
+        if (scope.from >= numPoints || scope.to >= numPoints) {
+            throw std::invalid_argument("GPU timing scope out of range");
+        }
+    }
+}
+
+void GpuTimingProfiler::clearStats() {
+    for (auto& stats : stats_) {
+        stats.clear();
+    }
+}
+
+}  // namespace metaview
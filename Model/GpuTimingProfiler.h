@@ -0,0 +1,96 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include "RollingStats.h"
+#include "TimestampQueryRing.h"
+
+#include <vector>
+
+namespace metaview {
+
+/**
+ * @brief A span of GPU work between two timestamps of a frame.
+ */
+struct GpuTimingScope {
+    size_t from;
+    size_t to;
+};
+
+/**
+ * @brief Per-frame GPU timing of a few scopes, with rolling statistics.
+ *
+ * Wraps a TimestampQueryRing: the caller marks timestamps through the frame,
+ * and collect() turns the frames that have come back into per-scope
+ * durations. Never waits on the GPU.
+ *
+ * Single threaded.
+ */
+class GpuTimingProfiler {
+  public:
+    /**
+     * @brief Construct a new GPU Timing Profiler object
+     *
+     * @param source Query backend with at least @p depth slots of
+     * @p numPoints timestamps. Must outlive this object.
+     * @param depth Number of frames that may be in flight.
+     * @param numPoints Timestamps per frame.
+     * @param scopes Spans to measure, by timestamp index.
+     * @param window Number of frames the statistics cover.
+     */
+    GpuTimingProfiler(ITimestampQuerySource& source, size_t depth,
+                      size_t numPoints, std::vector<GpuTimingScope> scopes,
+                      size_t window = 120);
+
+    bool beginFrame() { return ring_.beginFrame(); }
+    void mark(size_t point) { ring_.mark(point); }
+    void endFrame() { ring_.endFrame(); }
+
+    /**
+     * @brief Read back finished frames and add their durations to the
+     * statistics.
+     *
+     * @param onSample Called as onSample(scopeIndex, milliseconds) for every
+     * scope measured in every frame collected, oldest frame first.
+     * @return number of frames collected.
+     */
+    template <typename F> size_t collect(F&& onSample) {
+        return ring_.collect([&](TimestampFrame const& frame) {
+            for (size_t i = 0; i < scopes_.size(); ++i) {
+                const double ms = frame.elapsedMs(scopes_[i].from,
+                                                  scopes_[i].to);
+                if (ms < 0) {
+                    continue;
+                }
+                stats_[i].add(ms);
+                onSample(i, ms);
+            }
+        });
+    }
+
+    /**
+     * @brief Get the statistics of a scope over the recent frames.
+     */
+    RollingSummary getSummary(size_t scope) const {
+        return stats_[scope].summarize();
+    }
+
+    size_t getNumScopes() const noexcept { return scopes_.size(); }
+
+    TimestampQueryRing const& getRing() const noexcept { return ring_; }
+
+    /**
+     * @brief Forget the statistics (e.g. after a mode change).
+     */
+    void clearStats();
+
+  private:
+    TimestampQueryRing ring_;
+    std::vector<GpuTimingScope> scopes_;
+    std::vector<RollingStats> stats_;
+};
+
+}  // namespace metaview
@@ -0,0 +1,102 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#include "OcclusionMesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace metaview {
+
+static constexpr float Pi = 3.14159265358979f;
+
+//! Distance from the contour's center to its edge, along a unit direction.
+static float contourRadius(LensContour const& contour, float dx, float dy) {
+    const float e = contour.exponent;
+    const float sum = std::pow(std::abs(dx) / contour.radiusX, e) +
+                      std::pow(std::abs(dy) / contour.radiusY, e);
+    return std::pow(sum, -1.f / e);
+}
+
+//! Distance from a point inside the view to its edge, along a unit direction.
+static float edgeDistance(EyeFov const& fov, float x, float y, float dx,
+                          float dy) {
+    float t = std::numeric_limits<float>::max();
+    if (dx > 0.f) {
+        t = std::min(t, (fov.right - x) / dx);
+    } else if (dx < 0.f) {
+        t = std::min(t, (fov.left - x) / dx);
+    }
+    if (dy > 0.f) {
+        t = std::min(t, (fov.top - y) / dy);
+    } else if (dy < 0.f) {
+        t = std::min(t, (fov.bottom - y) / dy);
+    }
+    return t;
+}
+
+bool buildOcclusionMesh(EyeFov const& fov, LensContour const& contour,
+                        uint32_t segments, OcclusionMesh& out) {
+    out.vertices.clear();
+    out.indices.clear();
+    const float width = fov.right - fov.left;
+    const float height = fov.top - fov.bottom;
+    if (!(contour.radiusX > 0.f && contour.radiusY > 0.f &&
+          contour.exponent > 0.f && width > 0.f && height > 0.f) ||
+        segments < 3) {
+        return false;
+    }
+    // Sample by angle around the center, so it must be inside the view
+    const float cx = std::min(std::max(contour.centerX, fov.left + 1e-4f * width),
+                              fov.right - 1e-4f * width);
+    const float cy =
+        std::min(std::max(contour.centerY, fov.bottom + 1e-4f * height),
+                 fov.top - 1e-4f * height);
+
+    std::vector<float> angles;
+    angles.reserve(segments + 4);
+    for (uint32_t i = 0; i < segments; ++i) {
+        angles.push_back(2.f * Pi * static_cast<float>(i) / segments);
+    }
+    for (float x : {fov.left, fov.right}) {
+        for (float y : {fov.bottom, fov.top}) {
+            float angle = std::atan2(y - cy, x - cx);
+            angles.push_back(angle < 0.f ? angle + 2.f * Pi : angle);
+        }
+    }
+    std::sort(angles.begin(), angles.end());
+
+    // An inner (contour) and outer (view edge) vertex per angle
+    bool hidesAnything = false;
+    for (float angle : angles) {
+        const float dx = std::cos(angle);
+        const float dy = std::sin(angle);
+        const float edge = edgeDistance(fov, cx, cy, dx, dy);
+        const float inner = std::min(contourRadius(contour, dx, dy), edge);
+        hidesAnything = hidesAnything || inner < edge;
+        for (float r : {inner, edge}) {
+            out.vertices.push_back({(cx + r * dx - fov.left) / width,
+                                    (cy + r * dy - fov.bottom) / height});
+        }
+    }
+    if (!hidesAnything) {
+        out.vertices.clear();
+        return false;
+    }
+
+    const uint32_t count = static_cast<uint32_t>(angles.size());
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint32_t inner = 2 * i;
+        const uint32_t outer = inner + 1;
+        const uint32_t nextInner = 2 * ((i + 1) % count);
+        const uint32_t nextOuter = nextInner + 1;
+        out.indices.insert(out.indices.end(), {inner, outer, nextOuter, inner,
+                                               nextOuter, nextInner});
+    }
+    return true;
+}
+
+}  // namespace metaview
@@ -0,0 +1,62 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include "Reprojection.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace metaview {
+
+/**
+ * @brief The part of an eye's view the optics actually show: a superellipse
+ * in the same tangent space as EyeFov,
+ * |x - centerX|^e / radiusX^e + |y - centerY|^e / radiusY^e <= 1.
+ */
+struct LensContour {
+    float centerX = 0.f;
+    float centerY = 0.f;
+    //! Zero for no contour: the whole view is visible.
+    float radiusX = 0.f;
+    float radiusY = 0.f;
+    //! 2 for an ellipse, larger for squarer corners.
+    float exponent = 2.f;
+};
+
+/**
+ * @brief A point of an occlusion mesh, in viewport coordinates: 0 to 1, origin
+ * bottom left.
+ */
+struct OcclusionMeshVertex {
+    float x;
+    float y;
+};
+
+/**
+ * @brief Triangles covering the part of an eye's view to leave unshaded.
+ */
+struct OcclusionMesh {
+    std::vector<OcclusionMeshVertex> vertices;
+    std::vector<uint32_t> indices;
+};
+
+/**
+ * @brief Build the hidden area mesh of an eye: the part of @p fov outside
+ * @p contour, as a strip between the contour and the edge of the view.
+ *
+ * The contour is sampled at @p segments points around its center, plus one
+ * toward each corner of the view so the strip reaches them. Vertex and index
+ * counts depend only on @p segments, so a mesh registered with the graphics
+ * API can be updated in place when the parameters change. Triangles wind
+ * counter-clockwise in the viewport.
+ *
+ * @return false, and an empty mesh, if the contour hides nothing.
+ */
+bool buildOcclusionMesh(EyeFov const& fov, LensContour const& contour,
+                        uint32_t segments, OcclusionMesh& out);
+
+}  // namespace metaview
@@ -0,0 +1,162 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#include "PoseHistory.h"
+
+#include <algorithm>
+
+namespace metaview {
+
+//! How many times a lookup starts over after racing with the writer.
+static constexpr int MaxReadAttempts = 4;
+
+static size_t roundUpToPowerOfTwo(size_t n) {
+    size_t ret = 1;
+    while (ret < n) {
+        ret <<= 1;
+    }
+    return ret;
+}
+
+static Vec3f lerp(Vec3f const& a, Vec3f const& b, float t) {
+    return a + (b - a) * t;
+}
+
+PoseSample interpolate(PoseSample const& a, PoseSample const& b, float t) {
+    PoseSample ret;
+    const double span = static_cast<double>(b.timeNs - a.timeNs);
+    ret.timeNs = a.timeNs + static_cast<int64_t>(static_cast<double>(t) * span);
+    ret.pose.orientation = slerp(a.pose.orientation, b.pose.orientation, t);
+    ret.pose.position = lerp(a.pose.position, b.pose.position, t);
+    ret.linearVelocity = lerp(a.linearVelocity, b.linearVelocity, t);
+    ret.angularVelocity = lerp(a.angularVelocity, b.angularVelocity, t);
+    return ret;
+}
+
+PoseSample extrapolate(PoseSample const& sample, int64_t timeNs) {
+    const float dt = static_cast<float>(timeNs - sample.timeNs) * 1e-9f;
+    PoseSample ret = sample;
+    ret.timeNs = timeNs;
+    ret.pose.position = sample.pose.position + sample.linearVelocity * dt;
+    // Angular velocity is in the pose's space, so it applies on the left
+    ret.pose.orientation =
+        normalize(fromRotationVector(sample.angularVelocity * dt) *
+                  sample.pose.orientation);
+    return ret;
+}
+
+PoseHistory::PoseHistory(size_t capacity, int64_t maxExtrapolationNs)
+    : capacity_(roundUpToPowerOfTwo(std::max<size_t>(capacity, 2))),
+      mask_(capacity_ - 1),
+      maxExtrapolationNs_(std::max<int64_t>(maxExtrapolationNs, 0)),
+      slots_(new Slot[capacity_]) {}
+
+bool PoseHistory::push(PoseSample const& sample) {
+    const uint64_t index = count_.load(std::memory_order_relaxed);
+    if (index > begin_.load(std::memory_order_relaxed) &&
+        sample.timeNs <= newestTimeNs_) {
+        return false;
+    }
+    Slot& slot = slots_[index & mask_];
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.sample.store(sample);
+    slot.sequence.store(2 * (index + 1), std::memory_order_release);
+    newestTimeNs_ = sample.timeNs;
+    count_.store(index + 1, std::memory_order_release);
+    return true;
+}
+
+void PoseHistory::clear() noexcept {
+    begin_.store(count_.load(std::memory_order_relaxed),
+                 std::memory_order_release);
+}
+
+bool PoseHistory::read(uint64_t index, PoseSample& out) const {
+    Slot const& slot = slots_[index & mask_];
+    const uint64_t expected = 2 * (index + 1);
+    if (slot.sequence.load(std::memory_order_acquire) != expected) {
+        return false;
+    }
+    slot.sample.load(out);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.sequence.load(std::memory_order_relaxed) == expected;
+}
+
+bool PoseHistory::newest(PoseSample& out) const {
+    for (int attempt = 0; attempt < MaxReadAttempts; ++attempt) {
+        const uint64_t end = count_.load(std::memory_order_acquire);
+        if (end <= begin_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        if (read(end - 1, out)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PoseHistory::sample(int64_t timeNs, PoseSample& out) const {
+    for (int attempt = 0; attempt < MaxReadAttempts; ++attempt) {
+        const uint64_t end = count_.load(std::memory_order_acquire);
+        uint64_t first = begin_.load(std::memory_order_acquire);
+        if (end > capacity_) {
+            first = std::max<uint64_t>(first, end - capacity_);
+        }
+        if (first >= end) {
+            return false;
+        }
+
+        PoseSample hi;
+        if (!read(end - 1, hi)) {
+            continue;
+        }
+        if (timeNs >= hi.timeNs) {
+            out = extrapolate(
+                hi, std::min(timeNs, hi.timeNs + maxExtrapolationNs_));
+            return true;
+        }
+        PoseSample lo;
+        if (!read(first, lo)) {
+            continue;
+        }
+        if (timeNs <= lo.timeNs) {
+            out = lo;
+            return true;
+        }
+
+        // Narrow down to adjacent samples with lo <= timeNs < hi
+        uint64_t loIndex = first;
+        uint64_t hiIndex = end - 1;
+        bool raced = false;
+        while (hiIndex - loIndex > 1) {
+            const uint64_t mid = loIndex + (hiIndex - loIndex) / 2;
+            PoseSample midSample;
+            if (!read(mid, midSample)) {
+                raced = true;
+                break;
+            }
+            if (midSample.timeNs <= timeNs) {
+                loIndex = mid;
+                lo = midSample;
+            } else {
+                hiIndex = mid;
+                hi = midSample;
+            }
+        }
+        if (raced) {
+            continue;
+        }
+        const float t = static_cast<float>(
+            static_cast<double>(timeNs - lo.timeNs) /
+            static_cast<double>(hi.timeNs - lo.timeNs));
+        out = interpolate(lo, hi, t);
+        out.timeNs = timeNs;
+        return true;
+    }
+    return false;
+}
+
+}  // namespace metaview
@@ -0,0 +1,136 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include "PoseMath.h"
+#include "SeqLock.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace metaview {
+
+/**
+ * @brief A tracked pose at a point in time, with its derivatives.
+ */
+struct PoseSample {
+    //! Time the pose was valid at, in SteadyClock nanoseconds.
+    int64_t timeNs = 0;
+    Posef pose;
+    //! Meters per second, in the same space as the pose.
+    Vec3f linearVelocity;
+    //! Rotation vector per second (radians), in the same space as the pose.
+    Vec3f angularVelocity;
+};
+
+/**
+ * @brief Fixed-capacity history of one device's poses, queryable at any time.
+ *
+ * Lookups between two samples interpolate (slerp for orientation, linear for
+ * the rest); lookups past the newest sample extrapolate along its velocities,
+ * for at most a bounded time. Lookups before the oldest sample get the oldest
+ * sample. Finding the samples around a time is a binary search.
+ *
+ * Lock-free: exactly one thread may call push(), while any number of threads
+ * call sample(). Neither blocks or allocates. Each slot carries a sequence
+ * number, so a reader that races with the writer overwriting a slot notices
+ * and retries, and keeps its sample as AtomicWords, as SeqLock does, so the
+ * racing copy itself is harmless.
+ */
+class PoseHistory {
+  public:
+    /**
+     * @brief Construct a new Pose History object
+     *
+     * @param capacity Minimum number of samples kept. Rounded up to a power of
+     * two.
+     * @param maxExtrapolationNs How far past the newest sample lookups may
+     * extrapolate. Later times get the pose at this limit.
+     */
+    explicit PoseHistory(size_t capacity = 256,
+                         int64_t maxExtrapolationNs = 50'000'000);
+
+    PoseHistory(PoseHistory const&) = delete;
+    PoseHistory& operator=(PoseHistory const&) = delete;
+
+    /**
+     * @brief Add a sample, evicting the oldest if full. Writer thread only.
+     *
+     * Samples must come in increasing time order: ones not newer than the
+     * newest sample are dropped.
+     *
+     * @return false if the sample was dropped.
+     */
+    bool push(PoseSample const& sample);
+
+    /**
+     * @brief Get the pose at a time. Any thread.
+     *
+     * @return false if the history is empty, or the writer kept overwriting
+     * the samples needed (only possible if it is far ahead of this reader).
+     */
+    bool sample(int64_t timeNs, PoseSample& out) const;
+
+    /**
+     * @brief Get the newest sample. Any thread.
+     *
+     * @return false if the history is empty.
+     */
+    bool newest(PoseSample& out) const;
+
+    /**
+     * @brief Forget all samples. Writer thread only, and readers see a
+     * snapshot as usual.
+     */
+    void clear() noexcept;
+
+    size_t capacity() const noexcept { return capacity_; }
+
+    int64_t getMaxExtrapolation() const noexcept { return maxExtrapolationNs_; }
+
+  private:
+    struct Slot {
+        //! 2 * (index + 1) once sample number index is written, odd while
+        //! being written.
+        std::atomic<uint64_t> sequence{0};
+        AtomicWords<PoseSample> sample;
+    };
+
+    /**
+     * @brief Copy sample number @p index out of its slot.
+     *
+     * @return false if the slot no longer (or doesn't yet) hold that sample.
+     */
+    bool read(uint64_t index, PoseSample& out) const;
+
+    size_t capacity_;
+    size_t mask_;
+    int64_t maxExtrapolationNs_;
+    std::unique_ptr<Slot[]> slots_;
+    //! Samples pushed since construction, counting evicted ones.
+    std::atomic<uint64_t> count_{0};
+    //! Index of the oldest sample not cleared. Written by the writer only.
+    std::atomic<uint64_t> begin_{0};
+    //! Time of the newest sample pushed. Writer only.
+    int64_t newestTimeNs_ = 0;
+};
+
+/**
+ * @brief Interpolate between two samples: slerp for orientation, linear for
+ * the rest.
+ *
+ * @param t 0 for @p a, 1 for @p b.
+ */
+PoseSample interpolate(PoseSample const& a, PoseSample const& b, float t);
+
+/**
+ * @brief Move a sample along its velocities to a later (or earlier) time.
+ */
+PoseSample extrapolate(PoseSample const& sample, int64_t timeNs);
+
+}  // namespace metaview
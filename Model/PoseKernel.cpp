@@ -0,0 +1,185 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#include "PoseKernel.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define METAVIEW_POSE_KERNEL_SSE
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define METAVIEW_POSE_KERNEL_NEON
+#include <arm_neon.h>
+#endif
+
+namespace metaview {
+
+static inline void transformPose(Posef const& pose, Vec3f const& offset,
+                                 Posef& out) {
+    const Quatf orientation = normalize(pose.orientation);
+    const Vec3f position = pose.position + rotate(orientation, offset);
+    out.orientation = orientation;
+    out.position = position;
+}
+
+void transformPosesScalar(Posef const* poses, Vec3f const* offsets,
+                          Posef* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        transformPose(poses[i], offsets[i], out[i]);
+    }
+}
+
+#if defined(METAVIEW_POSE_KERNEL_SSE) || defined(METAVIEW_POSE_KERNEL_NEON)
+
+namespace {
+
+// Just enough of a four lane float type for the kernel, so it is written once
+// for both instruction sets. Wrapped in a struct since the native types can't
+// all carry operators.
+#ifdef METAVIEW_POSE_KERNEL_SSE
+struct Lanes {
+    __m128 v;
+};
+using Mask = __m128;
+
+inline Lanes load4(float const* p) { return {_mm_loadu_ps(p)}; }
+inline void store4(float* p, Lanes a) { _mm_storeu_ps(p, a.v); }
+//! x, y, z, 0: a Vec3f, without reading past it
+inline Lanes load3(float const* p) {
+    const __m128 xy =
+        _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<__m64 const*>(p));
+    return {_mm_movelh_ps(xy, _mm_load_ss(p + 2))};
+}
+inline void store3(float* p, Lanes a) {
+    _mm_storel_pi(reinterpret_cast<__m64*>(p), a.v);
+    _mm_store_ss(p + 2, _mm_movehl_ps(a.v, a.v));
+}
+inline void transpose(Lanes& a, Lanes& b, Lanes& c, Lanes& d) {
+    _MM_TRANSPOSE4_PS(a.v, b.v, c.v, d.v);
+}
+inline Lanes splat(float f) { return {_mm_set1_ps(f)}; }
+inline Lanes operator+(Lanes a, Lanes b) { return {_mm_add_ps(a.v, b.v)}; }
+inline Lanes operator-(Lanes a, Lanes b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline Lanes operator*(Lanes a, Lanes b) { return {_mm_mul_ps(a.v, b.v)}; }
+inline Lanes operator/(Lanes a, Lanes b) { return {_mm_div_ps(a.v, b.v)}; }
+inline Lanes sqrt(Lanes a) { return {_mm_sqrt_ps(a.v)}; }
+//! Lanes where !(a <= b), so NaN lanes count, as in normalize()
+inline Mask notLessEqual(Lanes a, Lanes b) {
+    return _mm_cmpnle_ps(a.v, b.v);
+}
+inline Lanes select(Mask m, Lanes a, Lanes b) {
+    return {_mm_or_ps(_mm_and_ps(m, a.v), _mm_andnot_ps(m, b.v))};
+}
+#else
+struct Lanes {
+    float32x4_t v;
+};
+using Mask = uint32x4_t;
+
+inline Lanes load4(float const* p) { return {vld1q_f32(p)}; }
+inline void store4(float* p, Lanes a) { vst1q_f32(p, a.v); }
+//! x, y, z, 0: a Vec3f, without reading past it
+inline Lanes load3(float const* p) {
+    return {vcombine_f32(vld1_f32(p), vld1_lane_f32(p + 2, vdup_n_f32(0), 0))};
+}
+inline void store3(float* p, Lanes a) {
+    vst1_f32(p, vget_low_f32(a.v));
+    vst1q_lane_f32(p + 2, a.v, 2);
+}
+inline void transpose(Lanes& a, Lanes& b, Lanes& c, Lanes& d) {
+    const float32x4x2_t ab = vtrnq_f32(a.v, b.v);
+    const float32x4x2_t cd = vtrnq_f32(c.v, d.v);
+    a.v = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+    b.v = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+    c.v = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+    d.v = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+}
+inline Lanes splat(float f) { return {vdupq_n_f32(f)}; }
+inline Lanes operator+(Lanes a, Lanes b) { return {vaddq_f32(a.v, b.v)}; }
+inline Lanes operator-(Lanes a, Lanes b) { return {vsubq_f32(a.v, b.v)}; }
+inline Lanes operator*(Lanes a, Lanes b) { return {vmulq_f32(a.v, b.v)}; }
+inline Lanes operator/(Lanes a, Lanes b) { return {vdivq_f32(a.v, b.v)}; }
+inline Lanes sqrt(Lanes a) { return {vsqrtq_f32(a.v)}; }
+inline Mask notLessEqual(Lanes a, Lanes b) {
+    return vmvnq_u32(vcleq_f32(a.v, b.v));
+}
+inline Lanes select(Mask m, Lanes a, Lanes b) {
+    return {vbslq_f32(m, a.v, b.v)};
+}
+#endif
+
+constexpr size_t Width = 4;
+
+//! Transform poses[0..3], a component per register throughout.
+inline void transformBlock(Posef const* poses, Vec3f const* offsets,
+                           Posef* out) {
+    Lanes qx = load4(&poses[0].orientation.x);
+    Lanes qy = load4(&poses[1].orientation.x);
+    Lanes qz = load4(&poses[2].orientation.x);
+    Lanes qw = load4(&poses[3].orientation.x);
+    transpose(qx, qy, qz, qw);
+    Lanes px = load3(&poses[0].position.x);
+    Lanes py = load3(&poses[1].position.x);
+    Lanes pz = load3(&poses[2].position.x);
+    Lanes pUnused = load3(&poses[3].position.x);
+    transpose(px, py, pz, pUnused);
+    Lanes ox = load3(&offsets[0].x);
+    Lanes oy = load3(&offsets[1].x);
+    Lanes oz = load3(&offsets[2].x);
+    Lanes oUnused = load3(&offsets[3].x);
+    transpose(ox, oy, oz, oUnused);
+
+    const Lanes zero = splat(0.f);
+    const Lanes norm2 = qx * qx + qy * qy + qz * qz + qw * qw;
+    const Mask nonZero = notLessEqual(norm2, zero);
+    // Zero lanes divide by zero here, then select identity instead
+    const Lanes invNorm = splat(1.f) / sqrt(norm2);
+    qx = select(nonZero, qx * invNorm, zero);
+    qy = select(nonZero, qy * invNorm, zero);
+    qz = select(nonZero, qz * invNorm, zero);
+    qw = select(nonZero, qw * invNorm, splat(1.f));
+
+    // rotate(): t = 2 (u x o), o' = o + w t + u x t
+    const Lanes two = splat(2.f);
+    const Lanes tx = (qy * oz - qz * oy) * two;
+    const Lanes ty = (qz * ox - qx * oz) * two;
+    const Lanes tz = (qx * oy - qy * ox) * two;
+    px = px + ox + qw * tx + (qy * tz - qz * ty);
+    py = py + oy + qw * ty + (qz * tx - qx * tz);
+    pz = pz + oz + qw * tz + (qx * ty - qy * tx);
+
+    transpose(qx, qy, qz, qw);
+    store4(&out[0].orientation.x, qx);
+    store4(&out[1].orientation.x, qy);
+    store4(&out[2].orientation.x, qz);
+    store4(&out[3].orientation.x, qw);
+    transpose(px, py, pz, pUnused);
+    store3(&out[0].position.x, px);
+    store3(&out[1].position.x, py);
+    store3(&out[2].position.x, pz);
+    store3(&out[3].position.x, pUnused);
+}
+
+}  // namespace
+
+void transformPoses(Posef const* poses, Vec3f const* offsets, Posef* out,
+                    size_t count) {
+    size_t i = 0;
+    for (; i + Width <= count; i += Width) {
+        transformBlock(poses + i, offsets + i, out + i);
+    }
+    transformPosesScalar(poses + i, offsets + i, out + i, count - i);
+}
+
+#else
+
+void transformPoses(Posef const* poses, Vec3f const* offsets, Posef* out,
+                    size_t count) {
+    transformPosesScalar(poses, offsets, out, count);
+}
+
+#endif
+
+}  // namespace metaview
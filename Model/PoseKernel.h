@@ -0,0 +1,49 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include "PoseMath.h"
+
+#include <cstddef>
+
+namespace metaview {
+
+/**
+ * @brief Offset a batch of poses in their own frames: out[i] is poses[i] *
+ * Posef{identity, offsets[i]}, e.g. an eye pose from a head pose and the eye's
+ * offset from the head.
+ *
+ * Orientations are normalized on the way (an all-zero one, as an untracked
+ * pose may carry, becomes identity), so rotation and translation come out
+ * without ever building a matrix. Runs four poses at a time with SSE or NEON
+ * where available. @p out may be @p poses.
+ */
+void transformPoses(Posef const* poses, Vec3f const* offsets, Posef* out,
+                    size_t count);
+
+/**
+ * @brief transformPoses() one pose at a time in plain C++: the reference the
+ * SIMD path is checked and benchmarked against.
+ */
+void transformPosesScalar(Posef const* poses, Vec3f const* offsets,
+                          Posef* out, size_t count);
+
+/**
+ * @brief Mirror a pose along z, between right-handed tracking space and
+ * Unity's left-handed space; its own inverse.
+ *
+ * The orientation's axis is mirrored like an angular velocity, (-x, -y, z),
+ * so the mirrored orientation turns a mirrored offset into the mirrored
+ * result: an eye offset applied on either side of the mirror lands in the
+ * same place.
+ */
+inline Posef mirrorZ(Posef const& pose) {
+    return {{-pose.orientation.x, -pose.orientation.y, pose.orientation.z,
+             pose.orientation.w},
+            {pose.position.x, pose.position.y, -pose.position.z}};
+}
+
+}  // namespace metaview
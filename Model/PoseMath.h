@@ -0,0 +1,208 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include <cmath>
+
+namespace metaview {
+
+/**
+ * @brief 3D vector of floats.
+ */
+struct Vec3f {
+    float x = 0.f;
+    float y = 0.f;
+    float z = 0.f;
+};
+
+inline Vec3f operator+(Vec3f const& a, Vec3f const& b) {
+    return {a.x + b.x, a.y + b.y, a.z + b.z};
+}
+
+inline Vec3f operator-(Vec3f const& a, Vec3f const& b) {
+    return {a.x - b.x, a.y - b.y, a.z - b.z};
+}
+
+inline Vec3f operator*(Vec3f const& v, float s) {
+    return {v.x * s, v.y * s, v.z * s};
+}
+
+inline float dot(Vec3f const& a, Vec3f const& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+inline Vec3f cross(Vec3f const& a, Vec3f const& b) {
+    return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z,
+            a.x * b.y - a.y * b.x};
+}
+
+/**
+ * @brief Rotation quaternion, identity by default.
+ */
+struct Quatf {
+    float x = 0.f;
+    float y = 0.f;
+    float z = 0.f;
+    float w = 1.f;
+};
+
+/**
+ * @brief Hamilton product: rotating by @p b, then by @p a.
+ */
+inline Quatf operator*(Quatf const& a, Quatf const& b) {
+    return {a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+            a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+            a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+            a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z};
+}
+
+inline float dot(Quatf const& a, Quatf const& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
+/**
+ * @brief Inverse of a unit quaternion.
+ */
+inline Quatf conjugate(Quatf const& q) { return {-q.x, -q.y, -q.z, q.w}; }
+
+inline Quatf normalize(Quatf const& q) {
+    const float norm = std::sqrt(dot(q, q));
+    if (norm <= 0.f) {
+        return Quatf{};
+    }
+    return {q.x / norm, q.y / norm, q.z / norm, q.w / norm};
+}
+
+/**
+ * @brief Rotate a vector by a unit quaternion.
+ */
+inline Vec3f rotate(Quatf const& q, Vec3f const& v) {
+    const Vec3f u{q.x, q.y, q.z};
+    const Vec3f t = cross(u, v) * 2.f;
+    return v + t * q.w + cross(u, t);
+}
+
+/**
+ * @brief Rotation of @p angle radians about a unit @p axis.
+ */
+inline Quatf fromAxisAngle(Vec3f const& axis, float angle) {
+    const float s = std::sin(angle / 2.f);
+    return {axis.x * s, axis.y * s, axis.z * s, std::cos(angle / 2.f)};
+}
+
+/**
+ * @brief Rotation vector (axis times angle) to quaternion, as used to
+ * integrate an angular velocity over a time step.
+ */
+inline Quatf fromRotationVector(Vec3f const& v) {
+    const float angle = std::sqrt(dot(v, v));
+    if (angle < 1e-9f) {
+        return normalize(Quatf{v.x / 2.f, v.y / 2.f, v.z / 2.f, 1.f});
+    }
+    return fromAxisAngle(v * (1.f / angle), angle);
+}
+
+/**
+ * @brief Spherical linear interpolation between unit quaternions, along the
+ * shorter arc.
+ */
+inline Quatf slerp(Quatf const& a, Quatf b, float t) {
+    float cosTheta = dot(a, b);
+    if (cosTheta < 0.f) {
+        b = {-b.x, -b.y, -b.z, -b.w};
+        cosTheta = -cosTheta;
+    }
+    float wa, wb;
+    if (cosTheta > 0.9995f) {
+        // Nearly parallel: lerp is accurate and avoids dividing by ~0
+        wa = 1.f - t;
+        wb = t;
+    } else {
+        const float theta = std::acos(cosTheta);
+        const float sinTheta = std::sin(theta);
+        wa = std::sin((1.f - t) * theta) / sinTheta;
+        wb = std::sin(t * theta) / sinTheta;
+    }
+    return normalize({wa * a.x + wb * b.x, wa * a.y + wb * b.y,
+                      wa * a.z + wb * b.z, wa * a.w + wb * b.w});
+}
+
+/**
+ * @brief Rigid transform: rotation, then translation.
+ */
+struct Posef {
+    Quatf orientation;
+    Vec3f position;
+};
+
+/**
+ * @brief Compose poses: the result maps like applying @p b, then @p a.
+ */
+inline Posef operator*(Posef const& a, Posef const& b) {
+    return {a.orientation * b.orientation,
+            a.position + rotate(a.orientation, b.position)};
+}
+
+inline Posef inverse(Posef const& p) {
+    const Quatf inv = conjugate(p.orientation);
+    return {inv, rotate(inv, p.position) * -1.f};
+}
+
+/**
+ * @brief Row-major 3x3 matrix of floats.
+ */
+struct Mat3f {
+    float m[3][3] = {{1.f, 0.f, 0.f}, {0.f, 1.f, 0.f}, {0.f, 0.f, 1.f}};
+};
+
+inline Mat3f operator*(Mat3f const& a, Mat3f const& b) {
+    Mat3f ret;
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) {
+            ret.m[r][c] = a.m[r][0] * b.m[0][c] + a.m[r][1] * b.m[1][c] +
+                          a.m[r][2] * b.m[2][c];
+        }
+    }
+    return ret;
+}
+
+inline Vec3f operator*(Mat3f const& a, Vec3f const& v) {
+    return {a.m[0][0] * v.x + a.m[0][1] * v.y + a.m[0][2] * v.z,
+            a.m[1][0] * v.x + a.m[1][1] * v.y + a.m[1][2] * v.z,
+            a.m[2][0] * v.x + a.m[2][1] * v.y + a.m[2][2] * v.z};
+}
+
+inline Mat3f transpose(Mat3f const& a) {
+    Mat3f ret;
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) {
+            ret.m[r][c] = a.m[c][r];
+        }
+    }
+    return ret;
+}
+
+/**
+ * @brief Rotation matrix of a unit quaternion.
+ */
+inline Mat3f toMatrix(Quatf const& q) {
+    const float x2 = q.x * q.x, y2 = q.y * q.y, z2 = q.z * q.z;
+    const float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    const float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+    Mat3f ret;
+    ret.m[0][0] = 1.f - 2.f * (y2 + z2);
+    ret.m[0][1] = 2.f * (xy - wz);
+    ret.m[0][2] = 2.f * (xz + wy);
+    ret.m[1][0] = 2.f * (xy + wz);
+    ret.m[1][1] = 1.f - 2.f * (x2 + z2);
+    ret.m[1][2] = 2.f * (yz - wx);
+    ret.m[2][0] = 2.f * (xz - wy);
+    ret.m[2][1] = 2.f * (yz + wx);
+    ret.m[2][2] = 1.f - 2.f * (x2 + y2);
+    return ret;
+}
+
+}  // namespace metaview
@@ -0,0 +1,253 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#include "PosePredictor.h"
+
+#include <algorithm>
+
+namespace metaview {
+
+//! Samples further apart than this restart prediction from scratch.
+static constexpr int64_t MaxSampleGapNs = 250'000'000;
+
+//! Variance of the (unmeasured) initial acceleration estimates.
+static constexpr double InitialAccelerationVariance = 100.0;
+
+static constexpr double NsToSeconds = 1e-9;
+
+static float component(Vec3f const& v, int axis) {
+    return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+static int64_t clampPredictionTime(int64_t timeNs, int64_t lastNs,
+                                   int64_t maxPredictionNs) {
+    return std::min(std::max(timeNs, lastNs), lastNs + maxPredictionNs);
+}
+
+KalmanPosePredictor::KalmanPosePredictor(
+    KalmanPosePredictorConfig const& config)
+    : config_(config) {}
+
+void KalmanPosePredictor::reset() { initialized_ = false; }
+
+void KalmanPosePredictor::updatePosition(AccelerationAxis& axis, double dt,
+                                         double position,
+                                         double velocity) const {
+    // Predict: x = F x, P = F P F' + Q
+    const double f[3][3] = {{1, dt, dt * dt / 2}, {0, 1, dt}, {0, 0, 1}};
+    const double x[3] = {axis.x[0] + axis.x[1] * dt + axis.x[2] * dt * dt / 2,
+                         axis.x[1] + axis.x[2] * dt, axis.x[2]};
+    double fp[3][3] = {};
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            for (int k = 0; k < 3; ++k) {
+                fp[i][j] += f[i][k] * axis.p[k][j];
+            }
+        }
+    }
+    const double dt2 = dt * dt;
+    const double dt3 = dt2 * dt;
+    const double q = config_.positionProcessNoise;
+    const double noise[3][3] = {
+        {q * dt3 * dt2 / 20, q * dt2 * dt2 / 8, q * dt3 / 6},
+        {q * dt2 * dt2 / 8, q * dt3 / 3, q * dt2 / 2},
+        {q * dt3 / 6, q * dt2 / 2, q * dt}};
+    double p[3][3];
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            p[i][j] = noise[i][j];
+            for (int k = 0; k < 3; ++k) {
+                p[i][j] += fp[i][k] * f[j][k];
+            }
+        }
+    }
+
+    // Correct with the measured position and velocity: H selects x[0], x[1]
+    const double s00 = p[0][0] + config_.positionMeasurementNoise;
+    const double s01 = p[0][1];
+    const double s10 = p[1][0];
+    const double s11 = p[1][1] + config_.velocityMeasurementNoise;
+    const double det = s00 * s11 - s01 * s10;
+    if (det <= 0) {
+        return;
+    }
+    const double inv[2][2] = {{s11 / det, -s01 / det},
+                              {-s10 / det, s00 / det}};
+    const double y[2] = {position - x[0], velocity - x[1]};
+    double gain[3][2];
+    for (int i = 0; i < 3; ++i) {
+        gain[i][0] = p[i][0] * inv[0][0] + p[i][1] * inv[1][0];
+        gain[i][1] = p[i][0] * inv[0][1] + p[i][1] * inv[1][1];
+        axis.x[i] = x[i] + gain[i][0] * y[0] + gain[i][1] * y[1];
+    }
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            axis.p[i][j] =
+                p[i][j] - gain[i][0] * p[0][j] - gain[i][1] * p[1][j];
+        }
+    }
+}
+
+void KalmanPosePredictor::updateRate(RateAxis& axis, double dt,
+                                     double rate) const {
+    // Predict
+    const double x[2] = {axis.x[0] + axis.x[1] * dt, axis.x[1]};
+    const double q = config_.angularProcessNoise;
+    const double dt2 = dt * dt;
+    const double p00 = axis.p[0][0] + dt * (axis.p[1][0] + axis.p[0][1]) +
+                       dt2 * axis.p[1][1] + q * dt2 * dt / 3;
+    const double p01 = axis.p[0][1] + dt * axis.p[1][1] + q * dt2 / 2;
+    const double p10 = axis.p[1][0] + dt * axis.p[1][1] + q * dt2 / 2;
+    const double p11 = axis.p[1][1] + q * dt;
+
+    // Correct with the measured rate
+    const double s = p00 + config_.angularVelocityMeasurementNoise;
+    const double k0 = p00 / s;
+    const double k1 = p10 / s;
+    const double y = rate - x[0];
+    axis.x[0] = x[0] + k0 * y;
+    axis.x[1] = x[1] + k1 * y;
+    axis.p[0][0] = p00 - k0 * p00;
+    axis.p[0][1] = p01 - k0 * p01;
+    axis.p[1][0] = p10 - k1 * p00;
+    axis.p[1][1] = p11 - k1 * p01;
+}
+
+void KalmanPosePredictor::update(PoseSample const& sample) {
+    if (initialized_ && sample.timeNs <= last_.timeNs) {
+        return;
+    }
+    if (initialized_ && sample.timeNs - last_.timeNs > MaxSampleGapNs) {
+        initialized_ = false;
+    }
+    if (!initialized_) {
+        for (int i = 0; i < 3; ++i) {
+            position_[i] = {};
+            position_[i].x[0] = component(sample.pose.position, i);
+            position_[i].x[1] = component(sample.linearVelocity, i);
+            position_[i].p[0][0] = config_.positionMeasurementNoise;
+            position_[i].p[1][1] = config_.velocityMeasurementNoise;
+            position_[i].p[2][2] = InitialAccelerationVariance;
+            angular_[i] = {};
+            angular_[i].x[0] = component(sample.angularVelocity, i);
+            angular_[i].p[0][0] = config_.angularVelocityMeasurementNoise;
+            angular_[i].p[1][1] = InitialAccelerationVariance;
+        }
+        last_ = sample;
+        initialized_ = true;
+        return;
+    }
+    const double dt =
+        static_cast<double>(sample.timeNs - last_.timeNs) * NsToSeconds;
+    for (int i = 0; i < 3; ++i) {
+        updatePosition(position_[i], dt, component(sample.pose.position, i),
+                       component(sample.linearVelocity, i));
+        updateRate(angular_[i], dt, component(sample.angularVelocity, i));
+    }
+    last_ = sample;
+}
+
+bool KalmanPosePredictor::predict(int64_t timeNs, PoseSample& out) const {
+    if (!initialized_) {
+        return false;
+    }
+    const int64_t targetNs =
+        clampPredictionTime(timeNs, last_.timeNs, config_.maxPredictionNs);
+    const double dt =
+        static_cast<double>(targetNs - last_.timeNs) * NsToSeconds;
+    float position[3], velocity[3], rotation[3], rate[3];
+    for (int i = 0; i < 3; ++i) {
+        const double* x = position_[i].x;
+        position[i] = static_cast<float>(x[0] + x[1] * dt + x[2] * dt * dt / 2);
+        velocity[i] = static_cast<float>(x[1] + x[2] * dt);
+        const double* w = angular_[i].x;
+        rotation[i] = static_cast<float>(w[0] * dt + w[1] * dt * dt / 2);
+        rate[i] = static_cast<float>(w[0] + w[1] * dt);
+    }
+    out.timeNs = targetNs;
+    out.pose.position = {position[0], position[1], position[2]};
+    out.linearVelocity = {velocity[0], velocity[1], velocity[2]};
+    out.angularVelocity = {rate[0], rate[1], rate[2]};
+    // Angular velocity is in the pose's space, so it applies on the left
+    out.pose.orientation = normalize(
+        fromRotationVector({rotation[0], rotation[1], rotation[2]}) *
+        last_.pose.orientation);
+    return true;
+}
+
+DoubleExponentialPosePredictor::DoubleExponentialPosePredictor(
+    DoubleExponentialPosePredictorConfig const& config)
+    : config_(config) {}
+
+void DoubleExponentialPosePredictor::reset() { initialized_ = false; }
+
+void DoubleExponentialPosePredictor::update(PoseSample const& sample) {
+    if (initialized_ && sample.timeNs <= last_.timeNs) {
+        return;
+    }
+    if (initialized_ && sample.timeNs - last_.timeNs > MaxSampleGapNs) {
+        initialized_ = false;
+    }
+    if (!initialized_) {
+        position1_ = position2_ = sample.pose.position;
+        orientation1_ = orientation2_ = sample.pose.orientation;
+        intervalNs_ = 0;
+        last_ = sample;
+        initialized_ = true;
+        return;
+    }
+    const double interval = static_cast<double>(sample.timeNs - last_.timeNs);
+    intervalNs_ = intervalNs_ == 0
+                      ? interval
+                      : intervalNs_ + config_.intervalSmoothing *
+                                          (interval - intervalNs_);
+
+    const float a = static_cast<float>(config_.positionAlpha);
+    position1_ = sample.pose.position * a + position1_ * (1.f - a);
+    position2_ = position1_ * a + position2_ * (1.f - a);
+    const float b = static_cast<float>(config_.orientationAlpha);
+    orientation1_ = slerp(orientation1_, sample.pose.orientation, b);
+    orientation2_ = slerp(orientation2_, orientation1_, b);
+    last_ = sample;
+}
+
+bool DoubleExponentialPosePredictor::predict(int64_t timeNs,
+                                             PoseSample& out) const {
+    if (!initialized_) {
+        return false;
+    }
+    const int64_t targetNs =
+        clampPredictionTime(timeNs, last_.timeNs, config_.maxPredictionNs);
+    // Prediction horizon in sample steps
+    const double steps =
+        intervalNs_ > 0
+            ? static_cast<double>(targetNs - last_.timeNs) / intervalNs_
+            : 0.0;
+    out = last_;
+    out.timeNs = targetNs;
+
+    const double a = config_.positionAlpha;
+    const float kp = static_cast<float>(a * steps / (1 - a));
+    out.pose.position = position1_ * (2.f + kp) - position2_ * (1.f + kp);
+    const double b = config_.orientationAlpha;
+    const float kq = static_cast<float>(b * steps / (1 - b));
+    // (2 + k) q1 - (1 + k) q2, along the arc from q2 through q1
+    out.pose.orientation = slerp(orientation2_, orientation1_, 2.f + kq);
+    return true;
+}
+
+std::unique_ptr<IPosePredictor> makePosePredictor(PosePredictorType type) {
+    switch (type) {
+        case PosePredictorType::ConstantAccelerationKalman:
+            return std::make_unique<KalmanPosePredictor>();
+        case PosePredictorType::DoubleExponential:
+            return std::make_unique<DoubleExponentialPosePredictor>();
+        case PosePredictorType::None:
+        default:
+            return nullptr;
+    }
+}
+
+}  // namespace metaview
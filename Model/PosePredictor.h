@@ -0,0 +1,176 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include "PoseHistory.h"
+
+#include <cstdint>
+#include <memory>
+
+namespace metaview {
+
+/**
+ * @brief Predicts where a tracked device will be, from its recent samples.
+ *
+ * Implementations keep fixed-size state only: update() and predict() never
+ * allocate. Single threaded.
+ */
+class IPosePredictor {
+  public:
+    virtual ~IPosePredictor() = default;
+
+    /**
+     * @brief Feed a new sample. Samples not newer than the previous one are
+     * ignored.
+     */
+    virtual void update(PoseSample const& sample) = 0;
+
+    /**
+     * @brief Predict the pose at a time, typically when the frame being
+     * rendered will reach the display.
+     *
+     * @return false if no sample has been fed yet.
+     */
+    virtual bool predict(int64_t timeNs, PoseSample& out) const = 0;
+
+    /**
+     * @brief Forget all samples, e.g. after tracking was lost.
+     */
+    virtual void reset() = 0;
+};
+
+/**
+ * @brief The available prediction methods. Values are part of the managed
+ * API.
+ */
+enum class PosePredictorType : uint32_t {
+    //! No prediction: the latest sample is used as is.
+    None = 0,
+    //! KalmanPosePredictor
+    ConstantAccelerationKalman = 1,
+    //! DoubleExponentialPosePredictor
+    DoubleExponential = 2,
+};
+
+/**
+ * @brief Tuning parameters for a KalmanPosePredictor.
+ *
+ * Noise values are variances, in SI units (meters, radians, seconds).
+ */
+struct KalmanPosePredictorConfig {
+    //! Spectral density of the jerk driving the position model.
+    double positionProcessNoise = 200.0;
+
+    //! Variance of measured positions.
+    double positionMeasurementNoise = 1e-6;
+
+    //! Variance of measured linear velocities.
+    double velocityMeasurementNoise = 1e-3;
+
+    //! Spectral density of the angular jerk driving the rotation model.
+    double angularProcessNoise = 2000.0;
+
+    //! Variance of measured angular velocities.
+    double angularVelocityMeasurementNoise = 1e-3;
+
+    //! Predictions further than this past the newest sample are clamped.
+    int64_t maxPredictionNs = 50'000'000;
+};
+
+/**
+ * @brief Constant-acceleration Kalman filter on each axis of position and of
+ * angular velocity.
+ *
+ * Position state is (position, velocity, acceleration), measured by the
+ * sampled position and velocity. Rotation state is (angular velocity, angular
+ * acceleration), measured by the sampled angular velocity; predictions rotate
+ * the newest sampled orientation by the integrated rate.
+ */
+class KalmanPosePredictor : public IPosePredictor {
+  public:
+    explicit KalmanPosePredictor(KalmanPosePredictorConfig const& config = {});
+
+    void update(PoseSample const& sample) override;
+    bool predict(int64_t timeNs, PoseSample& out) const override;
+    void reset() override;
+
+  private:
+    //! (value, rate, rate of rate) along one axis.
+    struct AccelerationAxis {
+        double x[3] = {};
+        double p[3][3] = {};
+    };
+
+    //! (rate, rate of rate) along one axis.
+    struct RateAxis {
+        double x[2] = {};
+        double p[2][2] = {};
+    };
+
+    void updatePosition(AccelerationAxis& axis, double dt, double position,
+                        double velocity) const;
+    void updateRate(RateAxis& axis, double dt, double rate) const;
+
+    KalmanPosePredictorConfig config_;
+    bool initialized_ = false;
+    PoseSample last_;
+    AccelerationAxis position_[3];
+    RateAxis angular_[3];
+};
+
+/**
+ * @brief Tuning parameters for a DoubleExponentialPosePredictor.
+ */
+struct DoubleExponentialPosePredictorConfig {
+    //! Smoothing factor for position, in (0, 1): higher follows the samples
+    //! more closely but passes more noise. Suits samples at about 1 kHz.
+    double positionAlpha = 0.1;
+
+    //! Smoothing factor for orientation, in (0, 1).
+    double orientationAlpha = 0.5;
+
+    //! Weight of each new interval in the average sample interval.
+    double intervalSmoothing = 0.1;
+
+    //! Predictions further than this past the newest sample are clamped.
+    int64_t maxPredictionNs = 50'000'000;
+};
+
+/**
+ * @brief Double exponential smoothing prediction (LaViola 2003) of position
+ * and orientation quaternion.
+ *
+ * Cheaper than the Kalman filter and doesn't need velocities, but trails the
+ * samples a little while the motion changes. Prediction times are converted
+ * to sample steps with the average interval between samples.
+ */
+class DoubleExponentialPosePredictor : public IPosePredictor {
+  public:
+    explicit DoubleExponentialPosePredictor(
+        DoubleExponentialPosePredictorConfig const& config = {});
+
+    void update(PoseSample const& sample) override;
+    bool predict(int64_t timeNs, PoseSample& out) const override;
+    void reset() override;
+
+  private:
+    DoubleExponentialPosePredictorConfig config_;
+    bool initialized_ = false;
+    PoseSample last_;
+    double intervalNs_ = 0;
+    Vec3f position1_;
+    Vec3f position2_;
+    Quatf orientation1_;
+    Quatf orientation2_;
+};
+
+/**
+ * @brief Create a predictor of the given type, or nullptr for
+ * PosePredictorType::None.
+ */
+std::unique_ptr<IPosePredictor> makePosePredictor(PosePredictorType type);
+
+}  // namespace metaview
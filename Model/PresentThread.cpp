@@ -0,0 +1,73 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#include "PresentThread.h"
+
+namespace metaview {
+
+PresentThread::PresentThread(IPresentSink& sink, size_t capacity)
+    : sink_(sink), queue_(capacity) {
+    thread_ = std::thread([this] { threadFunc(); });
+}
+
+PresentThread::~PresentThread() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+void PresentThread::submit(PresentRecord const& record) {
+    if (!queue_.tryPush(record)) {
+        // The present thread signals drained_ each time it has emptied the
+        // queue, and we're the only one filling it
+        std::unique_lock<std::mutex> lock(mutex_);
+        drained_.wait(lock, [&] { return queue_.empty(); });
+        queue_.tryPush(record);
+    }
+    ++submitted_;
+    // Pairs with the fence in threadFunc(): either it sees the record when it
+    // checks the queue, or we see it's going to sleep.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!sleeping_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    {
+        // Taking the lock, however briefly, means the present thread is
+        // already waiting, so the notification can't be lost.
+        std::lock_guard<std::mutex> lock(mutex_);
+    }
+    wake_.notify_one();
+}
+
+void PresentThread::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    drained_.wait(lock, [&] { return getPresentedCount() >= submitted_; });
+}
+
+void PresentThread::threadFunc() {
+    sink_.onPresentThreadStart();
+    PresentRecord record;
+    while (true) {
+        while (queue_.tryPop(record)) {
+            sink_.present(record);
+            presented_.fetch_add(1, std::memory_order_release);
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        drained_.notify_all();
+        if (stop_ && queue_.empty()) {
+            break;
+        }
+        sleeping_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        wake_.wait(lock, [&] { return stop_ || !queue_.empty(); });
+        sleeping_.store(false, std::memory_order_relaxed);
+    }
+    sink_.onPresentThreadStop();
+}
+
+}  // namespace metaview
@@ -0,0 +1,120 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include "SpscQueue.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace metaview {
+
+/**
+ * @brief A frame that's ready to be scanned out, once its fence is reached.
+ */
+struct PresentRecord {
+    int32_t surfaceIndex = -1;
+    uint64_t fenceValue = 0;
+};
+
+/**
+ * @brief Interface for whatever actually schedules the scanout.
+ *
+ * Called only from the present thread.
+ */
+class IPresentSink {
+  public:
+    virtual ~IPresentSink() = default;
+
+    /**
+     * @brief Called once on the present thread before any present().
+     */
+    virtual void onPresentThreadStart() {}
+
+    /**
+     * @brief Schedule scanout of the given surface once its fence is reached.
+     */
+    virtual void present(PresentRecord const& record) = 0;
+
+    /**
+     * @brief Called once on the present thread after the last present().
+     */
+    virtual void onPresentThreadStop() {}
+};
+
+/**
+ * @brief Moves scanout scheduling off the render thread.
+ *
+ * The render thread calls submit() (cheap, non-blocking unless the queue is
+ * full) and a dedicated thread passes each record, in order, to the sink.
+ * submit() only takes the lock the present thread sleeps under when that
+ * thread is asleep, so it never waits on it while it is presenting.
+ */
+class PresentThread {
+  public:
+    /**
+     * @brief Construct a new Present Thread object and start the thread.
+     *
+     * @param sink Receives records on the present thread. Must outlive this
+     * object.
+     * @param capacity How many records may be in flight.
+     */
+    explicit PresentThread(IPresentSink& sink, size_t capacity = 4);
+
+    /**
+     * @brief Present any remaining records then stop the thread.
+     */
+    ~PresentThread();
+
+    PresentThread(PresentThread const&) = delete;
+    PresentThread& operator=(PresentThread const&) = delete;
+
+    /**
+     * @brief Queue a record for presentation. Call from a single thread only.
+     *
+     * If the queue is full, blocks, without spinning, until the present
+     * thread has emptied it. The render thread submits at most once a
+     * refresh, so that only happens once the present thread has been stalled
+     * for as many refreshes as the queue holds.
+     */
+    void submit(PresentRecord const& record);
+
+    /**
+     * @brief Block until every record submitted so far has been presented.
+     */
+    void flush();
+
+    /**
+     * @brief Number of records passed to the sink so far.
+     */
+    uint64_t getPresentedCount() const {
+        return presented_.load(std::memory_order_acquire);
+    }
+
+  private:
+    void threadFunc();
+
+    IPresentSink& sink_;
+    SpscQueue<PresentRecord> queue_;
+    uint64_t submitted_ = 0;
+    std::atomic<uint64_t> presented_{0};
+
+    //! Only guards the sleep/wake handshake, never the queue itself.
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable drained_;
+    bool stop_ = false;
+    //! Set by the present thread, under mutex_, from before it last checks
+    //! the queue until it wakes: only then must submit() notify it.
+    std::atomic_bool sleeping_{false};
+
+    std::thread thread_;
+};
+
+}  // namespace metaview
@@ -9,6 +9,7 @@
 // SPDX-License-Identifier: MIT
 
 #include "Renderer.h"
+#include "Timebase.h"
 
 #include <windows.devices.display.core.interop.h>
 #include <winrt/Windows.Foundation.h>
@@ -19,6 +20,7 @@
 namespace winrt {
 using namespace winrt::Windows::Graphics::DirectX;
 
+using winrt::Windows::Devices::Display::Core::DisplayPresentationRate;
 using winrt::Windows::Devices::Display::Core::DisplayPrimaryDescription;
 using winrt::Windows::Devices::Display::Core::DisplayTask;
 using winrt::Windows::Graphics::SizeInt32;
@@ -40,16 +42,45 @@ static inline HRESULT FreeQueryInterface(::IUnknown* ptr, winrt::guid guid,
     return ptr->QueryInterface(guid, dst);
 }
 
+/**
+ * @brief Get the refresh period of a display path in nanoseconds, or 0 if it
+ * isn't available.
+ */
+static int64_t getNominalPeriodNs(winrt::DisplayPath const& path) {
+    auto rate = path.PresentationRate();
+    if (!rate) {
+        return 0;
+    }
+    winrt::DisplayPresentationRate value = rate.Value();
+    if (value.VerticalSyncRate.Numerator == 0) {
+        return 0;
+    }
+    return static_cast<int64_t>(value.VerticalSyncRate.Denominator) *
+           value.VerticalSyncsPerPresentation * 1'000'000'000 /
+           value.VerticalSyncRate.Numerator;
+}
+
+/**
+ * @brief Build the pacer configuration for a display path.
+ */
+static FramePacerConfig makePacerConfig(winrt::DisplayPath const& path) {
+    FramePacerConfig config;
+    config.nominalPeriodNs = getNominalPeriodNs(path);
+    return config;
+}
+
 Renderer::Renderer(std::unique_ptr<RenderParam>&& params, size_t numSurfaces,
                    ID3D11Device* d3dDev)
     : params_(std::move(params)),
       numSurfaces_(numSurfaces),
+      activeSurfaces_(numSurfaces),
       source_(params_->device.CreateScanoutSource(params_->target)),
       taskPool_(params_->device.CreateTaskPool()),
       primaries_(numSurfaces, nullptr),
       scanouts_(numSurfaces, nullptr),
       textures_(numSurfaces, nullptr),
-      rtvs_(numSurfaces_, nullptr) {
+      rtvs_(numSurfaces_, nullptr),
+      pacer_(Timebase::instance(), makePacerConfig(params_->path)) {
     winrt::com_ptr<ID3D11DeviceContext> context;
     if (d3dDev != nullptr) {
         d3dDevice_.capture(FreeQueryInterface, d3dDev);
@@ -92,6 +123,10 @@ Renderer::Renderer(std::unique_ptr<RenderParam>&& params, size_t numSurfaces,
         d3dContext_->ClearRenderTargetView(rtvs_[surfaceIndex].get(),
                                            clearColor);
     }
+
+    // A new display: the timebase converts vblanks with its pacer
+    Timebase::instance().attachVBlankModel(&pacer_);
+    vblankThread_ = std::thread([this] { vblankThreadFunc(); });
 }
 
 void Renderer::createFence() {
@@ -116,13 +151,56 @@ void Renderer::createFence() {
 }
 
 Renderer::~Renderer() {
+    compositor_.reset();
+    presentThread_.reset();
+    stopVBlankThread_ = true;
+    if (vblankThread_.joinable()) {
+        vblankThread_.join();
+    }
+    Timebase::instance().detachVBlankModel(&pacer_);
     params_->device.WaitForVBlank(source_);
     params_.reset();
 }
 
+void Renderer::vblankThreadFunc() {
+    winrt::init_apartment(winrt::apartment_type::multi_threaded);
+    while (!stopVBlankThread_) {
+        params_->device.WaitForVBlank(source_);
+        const int64_t now = Timebase::instance().now();
+        pacer_.recordVBlank(now);
+        classifier_.onVBlank(now, d3dFence_->GetCompletedValue());
+    }
+    winrt::uninit_apartment();
+}
+
 int Renderer::waitFrame() {
     incrementModuloSize(waitedIndex_);
-    params_->device.WaitForVBlank(source_);
+    if (compositor_) {
+        // The compositor may still be re-warping the last frame rendered to
+        // this eye buffer: stop it picking the buffer again, and have our
+        // GPU work wait for any composition already reading it.
+        const uint64_t release = compositor_->acquire(waitedIndex_);
+        if (release != 0) {
+            d3dContext_->Wait(compositorFence_.get(), release);
+        }
+    }
+    IClock& clock = Timebase::instance();
+    frameStats_.beginWait(clock.now());
+    targetVBlankNs_ = 0;
+    const uint32_t interval = pacer_.getFrameInterval();
+    if (pacer_.isLocked()) {
+        targetVBlankNs_ = pacer_.waitForRunningStart();
+    } else {
+        for (uint32_t i = 0; i < interval; ++i) {
+            params_->device.WaitForVBlank(source_);
+        }
+    }
+    frameStats_.endWait(clock.now(), targetVBlankNs_, getVBlankCount(),
+                        interval);
+    if (poseProvider_) {
+        poseProvider_(targetVBlankNs_ != 0 ? targetVBlankNs_ : clock.now(),
+                      renderPose_);
+    }
     d3dContext_->SetMarkerInt(L"waitFrame completed", 0);
     d3dContext_->BeginEventInt(L"Render frame #d", (INT)fenceValue_);
 
@@ -130,32 +208,237 @@ int Renderer::waitFrame() {
 }
 
 void Renderer::endFrame() {
+    frameStats_.beginSubmit(Timebase::instance().now());
     //! @todo do we care about wrapping? Will this 64 bit value ever wrap?
     ++fenceValue_;
     d3dContext_->EndEvent();
 
     d3dContext_->BeginEventInt(L"endFrame #d", (INT)fenceValue_);
     d3dContext_->Signal(d3dFence_.get(), fenceValue_);
+    classifier_.onFrameSubmitted(fenceValue_, targetVBlankNs_,
+                                 pacer_.getPeriod(),
+                                 pacer_.getFrameInterval());
     incrementModuloSize(endedIndex_);
 
+    PresentRecord record{endedIndex_, fenceValue_};
+    if (compositor_) {
+        // The compositor picks it up before the next vblank it makes.
+        d3dContext_->Flush();
+        compositor_->submit(endedIndex_, fenceValue_, renderPose_);
+    } else if (presentThread_) {
+        presentThread_->submit(record);
+    } else {
+        present(record);
+    }
+    d3dContext_->EndEvent();
+    frameStats_.endSubmit(Timebase::instance().now());
+}
+
+bool Renderer::latchPose() {
+    latchedPose_ = renderPose_;
+    if (!poseProvider_) {
+        return false;
+    }
+    const int64_t timeNs = targetVBlankNs_ != 0 ? targetVBlankNs_
+                                                : Timebase::instance().now();
+    if (!poseProvider_(timeNs, latchedPose_)) {
+        latchedPose_ = renderPose_;
+        return false;
+    }
+    return true;
+}
+
+Mat3f Renderer::getLateLatchWarp(int eye) const {
+    return computeOrientationWarp(renderPose_.orientation,
+                                  latchedPose_.orientation,
+                                  eyeRotations_[eye], fov_[eye]);
+}
+
+void Renderer::setUsePresentThread(bool enable) {
+    presentThreadWanted_ = enable;
+    if (compositor_ || enable == getUsePresentThread()) {
+        // While timewarp is on the compositor schedules the scanouts, and
+        // the choice is applied once it is turned off.
+        return;
+    }
+    if (enable) {
+        presentThread_ = std::make_unique<PresentThread>(*this, numSurfaces_);
+    } else {
+        // destructor drains the queue
+        presentThread_.reset();
+    }
+}
+
+void Renderer::setSurfaceCount(size_t count) {
+    if (count < 1) {
+        count = 1;
+    }
+    if (count > numSurfaces_) {
+        count = numSurfaces_;
+    }
+    // The index sequence just wraps earlier or later from the next frame on,
+    // so the next surface is never the one most recently submitted.
+    activeSurfaces_ = count;
+    if (compositor_) {
+        compositor_->setOutputCount(count);
+    }
+}
+
+void Renderer::setTimewarpEnabled(bool enable) {
+    if (enable == getTimewarpEnabled()) {
+        return;
+    }
+    if (!enable) {
+        // Stop composing before the app path takes the scanouts back.
+        compositor_.reset();
+        compositorFence_ = nullptr;
+        eyeBuffers_.clear();
+        eyeRtvs_.clear();
+        eyeDepth_.clear();
+        eyeDepthRtvs_.clear();
+        setUsePresentThread(presentThreadWanted_);
+        return;
+    }
+    // Anything queued for direct scanout goes out first. The present thread
+    // goes unused while timewarp is on.
+    presentThread_.reset();
+
+    D3D11_TEXTURE2D_DESC desc;
+    textures_[0]->GetDesc(&desc);
+    desc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+    desc.MiscFlags =
+        D3D11_RESOURCE_MISC_SHARED | D3D11_RESOURCE_MISC_SHARED_NTHANDLE;
+
+    TimewarpCompositorDesc compositorDesc;
+    compositorDesc.params = params_.get();
+    compositorDesc.outputs = primaries_;
+    compositorDesc.scanouts = scanouts_;
+    compositorDesc.taskPool = taskPool_;
+    compositorDesc.pacer = &pacer_;
+
+    // One eye buffer more than there are surfaces, so the one handed out
+    // next is never the only finished frame the compositor has to show.
+    const size_t numEyeBuffers = numSurfaces_ + 1;
+
+    // The compositor opens its own references; the handles only need to
+    // live until then.
+    vector<winrt::handle> handles;
+    eyeBuffers_.resize(numEyeBuffers);
+    eyeRtvs_.resize(numEyeBuffers);
+    for (size_t i = 0; i < numEyeBuffers; ++i) {
+        winrt::check_hresult(
+            d3dDevice_->CreateTexture2D(&desc, nullptr, eyeBuffers_[i].put()));
+        winrt::check_hresult(d3dDevice_->CreateRenderTargetView(
+            eyeBuffers_[i].get(), nullptr, eyeRtvs_[i].put()));
+        winrt::handle handle;
+        winrt::check_hresult(
+            eyeBuffers_[i].as<IDXGIResource1>()->CreateSharedHandle(
+                nullptr, GENERIC_ALL, nullptr, handle.put()));
+        compositorDesc.sourceHandles.push_back(handle.get());
+        handles.push_back(std::move(handle));
+    }
+    desc.Format = DXGI_FORMAT_R32_FLOAT;
+    eyeDepth_.resize(numEyeBuffers);
+    eyeDepthRtvs_.resize(numEyeBuffers);
+    const float infinity[4] = {0.f, 0.f, 0.f, 0.f};
+    for (size_t i = 0; i < numEyeBuffers; ++i) {
+        winrt::check_hresult(
+            d3dDevice_->CreateTexture2D(&desc, nullptr, eyeDepth_[i].put()));
+        winrt::check_hresult(d3dDevice_->CreateRenderTargetView(
+            eyeDepth_[i].get(), nullptr, eyeDepthRtvs_[i].put()));
+        d3dContext_->ClearRenderTargetView(eyeDepthRtvs_[i].get(), infinity);
+        winrt::handle handle;
+        winrt::check_hresult(
+            eyeDepth_[i].as<IDXGIResource1>()->CreateSharedHandle(
+                nullptr, GENERIC_ALL, nullptr, handle.put()));
+        compositorDesc.depthHandles.push_back(handle.get());
+        handles.push_back(std::move(handle));
+    }
+    winrt::handle fenceHandle;
+    winrt::check_hresult(d3dFence_->CreateSharedHandle(
+        nullptr, GENERIC_ALL, nullptr, fenceHandle.put()));
+    compositorDesc.sourceFenceHandle = fenceHandle.get();
+    // The clears above reach the GPU before any frame the compositor reads.
+    d3dContext_->Flush();
+
+    compositor_ = std::make_unique<TimewarpCompositor>(compositorDesc);
+    compositorFence_.capture(d3dDevice_, &ID3D11Device5::OpenSharedFence,
+                             compositor_->getReleaseFenceHandle());
+    compositor_->setOutputCount(activeSurfaces_);
+    compositor_->setPoseProvider(poseProvider_);
+    compositor_->setEyeFov(fov_[0], fov_[1]);
+    compositor_->setEyeOffsets(eyeOffsets_[0], eyeOffsets_[1]);
+    compositor_->setEyeRotations(eyeRotations_[0], eyeRotations_[1]);
+    compositor_->setPositional(positional_);
+}
+
+void Renderer::setTimewarpPositional(bool enable) {
+    positional_ = enable;
+    if (compositor_) {
+        compositor_->setPositional(enable);
+    }
+}
+
+void Renderer::setTimewarpEyeOffsets(Vec3f const& left, Vec3f const& right) {
+    eyeOffsets_[0] = left;
+    eyeOffsets_[1] = right;
+    if (compositor_) {
+        compositor_->setEyeOffsets(left, right);
+    }
+}
+
+void Renderer::setTimewarpEyeRotations(Quatf const& left,
+                                       Quatf const& right) {
+    eyeRotations_[0] = left;
+    eyeRotations_[1] = right;
+    if (compositor_) {
+        compositor_->setEyeRotations(left, right);
+    }
+}
+
+void Renderer::setPoseProvider(PoseProvider provider) {
+    poseProvider_ = std::move(provider);
+    if (compositor_) {
+        compositor_->setPoseProvider(poseProvider_);
+    }
+}
+
+void Renderer::setTimewarpFov(EyeFov const& left, EyeFov const& right) {
+    fov_[0] = left;
+    fov_[1] = right;
+    if (compositor_) {
+        compositor_->setEyeFov(left, right);
+    }
+}
+
+void Renderer::onPresentThreadStart() {
+    winrt::init_apartment(winrt::apartment_type::multi_threaded);
+}
+
+void Renderer::present(PresentRecord const& record) {
     winrt::DisplayTask task = taskPool_.CreateTask();
-    task.SetScanout(scanouts_[endedIndex_]);
-    task.SetWait(displayFence_, fenceValue_);
+    task.SetScanout(scanouts_[record.surfaceIndex]);
+    task.SetWait(displayFence_, record.fenceValue);
 
     taskPool_.ExecuteTask(task);
-    d3dContext_->EndEvent();
+    frameStats_.recordPresent();
 }
 
+void Renderer::onPresentThreadStop() { winrt::uninit_apartment(); }
+
 void Renderer::blankScreen() {
     auto index = waitFrame();
     float clearColor[4] = {0, 0, 0, 0};
-    d3dContext_->ClearRenderTargetView(rtvs_[index].get(), clearColor);
+    d3dContext_->ClearRenderTargetView(getSwapchainRTVs()[index].get(),
+                                       clearColor);
     endFrame();
 }
 
 void Renderer::incrementModuloSize(int32_t& i) const noexcept {
+    // With timewarp, the app cycles through one spare eye buffer as well
+    const size_t cycle = activeSurfaces_ + (compositor_ ? 1 : 0);
     int32_t newVal = i + 1;
-    if (newVal >= static_cast<uint64_t>(numSurfaces_)) {
+    if (newVal >= static_cast<int64_t>(cycle)) {
         newVal = 0;
     }
     i = newVal;
@@ -10,11 +10,20 @@
 
 #pragma once
 
+#include "FrameClassifier.h"
+#include "FramePacer.h"
+#include "FrameStatistics.h"
+#include "PresentThread.h"
 #include "RenderParam.h"
+#include "TimewarpCompositor.h"
 
 #include <d3d11_4.h>
 #include <winrt/Windows.Devices.Display.Core.h>
 
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
 #include <vector>
 
 // Import things into the winrt namespace, removing extra qualifications.
@@ -27,15 +36,15 @@ using winrt::Windows::Devices::Display::Core::DisplayTaskPool;
 }  // namespace winrt
 
 namespace metaview {
-class Renderer {
+class Renderer : private IPresentSink {
   public:
     /**
      * @brief Construct a new Renderer object
      *
      * @param params The render params from
      * DirectDisplayManager::setupDirectDisplay()
-     * @param numSurfaces How many surfaces you want to switch between. 2 is a
-     * common number.
+     * @param numSurfaces How many surfaces to create. 2 is a common number.
+     * All of them are used to start with; see setSurfaceCount().
      * @param d3dDev Your D3D11Device. If not supplied, a very basic one will be
      * created with RenderParams.
      */
@@ -51,11 +60,14 @@ class Renderer {
     /**
      * @brief Get the textures corresponding to each swapchain image
      *
+     * With timewarp enabled these are the eye buffers, one more than there
+     * are surfaces.
+     *
      * @return std::vector<winrt::com_ptr<ID3D11Texture2D>> const&
      */
     std::vector<winrt::com_ptr<ID3D11Texture2D>> const& getSwapchainImages()
         const noexcept {
-        return textures_;
+        return compositor_ ? eyeBuffers_ : textures_;
     }
 
     /**
@@ -65,7 +77,7 @@ class Renderer {
      */
     std::vector<winrt::com_ptr<ID3D11RenderTargetView>> const&
     getSwapchainRTVs() const noexcept {
-        return rtvs_;
+        return compositor_ ? eyeRtvs_ : rtvs_;
     }
 
     /**
@@ -103,15 +115,218 @@ class Renderer {
     /**
      * @brief Call before rendering, to block.
      *
+     * Once the frame pacer has locked on to the display timing, this returns a
+     * "running start" offset before the vblank the frame is aimed at, rather
+     * than just after the previous vblank. Until then, it waits for vblank.
+     *
      * @return the swapchain image index to render to.
      */
     int waitFrame();
 
+    /**
+     * @brief Set how long before the target vblank waitFrame() should return.
+     */
+    void setRunningStart(std::chrono::nanoseconds runningStart) {
+        pacer_.setRunningStart(runningStart.count());
+    }
+
+    /**
+     * @brief Choose how many vblanks each frame is aimed to last: 1 to render
+     * at the refresh rate, 2 for half rate.
+     *
+     * With timewarp enabled, the compositor fills the vblanks in between
+     * with reprojected frames; otherwise each frame is simply shown longer.
+     * Call between frames, from the thread that calls waitFrame().
+     */
+    void setFrameInterval(uint32_t vblanks) {
+        pacer_.setFrameInterval(vblanks);
+    }
+
+    /**
+     * @brief Get how many vblanks each frame is aimed to last.
+     */
+    uint32_t getFrameInterval() const { return pacer_.getFrameInterval(); }
+
+    /**
+     * @brief Get the frame pacer, for querying display timing estimates.
+     */
+    FramePacer const& getFramePacer() const noexcept { return pacer_; }
+
+    /**
+     * @brief Get frame timing measurements. Read from the thread calling
+     * waitFrame() and endFrame().
+     */
+    FrameStatistics const& getFrameStatistics() const noexcept {
+        return frameStats_;
+    }
+
+    /**
+     * @brief Get the classification of frames as on time, late or repeated,
+     * e.g. to set a callback for runs of late frames.
+     */
+    FrameClassifier& getFrameClassifier() noexcept { return classifier_; }
+    FrameClassifier const& getFrameClassifier() const noexcept {
+        return classifier_;
+    }
+
+    /**
+     * @brief Get the number of vblanks since the renderer started, including
+     * any the vblank thread slept through.
+     */
+    uint64_t getVBlankCount() const {
+        return static_cast<uint64_t>(pacer_.getVBlankCount());
+    }
+
     /**
      * @brief Call when you are done rendering.
+     *
+     * If the present thread is enabled, this only signals the fence and queues
+     * the scanout, returning without touching the display task pool.
      */
     void endFrame();
 
+    /**
+     * @brief Choose whether scanouts are scheduled on a dedicated present
+     * thread rather than inline in endFrame().
+     *
+     * Call between frames, from the thread that calls endFrame(). Disabling
+     * waits for any queued scanouts to be scheduled first. While timewarp is
+     * enabled the choice is only remembered, and takes effect once timewarp
+     * is disabled, so calling this every frame is cheap.
+     */
+    void setUsePresentThread(bool enable);
+
+    /**
+     * @brief Whether scanouts are scheduled on a dedicated present thread.
+     */
+    bool getUsePresentThread() const noexcept {
+        return presentThread_ != nullptr;
+    }
+
+    /**
+     * @brief Choose how many of the surfaces to cycle through: 2 for double
+     * buffering, 3 for triple buffering, etc.
+     *
+     * Call between frames, from the thread that calls waitFrame(). Clamped to
+     * [1, getMaxSurfaceCount()]. The other surfaces stay allocated, so this is
+     * cheap. With timewarp enabled, the compositor cycles through that many
+     * outputs and the app through one eye buffer more.
+     */
+    void setSurfaceCount(size_t count);
+
+    /**
+     * @brief Get how many surfaces are cycled through.
+     */
+    size_t getSurfaceCount() const noexcept { return activeSurfaces_; }
+
+    /**
+     * @brief Get how many surfaces were created.
+     */
+    size_t getMaxSurfaceCount() const noexcept { return numSurfaces_; }
+
+    /**
+     * @brief Get the fence value signaled by the most recent endFrame().
+     *
+     * Anything used by frames up to and including that one is done with once
+     * getCompletedFenceValue() reaches it.
+     */
+    uint64_t getSubmittedFenceValue() const noexcept { return fenceValue_; }
+
+    /**
+     * @brief Get the fence value the GPU has reached.
+     */
+    uint64_t getCompletedFenceValue() const {
+        return d3dFence_->GetCompletedValue();
+    }
+
+    /**
+     * @brief Choose whether frames go through the timewarp compositor rather
+     * than straight to scanout.
+     *
+     * When enabled, getSwapchainImages() and getSwapchainRTVs() return
+     * side-by-side eye buffers instead of the display surfaces, and a
+     * TimewarpCompositor warps the newest finished one to the latest head
+     * orientation before every vblank, whether or not a new frame arrived.
+     * Call between frames, from the thread that calls endFrame(), and fetch
+     * the swapchain images again afterwards.
+     */
+    void setTimewarpEnabled(bool enable);
+
+    /**
+     * @brief Whether frames go through the timewarp compositor.
+     */
+    bool getTimewarpEnabled() const noexcept { return compositor_ != nullptr; }
+
+    /**
+     * @brief Get R32_FLOAT render targets laid out like the eye buffers, one
+     * per swapchain image, to write linear depth (meters, 0 for infinity)
+     * into for positional timewarp. Empty unless timewarp is enabled.
+     */
+    std::vector<winrt::com_ptr<ID3D11RenderTargetView>> const&
+    getTimewarpDepthRTVs() const noexcept {
+        return eyeDepthRtvs_;
+    }
+
+    /**
+     * @brief Choose whether timewarp corrects head translation as well as
+     * rotation, using the depth written to getTimewarpDepthRTVs().
+     */
+    void setTimewarpPositional(bool enable);
+
+    /**
+     * @brief Set each eye's position relative to the head, for positional
+     * timewarp.
+     */
+    void setTimewarpEyeOffsets(Vec3f const& left, Vec3f const& right);
+
+    /**
+     * @brief Set each eye camera's orientation relative to the head, for
+     * timewarp and late latching.
+     */
+    void setTimewarpEyeRotations(Quatf const& left, Quatf const& right);
+
+    /**
+     * @brief Set where head poses come from, for timewarp. Without one, no
+     * warping takes place.
+     */
+    void setPoseProvider(PoseProvider provider);
+
+    /**
+     * @brief Set the head pose the current frame is rendered with, if it
+     * differs from the one sampled in waitFrame(). Call before endFrame().
+     */
+    void setFrameRenderPose(Posef const& pose) noexcept { renderPose_ = pose; }
+
+    /**
+     * @brief Re-sample the head pose for the frame about to be submitted.
+     *
+     * Call as late as possible before endFrame(), then warp each eye by
+     * getLateLatchWarp() on the way to the swapchain image.
+     *
+     * @return false if there is no pose provider or it had no pose, in which
+     * case the warp is the identity.
+     */
+    bool latchPose();
+
+    /**
+     * @brief Get the homography that rotates an eye from the render pose to
+     * the pose sampled by latchPose(), as from computeOrientationWarp(), in
+     * the eye's own space (see setTimewarpEyeRotations()).
+     */
+    Mat3f getLateLatchWarp(int eye) const;
+
+    /**
+     * @brief Set the field of view of each eye, for timewarp.
+     */
+    void setTimewarpFov(EyeFov const& left, EyeFov const& right);
+
+    /**
+     * @brief Get the timewarp compositor, or nullptr if disabled.
+     */
+    TimewarpCompositor const* getTimewarpCompositor() const noexcept {
+        return compositor_.get();
+    }
+
     /**
      * @brief Render a solid black screen.
      *
@@ -121,7 +336,8 @@ class Renderer {
 
   private:
     /**
-     * @brief Increment a value modulo the number of surfaces.
+     * @brief Increment a value modulo the number of surfaces (or eye
+     * buffers, with timewarp) in use.
      *
      * @param[in,out] i The value to increment.
      */
@@ -132,8 +348,20 @@ class Renderer {
      */
     void createFence();
 
+    /**
+     * @brief Body of the thread that records vblank timestamps for the pacer.
+     */
+    void vblankThreadFunc();
+
+    // IPresentSink implementation: called on the present thread, or inline.
+    void onPresentThreadStart() override;
+    void present(PresentRecord const& record) override;
+    void onPresentThreadStop() override;
+
     std::unique_ptr<RenderParam> params_;
     size_t numSurfaces_;
+    //! How many of the surfaces are in use, counting from 0.
+    size_t activeSurfaces_;
     //! to know where to render
     winrt::DisplaySource source_;
     //! for scheduling presents
@@ -157,5 +385,42 @@ class Renderer {
     winrt::DisplayFence displayFence_{nullptr};
 
     uint64_t fenceValue_{0};
+
+    FramePacer pacer_;
+    FrameStatistics frameStats_;
+    //! Fed by the vblank thread and endFrame().
+    FrameClassifier classifier_;
+    //! The vblank the frame being rendered is aimed at, or 0 if unknown.
+    int64_t targetVBlankNs_ = 0;
+    std::atomic_bool stopVBlankThread_{false};
+    //! Waits on vblank continuously, feeding pacer_.
+    std::thread vblankThread_;
+
+    //! Schedules scanouts, if enabled.
+    std::unique_ptr<PresentThread> presentThread_;
+    //! Whether the present thread was asked for: it is dropped while
+    //! timewarp is enabled.
+    bool presentThreadWanted_ = false;
+
+    //! Eye buffers rendered to in timewarp mode, shared with compositor_:
+    //! one more than there are surfaces.
+    std::vector<winrt::com_ptr<ID3D11Texture2D>> eyeBuffers_;
+    std::vector<winrt::com_ptr<ID3D11RenderTargetView>> eyeRtvs_;
+    //! Linear depth of the eye buffers, shared with compositor_.
+    std::vector<winrt::com_ptr<ID3D11Texture2D>> eyeDepth_;
+    std::vector<winrt::com_ptr<ID3D11RenderTargetView>> eyeDepthRtvs_;
+    PoseProvider poseProvider_;
+    //! Head pose the frame being rendered is rendered with.
+    Posef renderPose_;
+    //! Head pose sampled by latchPose(), just before submission.
+    Posef latchedPose_;
+    EyeFov fov_[2];
+    Vec3f eyeOffsets_[2];
+    Quatf eyeRotations_[2];
+    bool positional_ = false;
+    //! Warps and scans out frames, if timewarp is enabled.
+    std::unique_ptr<TimewarpCompositor> compositor_;
+    //! compositor_'s release fence, opened on our device.
+    winrt::com_ptr<ID3D11Fence> compositorFence_;
 };
 }  // namespace metaview
@@ -0,0 +1,270 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#include "Reprojection.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace metaview {
+
+Mat3f makeTextureProjection(EyeFov const& fov) {
+    const float width = fov.right - fov.left;
+    const float height = fov.top - fov.bottom;
+    Mat3f k;
+    k.m[0][0] = 1.f / width;
+    k.m[0][1] = 0.f;
+    k.m[0][2] = fov.left / width;
+    k.m[1][0] = 0.f;
+    k.m[1][1] = -1.f / height;
+    k.m[1][2] = -fov.top / height;
+    k.m[2][0] = 0.f;
+    k.m[2][1] = 0.f;
+    k.m[2][2] = -1.f;
+    return k;
+}
+
+Mat3f makeTextureUnprojection(EyeFov const& fov) {
+    Mat3f inv;
+    inv.m[0][0] = fov.right - fov.left;
+    inv.m[0][1] = 0.f;
+    inv.m[0][2] = fov.left;
+    inv.m[1][0] = 0.f;
+    inv.m[1][1] = fov.bottom - fov.top;
+    inv.m[1][2] = fov.top;
+    inv.m[2][0] = 0.f;
+    inv.m[2][1] = 0.f;
+    inv.m[2][2] = -1.f;
+    return inv;
+}
+
+Mat3f computeOrientationWarp(Quatf const& renderOrientation,
+                             Quatf const& displayOrientation,
+                             EyeFov const& fov) {
+    // display texcoord -> display eye direction -> world -> render eye
+    // direction -> render texcoord
+    const Mat3f delta =
+        transpose(toMatrix(renderOrientation)) * toMatrix(displayOrientation);
+    return makeTextureProjection(fov) * delta * makeTextureUnprojection(fov);
+}
+
+Mat3f computeOrientationWarp(Quatf const& renderHead, Quatf const& displayHead,
+                             Quatf const& eyeRotation, EyeFov const& fov) {
+    const Mat3f eye = toMatrix(eyeRotation);
+    const Mat3f delta = transpose(eye) * transpose(toMatrix(renderHead)) *
+                        toMatrix(displayHead) * eye;
+    return makeTextureProjection(fov) * delta * makeTextureUnprojection(fov);
+}
+
+/**
+ * @brief Bilinear sample of @p src at texture coordinates (u, v), clamped to
+ * the edge, as a GPU linear sampler does.
+ */
+static void sampleBilinear(ConstImageView const& src, float u, float v,
+                           uint8_t* out) {
+    const float fx = u * static_cast<float>(src.width) - 0.5f;
+    const float fy = v * static_cast<float>(src.height) - 0.5f;
+    const float x0f = std::floor(fx);
+    const float y0f = std::floor(fy);
+    const float tx = fx - x0f;
+    const float ty = fy - y0f;
+    const int maxX = static_cast<int>(src.width) - 1;
+    const int maxY = static_cast<int>(src.height) - 1;
+    const int x0 = std::min(std::max(static_cast<int>(x0f), 0), maxX);
+    const int y0 = std::min(std::max(static_cast<int>(y0f), 0), maxY);
+    const int x1 = std::min(std::max(static_cast<int>(x0f) + 1, 0), maxX);
+    const int y1 = std::min(std::max(static_cast<int>(y0f) + 1, 0), maxY);
+    const uint8_t* r0 = src.data + y0 * src.stride;
+    const uint8_t* r1 = src.data + y1 * src.stride;
+    for (int c = 0; c < 4; ++c) {
+        const float top =
+            r0[x0 * 4 + c] + (r0[x1 * 4 + c] - r0[x0 * 4 + c]) * tx;
+        const float bottom =
+            r1[x0 * 4 + c] + (r1[x1 * 4 + c] - r1[x0 * 4 + c]) * tx;
+        out[c] = static_cast<uint8_t>(top + (bottom - top) * ty + 0.5f);
+    }
+}
+
+static void setBlack(uint8_t* out) {
+    out[0] = out[1] = out[2] = 0;
+    out[3] = 255;
+}
+
+void warpImageCpu(ConstImageView const& src, ImageView const& dst,
+                  Mat3f const& warp) {
+    for (uint32_t y = 0; y < dst.height; ++y) {
+        uint8_t* out = dst.data + y * dst.stride;
+        const float v = (static_cast<float>(y) + 0.5f) / dst.height;
+        for (uint32_t x = 0; x < dst.width; ++x, out += 4) {
+            const float u = (static_cast<float>(x) + 0.5f) / dst.width;
+            const Vec3f s = warp * Vec3f{u, v, 1.f};
+            const float su = s.x / s.z;
+            const float sv = s.y / s.z;
+            if (s.z <= 0.f || su < 0.f || su > 1.f || sv < 0.f || sv > 1.f) {
+                setBlack(out);
+                continue;
+            }
+            sampleBilinear(src, su, sv, out);
+        }
+    }
+}
+
+float linearizeDepth(float value, float zNear, float zFar, bool reversedZ) {
+    if (reversedZ) {
+        value = 1.f - value;
+    }
+    if (value >= 1.f) {
+        // Far plane: nothing drawn there
+        return 0.f;
+    }
+    // value = f (z - n) / (z (f - n)), solved for z
+    return zNear * zFar / (zFar - value * (zFar - zNear));
+}
+
+bool reprojectTexel(float u, float v, float depth, Posef const& delta,
+                    EyeFov const& fov, float& outU, float& outV,
+                    float& outDepth) {
+    // Direction with z = -1, so scaling by depth gives the point.
+    const Vec3f dir = makeTextureUnprojection(fov) * Vec3f{u, v, 1.f};
+    Vec3f p;
+    if (depth > 0.f) {
+        p = rotate(delta.orientation, dir * depth) + delta.position;
+    } else {
+        p = rotate(delta.orientation, dir);
+    }
+    const Vec3f t = makeTextureProjection(fov) * p;
+    if (t.z <= 0.f) {
+        return false;
+    }
+    outU = t.x / t.z;
+    outV = t.y / t.z;
+    outDepth = depth > 0.f ? t.z : 0.f;
+    return true;
+}
+
+namespace {
+//! A grid vertex after reprojection.
+struct WarpedVertex {
+    //! Position in destination pixels
+    float x, y;
+    //! Depth test key, increasing with distance, in [0, 1]
+    float key;
+    //! Where to sample the source
+    float u, v;
+    bool valid;
+};
+}  // namespace
+
+//! Map linear depth to [0, 1) for the depth test, as the shader does.
+static float depthKey(float depth) {
+    return depth > 0.f ? depth / (depth + 1.f) : 1.f;
+}
+
+static float edge(WarpedVertex const& a, WarpedVertex const& b, float x,
+                  float y) {
+    return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+}
+
+/**
+ * @brief Rasterize a triangle with affine interpolation (the shader outputs
+ * w = 1), keeping the nearest surface per pixel. Later triangles win ties,
+ * as with D3D11_COMPARISON_LESS_EQUAL.
+ */
+static void rasterizeTriangle(WarpedVertex const& a, WarpedVertex const& b,
+                              WarpedVertex const& c, ConstImageView const& src,
+                              ImageView const& dst, std::vector<float>& zbuf) {
+    if (!a.valid || !b.valid || !c.valid) {
+        return;
+    }
+    const float area = edge(a, b, c.x, c.y);
+    if (area == 0.f) {
+        return;
+    }
+    const int maxX = static_cast<int>(dst.width) - 1;
+    const int maxY = static_cast<int>(dst.height) - 1;
+    const int x0 = std::max(
+        static_cast<int>(std::floor(std::min({a.x, b.x, c.x}) - 0.5f)), 0);
+    const int x1 = std::min(
+        static_cast<int>(std::ceil(std::max({a.x, b.x, c.x}) - 0.5f)), maxX);
+    const int y0 = std::max(
+        static_cast<int>(std::floor(std::min({a.y, b.y, c.y}) - 0.5f)), 0);
+    const int y1 = std::min(
+        static_cast<int>(std::ceil(std::max({a.y, b.y, c.y}) - 0.5f)), maxY);
+    for (int y = y0; y <= y1; ++y) {
+        const float py = static_cast<float>(y) + 0.5f;
+        for (int x = x0; x <= x1; ++x) {
+            const float px = static_cast<float>(x) + 0.5f;
+            // Barycentrics, either winding
+            const float wa = edge(b, c, px, py) / area;
+            const float wb = edge(c, a, px, py) / area;
+            const float wc = 1.f - wa - wb;
+            if (wa < 0.f || wb < 0.f || wc < 0.f) {
+                continue;
+            }
+            const float key = wa * a.key + wb * b.key + wc * c.key;
+            float& nearest = zbuf[static_cast<size_t>(y) * dst.width + x];
+            if (key > nearest) {
+                continue;
+            }
+            nearest = key;
+            sampleBilinear(src, wa * a.u + wb * b.u + wc * c.u,
+                           wa * a.v + wb * b.v + wc * c.v,
+                           dst.data + y * dst.stride + x * 4);
+        }
+    }
+}
+
+void warpImagePositionalCpu(ConstImageView const& src,
+                            ConstDepthView const& depth, ImageView const& dst,
+                            Posef const& delta, EyeFov const& fov,
+                            uint32_t gridStep) {
+    for (uint32_t y = 0; y < dst.height; ++y) {
+        uint8_t* out = dst.data + y * dst.stride;
+        for (uint32_t x = 0; x < dst.width; ++x, out += 4) {
+            setBlack(out);
+        }
+    }
+    if (gridStep == 0) {
+        gridStep = 1;
+    }
+    const uint32_t cols = (src.width + gridStep - 1) / gridStep;
+    const uint32_t rows = (src.height + gridStep - 1) / gridStep;
+    std::vector<WarpedVertex> verts((cols + 1) * (rows + 1));
+    for (uint32_t j = 0; j <= rows; ++j) {
+        for (uint32_t i = 0; i <= cols; ++i) {
+            const float u = static_cast<float>(i) / cols;
+            const float v = static_cast<float>(j) / rows;
+            // Depth texel under the vertex, as Load() picks it
+            const uint32_t dx = std::min(
+                static_cast<uint32_t>(u * depth.width), depth.width - 1);
+            const uint32_t dy = std::min(
+                static_cast<uint32_t>(v * depth.height), depth.height - 1);
+            WarpedVertex& vert = verts[j * (cols + 1) + i];
+            float outU = 0.f, outV = 0.f, outDepth = 0.f;
+            vert.valid = reprojectTexel(u, v, depth.at(dx, dy), delta, fov,
+                                        outU, outV, outDepth);
+            vert.x = outU * dst.width;
+            vert.y = outV * dst.height;
+            vert.key = depthKey(outDepth);
+            vert.u = u;
+            vert.v = v;
+        }
+    }
+    // Cleared to the far end of the depth range, as on the GPU
+    std::vector<float> zbuf(static_cast<size_t>(dst.width) * dst.height, 1.f);
+    for (uint32_t j = 0; j < rows; ++j) {
+        for (uint32_t i = 0; i < cols; ++i) {
+            WarpedVertex const& v00 = verts[j * (cols + 1) + i];
+            WarpedVertex const& v10 = verts[j * (cols + 1) + i + 1];
+            WarpedVertex const& v01 = verts[(j + 1) * (cols + 1) + i];
+            WarpedVertex const& v11 = verts[(j + 1) * (cols + 1) + i + 1];
+            rasterizeTriangle(v00, v10, v01, src, dst, zbuf);
+            rasterizeTriangle(v01, v10, v11, src, dst, zbuf);
+        }
+    }
+}
+
+}  // namespace metaview
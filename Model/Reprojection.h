@@ -0,0 +1,200 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include "PoseMath.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace metaview {
+
+/**
+ * @brief Extent of an eye's view frustum, as tangents of the half angles:
+ * left and bottom negative, right and top positive.
+ */
+struct EyeFov {
+    float left = -1.f;
+    float right = 1.f;
+    float top = 1.f;
+    float bottom = -1.f;
+};
+
+/**
+ * @brief Projection from eye space (right handed, looking down -Z, Y up) to
+ * normalized texture coordinates (origin top left), as a homogeneous 3x3
+ * matrix: (u w, v w, w) = K * direction.
+ */
+Mat3f makeTextureProjection(EyeFov const& fov);
+
+/**
+ * @brief Inverse of makeTextureProjection(): texture coordinates to an eye
+ * space direction (not normalized).
+ */
+Mat3f makeTextureUnprojection(EyeFov const& fov);
+
+/**
+ * @brief Orientation-only reprojection ("timewarp") of an eye image.
+ *
+ * Computes the homography that maps texture coordinates of the image to
+ * display, (u, v, 1), to homogeneous texture coordinates of the image that
+ * was rendered. Divide by the third component; a non-positive one means the
+ * direction was behind the rendered eye.
+ *
+ * @param renderOrientation Eye orientation the image was rendered with.
+ * @param displayOrientation Eye orientation at display time.
+ * @param fov Field of view of both images.
+ */
+Mat3f computeOrientationWarp(Quatf const& renderOrientation,
+                             Quatf const& displayOrientation,
+                             EyeFov const& fov);
+
+/**
+ * @brief computeOrientationWarp() from head orientations, for an eye whose
+ * camera is rotated relative to the head, e.g. rolled to suit a panel
+ * mounted sideways.
+ *
+ * The head's rotation between render and display is taken into the eye's
+ * space, R_eye^T * delta * R_eye, so a head yaw moves the image along the
+ * axes the eye was rendered with.
+ *
+ * @param eyeRotation The eye's orientation relative to the head.
+ */
+Mat3f computeOrientationWarp(Quatf const& renderHead, Quatf const& displayHead,
+                             Quatf const& eyeRotation, EyeFov const& fov);
+
+/**
+ * @brief Pointer to a block of 8 bit RGBA pixels, rows @p stride bytes apart.
+ */
+struct ImageView {
+    uint8_t* data = nullptr;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    size_t stride = 0;
+
+    //! View of a rectangle of this image.
+    ImageView sub(uint32_t x, uint32_t y, uint32_t w, uint32_t h) const {
+        return {data + y * stride + x * 4, w, h, stride};
+    }
+};
+
+/**
+ * @brief Read-only variant of ImageView.
+ */
+struct ConstImageView {
+    const uint8_t* data = nullptr;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    size_t stride = 0;
+
+    ConstImageView() = default;
+    ConstImageView(const uint8_t* d, uint32_t w, uint32_t h, size_t s)
+        : data(d), width(w), height(h), stride(s) {}
+    ConstImageView(ImageView const& v)
+        : data(v.data), width(v.width), height(v.height), stride(v.stride) {}
+
+    ConstImageView sub(uint32_t x, uint32_t y, uint32_t w, uint32_t h) const {
+        return {data + y * stride + x * 4, w, h, stride};
+    }
+};
+
+/**
+ * @brief Pointer to a block of linear depths (float, meters along the view
+ * direction), rows @p stride bytes apart. A depth of 0 or less means "at
+ * infinity", e.g. background that was never drawn.
+ */
+struct ConstDepthView {
+    const float* data = nullptr;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    size_t stride = 0;
+
+    float at(uint32_t x, uint32_t y) const {
+        return reinterpret_cast<const float*>(
+            reinterpret_cast<const uint8_t*>(data) + y * stride)[x];
+    }
+
+    ConstDepthView sub(uint32_t x, uint32_t y, uint32_t w, uint32_t h) const {
+        return {reinterpret_cast<const float*>(
+                    reinterpret_cast<const uint8_t*>(data) + y * stride) +
+                    x,
+                w, h, stride};
+    }
+};
+
+/**
+ * @brief Convert a D3D depth buffer value to linear depth in meters.
+ *
+ * @param reversedZ Whether the near plane is at 1 and the far plane at 0, as
+ * Unity does on D3D11.
+ * @return the depth, or 0 (infinity) for values at the far plane.
+ */
+float linearizeDepth(float value, float zNear, float zFar, bool reversedZ);
+
+/**
+ * @brief Rigid transform taking points from the eye space an image was
+ * rendered in to the eye space it will be displayed in.
+ */
+inline Posef computeEyeDelta(Posef const& renderEye, Posef const& displayEye) {
+    return inverse(displayEye) * renderEye;
+}
+
+/**
+ * @brief computeEyeDelta() from head poses, for an eye at @p eye relative to
+ * the head, its rotation included.
+ */
+inline Posef computeEyeDelta(Posef const& renderHead, Posef const& displayHead,
+                             Posef const& eye) {
+    return computeEyeDelta(renderHead * eye, displayHead * eye);
+}
+
+/**
+ * @brief Move a texel of a rendered image to where it would appear from
+ * another eye pose, given its depth.
+ *
+ * @param u,v Texture coordinates in the rendered image.
+ * @param depth Linear depth of the texel; 0 or less for infinity, where only
+ * rotation matters.
+ * @param delta From computeEyeDelta().
+ * @param fov Field of view of both images.
+ * @param[out] outU,outV Texture coordinates in the displayed image.
+ * @param[out] outDepth Depth as seen from the display eye (infinity stays 0).
+ * @return false if the point ends up behind the display eye.
+ */
+bool reprojectTexel(float u, float v, float depth, Posef const& delta,
+                    EyeFov const& fov, float& outU, float& outV,
+                    float& outDepth);
+
+//! Spacing of the positional warp's grid, in source pixels.
+static constexpr uint32_t PositionalWarpGridStep = 8;
+
+/**
+ * @brief Depth-aware ("positional") reprojection of an eye image.
+ *
+ * Reference implementation of the compositor's positional warp: a grid with
+ * a vertex every @p gridStep source pixels is laid over the image, each
+ * vertex moved by reprojectTexel() using the depth under it, and the
+ * resulting mesh rasterized into @p dst with a depth test, sampling @p src
+ * bilinearly. Pixels the mesh doesn't cover are black.
+ *
+ * @param depth Linear depth, the same size as @p src.
+ */
+void warpImagePositionalCpu(ConstImageView const& src,
+                            ConstDepthView const& depth, ImageView const& dst,
+                            Posef const& delta, EyeFov const& fov,
+                            uint32_t gridStep = PositionalWarpGridStep);
+
+/**
+ * @brief Reference implementation of the reprojection shader: fill @p dst by
+ * sampling @p src (bilinear, clamped to the edge) through a homography
+ * from computeOrientationWarp(). Pixels that map outside @p src are black.
+ *
+ * Pixel centers are at (i + 0.5) / size, as on the GPU.
+ */
+void warpImageCpu(ConstImageView const& src, ImageView const& dst,
+                  Mat3f const& warp);
+
+}  // namespace metaview
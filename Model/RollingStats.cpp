@@ -0,0 +1,51 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#include "RollingStats.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace metaview {
+
+RollingStats::RollingStats(size_t window) : window_(window < 1 ? 1 : window) {
+    samples_.reserve(window_);
+    scratch_.reserve(window_);
+}
+
+void RollingStats::add(double value) {
+    if (samples_.size() < window_) {
+        samples_.push_back(value);
+        return;
+    }
+    samples_[next_] = value;
+    next_ = (next_ + 1) % window_;
+}
+
+RollingSummary RollingStats::summarize() const {
+    RollingSummary summary;
+    summary.count = samples_.size();
+    if (samples_.empty()) {
+        return summary;
+    }
+    summary.min = *std::min_element(samples_.begin(), samples_.end());
+    summary.avg = std::accumulate(samples_.begin(), samples_.end(), 0.0) /
+                  static_cast<double>(samples_.size());
+
+    // Nearest-rank percentile
+    scratch_.assign(samples_.begin(), samples_.end());
+    const size_t rank = (scratch_.size() * 99 + 99) / 100 - 1;
+    std::nth_element(scratch_.begin(), scratch_.begin() + rank,
+                     scratch_.end());
+    summary.p99 = scratch_[rank];
+    return summary;
+}
+
+void RollingStats::clear() {
+    samples_.clear();
+    next_ = 0;
+}
+
+}  // namespace metaview
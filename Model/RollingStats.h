@@ -0,0 +1,56 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace metaview {
+
+/**
+ * @brief Summary of the samples in a RollingStats window.
+ */
+struct RollingSummary {
+    double min = 0;
+    double avg = 0;
+    double p99 = 0;
+    size_t count = 0;
+};
+
+/**
+ * @brief Keeps the last N samples of a quantity and summarizes them.
+ */
+class RollingStats {
+  public:
+    /**
+     * @brief Construct a new Rolling Stats object
+     *
+     * @param window Number of most recent samples kept.
+     */
+    explicit RollingStats(size_t window = 120);
+
+    void add(double value);
+
+    /**
+     * @brief Get min, average and 99th percentile of the window. All zero if
+     * it's empty.
+     */
+    RollingSummary summarize() const;
+
+    size_t size() const noexcept { return samples_.size(); }
+
+    void clear();
+
+  private:
+    size_t window_;
+    std::vector<double> samples_;
+    //! Where the next sample goes once the window is full.
+    size_t next_ = 0;
+    //! Reused by summarize() to avoid allocating each time.
+    mutable std::vector<double> scratch_;
+};
+
+}  // namespace metaview
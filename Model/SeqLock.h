@@ -0,0 +1,121 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+
+namespace metaview {
+
+/**
+ * @brief A trivially copyable value kept as relaxed atomic words, so one
+ * thread can copy it out while another overwrites it without a data race.
+ *
+ * A copy taken during a write may mix old and new words: pair it with a
+ * sequence number, as SeqLock does, to tell. Ordering is up to that too.
+ */
+template <typename T> class AtomicWords {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Value type must be trivially copyable");
+
+  public:
+    AtomicWords() { store(T{}); }
+
+    AtomicWords(AtomicWords const&) = delete;
+    AtomicWords& operator=(AtomicWords const&) = delete;
+
+    void load(T& value) const {
+        uint32_t words[WordCount];
+        for (size_t i = 0; i < WordCount; ++i) {
+            words[i] = words_[i].load(std::memory_order_relaxed);
+        }
+        std::memcpy(&value, words, sizeof(T));
+    }
+
+    void store(T const& value) {
+        uint32_t words[WordCount] = {};
+        std::memcpy(words, &value, sizeof(T));
+        for (size_t i = 0; i < WordCount; ++i) {
+            words_[i].store(words[i], std::memory_order_relaxed);
+        }
+    }
+
+  private:
+    static constexpr size_t WordCount =
+        (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+    std::atomic<uint32_t> words_[WordCount];
+};
+
+/**
+ * @brief A value many threads can read without locking, while others replace
+ * it, and never see half of one update and half of another.
+ *
+ * A sequence lock: writers bump a sequence counter to odd before changing the
+ * value and back to even after, readers retry if it was odd or changed while
+ * they copied. The value is kept as AtomicWords, so the copying itself is no
+ * data race. Writers are serialized with a mutex; readers never block them.
+ *
+ * @tparam T Value type: must be trivially copyable. Intended for small
+ * blocks of parameters, read far more often than written.
+ */
+template <typename T> class SeqLock {
+  public:
+    explicit SeqLock(T const& value = T{}) { value_.store(value); }
+
+    SeqLock(SeqLock const&) = delete;
+    SeqLock& operator=(SeqLock const&) = delete;
+
+    /**
+     * @brief Get a consistent copy of the value. Any thread.
+     */
+    T load() const {
+        T value;
+        uint32_t before, after;
+        do {
+            before = sequence_.load(std::memory_order_acquire);
+            value_.load(value);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence_.load(std::memory_order_relaxed);
+        } while ((before & 1) != 0 || before != after);
+        return value;
+    }
+
+    /**
+     * @brief Replace the value. Any thread.
+     */
+    void store(T const& value) {
+        update([&](T& current) { current = value; });
+    }
+
+    /**
+     * @brief Change the value in place: @p f is called with a copy of the
+     * current value to modify, which is then published as one update. Any
+     * thread; concurrent updates are applied one after the other.
+     */
+    template <typename F> void update(F&& f) {
+        std::lock_guard<std::mutex> lock(writeMutex_);
+        T value;
+        value_.load(value);
+        f(value);
+        const uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        value_.store(value);
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+  private:
+    //! Odd while an update is being written.
+    std::atomic<uint32_t> sequence_{0};
+    AtomicWords<T> value_;
+    std::mutex writeMutex_;
+};
+
+}  // namespace metaview
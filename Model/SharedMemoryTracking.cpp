@@ -0,0 +1,316 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#include "SharedMemoryTracking.h"
+#include "Clock.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace metaview {
+
+using shared_tracking::Header;
+using shared_tracking::Record;
+
+//! How often a reader without a block retries opening it.
+static constexpr int64_t OpenRetryNs = 1'000'000'000;
+
+//! A writer silent for longer than this is considered gone.
+static constexpr int64_t HeartbeatTimeoutNs = 500'000'000;
+
+//! Offset of the first record: the header rounded up to a record.
+static constexpr size_t RecordsOffset =
+    sizeof(Record) * ((sizeof(Header) + sizeof(Record) - 1) / sizeof(Record));
+
+SharedMemoryRegion::~SharedMemoryRegion() { close(); }
+
+bool SharedMemoryRegion::create(std::string const& name, size_t size) {
+    return map(name, size, true);
+}
+
+bool SharedMemoryRegion::open(std::string const& name, size_t size) {
+    return map(name, size, false);
+}
+
+#ifdef _WIN32
+bool SharedMemoryRegion::map(std::string const& name, size_t size,
+                             bool create) {
+    close();
+    const std::string fullName = "Local\\" + name;
+    HANDLE mapping = nullptr;
+    if (create) {
+        const uint64_t size64 = size;
+        mapping = CreateFileMappingA(
+            INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+            static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64),
+            fullName.c_str());
+    } else {
+        mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, fullName.c_str());
+    }
+    if (mapping == nullptr) {
+        return false;
+    }
+    void* view = MapViewOfFile(
+        mapping, create ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, 0);
+    MEMORY_BASIC_INFORMATION info = {};
+    if (view == nullptr ||
+        VirtualQuery(view, &info, sizeof(info)) != sizeof(info) ||
+        info.RegionSize < size) {
+        if (view != nullptr) {
+            UnmapViewOfFile(view);
+        }
+        CloseHandle(mapping);
+        return false;
+    }
+    data_ = view;
+    size_ = info.RegionSize;
+    handle_ = reinterpret_cast<intptr_t>(mapping);
+    return true;
+}
+
+void SharedMemoryRegion::close() {
+    if (data_ != nullptr) {
+        UnmapViewOfFile(data_);
+        data_ = nullptr;
+    }
+    if (handle_ != -1) {
+        CloseHandle(reinterpret_cast<HANDLE>(handle_));
+        handle_ = -1;
+    }
+    size_ = 0;
+}
+#else
+bool SharedMemoryRegion::map(std::string const& name, size_t size,
+                             bool create) {
+    close();
+    const std::string fullName = "/" + name;
+    const int fd = create
+                       ? shm_open(fullName.c_str(), O_CREAT | O_RDWR, 0600)
+                       : shm_open(fullName.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st = {};
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    size_t actual = static_cast<size_t>(st.st_size);
+    if (create && actual < size) {
+        // Extending zero-fills
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            ::close(fd);
+            return false;
+        }
+        actual = size;
+    }
+    if (actual < size || actual == 0) {
+        ::close(fd);
+        return false;
+    }
+    const int protection = create ? PROT_READ | PROT_WRITE : PROT_READ;
+    void* view = mmap(nullptr, actual, protection, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED) {
+        ::close(fd);
+        return false;
+    }
+    data_ = view;
+    size_ = actual;
+    handle_ = fd;
+    if (create) {
+        createdName_ = fullName;
+    }
+    return true;
+}
+
+void SharedMemoryRegion::close() {
+    if (data_ != nullptr) {
+        munmap(data_, size_);
+        data_ = nullptr;
+    }
+    if (handle_ != -1) {
+        ::close(static_cast<int>(handle_));
+        handle_ = -1;
+    }
+    if (!createdName_.empty()) {
+        shm_unlink(createdName_.c_str());
+        createdName_.clear();
+    }
+    size_ = 0;
+}
+#endif
+
+SharedTrackingWriter::SharedTrackingWriter(std::string const& name,
+                                           uint32_t capacity) {
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        throw std::invalid_argument("Capacity must be a power of two");
+    }
+    if (!region_.create(name, shared_tracking::blockSize(capacity))) {
+        throw std::runtime_error("Could not create tracking shared memory");
+    }
+    header_ = static_cast<Header*>(region_.data());
+    records_ = reinterpret_cast<Record*>(
+        static_cast<char*>(region_.data()) + RecordsOffset);
+    mask_ = capacity - 1;
+    // Carry on from a previous writer of the same layout, so readers that
+    // stayed attached don't see the count go backwards.
+    if (header_->magic != shared_tracking::Magic ||
+        header_->version != shared_tracking::Version ||
+        header_->capacity != capacity ||
+        header_->recordSize != sizeof(Record)) {
+        header_->writeCount.store(0, std::memory_order_relaxed);
+        for (uint32_t i = 0; i < capacity; ++i) {
+            records_[i].sequence.store(0, std::memory_order_relaxed);
+        }
+        header_->capacity = capacity;
+        header_->recordSize = sizeof(Record);
+        header_->version = shared_tracking::Version;
+        std::atomic_thread_fence(std::memory_order_release);
+        header_->magic = shared_tracking::Magic;
+    }
+    heartbeat(SteadyClock::instance().now());
+}
+
+void SharedTrackingWriter::write(TrackedSample const& sample) {
+    const uint64_t index =
+        header_->writeCount.load(std::memory_order_relaxed);
+    Record& record = records_[index & mask_];
+    record.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    PoseSample const& s = sample.sample;
+    record.device = sample.device;
+    record.reserved = 0;
+    record.timeNs = s.timeNs;
+    record.position[0] = s.pose.position.x;
+    record.position[1] = s.pose.position.y;
+    record.position[2] = s.pose.position.z;
+    record.orientation[0] = s.pose.orientation.x;
+    record.orientation[1] = s.pose.orientation.y;
+    record.orientation[2] = s.pose.orientation.z;
+    record.orientation[3] = s.pose.orientation.w;
+    record.linearVelocity[0] = s.linearVelocity.x;
+    record.linearVelocity[1] = s.linearVelocity.y;
+    record.linearVelocity[2] = s.linearVelocity.z;
+    record.angularVelocity[0] = s.angularVelocity.x;
+    record.angularVelocity[1] = s.angularVelocity.y;
+    record.angularVelocity[2] = s.angularVelocity.z;
+    record.sequence.store(2 * (index + 1), std::memory_order_release);
+    header_->writeCount.store(index + 1, std::memory_order_release);
+    header_->heartbeatNs.store(s.timeNs, std::memory_order_relaxed);
+}
+
+void SharedTrackingWriter::heartbeat(int64_t nowNs) {
+    header_->heartbeatNs.store(nowNs, std::memory_order_relaxed);
+}
+
+SharedTrackingSource::SharedTrackingSource(std::string const& name)
+    : name_(name) {}
+
+bool SharedTrackingSource::tryOpen() {
+    if (!region_.open(name_, sizeof(Header))) {
+        return false;
+    }
+    auto const* header = static_cast<Header const*>(region_.data());
+    if (header->magic != shared_tracking::Magic ||
+        header->version != shared_tracking::Version ||
+        header->recordSize != sizeof(Record) || header->capacity == 0 ||
+        (header->capacity & (header->capacity - 1)) != 0 ||
+        region_.size() < shared_tracking::blockSize(header->capacity)) {
+        region_.close();
+        return false;
+    }
+    header_ = header;
+    records_ = reinterpret_cast<Record const*>(
+        static_cast<char const*>(region_.data()) + RecordsOffset);
+    mask_ = header->capacity - 1;
+    // Start from the newest sample
+    const uint64_t count = header_->writeCount.load(std::memory_order_acquire);
+    next_ = count > 0 ? count - 1 : 0;
+    return true;
+}
+
+bool SharedTrackingSource::isConnected() {
+    const int64_t now = SteadyClock::instance().now();
+    if (header_ != nullptr &&
+        now - header_->heartbeatNs.load(std::memory_order_relaxed) <=
+            HeartbeatTimeoutNs) {
+        return true;
+    }
+    // Not open yet, or the writer went away: it may come back under a new
+    // block, so reopen now and then.
+    if (attempted_ && now - lastOpenAttemptNs_ < OpenRetryNs) {
+        return false;
+    }
+    attempted_ = true;
+    lastOpenAttemptNs_ = now;
+    header_ = nullptr;
+    records_ = nullptr;
+    if (!tryOpen()) {
+        return false;
+    }
+    return now - header_->heartbeatNs.load(std::memory_order_relaxed) <=
+           HeartbeatTimeoutNs;
+}
+
+size_t SharedTrackingSource::read(TrackedSample* out, size_t capacity) {
+    if (header_ == nullptr) {
+        return 0;
+    }
+    const uint64_t count = header_->writeCount.load(std::memory_order_acquire);
+    if (count < next_) {
+        // The block was reset under us
+        next_ = count;
+    }
+    const uint64_t ringSize = uint64_t(mask_) + 1;
+    if (count - next_ > ringSize) {
+        lost_ += count - next_ - ringSize;
+        next_ = count - ringSize;
+    }
+    size_t written = 0;
+    while (next_ < count && written < capacity) {
+        Record const& record = records_[next_ & mask_];
+        const uint64_t expected = 2 * (next_ + 1);
+        if (record.sequence.load(std::memory_order_acquire) != expected) {
+            // Overwritten already
+            ++lost_;
+            ++next_;
+            continue;
+        }
+        TrackedSample sample;
+        sample.device = record.device;
+        PoseSample& s = sample.sample;
+        s.timeNs = record.timeNs;
+        s.pose.position = {record.position[0], record.position[1],
+                           record.position[2]};
+        s.pose.orientation = {record.orientation[0], record.orientation[1],
+                              record.orientation[2], record.orientation[3]};
+        s.linearVelocity = {record.linearVelocity[0], record.linearVelocity[1],
+                            record.linearVelocity[2]};
+        s.angularVelocity = {record.angularVelocity[0],
+                             record.angularVelocity[1],
+                             record.angularVelocity[2]};
+        std::atomic_thread_fence(std::memory_order_acquire);
+        ++next_;
+        if (record.sequence.load(std::memory_order_relaxed) != expected) {
+            ++lost_;
+            continue;
+        }
+        out[written++] = sample;
+    }
+    return written;
+}
+
+}  // namespace metaview
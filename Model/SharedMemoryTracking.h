@@ -0,0 +1,191 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include "TrackingSource.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace metaview {
+
+//! Name of the shared memory block the plugin reads by default.
+constexpr const char* DefaultSharedTrackingName = "MetaViewTracking";
+
+/**
+ * @brief Layout of the shared memory block: a header followed by a ring of
+ * records.
+ *
+ * A single writer process appends records; any number of readers follow
+ * along. Each record carries a sequence number, seqlock style: odd while the
+ * writer fills it in, 2 * (index + 1) once record number index is complete.
+ * Readers copy a record and check the sequence number didn't change, so they
+ * never take a lock or make a system call.
+ */
+namespace shared_tracking {
+
+//! "MVTR"
+constexpr uint32_t Magic = 0x5254564d;
+constexpr uint32_t Version = 1;
+//! Records in the ring. A power of two.
+constexpr uint32_t DefaultCapacity = 1024;
+
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t recordSize;
+    //! Records written since the block was created.
+    std::atomic<uint64_t> writeCount;
+    //! SteadyClock time of the writer's last write, so readers can tell a
+    //! writer that went away.
+    std::atomic<int64_t> heartbeatNs;
+};
+
+struct alignas(64) Record {
+    std::atomic<uint64_t> sequence;
+    uint32_t device;
+    uint32_t reserved;
+    //! SteadyClock nanoseconds.
+    int64_t timeNs;
+    //! Right handed, meters. X right, Y up, looking down -Z.
+    float position[3];
+    //! x, y, z, w
+    float orientation[4];
+    float linearVelocity[3];
+    //! Rotation vector per second, in the same space as the pose.
+    float angularVelocity[3];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "Shared memory atomics must be lock free");
+static_assert(std::atomic<int64_t>::is_always_lock_free,
+              "Shared memory atomics must be lock free");
+
+//! Size of a block holding @p capacity records.
+constexpr size_t blockSize(uint32_t capacity) {
+    return sizeof(Record) * ((sizeof(Header) + sizeof(Record) - 1) /
+                             sizeof(Record)) +
+           sizeof(Record) * capacity;
+}
+
+}  // namespace shared_tracking
+
+/**
+ * @brief A named block of memory shared between processes.
+ *
+ * A file mapping in the "Local\" namespace on Windows, POSIX shared memory
+ * elsewhere.
+ */
+class SharedMemoryRegion {
+  public:
+    SharedMemoryRegion() = default;
+    ~SharedMemoryRegion();
+
+    SharedMemoryRegion(SharedMemoryRegion const&) = delete;
+    SharedMemoryRegion& operator=(SharedMemoryRegion const&) = delete;
+
+    /**
+     * @brief Create (or open, if it exists) a block of at least @p size
+     * bytes. Newly created blocks are zeroed.
+     *
+     * @return false on failure.
+     */
+    bool create(std::string const& name, size_t size);
+
+    /**
+     * @brief Open an existing block of @p size bytes.
+     *
+     * @return false if it doesn't exist or is too small.
+     */
+    bool open(std::string const& name, size_t size);
+
+    void close();
+
+    void* data() const noexcept { return data_; }
+    size_t size() const noexcept { return size_; }
+
+  private:
+    bool map(std::string const& name, size_t size, bool create);
+
+    void* data_ = nullptr;
+    size_t size_ = 0;
+    //! Platform handle: a HANDLE on Windows, a file descriptor elsewhere.
+    intptr_t handle_ = -1;
+    //! Name to unlink on close, if we created the block (POSIX only).
+    std::string createdName_;
+};
+
+/**
+ * @brief Publishes poses to shared memory, for a SharedTrackingSource in
+ * another process to read. Used by the external tracker.
+ *
+ * Single threaded: one writer per block.
+ */
+class SharedTrackingWriter {
+  public:
+    /**
+     * @brief Create the block and mark it as ours.
+     *
+     * @throws std::runtime_error if the block can't be created.
+     */
+    explicit SharedTrackingWriter(
+        std::string const& name = DefaultSharedTrackingName,
+        uint32_t capacity = shared_tracking::DefaultCapacity);
+
+    /**
+     * @brief Append a sample. Never blocks.
+     */
+    void write(TrackedSample const& sample);
+
+    /**
+     * @brief Tell readers we're alive without writing a sample.
+     */
+    void heartbeat(int64_t nowNs);
+
+  private:
+    SharedMemoryRegion region_;
+    shared_tracking::Header* header_ = nullptr;
+    shared_tracking::Record* records_ = nullptr;
+    uint32_t mask_ = 0;
+};
+
+/**
+ * @brief Reads poses another process publishes with SharedTrackingWriter.
+ *
+ * Opens the block lazily, retrying at most once a second while it doesn't
+ * exist, so the tracker can start after the plugin. Once open, reading takes
+ * no locks and makes no system calls.
+ */
+class SharedTrackingSource : public ITrackingSource {
+  public:
+    explicit SharedTrackingSource(
+        std::string const& name = DefaultSharedTrackingName);
+
+    bool isConnected() override;
+    size_t read(TrackedSample* out, size_t capacity) override;
+
+    //! Samples the writer overwrote before we got to them.
+    uint64_t getLostSamples() const noexcept { return lost_; }
+
+  private:
+    bool tryOpen();
+
+    std::string name_;
+    SharedMemoryRegion region_;
+    shared_tracking::Header const* header_ = nullptr;
+    shared_tracking::Record const* records_ = nullptr;
+    uint32_t mask_ = 0;
+    //! Index of the next record to read.
+    uint64_t next_ = 0;
+    uint64_t lost_ = 0;
+    int64_t lastOpenAttemptNs_ = 0;
+    bool attempted_ = false;
+};
+
+}  // namespace metaview
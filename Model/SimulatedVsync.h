@@ -0,0 +1,106 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include "Clock.h"
+
+#include <cstdint>
+#include <random>
+
+namespace metaview {
+
+/**
+ * @brief A clock whose time only moves when told to.
+ *
+ * sleepUntil() simply jumps the time forward, so code under test runs as fast
+ * as possible and deterministically.
+ */
+class SimulatedClock : public IClock {
+  public:
+    explicit SimulatedClock(int64_t startNs = 0) : now_(startNs) {}
+
+    int64_t now() const override { return now_; }
+
+    void sleepUntil(int64_t timeNs) override {
+        if (timeNs > now_) {
+            now_ = timeNs;
+        }
+    }
+
+    /**
+     * @brief Move time forward by the given amount.
+     */
+    void advance(int64_t durationNs) { now_ += durationNs; }
+
+  private:
+    int64_t now_;
+};
+
+/**
+ * @brief Simulated display vsync, driving a SimulatedClock.
+ *
+ * Stands in for DisplayDevice::WaitForVBlank when exercising frame pacing
+ * logic without a display.
+ */
+class SimulatedVsync {
+  public:
+    /**
+     * @brief Construct a new Simulated Vsync object
+     *
+     * @param clock The clock to advance. Must outlive this object.
+     * @param periodNs True refresh period.
+     * @param phaseNs Time of vblank 0.
+     * @param jitterNs Maximum absolute error added to reported timestamps,
+     * modelling wake-up latency of the thread observing the vblank.
+     * @param seed Seed for the jitter generator.
+     */
+    SimulatedVsync(SimulatedClock& clock, int64_t periodNs, int64_t phaseNs = 0,
+                   int64_t jitterNs = 0, uint32_t seed = 0)
+        : clock_(clock),
+          periodNs_(periodNs),
+          phaseNs_(phaseNs),
+          jitter_(-jitterNs, jitterNs),
+          rng_(seed) {}
+
+    /**
+     * @brief Get the true time of the first vblank strictly after the given
+     * time.
+     */
+    int64_t vblankAfter(int64_t timeNs) const {
+        if (timeNs < phaseNs_) {
+            return phaseNs_;
+        }
+        int64_t index = (timeNs - phaseNs_) / periodNs_ + 1;
+        return phaseNs_ + index * periodNs_;
+    }
+
+    /**
+     * @brief Block (advance the clock) until the next vblank.
+     *
+     * @return the observed timestamp of that vblank, including jitter.
+     */
+    int64_t waitForVBlank() {
+        int64_t vblank = vblankAfter(clock_.now());
+        int64_t observed = vblank + jitter_(rng_);
+        if (observed < vblank) {
+            // can't observe it before it happens
+            observed = vblank;
+        }
+        clock_.sleepUntil(observed);
+        return observed;
+    }
+
+    int64_t getPeriod() const { return periodNs_; }
+
+  private:
+    SimulatedClock& clock_;
+    int64_t periodNs_;
+    int64_t phaseNs_;
+    std::uniform_int_distribution<int64_t> jitter_;
+    std::minstd_rand rng_;
+};
+
+}  // namespace metaview
@@ -0,0 +1,108 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace metaview {
+
+/**
+ * @brief Bounded lock-free single-producer/single-consumer ring buffer.
+ *
+ * Exactly one thread may call tryPush() and exactly one (other) thread may
+ * call tryPop(). Neither ever blocks or allocates.
+ *
+ * @tparam T Element type: must be default constructible and copy assignable.
+ * Intended for small records.
+ */
+template <typename T> class SpscQueue {
+    static_assert(std::is_default_constructible<T>::value,
+                  "Element type must be default constructible");
+
+  public:
+    /**
+     * @brief Construct a new Spsc Queue object
+     *
+     * @param capacity Minimum number of elements the queue can hold. Rounded
+     * up to a power of two.
+     */
+    explicit SpscQueue(size_t capacity)
+        : buffer_(roundUpToPowerOfTwo(capacity)), mask_(buffer_.size() - 1) {}
+
+    SpscQueue(SpscQueue const&) = delete;
+    SpscQueue& operator=(SpscQueue const&) = delete;
+
+    /**
+     * @brief Add an element. Producer thread only.
+     *
+     * @return false if the queue was full (element not added).
+     */
+    bool tryPush(T const& value) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) >= buffer_.size()) {
+            return false;
+        }
+        buffer_[tail & mask_] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Remove the oldest element. Consumer thread only.
+     *
+     * @return false if the queue was empty (out parameter untouched).
+     */
+    bool tryPop(T& out) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        out = buffer_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Whether the queue is empty. Only a snapshot if called while the
+     * other thread is active.
+     */
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) ==
+               tail_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Number of elements queued. Only a snapshot if called while the
+     * other thread is active.
+     */
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) -
+               head_.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const noexcept { return buffer_.size(); }
+
+  private:
+    static size_t roundUpToPowerOfTwo(size_t n) {
+        size_t ret = 1;
+        while (ret < n) {
+            ret <<= 1;
+        }
+        return ret;
+    }
+
+    std::vector<T> buffer_;
+    const size_t mask_;
+    //! Index of next element to pop. Written by consumer only.
+    alignas(64) std::atomic<size_t> head_{0};
+    //! Index of next slot to push. Written by producer only.
+    alignas(64) std::atomic<size_t> tail_{0};
+};
+
+}  // namespace metaview
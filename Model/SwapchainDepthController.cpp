@@ -0,0 +1,37 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#include "SwapchainDepthController.h"
+
+namespace metaview {
+
+uint32_t SwapchainDepthController::update(double cpuFrameMs, double gpuFrameMs,
+                                          double periodMs) {
+    if (periodMs <= 0 || cpuFrameMs < 0 || gpuFrameMs <= 0) {
+        return depth_;
+    }
+    load_ = (cpuFrameMs + gpuFrameMs) / periodMs;
+
+    const bool deep = depth_ == config_.maxDepth;
+    const bool wantSwitch =
+        deep ? load_ < config_.lowerLoad : load_ > config_.raiseLoad;
+    if (!wantSwitch) {
+        streak_ = 0;
+        return depth_;
+    }
+    if (++streak_ >= (deep ? config_.lowerFrames : config_.raiseFrames)) {
+        depth_ = deep ? config_.minDepth : config_.maxDepth;
+        streak_ = 0;
+    }
+    return depth_;
+}
+
+void SwapchainDepthController::reset() {
+    depth_ = config_.minDepth;
+    load_ = 0;
+    streak_ = 0;
+}
+
+}  // namespace metaview
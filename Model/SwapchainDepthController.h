@@ -0,0 +1,86 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include <cstdint>
+
+namespace metaview {
+
+/**
+ * @brief Tuning parameters for a SwapchainDepthController.
+ */
+struct SwapchainDepthConfig {
+    //! Depth used while the load is light: lowest latency.
+    uint32_t minDepth = 2;
+
+    //! Depth used while CPU and GPU must overlap to keep up.
+    uint32_t maxDepth = 3;
+
+    //! Go deeper once CPU plus GPU time exceeds this fraction of the refresh
+    //! period...
+    double raiseLoad = 0.9;
+
+    //! ...for this many frames in a row.
+    uint32_t raiseFrames = 30;
+
+    //! Go back to the shallow depth once CPU plus GPU time is under this
+    //! fraction of the period...
+    double lowerLoad = 0.7;
+
+    //! ...for this many frames in a row. Longer than raiseFrames: a hitch is
+    //! worse than a little extra latency.
+    uint32_t lowerFrames = 300;
+};
+
+/**
+ * @brief Picks between double and triple buffering from how much the CPU and
+ * GPU work of a frame have to overlap.
+ *
+ * If the CPU and GPU time of a frame add up to less than the refresh period,
+ * two surfaces suffice and give the lowest latency. Once they don't, the GPU
+ * is still finishing a frame while the next one is being recorded, which
+ * only works without stalls or rendering into the surface on screen if
+ * there's a third surface.
+ *
+ * Pure logic: feed it one frame's measurements at a time.
+ */
+class SwapchainDepthController {
+  public:
+    explicit SwapchainDepthController(SwapchainDepthConfig const& config = {})
+        : config_(config), depth_(config.minDepth) {}
+
+    /**
+     * @brief Feed the measurements of a frame.
+     *
+     * @param cpuFrameMs CPU time spent producing the frame.
+     * @param gpuFrameMs GPU time spent rendering it.
+     * @param periodMs Refresh period.
+     * @return the depth to use from now on.
+     */
+    uint32_t update(double cpuFrameMs, double gpuFrameMs, double periodMs);
+
+    uint32_t getDepth() const noexcept { return depth_; }
+
+    /**
+     * @brief Get the most recent CPU plus GPU time as a fraction of the
+     * period.
+     */
+    double getLoad() const noexcept { return load_; }
+
+    /**
+     * @brief Go back to the shallow depth and forget all history.
+     */
+    void reset();
+
+  private:
+    SwapchainDepthConfig config_;
+    uint32_t depth_;
+    double load_ = 0;
+    //! Consecutive frames beyond the threshold for switching depth.
+    uint32_t streak_ = 0;
+};
+
+}  // namespace metaview
@@ -0,0 +1,109 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#include "Timebase.h"
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace metaview {
+
+static constexpr int64_t NsPerMs = 1'000'000;
+
+Timebase::Timebase(IClock& clock, TimebaseConfig const& config)
+    : clock_(clock), config_(config) {
+    syncWallClock();
+}
+
+Timebase& Timebase::instance() {
+    static Timebase timebase;
+    return timebase;
+}
+
+void Timebase::syncWallClock() {
+    // Bracket the wall clock read, to pair it with the middle
+    const int64_t before = now();
+    const int64_t wallClockNs =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    const int64_t after = now();
+    syncWallClock(before + (after - before) / 2, wallClockNs);
+}
+
+void Timebase::syncWallClock(int64_t timeNs, int64_t wallClockNs) {
+    std::lock_guard<std::mutex> lock(wallClockMutex_);
+    const int64_t measured = wallClockNs - timeNs;
+    const int64_t offset = wallClockOffsetNs_.load(std::memory_order_relaxed);
+    const int64_t error = measured - offset;
+    if (!wallClockSynced_ || std::abs(error) > config_.wallClockStepNs) {
+        wallClockOffsetNs_.store(measured, std::memory_order_relaxed);
+        wallClockSynced_ = true;
+        return;
+    }
+    const int64_t slew = static_cast<int64_t>(
+        std::llround(static_cast<double>(error) * config_.wallClockSlewGain));
+    const int64_t correction =
+        std::min(std::max(slew, -config_.maxWallClockSlewNs),
+                 config_.maxWallClockSlewNs);
+    wallClockOffsetNs_.store(offset + correction, std::memory_order_relaxed);
+}
+
+int64_t Timebase::toUnityTimestamp(int64_t timeNs) const {
+    const int64_t wallClockNs =
+        timeNs + wallClockOffsetNs_.load(std::memory_order_relaxed);
+    return (wallClockNs + NsPerMs / 2) / NsPerMs;
+}
+
+int64_t Timebase::fromUnityTimestamp(int64_t unityTimestampMs) const {
+    return unityTimestampMs * NsPerMs -
+           wallClockOffsetNs_.load(std::memory_order_relaxed);
+}
+
+void Timebase::attachVBlankModel(FramePacer const* pacer) {
+    std::lock_guard<std::mutex> lock(vblankMutex_);
+    vblankModel_ = pacer;
+}
+
+void Timebase::detachVBlankModel(FramePacer const* pacer) {
+    std::lock_guard<std::mutex> lock(vblankMutex_);
+    if (vblankModel_ == pacer) {
+        vblankModel_ = nullptr;
+    }
+}
+
+bool Timebase::hasVBlankModel() const {
+    std::lock_guard<std::mutex> lock(vblankMutex_);
+    return vblankModel_ != nullptr && vblankModel_->isLocked();
+}
+
+int64_t Timebase::getVBlankPeriod() const {
+    std::lock_guard<std::mutex> lock(vblankMutex_);
+    return vblankModel_ != nullptr && vblankModel_->isLocked()
+               ? vblankModel_->getPeriod()
+               : 0;
+}
+
+int64_t Timebase::vblankToTime(int64_t vblankCount) const {
+    std::lock_guard<std::mutex> lock(vblankMutex_);
+    return vblankModel_ != nullptr ? vblankModel_->vblankToTime(vblankCount)
+                                   : 0;
+}
+
+double Timebase::timeToVBlank(int64_t timeNs) const {
+    std::lock_guard<std::mutex> lock(vblankMutex_);
+    return vblankModel_ != nullptr ? vblankModel_->timeToVBlank(timeNs) : 0;
+}
+
+int64_t Timebase::predictVBlankAtOrAfter(int64_t timeNs) const {
+    std::lock_guard<std::mutex> lock(vblankMutex_);
+    return vblankModel_ != nullptr && vblankModel_->isLocked()
+               ? vblankModel_->predictVBlankAtOrAfter(timeNs)
+               : 0;
+}
+
+}  // namespace metaview
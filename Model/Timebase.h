@@ -0,0 +1,153 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include "Clock.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+namespace metaview {
+
+/**
+ * @brief Tuning parameters for a Timebase.
+ */
+struct TimebaseConfig {
+    //! A wall clock that moved further than this from where we expect it was
+    //! set, rather than drifting: follow it at once.
+    int64_t wallClockStepNs = 100'000'000;
+
+    //! Fraction of the wall clock drift corrected per syncWallClock().
+    double wallClockSlewGain = 1.0 / 16;
+
+    //! Most the wall clock mapping may move per syncWallClock() while
+    //! slewing, so converted times stay monotonic at any sensible tick rate.
+    int64_t maxWallClockSlewNs = 500'000;
+};
+
+class FramePacer;
+
+/**
+ * @brief The one timebase shared by the input and display providers.
+ *
+ * Time is monotonic nanoseconds from the underlying clock: SteadyClock, the
+ * timebase of poses, tracking sources and frame pacing. On top of that:
+ *
+ *  - Unity timestamps (milliseconds of UTC since the Unix epoch) convert to
+ *    and from it through an offset that follows the wall clock, stepping when
+ *    the wall clock is set and slewing gradually when it drifts, so
+ *    conversions keep full resolution and never jump by more than a step.
+ *  - Display vblank counts convert to and from it through the period and
+ *    phase the display's FramePacer fits to observed vblank timestamps, so
+ *    the display's drift from its nominal rate is corrected continuously and
+ *    there is one vblank model, not two that could disagree.
+ *
+ * Thread-safe.
+ */
+class Timebase : public IClock {
+  public:
+    /**
+     * @param clock The monotonic clock. Must outlive this object.
+     */
+    explicit Timebase(IClock& clock = SteadyClock::instance(),
+                      TimebaseConfig const& config = {});
+
+    int64_t now() const override { return clock_.now(); }
+    void sleepUntil(int64_t timeNs) override { clock_.sleepUntil(timeNs); }
+
+    /**
+     * @brief Get the shared instance, over SteadyClock.
+     */
+    static Timebase& instance();
+
+    /**
+     * @brief Correct the wall clock mapping against the system wall clock.
+     * Call regularly, e.g. once per input update.
+     */
+    void syncWallClock();
+
+    /**
+     * @brief Correct the wall clock mapping given the wall clock time (in
+     * nanoseconds since the Unix epoch) at a time in our timebase.
+     */
+    void syncWallClock(int64_t timeNs, int64_t wallClockNs);
+
+    /**
+     * @brief Convert a time to a Unity timestamp, rounding to the nearest
+     * millisecond.
+     */
+    int64_t toUnityTimestamp(int64_t timeNs) const;
+
+    /**
+     * @brief Convert a Unity timestamp to a time.
+     */
+    int64_t fromUnityTimestamp(int64_t unityTimestampMs) const;
+
+    /**
+     * @brief The current time as a Unity timestamp.
+     */
+    int64_t getUnityTimestamp() const { return toUnityTimestamp(now()); }
+
+    /**
+     * @brief Take vblank conversions from @p pacer, the frame pacer of the
+     * display now in use, until detachVBlankModel().
+     *
+     * @p pacer must stay valid until detached. Its counts are those of
+     * FramePacer::getVBlankCount().
+     */
+    void attachVBlankModel(FramePacer const* pacer);
+
+    /**
+     * @brief Stop taking vblank conversions from @p pacer, if it is the one
+     * attached. Returns once no call is using it.
+     */
+    void detachVBlankModel(FramePacer const* pacer);
+
+    /**
+     * @brief Whether a vblank model is attached and locked, so vblank counts
+     * convert.
+     */
+    bool hasVBlankModel() const;
+
+    /**
+     * @brief Get the tracked refresh period, or 0 without a model.
+     */
+    int64_t getVBlankPeriod() const;
+
+    /**
+     * @brief Get when vblank number @p vblankCount happened or will happen,
+     * or 0 without a model.
+     */
+    int64_t vblankToTime(int64_t vblankCount) const;
+
+    /**
+     * @brief Get the (fractional) vblank count at a time, or 0 without a
+     * model.
+     */
+    double timeToVBlank(int64_t timeNs) const;
+
+    /**
+     * @brief Get the first vblank at or after a time, or 0 without a model.
+     */
+    int64_t predictVBlankAtOrAfter(int64_t timeNs) const;
+
+  private:
+    IClock& clock_;
+    TimebaseConfig config_;
+
+    //! Unix epoch time minus our time.
+    std::atomic<int64_t> wallClockOffsetNs_{0};
+    std::atomic_bool wallClockSynced_{false};
+    //! Serializes syncWallClock() calls.
+    std::mutex wallClockMutex_;
+
+    //! Guards vblankModel_, and keeps it alive while in use.
+    mutable std::mutex vblankMutex_;
+    FramePacer const* vblankModel_ = nullptr;
+};
+
+}  // namespace metaview
@@ -0,0 +1,88 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#include "TimestampQueryRing.h"
+
+#include <stdexcept>
+
+namespace metaview {
+
+double TimestampFrame::elapsedMs(size_t from, size_t to) const {
+    if (!has(from) || !has(to) || frequency == 0 || ticks[to] < ticks[from]) {
+        return -1;
+    }
+    return static_cast<double>(ticks[to] - ticks[from]) * 1000.0 /
+           static_cast<double>(frequency);
+}
+
+TimestampQueryRing::TimestampQueryRing(ITimestampQuerySource& source,
+                                       size_t depth, size_t numPoints)
+    : source_(source), slots_(depth < 1 ? 1 : depth), numPoints_(numPoints) {
+    if (numPoints_ > 32) {
+        throw std::invalid_argument("At most 32 timestamps per frame");
+    }
+}
+
+bool TimestampQueryRing::beginFrame() {
+    if (inFrame_) {
+        endFrame();
+    }
+    inFrame_ = true;
+    ++frameNumber_;
+    if (pending_ == slots_.size()) {
+        ++skipped_;
+        return false;
+    }
+    Slot& slot = slots_[next_];
+    slot.frameNumber = frameNumber_;
+    slot.writtenMask = 0;
+    source_.begin(next_);
+    recording_ = true;
+    return true;
+}
+
+void TimestampQueryRing::mark(size_t point) {
+    if (!recording_ || point >= numPoints_) {
+        return;
+    }
+    source_.timestamp(next_, point);
+    slots_[next_].writtenMask |= 1u << point;
+}
+
+void TimestampQueryRing::endFrame() {
+    inFrame_ = false;
+    if (!recording_) {
+        return;
+    }
+    source_.end(next_);
+    recording_ = false;
+    next_ = (next_ + 1) % slots_.size();
+    ++pending_;
+}
+
+bool TimestampQueryRing::tryCollectOne(TimestampFrame& frame) {
+    while (pending_ > 0) {
+        const size_t oldest =
+            (next_ + slots_.size() - pending_) % slots_.size();
+        Slot const& slot = slots_[oldest];
+        frame.ticks.assign(numPoints_, 0);
+        bool disjoint = false;
+        if (!source_.tryRead(oldest, slot.writtenMask, frame.ticks.data(),
+                             frame.frequency, disjoint)) {
+            return false;
+        }
+        --pending_;
+        if (disjoint) {
+            ++disjoint_;
+            continue;
+        }
+        frame.frameNumber = slot.frameNumber;
+        frame.writtenMask = slot.writtenMask;
+        return true;
+    }
+    return false;
+}
+
+}  // namespace metaview
@@ -0,0 +1,166 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace metaview {
+
+/**
+ * @brief Graphics-API-specific half of GPU timestamp queries.
+ *
+ * Owns a fixed number of "slots", each able to hold one frame's worth of
+ * timestamps. TimestampQueryRing decides which slot to use when.
+ */
+class ITimestampQuerySource {
+  public:
+    virtual ~ITimestampQuerySource() = default;
+
+    /**
+     * @brief Start a frame of queries in a slot (e.g. begin a disjoint query).
+     */
+    virtual void begin(size_t slot) = 0;
+
+    /**
+     * @brief Record timestamp number @p point for the frame in a slot.
+     */
+    virtual void timestamp(size_t slot, size_t point) = 0;
+
+    /**
+     * @brief Finish the frame of queries in a slot.
+     */
+    virtual void end(size_t slot) = 0;
+
+    /**
+     * @brief Read back a slot's results if they are available. Must not wait.
+     *
+     * @param slot Slot to read.
+     * @param writtenMask Bit i set if timestamp i was recorded this frame.
+     * @param[out] ticks Receives one value per recorded timestamp (others are
+     * left alone).
+     * @param[out] frequency Timestamp ticks per second.
+     * @param[out] disjoint Whether the timestamps can't be trusted (e.g. the
+     * GPU clock changed).
+     * @return false if the results aren't ready yet.
+     */
+    virtual bool tryRead(size_t slot, uint32_t writtenMask, uint64_t* ticks,
+                         uint64_t& frequency, bool& disjoint) = 0;
+};
+
+/**
+ * @brief One frame's worth of timestamps, as read back.
+ */
+struct TimestampFrame {
+    //! Frame number, counting every beginFrame() including skipped ones.
+    uint64_t frameNumber = 0;
+    //! Bit i set if ticks[i] is valid.
+    uint32_t writtenMask = 0;
+    std::vector<uint64_t> ticks;
+    uint64_t frequency = 0;
+
+    bool has(size_t point) const { return (writtenMask >> point) & 1u; }
+
+    /**
+     * @brief Milliseconds between two timestamps, or a negative value if
+     * either wasn't recorded.
+     */
+    double elapsedMs(size_t from, size_t to) const;
+};
+
+/**
+ * @brief A ring of timestamp query sets, N frames deep, read back without
+ * ever stalling.
+ *
+ * Each frame: beginFrame(), any number of mark() calls, endFrame(). Call
+ * collect() once per frame to receive the frames whose results have arrived,
+ * oldest first. If every slot is still waiting on the GPU, the new frame is
+ * skipped rather than waiting.
+ *
+ * Single threaded.
+ */
+class TimestampQueryRing {
+  public:
+    /**
+     * @brief Construct a new Timestamp Query Ring object
+     *
+     * @param source Query backend, with at least @p depth slots. Must outlive
+     * this object.
+     * @param depth Number of frames that may be in flight.
+     * @param numPoints Timestamps per frame, at most 32.
+     */
+    TimestampQueryRing(ITimestampQuerySource& source, size_t depth,
+                       size_t numPoints);
+
+    /**
+     * @brief Start recording a frame.
+     *
+     * @return false if the ring is full, in which case this frame's marks are
+     * ignored.
+     */
+    bool beginFrame();
+
+    /**
+     * @brief Record a timestamp in the current frame.
+     */
+    void mark(size_t point);
+
+    /**
+     * @brief Finish recording the current frame.
+     */
+    void endFrame();
+
+    /**
+     * @brief Hand every frame whose results are available to a callback,
+     * oldest first, stopping at the first one that isn't ready.
+     *
+     * @return number of frames collected.
+     */
+    template <typename F> size_t collect(F&& onFrame) {
+        size_t count = 0;
+        TimestampFrame frame;
+        while (tryCollectOne(frame)) {
+            onFrame(static_cast<TimestampFrame const&>(frame));
+            ++count;
+        }
+        return count;
+    }
+
+    size_t getDepth() const noexcept { return slots_.size(); }
+    size_t getNumPoints() const noexcept { return numPoints_; }
+
+    //! Frames not measured because the ring was full.
+    uint64_t getSkippedFrames() const noexcept { return skipped_; }
+
+    //! Frames read back but discarded as disjoint.
+    uint64_t getDisjointFrames() const noexcept { return disjoint_; }
+
+  private:
+    bool tryCollectOne(TimestampFrame& frame);
+
+    struct Slot {
+        uint64_t frameNumber = 0;
+        uint32_t writtenMask = 0;
+    };
+
+    ITimestampQuerySource& source_;
+    std::vector<Slot> slots_;
+    size_t numPoints_;
+    //! Next slot to record into.
+    size_t next_ = 0;
+    //! Slots recorded but not yet read back.
+    size_t pending_ = 0;
+    //! Whether a frame is being recorded into slots_[next_].
+    bool recording_ = false;
+    //! Whether beginFrame() was called and endFrame() not yet.
+    bool inFrame_ = false;
+    uint64_t frameNumber_ = 0;
+    uint64_t skipped_ = 0;
+    uint64_t disjoint_ = 0;
+};
+
+}  // namespace metaview
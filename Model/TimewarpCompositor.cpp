@@ -0,0 +1,573 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#include "TimewarpCompositor.h"
+#include "Blitter.h"
+#include "Timebase.h"
+
+#include <d3dcompiler.h>
+#include <windows.devices.display.core.interop.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+// Import things into the winrt namespace, removing extra qualifications.
+namespace winrt {
+using winrt::Windows::Devices::Display::Core::DisplayTask;
+}  // namespace winrt
+
+namespace metaview {
+
+static const char WarpShaderSource[] = R"(
+cbuffer WarpConstants : register(b0) {
+    // Homography from output to source texture coordinates, by rows
+    float4 warpRow0;
+    float4 warpRow1;
+    float4 warpRow2;
+    // Region of the source holding this eye
+    float4 sourceRect;
+};
+
+Texture2D source : register(t0);
+SamplerState linearSampler : register(s0);
+
+struct VSOut {
+    float4 position : SV_Position;
+    float2 uv : TEXCOORD0;
+};
+
+// Fullscreen triangle, no vertex buffer needed.
+VSOut vsMain(uint id : SV_VertexID) {
+    VSOut ret;
+    float2 uv = float2((id << 1) & 2, id & 2);
+    ret.position = float4(uv * float2(2, -2) + float2(-1, 1), 0, 1);
+    ret.uv = uv;
+    return ret;
+}
+
+float4 psMain(VSOut input) : SV_Target {
+    float3 p = float3(input.uv, 1);
+    float3 s = float3(dot(warpRow0.xyz, p), dot(warpRow1.xyz, p),
+                      dot(warpRow2.xyz, p));
+    float2 uv = s.xy / s.z;
+    if (s.z <= 0 || any(uv < 0) || any(uv > 1)) {
+        return float4(0, 0, 0, 1);
+    }
+    return source.SampleLevel(linearSampler,
+                              sourceRect.xy + uv * sourceRect.zw, 0);
+}
+)";
+
+static const char GridShaderSource[] = R"(
+cbuffer GridConstants : register(b0) {
+    // Tangents of the half angles: left, right, top, bottom
+    float4 fov;
+    // Render eye to display eye: rotation by rows, translation in w
+    float4 deltaRow0;
+    float4 deltaRow1;
+    float4 deltaRow2;
+    // Region of the source holding this eye
+    float4 sourceRect;
+    // Grid columns and rows
+    float4 grid;
+};
+
+Texture2D source : register(t0);
+Texture2D<float> depth : register(t1);
+SamplerState linearSampler : register(s0);
+
+struct VSOut {
+    float4 position : SV_Position;
+    float2 uv : TEXCOORD0;
+};
+
+static const float2 Corners[6] = {float2(0, 0), float2(1, 0), float2(0, 1),
+                                  float2(0, 1), float2(1, 0), float2(1, 1)};
+
+// Two triangles per grid cell, no vertex buffer needed.
+VSOut vsGrid(uint id : SV_VertexID) {
+    uint cell = id / 6;
+    uint columns = (uint)grid.x;
+    float2 uv = (float2(cell % columns, cell / columns) + Corners[id % 6]) /
+                grid.xy;
+
+    // Depth texel under the vertex
+    uint width, height;
+    depth.GetDimensions(width, height);
+    float2 eyeSize = sourceRect.zw * float2(width, height);
+    float2 texel = sourceRect.xy * float2(width, height) +
+                   min(floor(uv * eyeSize), eyeSize - 1);
+    float d = depth.Load(int3(texel, 0));
+
+    // Unproject (z = -1), move to the display eye, project again
+    float3 dir = float3(fov.x + uv.x * (fov.y - fov.x),
+                        fov.z + uv.y * (fov.w - fov.z), -1);
+    float3 p = d > 0 ? dir * d : dir;
+    float3 q = float3(dot(deltaRow0.xyz, p), dot(deltaRow1.xyz, p),
+                      dot(deltaRow2.xyz, p));
+    if (d > 0) {
+        q += float3(deltaRow0.w, deltaRow1.w, deltaRow2.w);
+    }
+    float w = -q.z;
+
+    VSOut ret;
+    ret.uv = sourceRect.xy + uv * sourceRect.zw;
+    if (w <= 0) {
+        // Behind the display eye: clipped
+        ret.position = float4(0, 0, -1, 1);
+        return ret;
+    }
+    float2 t = float2((q.x / w - fov.x) / (fov.y - fov.x),
+                      (q.y / w - fov.z) / (fov.w - fov.z));
+    float key = d > 0 ? w / (w + 1) : 1;
+    ret.position = float4(t.x * 2 - 1, 1 - t.y * 2, key, 1);
+    return ret;
+}
+
+float4 psGrid(VSOut input) : SV_Target {
+    return source.SampleLevel(linearSampler, input.uv, 0);
+}
+)";
+
+struct WarpConstants {
+    float warp[3][4];
+    float sourceRect[4];
+};
+
+struct GridConstants {
+    float fov[4];
+    float delta[3][4];
+    float sourceRect[4];
+    float grid[4];
+};
+
+//! How many submitted frames we remember, to find the newest finished one.
+static constexpr size_t MaxSubmitted = 4;
+
+template <size_t N>
+static winrt::com_ptr<ID3DBlob> compileShader(const char (&source)[N],
+                                              const char* entryPoint,
+                                              const char* target) {
+    winrt::com_ptr<ID3DBlob> code;
+    winrt::com_ptr<ID3DBlob> errors;
+    HRESULT hr = D3DCompile(source, N - 1, "TimewarpCompositor", nullptr,
+                            nullptr, entryPoint, target,
+                            D3DCOMPILE_OPTIMIZATION_LEVEL3, 0, code.put(),
+                            errors.put());
+    if (FAILED(hr)) {
+        std::string message = "Could not compile timewarp shader";
+        if (errors) {
+            message += ": ";
+            message += static_cast<const char*>(errors->GetBufferPointer());
+        }
+        throw std::runtime_error(message);
+    }
+    return code;
+}
+
+TimewarpCompositor::TimewarpCompositor(TimewarpCompositorDesc const& desc)
+    : params_(*desc.params),
+      pacer_(*desc.pacer),
+      taskPool_(desc.taskPool),
+      scanouts_(desc.scanouts),
+      releaseValues_(desc.sourceHandles.size(), 0),
+      outputCount_(desc.scanouts.size()) {
+    // Our own device, so composition never waits for the app's context
+    winrt::com_ptr<ID3D11DeviceContext> context;
+    std::tie(device_, context) = params_.createBasicD3D11Device();
+    context.as(context_);
+
+    for (auto const& output : desc.outputs) {
+        auto [texture, rtv] = params_.ConvertSurface(device_, output);
+        outputTextures_.push_back(std::move(texture));
+        outputRtvs_.push_back(std::move(rtv));
+    }
+    D3D11_TEXTURE2D_DESC outputDesc;
+    outputTextures_[0]->GetDesc(&outputDesc);
+    width_ = outputDesc.Width;
+    height_ = outputDesc.Height;
+
+    for (HANDLE handle : desc.sourceHandles) {
+        winrt::com_ptr<ID3D11Texture2D> texture;
+        texture.capture(device_, &ID3D11Device5::OpenSharedResource1, handle);
+        D3D11_TEXTURE2D_DESC texDesc;
+        texture->GetDesc(&texDesc);
+        D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+        viewDesc.Format = getTypedFormat(texDesc.Format);
+        viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+        viewDesc.Texture2D.MipLevels = 1;
+        winrt::com_ptr<ID3D11ShaderResourceView> view;
+        winrt::check_hresult(device_->CreateShaderResourceView(
+            texture.get(), &viewDesc, view.put()));
+        sourceViews_.push_back(std::move(view));
+    }
+    for (HANDLE handle : desc.depthHandles) {
+        winrt::com_ptr<ID3D11Texture2D> texture;
+        texture.capture(device_, &ID3D11Device5::OpenSharedResource1, handle);
+        D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+        viewDesc.Format = DXGI_FORMAT_R32_FLOAT;
+        viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+        viewDesc.Texture2D.MipLevels = 1;
+        winrt::com_ptr<ID3D11ShaderResourceView> view;
+        winrt::check_hresult(device_->CreateShaderResourceView(
+            texture.get(), &viewDesc, view.put()));
+        depthViews_.push_back(std::move(view));
+    }
+    if (depthViews_.size() != sourceViews_.size()) {
+        depthViews_.clear();
+    }
+    sourceFence_.capture(device_, &ID3D11Device5::OpenSharedFence,
+                         desc.sourceFenceHandle);
+
+    // Fence the display waits on before scanning out our output
+    fence_.capture(device_, &ID3D11Device5::CreateFence, 0,
+                   D3D11_FENCE_FLAG_SHARED);
+    winrt::check_hresult(fence_->CreateSharedHandle(
+        nullptr, GENERIC_ALL, nullptr, fenceHandle_.put()));
+    winrt::com_ptr<::IInspectable> displayFenceInspectable;
+    displayFenceInspectable.capture(
+        params_.device.as<IDisplayDeviceInterop>(),
+        &IDisplayDeviceInterop::OpenSharedHandle, fenceHandle_.get());
+    displayFence_ = displayFenceInspectable.as<winrt::DisplayFence>();
+
+    auto vsCode = compileShader(WarpShaderSource, "vsMain", "vs_5_0");
+    winrt::check_hresult(device_->CreateVertexShader(
+        vsCode->GetBufferPointer(), vsCode->GetBufferSize(), nullptr,
+        vertexShader_.put()));
+    auto psCode = compileShader(WarpShaderSource, "psMain", "ps_5_0");
+    winrt::check_hresult(device_->CreatePixelShader(
+        psCode->GetBufferPointer(), psCode->GetBufferSize(), nullptr,
+        pixelShader_.put()));
+
+    D3D11_SAMPLER_DESC samplerDesc = {};
+    samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+    samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+    samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+    winrt::check_hresult(
+        device_->CreateSamplerState(&samplerDesc, sampler_.put()));
+
+    D3D11_RASTERIZER_DESC rasterizerDesc = {};
+    rasterizerDesc.FillMode = D3D11_FILL_SOLID;
+    rasterizerDesc.CullMode = D3D11_CULL_NONE;
+    rasterizerDesc.DepthClipEnable = TRUE;
+    winrt::check_hresult(
+        device_->CreateRasterizerState(&rasterizerDesc, rasterizer_.put()));
+
+    D3D11_BUFFER_DESC bufferDesc = {};
+    bufferDesc.ByteWidth = sizeof(WarpConstants);
+    bufferDesc.Usage = D3D11_USAGE_DEFAULT;
+    bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    winrt::check_hresult(
+        device_->CreateBuffer(&bufferDesc, nullptr, constants_.put()));
+
+    if (!depthViews_.empty()) {
+        auto gridVsCode = compileShader(GridShaderSource, "vsGrid", "vs_5_0");
+        winrt::check_hresult(device_->CreateVertexShader(
+            gridVsCode->GetBufferPointer(), gridVsCode->GetBufferSize(),
+            nullptr, gridVertexShader_.put()));
+        auto gridPsCode = compileShader(GridShaderSource, "psGrid", "ps_5_0");
+        winrt::check_hresult(device_->CreatePixelShader(
+            gridPsCode->GetBufferPointer(), gridPsCode->GetBufferSize(),
+            nullptr, gridPixelShader_.put()));
+
+        bufferDesc.ByteWidth = sizeof(GridConstants);
+        winrt::check_hresult(
+            device_->CreateBuffer(&bufferDesc, nullptr, gridConstants_.put()));
+
+        D3D11_TEXTURE2D_DESC depthDesc = {};
+        depthDesc.Width = width_;
+        depthDesc.Height = height_;
+        depthDesc.MipLevels = 1;
+        depthDesc.ArraySize = 1;
+        depthDesc.Format = DXGI_FORMAT_D32_FLOAT;
+        depthDesc.SampleDesc.Count = 1;
+        depthDesc.Usage = D3D11_USAGE_DEFAULT;
+        depthDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
+        winrt::com_ptr<ID3D11Texture2D> depthTexture;
+        winrt::check_hresult(
+            device_->CreateTexture2D(&depthDesc, nullptr, depthTexture.put()));
+        winrt::check_hresult(device_->CreateDepthStencilView(
+            depthTexture.get(), nullptr, depthStencil_.put()));
+
+        // Nearest surface wins; ties go to the later triangle.
+        D3D11_DEPTH_STENCIL_DESC depthStateDesc = {};
+        depthStateDesc.DepthEnable = TRUE;
+        depthStateDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+        depthStateDesc.DepthFunc = D3D11_COMPARISON_LESS_EQUAL;
+        winrt::check_hresult(device_->CreateDepthStencilState(
+            &depthStateDesc, depthState_.put()));
+    }
+
+    submitted_.reserve(MaxSubmitted);
+    thread_ = std::thread([this] { threadFunc(); });
+}
+
+TimewarpCompositor::~TimewarpCompositor() {
+    stop_ = true;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void TimewarpCompositor::submit(size_t sourceIndex, uint64_t fenceValue,
+                                Posef const& renderPose) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (submitted_.size() == MaxSubmitted) {
+        submitted_.erase(submitted_.begin());
+    }
+    submitted_.push_back(Submitted{sourceIndex, fenceValue, renderPose});
+}
+
+uint64_t TimewarpCompositor::acquire(size_t sourceIndex) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    submitted_.erase(std::remove_if(submitted_.begin(), submitted_.end(),
+                                    [&](Submitted const& frame) {
+                                        return frame.sourceIndex ==
+                                               sourceIndex;
+                                    }),
+                     submitted_.end());
+    composed_.wait(lock, [&] {
+        return composingIndex_ != static_cast<ptrdiff_t>(sourceIndex);
+    });
+    return sourceIndex < releaseValues_.size() ? releaseValues_[sourceIndex]
+                                               : 0;
+}
+
+void TimewarpCompositor::setOutputCount(size_t count) {
+    outputCount_ = std::min(std::max<size_t>(count, 1), scanouts_.size());
+}
+
+void TimewarpCompositor::setPoseProvider(PoseProvider provider) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    poseProvider_ = std::move(provider);
+}
+
+void TimewarpCompositor::setEyeFov(EyeFov const& left, EyeFov const& right) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    fov_[0] = left;
+    fov_[1] = right;
+}
+
+void TimewarpCompositor::setEyeOffsets(Vec3f const& left,
+                                       Vec3f const& right) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    eyeOffsets_[0] = left;
+    eyeOffsets_[1] = right;
+}
+
+void TimewarpCompositor::setEyeRotations(Quatf const& left,
+                                         Quatf const& right) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    eyeRotations_[0] = left;
+    eyeRotations_[1] = right;
+}
+
+void TimewarpCompositor::threadFunc() {
+    winrt::init_apartment(winrt::apartment_type::multi_threaded);
+    IClock& clock = Timebase::instance();
+    int64_t lastTargetNs = 0;
+    while (!stop_) {
+        const int64_t periodNs = pacer_.getPeriod();
+        if (!pacer_.isLocked() || periodNs <= 0) {
+            // Nothing to aim at yet: the app path is waiting on vblank too
+            clock.sleepUntil(clock.now() + 1'000'000);
+            continue;
+        }
+        // Aim at the first vblank we can still make, never twice the same
+        const int64_t lead = leadNs_;
+        int64_t targetNs = pacer_.predictVBlankAtOrAfter(clock.now() + lead);
+        if (targetNs - lastTargetNs < periodNs / 2) {
+            targetNs = pacer_.predictVBlankAtOrAfter(lastTargetNs +
+                                                     periodNs / 2 + 1);
+        }
+        clock.sleepUntil(targetNs - lead);
+        lastTargetNs = targetNs;
+        if (stop_) {
+            break;
+        }
+        compose(targetNs);
+    }
+    winrt::uninit_apartment();
+}
+
+void TimewarpCompositor::compose(int64_t targetVBlankNs) {
+    Submitted frame;
+    PoseProvider provider;
+    EyeFov fov[2];
+    Vec3f eyeOffsets[2];
+    Quatf eyeRotations[2];
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Newest frame the GPU has finished rendering
+        const uint64_t completed = sourceFence_->GetCompletedValue();
+        auto it = submitted_.rbegin();
+        while (it != submitted_.rend() && it->fenceValue > completed) {
+            ++it;
+        }
+        if (it == submitted_.rend()) {
+            return;
+        }
+        frame = *it;
+        composingIndex_ = static_cast<ptrdiff_t>(frame.sourceIndex);
+        provider = poseProvider_;
+        for (int eye = 0; eye < 2; ++eye) {
+            fov[eye] = fov_[eye];
+            eyeOffsets[eye] = eyeOffsets_[eye];
+            eyeRotations[eye] = eyeRotations_[eye];
+        }
+    }
+
+    Posef displayPose = frame.renderPose;
+    if (provider) {
+        provider(targetVBlankNs, displayPose);
+    }
+
+    // The frame is finished per the CPU-visible fence value, but make the
+    // GPU dependency explicit too.
+    context_->Wait(sourceFence_.get(), frame.fenceValue);
+
+    const bool positional = positional_ && !depthViews_.empty();
+    if (nextOutput_ >= outputCount_) {
+        nextOutput_ = 0;
+    }
+    ID3D11RenderTargetView* target = outputRtvs_[nextOutput_].get();
+    ID3D11ShaderResourceView* source = sourceViews_[frame.sourceIndex].get();
+    context_->IASetInputLayout(nullptr);
+    context_->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    ID3D11SamplerState* samplers[] = {sampler_.get()};
+    context_->PSSetSamplers(0, 1, samplers);
+    context_->PSSetShaderResources(0, 1, &source);
+    context_->RSSetState(rasterizer_.get());
+    if (positional) {
+        // The grid needn't cover everything
+        const float black[4] = {0.f, 0.f, 0.f, 1.f};
+        context_->ClearRenderTargetView(target, black);
+        context_->ClearDepthStencilView(depthStencil_.get(), D3D11_CLEAR_DEPTH,
+                                        1.f, 0);
+        context_->OMSetRenderTargets(1, &target, depthStencil_.get());
+        context_->OMSetDepthStencilState(depthState_.get(), 0);
+        ID3D11ShaderResourceView* depth =
+            depthViews_[frame.sourceIndex].get();
+        context_->VSSetShaderResources(1, 1, &depth);
+    } else {
+        context_->OMSetRenderTargets(1, &target, nullptr);
+        context_->OMSetDepthStencilState(nullptr, 0);
+    }
+
+    for (int eye = 0; eye < 2; ++eye) {
+        // In the eye's own space: its camera may be rolled against the head
+        if (positional) {
+            const Posef offset{eyeRotations[eye], eyeOffsets[eye]};
+            drawPositionalWarp(
+                eye, computeEyeDelta(frame.renderPose, displayPose, offset),
+                fov[eye]);
+        } else {
+            drawOrientationWarp(
+                eye, computeOrientationWarp(frame.renderPose.orientation,
+                                            displayPose.orientation,
+                                            eyeRotations[eye], fov[eye]));
+        }
+    }
+    ID3D11ShaderResourceView* nullView = nullptr;
+    context_->PSSetShaderResources(0, 1, &nullView);
+    context_->VSSetShaderResources(1, 1, &nullView);
+
+    ++fenceValue_;
+    context_->Signal(fence_.get(), fenceValue_);
+    context_->Flush();
+    {
+        // The app may have this buffer back once that signal is reached
+        std::lock_guard<std::mutex> lock(mutex_);
+        releaseValues_[frame.sourceIndex] = fenceValue_;
+        composingIndex_ = -1;
+    }
+    composed_.notify_all();
+
+    winrt::DisplayTask task = taskPool_.CreateTask();
+    task.SetScanout(scanouts_[nextOutput_]);
+    task.SetWait(displayFence_, fenceValue_);
+    taskPool_.ExecuteTask(task);
+
+    nextOutput_ = (nextOutput_ + 1) % outputCount_;
+    ++presented_;
+    if (frame.fenceValue == lastShownFence_) {
+        ++reprojected_;
+    }
+    lastShownFence_ = frame.fenceValue;
+}
+
+//! Viewport of one eye's half of the output.
+static D3D11_VIEWPORT eyeViewport(int eye, uint32_t width, uint32_t height) {
+    const float eyeWidth = static_cast<float>(width) / 2.f;
+    return {eye * eyeWidth, 0.f, eyeWidth, static_cast<float>(height),
+            0.f, 1.f};
+}
+
+void TimewarpCompositor::drawOrientationWarp(int eye, Mat3f const& warp) {
+    WarpConstants constants = {};
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) {
+            constants.warp[r][c] = warp.m[r][c];
+        }
+    }
+    constants.sourceRect[0] = eye * 0.5f;
+    constants.sourceRect[1] = 0.f;
+    constants.sourceRect[2] = 0.5f;
+    constants.sourceRect[3] = 1.f;
+    context_->UpdateSubresource(constants_.get(), 0, nullptr, &constants, 0,
+                                0);
+    context_->VSSetShader(vertexShader_.get(), nullptr, 0);
+    context_->PSSetShader(pixelShader_.get(), nullptr, 0);
+    ID3D11Buffer* buffers[] = {constants_.get()};
+    context_->PSSetConstantBuffers(0, 1, buffers);
+    const D3D11_VIEWPORT viewport = eyeViewport(eye, width_, height_);
+    context_->RSSetViewports(1, &viewport);
+    context_->Draw(3, 0);
+}
+
+void TimewarpCompositor::drawPositionalWarp(int eye, Posef const& delta,
+                                            EyeFov const& fov) {
+    // Same grid as warpImagePositionalCpu() on an eye-sized source
+    const uint32_t eyeWidth = width_ / 2;
+    const uint32_t columns =
+        (eyeWidth + PositionalWarpGridStep - 1) / PositionalWarpGridStep;
+    const uint32_t rows =
+        (height_ + PositionalWarpGridStep - 1) / PositionalWarpGridStep;
+
+    GridConstants constants = {};
+    constants.fov[0] = fov.left;
+    constants.fov[1] = fov.right;
+    constants.fov[2] = fov.top;
+    constants.fov[3] = fov.bottom;
+    const Mat3f rotation = toMatrix(delta.orientation);
+    const float translation[3] = {delta.position.x, delta.position.y,
+                                  delta.position.z};
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) {
+            constants.delta[r][c] = rotation.m[r][c];
+        }
+        constants.delta[r][3] = translation[r];
+    }
+    constants.sourceRect[0] = eye * 0.5f;
+    constants.sourceRect[1] = 0.f;
+    constants.sourceRect[2] = 0.5f;
+    constants.sourceRect[3] = 1.f;
+    constants.grid[0] = static_cast<float>(columns);
+    constants.grid[1] = static_cast<float>(rows);
+    context_->UpdateSubresource(gridConstants_.get(), 0, nullptr, &constants,
+                                0, 0);
+    context_->VSSetShader(gridVertexShader_.get(), nullptr, 0);
+    context_->PSSetShader(gridPixelShader_.get(), nullptr, 0);
+    ID3D11Buffer* buffers[] = {gridConstants_.get()};
+    context_->VSSetConstantBuffers(0, 1, buffers);
+    const D3D11_VIEWPORT viewport = eyeViewport(eye, width_, height_);
+    context_->RSSetViewports(1, &viewport);
+    context_->Draw(columns * rows * 6, 0);
+}
+
+}  // namespace metaview
@@ -0,0 +1,257 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include "FramePacer.h"
+#include "PoseMath.h"
+#include "RenderParam.h"
+#include "Reprojection.h"
+
+#include <d3d11_4.h>
+#include <winrt/Windows.Devices.Display.Core.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Import things into the winrt namespace, removing extra qualifications.
+namespace winrt {
+using winrt::Windows::Devices::Display::Core::DisplayFence;
+using winrt::Windows::Devices::Display::Core::DisplayScanout;
+using winrt::Windows::Devices::Display::Core::DisplaySurface;
+using winrt::Windows::Devices::Display::Core::DisplayTaskPool;
+}  // namespace winrt
+
+namespace metaview {
+
+/**
+ * @brief Supplies the predicted head pose for a given time, in the clock of
+ * the FramePacer. Returns false if no pose is available.
+ *
+ * Poses are right handed: X right, Y up, looking down -Z.
+ *
+ * Called from the compositor thread and the render thread.
+ */
+using PoseProvider = std::function<bool(int64_t timeNs, Posef& headPose)>;
+
+/**
+ * @brief What a TimewarpCompositor is built from.
+ */
+struct TimewarpCompositorDesc {
+    //! Display device, etc.
+    RenderParam* params = nullptr;
+    //! Surfaces to compose into and their scanouts, cycled through in order.
+    std::vector<winrt::DisplaySurface> outputs;
+    std::vector<winrt::DisplayScanout> scanouts;
+    winrt::DisplayTaskPool taskPool{nullptr};
+    //! Shared NT handles to the app's side-by-side eye buffers.
+    std::vector<HANDLE> sourceHandles;
+    //! Shared NT handles to linear depth (R32_FLOAT, meters, 0 for
+    //! infinity) laid out like the eye buffers, one per eye buffer. Optional:
+    //! without them only orientation is corrected.
+    std::vector<HANDLE> depthHandles;
+    //! Shared NT handle to the fence the app signals when a frame is done.
+    HANDLE sourceFenceHandle = nullptr;
+    //! Display timing, for waking up before each vblank.
+    FramePacer const* pacer = nullptr;
+};
+
+/**
+ * @brief Asynchronous reprojection ("timewarp").
+ *
+ * Runs on its own thread and D3D11 device, once per refresh: shortly before
+ * each vblank it takes the newest app frame the GPU has finished, warps each
+ * eye from the head orientation it was rendered with to the one predicted
+ * for that vblank, and scans the result out. If the app misses a vblank the
+ * previous frame is warped again, rather than repeated as is.
+ *
+ * With depth and positional mode enabled, head translation is corrected as
+ * well, by moving a grid over each eye image according to the depth under
+ * it (see warpImagePositionalCpu()).
+ *
+ * The app renders side-by-side eye buffers (left half, right half) and hands
+ * them over with submit().
+ */
+class TimewarpCompositor {
+  public:
+    /**
+     * @brief Create the compositor's device and resources, and start its
+     * thread.
+     */
+    explicit TimewarpCompositor(TimewarpCompositorDesc const& desc);
+
+    /**
+     * @brief Stop the thread. Anything already scheduled still scans out.
+     */
+    ~TimewarpCompositor();
+
+    TimewarpCompositor(TimewarpCompositor const&) = delete;
+    TimewarpCompositor& operator=(TimewarpCompositor const&) = delete;
+
+    /**
+     * @brief Hand over a frame. Thread-safe.
+     *
+     * @param sourceIndex Which eye buffer it was rendered to.
+     * @param fenceValue Source fence value signaled once it's rendered.
+     * @param renderPose Head pose it was rendered with.
+     */
+    void submit(size_t sourceIndex, uint64_t fenceValue,
+                Posef const& renderPose);
+
+    /**
+     * @brief Take an eye buffer back for the app to render into.
+     * Thread-safe.
+     *
+     * Frames in that buffer are no longer considered for composition, and a
+     * composition already reading it finishes recording its draws first.
+     *
+     * @return the release fence value (see getReleaseFenceHandle()) the
+     * app's GPU work has to wait for before writing to the buffer, or 0 if
+     * it was never composed from.
+     */
+    uint64_t acquire(size_t sourceIndex);
+
+    /**
+     * @brief Get a shared NT handle to the release fence, signaled on the
+     * compositor's device after each composition with the values acquire()
+     * returns. Valid for the life of this object.
+     */
+    HANDLE getReleaseFenceHandle() const { return fenceHandle_.get(); }
+
+    /**
+     * @brief Choose how many of the outputs to cycle through, counting from
+     * the first. Thread-safe.
+     */
+    void setOutputCount(size_t count);
+
+    /**
+     * @brief Set where head poses come from. Without a provider, frames are
+     * shown with the pose they were rendered with. Thread-safe.
+     */
+    void setPoseProvider(PoseProvider provider);
+
+    /**
+     * @brief Set the field of view of each eye's half of the eye buffers.
+     * Thread-safe.
+     */
+    void setEyeFov(EyeFov const& left, EyeFov const& right);
+
+    /**
+     * @brief Set each eye's position relative to the head, in the head's
+     * space. Only matters for positional warping. Thread-safe.
+     */
+    void setEyeOffsets(Vec3f const& left, Vec3f const& right);
+
+    /**
+     * @brief Set each eye camera's orientation relative to the head, e.g.
+     * rolled for a panel mounted sideways. Warps are done in each eye's own
+     * space. Thread-safe.
+     */
+    void setEyeRotations(Quatf const& left, Quatf const& right);
+
+    /**
+     * @brief Choose whether head translation is corrected too, using depth.
+     * Has no effect if no depth was supplied.
+     */
+    void setPositional(bool enable) { positional_ = enable; }
+
+    bool getPositional() const { return positional_; }
+
+    /**
+     * @brief How long before vblank to start composing, in nanoseconds.
+     */
+    void setLead(int64_t leadNs) { leadNs_ = leadNs; }
+
+    /**
+     * @brief Get the number of frames composed and scheduled for scanout.
+     */
+    uint64_t getPresentedCount() const { return presented_; }
+
+    /**
+     * @brief Get how many of those reused an app frame already shown.
+     */
+    uint64_t getReprojectedCount() const { return reprojected_; }
+
+  private:
+    struct Submitted {
+        size_t sourceIndex = 0;
+        uint64_t fenceValue = 0;
+        Posef renderPose;
+    };
+
+    void threadFunc();
+    //! Compose and schedule the frame for one vblank.
+    void compose(int64_t targetVBlankNs);
+    //! Set up the pipeline for and draw one eye, rotation only.
+    void drawOrientationWarp(int eye, Mat3f const& warp);
+    //! Set up the pipeline for and draw one eye, with depth.
+    void drawPositionalWarp(int eye, Posef const& delta, EyeFov const& fov);
+
+    RenderParam& params_;
+    FramePacer const& pacer_;
+    winrt::DisplayTaskPool taskPool_;
+    std::vector<winrt::DisplayScanout> scanouts_;
+
+    winrt::com_ptr<ID3D11Device5> device_;
+    winrt::com_ptr<ID3D11DeviceContext4> context_;
+    std::vector<winrt::com_ptr<ID3D11Texture2D>> outputTextures_;
+    std::vector<winrt::com_ptr<ID3D11RenderTargetView>> outputRtvs_;
+    std::vector<winrt::com_ptr<ID3D11ShaderResourceView>> sourceViews_;
+    std::vector<winrt::com_ptr<ID3D11ShaderResourceView>> depthViews_;
+    winrt::com_ptr<ID3D11Fence> sourceFence_;
+    //! Signaled when composition is done; the display waits on it, and the
+    //! app before reusing an eye buffer.
+    winrt::com_ptr<ID3D11Fence> fence_;
+    winrt::handle fenceHandle_;
+    winrt::DisplayFence displayFence_{nullptr};
+    uint64_t fenceValue_ = 0;
+
+    winrt::com_ptr<ID3D11VertexShader> vertexShader_;
+    winrt::com_ptr<ID3D11PixelShader> pixelShader_;
+    winrt::com_ptr<ID3D11SamplerState> sampler_;
+    winrt::com_ptr<ID3D11RasterizerState> rasterizer_;
+    winrt::com_ptr<ID3D11Buffer> constants_;
+    // Positional warp: grid shaders and our own depth buffer
+    winrt::com_ptr<ID3D11VertexShader> gridVertexShader_;
+    winrt::com_ptr<ID3D11PixelShader> gridPixelShader_;
+    winrt::com_ptr<ID3D11Buffer> gridConstants_;
+    winrt::com_ptr<ID3D11DepthStencilView> depthStencil_;
+    winrt::com_ptr<ID3D11DepthStencilState> depthState_;
+    uint32_t width_ = 0;
+    uint32_t height_ = 0;
+
+    std::mutex mutex_;
+    //! Recently submitted frames, oldest first. Protected by mutex_.
+    std::vector<Submitted> submitted_;
+    //! Per eye buffer: value of fence_ once the last composition reading it
+    //! is done. Protected by mutex_.
+    std::vector<uint64_t> releaseValues_;
+    //! Eye buffer being composed from, or -1. Protected by mutex_.
+    ptrdiff_t composingIndex_ = -1;
+    //! Notified when a composition has recorded its draws.
+    std::condition_variable composed_;
+    PoseProvider poseProvider_;
+    EyeFov fov_[2];
+    Vec3f eyeOffsets_[2];
+    Quatf eyeRotations_[2];
+
+    //! Fence value of the app frame composed last time.
+    uint64_t lastShownFence_ = 0;
+    size_t nextOutput_ = 0;
+    std::atomic<size_t> outputCount_;
+    std::atomic<int64_t> leadNs_{2'000'000};
+    std::atomic_bool positional_{false};
+    std::atomic<uint64_t> presented_{0};
+    std::atomic<uint64_t> reprojected_{0};
+    std::atomic_bool stop_{false};
+    std::thread thread_;
+};
+
+}  // namespace metaview
@@ -0,0 +1,95 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#include "TrackingFeeder.h"
+
+namespace metaview {
+
+TrackingFeeder::TrackingFeeder(IClock const& clock,
+                               TrackingFeederConfig const& config)
+    : clock_(clock), config_(config), queue_(config.queueCapacity) {}
+
+TrackingFeeder::~TrackingFeeder() { stop(); }
+
+void TrackingFeeder::setHistory(uint32_t device,
+                                std::shared_ptr<PoseHistory> history) {
+    if (device >= histories_.size()) {
+        histories_.resize(device + 1);
+    }
+    histories_[device] = std::move(history);
+}
+
+void TrackingFeeder::setSource(std::unique_ptr<ITrackingSource> source) {
+    std::lock_guard<std::mutex> lock(pendingMutex_);
+    pending_ = std::move(source);
+    hasPending_ = true;
+}
+
+void TrackingFeeder::start() {
+    if (isRunning()) {
+        return;
+    }
+    stop_ = false;
+    thread_ = std::thread([this] { threadFunc(); });
+}
+
+void TrackingFeeder::stop() {
+    if (!isRunning()) {
+        return;
+    }
+    stop_ = true;
+    thread_.join();
+}
+
+void TrackingFeeder::threadFunc() {
+    while (!stop_) {
+        poll();
+        sleepCoarse(config_.pollPeriodNs);
+    }
+}
+
+void TrackingFeeder::poll() {
+    if (hasPending_.exchange(false)) {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        source_ = std::move(pending_);
+        sourceChanges_.fetch_add(1, std::memory_order_release);
+    }
+    const bool connected = source_ && source_->isConnected();
+    connected_.store(connected, std::memory_order_release);
+    if (!connected) {
+        PoseSample fixed;
+        fixed.timeNs = clock_.now();
+        for (auto const& history : histories_) {
+            if (history) {
+                history->push(fixed);
+            }
+        }
+        return;
+    }
+    size_t count = 0;
+    do {
+        count = source_->read(buffer_.data(), buffer_.size());
+        for (size_t i = 0; i < count; ++i) {
+            TrackedSample const& tracked = buffer_[i];
+            if (tracked.device < histories_.size() &&
+                histories_[tracked.device]) {
+                histories_[tracked.device]->push(tracked.sample);
+            }
+            if (!queue_.tryPush(tracked)) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    } while (count == buffer_.size());
+}
+
+size_t TrackingFeeder::read(TrackedSample* out, size_t capacity) {
+    size_t count = 0;
+    while (count < capacity && queue_.tryPop(out[count])) {
+        ++count;
+    }
+    return count;
+}
+
+}  // namespace metaview
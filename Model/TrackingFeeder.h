@@ -0,0 +1,155 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include "Clock.h"
+#include "PoseHistory.h"
+#include "SpscQueue.h"
+#include "TrackingSource.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace metaview {
+
+/**
+ * @brief How a TrackingFeeder polls.
+ */
+struct TrackingFeederConfig {
+    //! Time between polls of the source.
+    int64_t pollPeriodNs = 1'000'000;
+    //! Samples held for read() between frames. While the reader falls
+    //! further behind, new ones are dropped from the queue, though never
+    //! from the histories.
+    size_t queueCapacity = 1024;
+};
+
+/**
+ * @brief Feeds device pose histories from a tracking source on a thread of
+ * its own, so they stay current between frames.
+ *
+ * Late latching and the timewarp compositor look poses up in the histories
+ * right before they are used. Fed only at frame setup, the histories would
+ * hold nothing newer than the pose the frame was rendered with, and
+ * lookups would only extrapolate it. Polled here, every sample is in its
+ * device's history as soon as it arrives; this thread is the histories'
+ * only writer.
+ *
+ * The samples are also queued for one consumer, the graphics thread, to
+ * take with read() for pose prediction.
+ *
+ * While the source isn't connected, each history gets a fixed identity pose
+ * every poll instead, so apps still render.
+ */
+class TrackingFeeder {
+  public:
+    /**
+     * @param clock Times the fixed poses. Must outlive this object.
+     */
+    explicit TrackingFeeder(IClock const& clock,
+                            TrackingFeederConfig const& config = {});
+
+    /**
+     * @brief Stop the thread, if running.
+     */
+    ~TrackingFeeder();
+
+    TrackingFeeder(TrackingFeeder const&) = delete;
+    TrackingFeeder& operator=(TrackingFeeder const&) = delete;
+
+    /**
+     * @brief Set the history a device's samples go to, by native device
+     * index. Only while stopped.
+     */
+    void setHistory(uint32_t device, std::shared_ptr<PoseHistory> history);
+
+    /**
+     * @brief Replace the source; null for none. Any thread: taken up at the
+     * next poll.
+     */
+    void setSource(std::unique_ptr<ITrackingSource> source);
+
+    /**
+     * @brief Start polling on a thread of its own. Does nothing if running.
+     */
+    void start();
+
+    /**
+     * @brief Stop polling and join the thread. Does nothing if stopped.
+     */
+    void stop();
+
+    bool isRunning() const noexcept { return thread_.joinable(); }
+
+    /**
+     * @brief Poll once: take up a new source, and move whatever arrived into
+     * the histories and the queue. Done by the thread; call directly only
+     * while stopped.
+     */
+    void poll();
+
+    /**
+     * @brief Whether the source was delivering poses at the last poll. Any
+     * thread.
+     */
+    bool isConnected() const noexcept {
+        return connected_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief How many times a new source was taken up. Any thread. Samples
+     * read before it changes may be from the old source.
+     */
+    uint64_t getSourceChanges() const noexcept {
+        return sourceChanges_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Take samples that arrived since the last call, oldest first.
+     * One consumer thread only.
+     *
+     * @return how many samples were written to @p out.
+     */
+    size_t read(TrackedSample* out, size_t capacity);
+
+    /**
+     * @brief Samples dropped from the queue because it was full. Any thread.
+     */
+    uint64_t getDroppedSamples() const noexcept {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    void threadFunc();
+
+    IClock const& clock_;
+    TrackingFeederConfig config_;
+    //! By native device index; null where nothing is kept.
+    std::vector<std::shared_ptr<PoseHistory>> histories_;
+    std::unique_ptr<ITrackingSource> source_;
+    SpscQueue<TrackedSample> queue_;
+    //! Scratch space for reading the source without allocating.
+    std::array<TrackedSample, 64> buffer_;
+
+    //! Set by setSource, taken up by poll().
+    std::mutex pendingMutex_;
+    std::unique_ptr<ITrackingSource> pending_;
+    std::atomic_bool hasPending_{false};
+
+    std::atomic_bool connected_{false};
+    std::atomic<uint64_t> sourceChanges_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic_bool stop_{false};
+    std::thread thread_;
+};
+
+}  // namespace metaview
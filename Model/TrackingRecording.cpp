@@ -0,0 +1,319 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "TrackingRecording.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+namespace metaview {
+
+using tracking_recording::Header;
+using tracking_recording::Record;
+using tracking_recording::RecordType;
+
+//! How long the writer thread sleeps between writes while records trickle in.
+static constexpr auto WriterPeriod = std::chrono::milliseconds(20);
+
+//! Gap between the end of a looped replay and its restart.
+static constexpr int64_t LoopGapNs = 1'000'000;
+
+PoseSample tracking_recording::toPoseSample(Record const& record) {
+    PoseSample sample;
+    sample.timeNs = record.timeNs;
+    sample.pose.position = {record.position[0], record.position[1],
+                            record.position[2]};
+    sample.pose.orientation = {record.orientation[0], record.orientation[1],
+                               record.orientation[2], record.orientation[3]};
+    sample.linearVelocity = {record.linearVelocity[0],
+                             record.linearVelocity[1],
+                             record.linearVelocity[2]};
+    sample.angularVelocity = {record.angularVelocity[0],
+                              record.angularVelocity[1],
+                              record.angularVelocity[2]};
+    return sample;
+}
+
+TrackingRecorder::TrackingRecorder(size_t capacity) : queue_(capacity) {}
+
+TrackingRecorder::~TrackingRecorder() { stop(); }
+
+bool TrackingRecorder::start(std::string const& path) {
+    std::lock_guard<std::mutex> control(controlMutex_);
+    stopLocked();
+    file_ = std::fopen(path.c_str(), "wb");
+    if (file_ == nullptr) {
+        return false;
+    }
+    Header header = {};
+    header.magic = tracking_recording::Magic;
+    header.version = tracking_recording::Version;
+    header.recordSize = sizeof(Record);
+    header.startNs = SteadyClock::instance().now();
+    if (std::fwrite(&header, sizeof(header), 1, file_) != 1) {
+        std::fclose(file_);
+        file_ = nullptr;
+        return false;
+    }
+    dropped_ = 0;
+    stop_ = false;
+    thread_ = std::thread([this] { threadFunc(); });
+    std::lock_guard<std::mutex> lock(pushMutex_);
+    recording_.store(true, std::memory_order_release);
+    return true;
+}
+
+void TrackingRecorder::stop() {
+    std::lock_guard<std::mutex> control(controlMutex_);
+    stopLocked();
+}
+
+void TrackingRecorder::stopLocked() {
+    if (file_ == nullptr) {
+        return;
+    }
+    {
+        // Once this is released no producer can reach the queue, so the
+        // writer thread's final drain gets everything.
+        std::lock_guard<std::mutex> lock(pushMutex_);
+        recording_.store(false, std::memory_order_release);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+    std::fclose(file_);
+    file_ = nullptr;
+}
+
+void TrackingRecorder::recordFrame(uint64_t frameIndex) {
+    if (!isRecording()) {
+        return;
+    }
+    Record record = {};
+    record.type = RecordType::Frame;
+    record.frameIndex = frameIndex;
+    push(record);
+}
+
+void TrackingRecorder::recordPose(RecordType type, uint32_t device,
+                                  uint32_t updateType,
+                                  PoseSample const& sample) {
+    if (!isRecording()) {
+        return;
+    }
+    Record record = {};
+    record.type = type;
+    record.device = device;
+    record.updateType = updateType;
+    record.timeNs = sample.timeNs;
+    record.position[0] = sample.pose.position.x;
+    record.position[1] = sample.pose.position.y;
+    record.position[2] = sample.pose.position.z;
+    record.orientation[0] = sample.pose.orientation.x;
+    record.orientation[1] = sample.pose.orientation.y;
+    record.orientation[2] = sample.pose.orientation.z;
+    record.orientation[3] = sample.pose.orientation.w;
+    record.linearVelocity[0] = sample.linearVelocity.x;
+    record.linearVelocity[1] = sample.linearVelocity.y;
+    record.linearVelocity[2] = sample.linearVelocity.z;
+    record.angularVelocity[0] = sample.angularVelocity.x;
+    record.angularVelocity[1] = sample.angularVelocity.y;
+    record.angularVelocity[2] = sample.angularVelocity.z;
+    push(record);
+}
+
+void TrackingRecorder::push(Record& record) {
+    std::lock_guard<std::mutex> lock(pushMutex_);
+    // Checked again under the lock, as stop() may have cleared it since
+    if (!recording_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    // Stamped under the lock, so the file stays in recordedNs order
+    record.recordedNs = SteadyClock::instance().now();
+    if (!queue_.tryPush(record)) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void TrackingRecorder::threadFunc() {
+    Record record;
+    while (true) {
+        while (queue_.tryPop(record)) {
+            std::fwrite(&record, sizeof(record), 1, file_);
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (stop_ && queue_.empty()) {
+            break;
+        }
+        // Poll rather than have every record notify: recording must cost
+        // the recorded thread as little as possible.
+        wake_.wait_for(lock, WriterPeriod, [&] { return stop_; });
+    }
+    std::fflush(file_);
+}
+
+TrackingRecording::TrackingRecording(std::string const& path) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Could not open tracking recording");
+    }
+    file_ = reinterpret_cast<intptr_t>(file);
+    LARGE_INTEGER size = {};
+    if (!GetFileSizeEx(file, &size) ||
+        size.QuadPart < static_cast<LONGLONG>(sizeof(Header))) {
+        CloseHandle(file);
+        throw std::runtime_error("Not a tracking recording");
+    }
+    HANDLE mapping =
+        CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* view = mapping != nullptr
+                     ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)
+                     : nullptr;
+    if (view == nullptr) {
+        if (mapping != nullptr) {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        throw std::runtime_error("Could not map tracking recording");
+    }
+    mapping_ = reinterpret_cast<intptr_t>(mapping);
+    data_ = view;
+    bytes_ = static_cast<size_t>(size.QuadPart);
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open tracking recording");
+    }
+    struct stat st = {};
+    if (fstat(fd, &st) != 0 ||
+        static_cast<size_t>(st.st_size) < sizeof(Header)) {
+        ::close(fd);
+        throw std::runtime_error("Not a tracking recording");
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                      MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED) {
+        ::close(fd);
+        throw std::runtime_error("Could not map tracking recording");
+    }
+    file_ = fd;
+    data_ = view;
+    bytes_ = static_cast<size_t>(st.st_size);
+#endif
+    header_ = static_cast<Header const*>(data_);
+    if (header_->magic != tracking_recording::Magic ||
+        header_->version != tracking_recording::Version ||
+        header_->recordSize != sizeof(Record)) {
+        unmap();
+        throw std::runtime_error("Not a tracking recording");
+    }
+    records_ = reinterpret_cast<Record const*>(header_ + 1);
+    count_ = (bytes_ - sizeof(Header)) / sizeof(Record);
+}
+
+TrackingRecording::~TrackingRecording() { unmap(); }
+
+void TrackingRecording::unmap() {
+#ifdef _WIN32
+    if (data_ != nullptr) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_ != -1) {
+        CloseHandle(reinterpret_cast<HANDLE>(mapping_));
+    }
+    if (file_ != -1) {
+        CloseHandle(reinterpret_cast<HANDLE>(file_));
+    }
+#else
+    if (data_ != nullptr) {
+        munmap(data_, bytes_);
+    }
+    if (file_ != -1) {
+        ::close(static_cast<int>(file_));
+    }
+#endif
+    data_ = nullptr;
+    mapping_ = -1;
+    file_ = -1;
+    header_ = nullptr;
+    records_ = nullptr;
+    count_ = 0;
+}
+
+size_t TrackingRecording::find(int64_t recordedNs) const {
+    Record const* found = std::lower_bound(
+        records_, records_ + count_, recordedNs,
+        [](Record const& record, int64_t timeNs) {
+            return record.recordedNs < timeNs;
+        });
+    return static_cast<size_t>(found - records_);
+}
+
+ReplayTrackingSource::ReplayTrackingSource(
+    std::shared_ptr<TrackingRecording const> recording, IClock const& clock,
+    ReplayTrackingSourceConfig const& config)
+    : recording_(std::move(recording)), clock_(clock), config_(config) {}
+
+size_t ReplayTrackingSource::read(TrackedSample* out, size_t capacity) {
+    TrackingRecording const& recording = *recording_;
+    const size_t count = recording.size();
+    if (count == 0) {
+        return 0;
+    }
+    const int64_t now = clock_.now();
+    if (!started_) {
+        offsetNs_ = now - recording[0].recordedNs;
+        started_ = true;
+    }
+    size_t written = 0;
+    while (written < capacity) {
+        if (next_ >= count) {
+            if (!config_.loop) {
+                break;
+            }
+            // Carry on from just after the last record, so times keep
+            // increasing
+            offsetNs_ += recording[count - 1].recordedNs -
+                         recording[0].recordedNs + LoopGapNs;
+            next_ = 0;
+        }
+        Record const& record = recording[next_];
+        if (record.recordedNs + offsetNs_ > now) {
+            break;
+        }
+        ++next_;
+        if (record.type != RecordType::Pose ||
+            record.updateType != config_.updateType) {
+            continue;
+        }
+        TrackedSample& sample = out[written++];
+        sample.device = record.device;
+        sample.sample = tracking_recording::toPoseSample(record);
+        sample.sample.timeNs += offsetNs_;
+    }
+    return written;
+}
+
+}  // namespace metaview
@@ -0,0 +1,265 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include "Clock.h"
+#include "SpscQueue.h"
+#include "TrackingSource.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace metaview {
+
+/**
+ * @brief Layout of a tracking recording: a header followed by fixed-size
+ * records, so the file can be mapped and indexed directly.
+ *
+ * Records are in the order they were recorded, so recordedNs never decreases
+ * through the file. A recording cut short (e.g. by a crash) is still valid up
+ * to its last whole record.
+ */
+namespace tracking_recording {
+
+//! "MVRC"
+constexpr uint32_t Magic = 0x4352564d;
+constexpr uint32_t Version = 1;
+
+enum class RecordType : uint32_t {
+    //! OpenVRSystem::Update started frame frameIndex.
+    Frame = 0,
+    //! A pose delivered to Unity by UpdateDeviceState, for timeNs.
+    Pose = 1,
+    //! A pose delivered to Unity by TryGetDeviceStateAtTime; timeNs is the
+    //! time asked for.
+    PoseAtTime = 2,
+};
+
+//! Values of Record::updateType: the same as UnityXRInputUpdateType.
+constexpr uint32_t UpdateTypeDynamic = 0;
+constexpr uint32_t UpdateTypeBeforeRender = 1;
+
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t reserved;
+    //! SteadyClock time recording started.
+    int64_t startNs;
+    uint64_t reserved2;
+};
+
+struct Record {
+    RecordType type;
+    uint32_t device;
+    //! SteadyClock time the record was made.
+    int64_t recordedNs;
+    //! SteadyClock time of the pose.
+    int64_t timeNs;
+    //! Frame records only.
+    uint64_t frameIndex;
+    //! Pose records only.
+    uint32_t updateType;
+    uint32_t reserved;
+    //! Right handed, meters. X right, Y up, looking down -Z.
+    float position[3];
+    //! x, y, z, w
+    float orientation[4];
+    float linearVelocity[3];
+    float angularVelocity[3];
+};
+
+static_assert(sizeof(Header) == 32, "Header layout is part of the format");
+static_assert(sizeof(Record) == 96, "Record layout is part of the format");
+
+//! The pose a record carries.
+PoseSample toPoseSample(Record const& record);
+
+}  // namespace tracking_recording
+
+/**
+ * @brief Appends the tracking stream to a file, without blocking the threads
+ * being recorded on file I/O.
+ *
+ * Records go through a queue to a writer thread. If the writer falls behind
+ * and the queue fills up, records are dropped and counted rather than waited
+ * for.
+ *
+ * The record functions may be called from any number of threads: pushes onto
+ * the queue take a short lock, which also keeps records in recordedNs order.
+ * start() and stop() may be called from any thread, concurrently with the
+ * record functions.
+ */
+class TrackingRecorder {
+  public:
+    /**
+     * @param capacity How many records may be waiting for the writer thread.
+     */
+    explicit TrackingRecorder(size_t capacity = 4096);
+    ~TrackingRecorder();
+
+    TrackingRecorder(TrackingRecorder const&) = delete;
+    TrackingRecorder& operator=(TrackingRecorder const&) = delete;
+
+    /**
+     * @brief Start recording to a new file, replacing any existing one.
+     * Stops any recording in progress first.
+     *
+     * @return false if the file can't be created.
+     */
+    bool start(std::string const& path);
+
+    /**
+     * @brief Write out everything recorded so far and close the file.
+     *
+     * Records made after this starts are not recorded.
+     */
+    void stop();
+
+    bool isRecording() const noexcept {
+        return recording_.load(std::memory_order_acquire);
+    }
+
+    void recordFrame(uint64_t frameIndex);
+
+    /**
+     * @param type RecordType::Pose or RecordType::PoseAtTime.
+     * @param updateType For RecordType::Pose, the UnityXRInputUpdateType.
+     */
+    void recordPose(tracking_recording::RecordType type, uint32_t device,
+                    uint32_t updateType, PoseSample const& sample);
+
+    //! Records lost because the writer thread fell behind.
+    uint64_t getDroppedRecords() const noexcept {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    void push(tracking_recording::Record& record);
+    void stopLocked();
+    void threadFunc();
+
+    //! Serializes start() and stop(), which own file_ and thread_.
+    std::mutex controlMutex_;
+
+    //! Makes the queue's producer side safe for several threads, and orders
+    //! clearing recording_ against pushes.
+    std::mutex pushMutex_;
+    SpscQueue<tracking_recording::Record> queue_;
+    std::atomic<bool> recording_{false};
+    std::atomic<uint64_t> dropped_{0};
+
+    //! Written by start() before the writer thread starts, closed by stop()
+    //! after it ends: no other thread sees it.
+    std::FILE* file_ = nullptr;
+
+    //! Only guards stop_, never the queue itself.
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stop_ = false;
+
+    std::thread thread_;
+};
+
+/**
+ * @brief A recording mapped into memory, read only.
+ */
+class TrackingRecording {
+  public:
+    /**
+     * @throws std::runtime_error if the file can't be mapped or isn't a
+     * recording.
+     */
+    explicit TrackingRecording(std::string const& path);
+    ~TrackingRecording();
+
+    TrackingRecording(TrackingRecording const&) = delete;
+    TrackingRecording& operator=(TrackingRecording const&) = delete;
+
+    size_t size() const noexcept { return count_; }
+
+    tracking_recording::Record const& operator[](size_t index) const {
+        return records_[index];
+    }
+
+    tracking_recording::Header const& getHeader() const noexcept {
+        return *header_;
+    }
+
+    /**
+     * @brief Index of the first record made at or after a time, or size() if
+     * none. A binary search.
+     */
+    size_t find(int64_t recordedNs) const;
+
+  private:
+    void unmap();
+
+    void* data_ = nullptr;
+    size_t bytes_ = 0;
+    //! Platform handles: HANDLEs on Windows, a file descriptor elsewhere.
+    intptr_t file_ = -1;
+    intptr_t mapping_ = -1;
+    tracking_recording::Header const* header_ = nullptr;
+    tracking_recording::Record const* records_ = nullptr;
+    size_t count_ = 0;
+};
+
+/**
+ * @brief Tuning parameters for a ReplayTrackingSource.
+ */
+struct ReplayTrackingSourceConfig {
+    //! Start again from the beginning after the last record.
+    bool loop = false;
+
+    //! Which delivered poses to replay. Both are predicted to the photon
+    //! time of their frame and timed with it, so they replay as the
+    //! trajectory the app was shown.
+    uint32_t updateType = tracking_recording::UpdateTypeBeforeRender;
+};
+
+/**
+ * @brief Plays a recording back as a tracking source.
+ *
+ * Records come out when as much time has passed on the given clock as had
+ * between them when recorded, with their times moved to match. Replay starts
+ * at the first read(). Driven by a SimulatedClock, replay is deterministic and
+ * runs as fast as the clock is advanced.
+ */
+class ReplayTrackingSource : public ITrackingSource {
+  public:
+    /**
+     * @param clock Paces replay. Must outlive this object.
+     */
+    ReplayTrackingSource(std::shared_ptr<TrackingRecording const> recording,
+                         IClock const& clock,
+                         ReplayTrackingSourceConfig const& config = {});
+
+    //! True until a non-looping replay reaches the end.
+    bool isConnected() override { return !isFinished(); }
+    size_t read(TrackedSample* out, size_t capacity) override;
+
+    bool isFinished() const noexcept {
+        return !config_.loop && next_ >= recording_->size();
+    }
+
+  private:
+    std::shared_ptr<TrackingRecording const> recording_;
+    IClock const& clock_;
+    ReplayTrackingSourceConfig config_;
+    size_t next_ = 0;
+    //! Added to recorded times to get replay times.
+    int64_t offsetNs_ = 0;
+    bool started_ = false;
+};
+
+}  // namespace metaview
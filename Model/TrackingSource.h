@@ -0,0 +1,50 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include "PoseHistory.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace metaview {
+
+/**
+ * @brief A pose sample for one tracked device.
+ */
+struct TrackedSample {
+    //! Native device index: 0 is the HMD.
+    uint32_t device = 0;
+    PoseSample sample;
+};
+
+/**
+ * @brief Where tracked device poses come from.
+ *
+ * Polled from one thread, a TrackingFeeder's, about every millisecond, so
+ * implementations must not block. Sample times are SteadyClock nanoseconds.
+ */
+class ITrackingSource {
+  public:
+    virtual ~ITrackingSource() = default;
+
+    /**
+     * @brief Whether the source is currently delivering poses. While it
+     * isn't, devices are reported as they would be without a source.
+     */
+    virtual bool isConnected() = 0;
+
+    /**
+     * @brief Take samples that arrived since the last call, oldest first.
+     *
+     * @param out Receives up to @p capacity samples.
+     * @return how many samples were written. If this equals @p capacity, call
+     * again for more.
+     */
+    virtual size_t read(TrackedSample* out, size_t capacity) = 0;
+};
+
+}  // namespace metaview
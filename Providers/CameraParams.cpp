@@ -0,0 +1,51 @@
+// Copyright (c) 2020, Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#include "CameraParams.h"
+
+#include "Metadata.h"
+
+constexpr float PerspectiveHalfAngleHeightTangent = 0.845065f;
+constexpr float PerspectiveHalfAngleWidthTangent = 0.939062f;
+
+//! @todo these are placeholder values
+constexpr UnityXRProjectionHalfAngles LeftFov = {
+    -PerspectiveHalfAngleWidthTangent, PerspectiveHalfAngleWidthTangent,
+    PerspectiveHalfAngleHeightTangent, -PerspectiveHalfAngleHeightTangent};
+constexpr UnityXRProjectionHalfAngles RightFov = {
+    -PerspectiveHalfAngleWidthTangent, PerspectiveHalfAngleWidthTangent,
+    PerspectiveHalfAngleHeightTangent, -PerspectiveHalfAngleHeightTangent};
+
+CameraParams CameraParams::Defaults() {
+    CameraParams params;
+    params.version = 0;
+    params.ipd = NominalIpd;
+    params.leftEyePosition = {-0.0315f, 0.f, 0.f};
+    params.rightEyePosition = {0.0315f, 0.f, 0.f};
+    params.leftFov = LeftFov;
+    params.rightFov = RightFov;
+    params.singleCameraFov = LeftFov;
+    params.lensContour = {};
+    params.mirrorViewMode = 0;
+    params.rotateEyes = 1;
+    return params;
+}
+
+CameraParamBlock::CameraParamBlock()
+    : m_Latest(CameraParams::Defaults()), m_Frame(CameraParams::Defaults()) {}
+
+CameraParams CameraParamBlock::LatchFrame() {
+    const CameraParams params = m_Latest.load();
+    m_Frame.store(params);
+    m_bFrameLatched.store(true, std::memory_order_release);
+    return params;
+}
+
+CameraParams CameraParamBlock::GetFrame() const {
+    if (!m_bFrameLatched.load(std::memory_order_acquire)) {
+        return m_Latest.load();
+    }
+    return m_Frame.load();
+}
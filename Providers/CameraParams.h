@@ -0,0 +1,93 @@
+// Copyright (c) 2020, Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include "Model/OcclusionMesh.h"
+#include "Model/SeqLock.h"
+#include "ProviderInterface/UnityXRTypes.h"
+#include "Singleton.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+/// The camera and view parameters managed code can change at runtime, as one
+/// block so readers never see some of a change and not the rest.
+struct CameraParams {
+    /// Bumped by every change, so readers can tell when to recompute what
+    /// they derive from these
+    uint32_t version;
+
+    /// Distance between the eyes the input provider offsets eye poses by
+    float ipd;
+
+    /// Eye positions relative to the head, as managed code gives them
+    UnityXRVector3 leftEyePosition;
+    UnityXRVector3 rightEyePosition;
+
+    /// Tangents of the projection half angles per eye
+    UnityXRProjectionHalfAngles leftFov;
+    UnityXRProjectionHalfAngles rightFov;
+
+    /// Tangents of the projection half angles in single camera mode
+    UnityXRProjectionHalfAngles singleCameraFov;
+
+    /// The part of the left eye's view the optics show, mirrored for the
+    /// right eye; the rest is masked with an occlusion mesh. None by default.
+    metaview::LensContour lensContour;
+
+    /// What the mirror view shows: an EVRMirrorViewMode
+    uint32_t mirrorViewMode;
+
+    /// Whether the eye images are rotated for the panels: 0 or 1
+    uint32_t rotateEyes;
+
+    /// The values used until managed code sets others
+    static CameraParams Defaults();
+};
+
+/// The one CameraParams block shared by the display and input providers.
+///
+/// Managed code updates the latest parameters from the main thread. The
+/// graphics thread latches them once per frame, and both providers render
+/// and track that frame with the latched copy, so they agree on it.
+class CameraParamBlock : public Singleton<CameraParamBlock> {
+  public:
+    CameraParamBlock();
+
+    /// Change the latest parameters, as one update. Any thread. The version
+    /// only changes if the parameters do, so setting the same values every
+    /// frame keeps what readers derived from them.
+    /// @param[in] f - Called with the parameters to change
+    template <typename F> void Update(F &&f) {
+        m_Latest.update([&](CameraParams &params) {
+            const CameraParams before = params;
+            f(params);
+            if (std::memcmp(&before, &params, sizeof(params)) != 0) {
+                ++params.version;
+            }
+        });
+    }
+
+    /// Get the latest parameters. Any thread.
+    CameraParams GetLatest() const { return m_Latest.load(); }
+
+    /// Take the latest parameters for the frame being set up. Graphics
+    /// thread, once per frame, before either provider uses them.
+    /// @return CameraParams - The parameters for this frame
+    CameraParams LatchFrame();
+
+    /// Get the parameters the current frame was set up with, or the latest
+    /// ones before the first frame. Any thread.
+    CameraParams GetFrame() const;
+
+  private:
+    metaview::SeqLock<CameraParams> m_Latest;
+    metaview::SeqLock<CameraParams> m_Frame;
+
+    /// Whether LatchFrame was called yet
+    std::atomic_bool m_bFrameLatched{false};
+};
@@ -20,16 +20,20 @@
 #include "CommonTypes.h"
 #include "Input/Input.h"
 #include "Model/InitErrors.h"
+#include "Model/Timebase.h"
 #include "OpenVRProviderContext.h"
 #include "ProviderInterface/IUnityXRStats.h"
 #include "ProviderInterface/UnityXRDisplayStats.h"
 #include "ProviderInterface/XRMath.h"
+#include "RuntimeConfig.h"
 #include "UnityInterfaces.h"
 #include "UserProjectSettings.h"
 
-#ifdef __linux__
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstring>
-#endif
+#include <mutex>
 
 // #define REALORTHO
 using namespace metaview;
@@ -40,19 +44,20 @@ constexpr float AspectRatio = 2.00683f;
 // Distance from center to top, as well as distance from center to viewer.
 constexpr float OrthoHalfSize = 2.5f;  // 0.1f;
 
-constexpr float PerspectiveHalfAngleHeightTangent = 0.845065f;
-constexpr float PerspectiveHalfAngleWidthTangent = 0.939062f;
+// Points sampled around the lens contour for occlusion meshes
+constexpr uint32_t OcclusionMeshSegments = 64;
 
-//! @todo these are placeholder values
-constexpr UnityXRProjectionHalfAngles LeftFov = {
-    -PerspectiveHalfAngleWidthTangent, PerspectiveHalfAngleWidthTangent,
-    PerspectiveHalfAngleHeightTangent, -PerspectiveHalfAngleHeightTangent};
-constexpr UnityXRProjectionHalfAngles RightFov = {
-    -PerspectiveHalfAngleWidthTangent, PerspectiveHalfAngleWidthTangent,
-    PerspectiveHalfAngleHeightTangent, -PerspectiveHalfAngleHeightTangent};
+static_assert(sizeof(metaview::OcclusionMeshVertex) == sizeof(UnityXRVector2),
+              "Occlusion mesh vertices are handed to Unity as they are");
 
-// This can be updated during runtime.
-static UnityXRProjectionHalfAngles SingleCamFov = LeftFov;
+static EyeFov ToEyeFov(const UnityXRProjectionHalfAngles &halfAngles) {
+    EyeFov fov;
+    fov.left = halfAngles.left;
+    fov.right = halfAngles.right;
+    fov.top = halfAngles.top;
+    fov.bottom = halfAngles.bottom;
+    return fov;
+}
 
 // Interfaces
 static IUnityXRDisplayInterface *s_pXRDisplay = nullptr;
@@ -60,48 +65,87 @@ static IUnityXRStats *s_pXRStats;
 static UnitySubsystemHandle s_DisplayHandle;
 static OpenVRProviderContext *s_pProviderContext;
 
-// Han Custom Code
-// this IPD can be changed in runtime.
-static float SinglePassInstancedCamIPD = NominalIpd;
-
-static float LeftEyeX = -0.0315f;
-
-static float RightEyeX = 0.0315f;
-
-static float LeftEyeY = 0;
-
-static float RightEyeY = 0;
-
-static float LeftEyeZ = 0;
-
-static float RightEyeZ = 0;
-
-static UnityXRProjectionHalfAngles LeftFovRuntime = LeftFov;
-
-static UnityXRProjectionHalfAngles RightFovRuntime = RightFov;
-
-// XR Stats
-static UnityXRStatId m_nNumDroppedFrames;  // number of additional times
-                                           // previous frame was scanned out
-static UnityXRStatId
-    m_nNumFramePresents;  // number of times this frame was presented
-static UnityXRStatId
-    m_flFrameTimeReference;  // absolute time reference for comparing
-                             // frames.This aligns with the vsync that running
-                             // start is relative to.
-static UnityXRStatId
-    m_flGPURenderTimeInMs;  // time between work submitted immediately after
-                            // present (ideally vsync) until the end of
-                            // compositor submitted work
-static UnityXRStatId m_flCPURenderTimeInMs;  // time spent on cpu submitting the
-                                             // above work for this frame
-static UnityXRStatId
-    m_flCPUIdelTimeInMs;  // time spent waiting for running start (application
-                          // could have used this much more time)
-static UnityXRStatId
-    m_flCompositorRenderTimeInMs;  // time spend performing distortion
-                                   // correction, rendering chaperone, overlays,
-                                   // etc.
+// How long before the target vblank the renderer wakes us to start a frame.
+// Can be changed at runtime.
+static std::atomic<int64_t> FramePacingRunningStartNs{2'000'000};
+
+// Whether scanouts are scheduled on the renderer's present thread rather than
+// on Unity's graphics thread. Can be changed at runtime.
+static std::atomic_bool UsePresentThread{true};
+
+// Whether Unity may render straight into the scanout surfaces when the
+// configuration allows it. Can be changed at runtime.
+static std::atomic_bool AllowZeroCopySubmission{true};
+
+// Video memory budget for eye textures in bytes, 0 for unlimited. Can be
+// changed at runtime.
+static std::atomic<uint64_t> EyeTextureBudgetBytes{0};
+
+// How much memory idle eye textures may keep in the pool, in bytes. Can be
+// changed at runtime.
+static std::atomic<uint64_t> EyeTexturePoolCapacityBytes{256 * 1024 * 1024};
+
+// Dynamic resolution: whether enabled, the fraction of the frame budget GPU
+// time should settle at, and the lowest render scale allowed. Can be changed
+// at runtime.
+static std::atomic_bool DynamicResolutionEnabled{false};
+static std::atomic<float> DynamicResolutionTargetFraction{0.85f};
+static std::atomic<float> DynamicResolutionMinScale{0.5f};
+
+// How many scanout surfaces to cycle through: 2 or 3, or 0 to pick between
+// them from measured load. Can be changed at runtime.
+static std::atomic<uint32_t> RequestedSwapchainDepth{2};
+
+// Whether frames are reprojected to the latest head orientation by the
+// renderer's timewarp compositor. Can be changed at runtime.
+static std::atomic_bool TimewarpEnabled{false};
+
+// Whether timewarp corrects head translation too, using the depth Unity
+// renders. Can be changed at runtime.
+static std::atomic_bool TimewarpPositional{false};
+
+// Whether the head pose is re-sampled just before submission, and the eye
+// textures rotated to it on their way to the swapchain image. Not needed while
+// timewarp is active, which samples later still. Can be changed at runtime.
+static std::atomic_bool LateLatchEnabled{false};
+
+// How many vblanks each frame lasts: 1 to render at the refresh rate, 2 for
+// half rate with timewarp synthesizing the frames in between, or 0 to switch
+// between them from dropped frames. Can be changed at runtime.
+static std::atomic<uint32_t> RequestedFrameInterval{1};
+
+// Unity renders with reversed Z on D3D11
+static constexpr bool DepthIsReversedZ = true;
+
+// How many frames in a row must miss their vblank before we warn about it
+static constexpr uint32_t ConsecutiveLateFramesWarning = 10;
+
+// Timestamps recorded on the GPU each frame
+enum EGpuTimestamp {
+    GpuTimestampFrameBegin,
+    GpuTimestampBlitBegin,
+    GpuTimestampBlitEnd,
+    GpuTimestampEndFrameBegin,
+    GpuTimestampEndFrameEnd,
+    NumGpuTimestamps
+};
+
+// What we time on the GPU each frame: the whole frame from setup to present,
+// the eye texture copy, and the present. Also the scope indices of
+// GetGpuTimingStats.
+enum EGpuTimingScope {
+    GpuTimingScopeFrame,
+    GpuTimingScopeBlit,
+    GpuTimingScopeEndFrame,
+    NumGpuTimingScopes
+};
+
+// Frames of GPU timestamp queries in flight before we skip timing frames
+static constexpr size_t GpuTimingDepth = 5;
+
+// Latest GPU timing statistics, for GetGpuTimingStats
+static std::mutex GpuTimingMutex;
+static metaview::RollingSummary GpuTimingSummaries[NumGpuTimingScopes];
 
 static UnitySubsystemErrorCode UNITY_INTERFACE_API
 GfxThread_Start(UnitySubsystemHandle handle, void *userData,
@@ -170,10 +214,9 @@ SetProjectionParamsForSingleCamera(float left, float right, float top,
              "Given project parameters from managed code: L: %f  R: %f  T: %f  "
              "B: %f\n",
              left, right, top, bottom);
-    SingleCamFov.left = left;
-    SingleCamFov.right = right;
-    SingleCamFov.top = top;
-    SingleCamFov.bottom = bottom;
+    CameraParamBlock::Get().Update([&](CameraParams &params) {
+        params.singleCameraFov = {left, right, top, bottom};
+    });
 }
 
 // Callback executed when a subsystem should initialize in preparation for
@@ -277,18 +320,15 @@ UnitySubsystemErrorCode OpenVRDisplayProvider::Lifecycle_Start(
     // Setup mirror subrect defaults
     SetupMirror();
 
+    m_stats.Register(s_pXRStats, handle);
+
     return kUnitySubsystemErrorCodeSuccess;
 }
 
 void OpenVRDisplayProvider::Lifecycle_Stop(UnitySubsystemHandle handle) {
     XR_TRACE_LOG(XR_TRACE_PTR, PLUGIN_LOG_PREFIX "XR Display Stop\n");
 
-#if 0
-    // Unregister XR Stats
-    if (s_pXRStats) {
-        s_pXRStats->UnregisterStatSource(handle);
-    }
-#endif
+    m_stats.Unregister();
 
     m_bFrameInFlight = false;
 }
@@ -301,6 +341,9 @@ void OpenVRDisplayProvider::Lifecycle_Shutdown(UnitySubsystemHandle handle) {
 
     swapchainImages_.clear();
     rtvs_.clear();
+    gpuProfiler_.reset();
+    gpuTimestamps_.reset();
+    m_gpuFrameMs.clear();
     renderer_.reset();
 
     // Explicitly reset member vars as Unity holds on to them in-between editor
@@ -344,9 +387,8 @@ UnitySubsystemErrorCode OpenVRDisplayProvider::GfxThread_Start(
     renderingCaps->noSinglePassRenderingSupport = false;
     renderingCaps->invalidateRenderStateAfterEachCallback = true;
 
-    // Get occlusion mesh/hidden area mesh for both eyes (if available)
-    // m_pOcclusionMeshLeftEye = SetupOcclusionMesh(Eye::Left);
-    // m_pOcclusionMeshRightEye = SetupOcclusionMesh(Eye::Right);
+    // Occlusion meshes (hidden area meshes) are built with the first frame's
+    // camera parameters, see UpdateOcclusionMeshes
 
     if (renderer_) {
         // We already brought up the renderer
@@ -367,8 +409,25 @@ UnitySubsystemErrorCode OpenVRDisplayProvider::GfxThread_Start(
         auto unityD3D11 =
             UnityInterfaces::Get().GetInterface<IUnityGraphicsD3D11>();
 
+        // Allocate the deepest swapchain we may use up front, so changing
+        // depth is just a matter of cycling through fewer surfaces
         renderer_ = std::make_unique<metaview::Renderer>(
-            std::move(renderParam), 2, unityD3D11->GetDevice());
+            std::move(renderParam), k_nMaxNumStages - 1,
+            unityD3D11->GetDevice());
+        renderer_->setSurfaceCount(2);
+        // Runs on the renderer's vblank thread
+        renderer_->getFrameClassifier().setMissCallback(
+            ConsecutiveLateFramesWarning, [](uint32_t consecutiveLate) {
+                XR_TRACE_WARNING(XR_TRACE_PTR,
+                                 PLUGIN_LOG_PREFIX "%u frames late in a row\n",
+                                 consecutiveLate);
+            });
+        // Runs on the graphics thread and the timewarp compositor's thread
+        renderer_->setPoseProvider(
+            [](int64_t timeNs, metaview::Posef &pose) {
+                return s_pProviderContext->inputProvider->GetLatestHeadPose(
+                    timeNs, pose);
+            });
 
         swapchainImages_ = renderer_->getSwapchainImages();
         rtvs_ = renderer_->getSwapchainRTVs();
@@ -411,9 +470,20 @@ void OpenVRDisplayProvider::TryUpdateMirrorMode(bool skipResolutionCheck) {
 UnitySubsystemErrorCode OpenVRDisplayProvider::GfxThread_PopulateNextFrameDesc(
     const UnityXRFrameSetupHints *frameHints, UnityXRNextFrameDesc *nextFrame) {
     UnitySubsystemErrorCode ret = kUnitySubsystemErrorCodeSuccess;
-    s_pProviderContext->inputProvider->GfxThread_UpdateDevices();
+    // Take up what managed code wrote to the shared config block, if any
+    RuntimeConfig::PollSharedBlock();
+    // Both providers set this frame up with these, so latch them before the
+    // input provider updates its devices
+    m_CameraParams = CameraParamBlock::Get().LatchFrame();
+    // Predict poses to when this frame should reach the display
+    metaview::Timebase &timebase = metaview::Timebase::instance();
+    const int64_t nowNs = timebase.now();
+    // 0 until the pacer locks, in which case poses are not predicted
+    const int64_t photonTimeNs =
+        renderer_ ? renderer_->getFramePacer().predictNextTarget(nowNs) : 0;
+    s_pProviderContext->inputProvider->GfxThread_UpdateDevices(photonTimeNs);
     m_bIsUsingSRGB = frameHints->appSetup.sRGB;
-    m_bRotateEyes = UserProjectSettings::RotateEyes();
+    m_bRotateEyes = m_CameraParams.rotateEyes != 0;
 
     TryUpdateMirrorMode();
 
@@ -449,11 +519,31 @@ UnitySubsystemErrorCode OpenVRDisplayProvider::GfxThread_PopulateNextFrameDesc(
         }
     }
 
-    // Check if there was a request to change the texture resolution scale
+    // Check if there was a request to change the texture resolution scale,
+    // or the budget they have to fit in
     if ((kUnityXRFrameSetupHintsChangedTextureResolutionScale &
-         frameHints->changedFlags) != 0) {
-        if (m_bTexturesCreated && s_DisplayHandle)
-            DestroyEyeTextures(s_DisplayHandle);
+         frameHints->changedFlags) != 0 ||
+        m_textureAllocator.GetBudget() != EyeTextureBudgetBytes) {
+        if (m_bTexturesCreated) ReleaseEyeTextures();
+
+        m_bTexturesCreated = false;
+    }
+
+    UpdateFrameInterval();
+    UpdateTimewarp(frameHints);
+
+    // Copied submission uses one set of eye textures per swapchain surface
+    const int nSwapchainDepth = UpdateSwapchainDepth();
+    if (m_bTexturesCreated && !m_bZeroCopy &&
+        nSwapchainDepth != m_nNumStages) {
+        ReleaseEyeTextures();
+
+        m_bTexturesCreated = false;
+    }
+
+    // Switch between zero-copy and copied submission if needed
+    if (m_bTexturesCreated && CanUseZeroCopy(frameHints) != m_bZeroCopy) {
+        ReleaseEyeTextures();
 
         m_bTexturesCreated = false;
     }
@@ -462,8 +552,31 @@ UnitySubsystemErrorCode OpenVRDisplayProvider::GfxThread_PopulateNextFrameDesc(
         ret = CreateEyeTextures(frameHints);
     }
 
+    // Evict and destroy old eye textures the GPU is done with
+    m_texturePool.SetCapacity(EyeTexturePoolCapacityBytes);
+    if (s_DisplayHandle) {
+        m_texturePool.Collect(GetCompletedFenceValue(),
+                              [](UnityXRRenderTextureId id) {
+                                  s_pXRDisplay->DestroyTexture(s_DisplayHandle,
+                                                               id);
+                              });
+    }
+    UpdateTextureStats();
+
     if (renderer_) {
+        renderer_->setRunningStart(
+            std::chrono::nanoseconds(FramePacingRunningStartNs.load()));
+        renderer_->setUsePresentThread(UsePresentThread);
         swapchainImageIndex_ = renderer_->waitFrame();
+        // The pose Unity renders with, for late latching and timewarp
+        metaview::Posef renderPose;
+        if (s_pProviderContext->inputProvider->GfxThread_GetRenderHeadPose(
+                renderPose)) {
+            renderer_->setFrameRenderPose(renderPose);
+        }
+        UpdateGpuTiming();
+        UpdateDynamicResolution();
+        UpdateFrameStats();
 
         auto rtv = rtvs_[swapchainImageIndex_];
         float clearColor[4] = {0.7f, 0.2f, 0.2f, 1.f};
@@ -477,6 +590,8 @@ UnitySubsystemErrorCode OpenVRDisplayProvider::GfxThread_PopulateNextFrameDesc(
             "Single Camera mode requires single-pass-capable shaders");
     }
 
+    UpdateOcclusionMeshes();
+
     // Calculate culling frustum
     if (frameHints->appSetup.singlePassRendering ||
         m_renderingMode == EVRStereoRenderingModes::SingleCamera) {
@@ -498,35 +613,6 @@ UnitySubsystemErrorCode OpenVRDisplayProvider::GfxThread_PopulateNextFrameDesc(
 
     m_bFrameInFlight = true;
 
-#if 0
-    // Set frame stats
-    if (s_pXRStats) {
-        vr::Compositor_FrameTiming pTiming = {};
-        pTiming.m_nSize = sizeof(vr::Compositor_FrameTiming);
-
-        if (vr::VRCompositor() &&
-            vr::VRCompositor()->GetFrameTiming(&pTiming, 0)) {
-            // Unity XRStats in this version only exposes floats
-            // Since we are in the gfx thread, we do NOT need to call increment
-            // frame here for XRStats
-            s_pXRStats->SetStatFloat(m_nNumDroppedFrames,
-                                     (float)pTiming.m_nNumDroppedFrames);
-            s_pXRStats->SetStatFloat(m_nNumFramePresents,
-                                     (float)pTiming.m_nNumFramePresents);
-            s_pXRStats->SetStatFloat(m_flFrameTimeReference,
-                                     (float)pTiming.m_flSystemTimeInSeconds);
-            s_pXRStats->SetStatFloat(m_flGPURenderTimeInMs,
-                                     pTiming.m_flTotalRenderGpuMs);
-            s_pXRStats->SetStatFloat(m_flCPURenderTimeInMs,
-                                     pTiming.m_flCompositorRenderCpuMs);
-            s_pXRStats->SetStatFloat(m_flCPUIdelTimeInMs,
-                                     pTiming.m_flCompositorIdleCpuMs);
-            s_pXRStats->SetStatFloat(m_flCompositorRenderTimeInMs,
-                                     pTiming.m_flCompositorRenderGpuMs);
-        }
-    }
-#endif
-
     return ret;
 }
 
@@ -534,44 +620,90 @@ void OpenVRDisplayProvider::SubmitToRenderer(int stage) {
     if (!renderer_) {
         return;
     }
+    if (m_bZeroCopy) {
+        // Unity rendered straight into the swapchain image
+        WriteTimewarpDepth(stage, metaview::BlitRect{});
+        gpuProfiler_->mark(GpuTimestampEndFrameBegin);
+        renderer_->endFrame();
+        gpuProfiler_->mark(GpuTimestampEndFrameEnd);
+        gpuProfiler_->endFrame();
+        return;
+    }
     auto rtv = rtvs_[swapchainImageIndex_];
     auto texture = swapchainImages_[swapchainImageIndex_];
-    auto blitIt = [&](int nTexIndex, int subresource, UINT dstx, UINT dsty) {
+    uint32_t height = 0, width = 0;
+    GetEyeTextureDimensions(height, width);
+    // The budget may have made the eye textures smaller than the display
+    const EyeTextureLayout &layout = m_textureAllocator.GetAllocated();
+    const bool bScaled = layout.width != width || layout.height != height ||
+                         m_flFrameRenderScale < 1.0f;
+    // Late latch: rotate each eye by how far the head turned since Unity
+    // sampled its pose
+    const bool bLateLatch =
+        LateLatchEnabled && !m_bTimewarpActive && renderer_->latchPose();
+    // The part of each eye texture Unity rendered to, in texture coordinates
+    // (top left origin)
+    metaview::BlitRect sourceRect;
+    sourceRect.y = 1.f - m_flFrameRenderScale;
+    sourceRect.width = m_flFrameRenderScale;
+    sourceRect.height = m_flFrameRenderScale;
+    if ((bScaled || bLateLatch) && !blitter_) {
+        blitter_ = std::make_unique<metaview::Blitter>(
+            renderer_->getDevice().get());
+    }
+    auto blitIt = [&](int nEye, int nTexIndex, int subresource, UINT dstx,
+                      UINT dsty) {
+        auto context = this->renderer_->getImmediateContext();
+        if (bScaled || bLateLatch) {
+            // stretch the eye texture over its part of the output texture.
+            D3D11_VIEWPORT viewport = {(float)dstx, (float)dsty, (float)width,
+                                       (float)height, 0.f, 1.f};
+            const metaview::Mat3f warp =
+                bLateLatch ? renderer_->getLateLatchWarp(nEye)
+                           : metaview::Mat3f{};
+            blitter_->blit(context.get(), GetEyeTextureView(stage, nTexIndex),
+                           subresource, rtv.get(), viewport, sourceRect, warp);
+            return;
+        }
         ID3D11Texture2D *src = static_cast<ID3D11Texture2D *>(
             GetNativeEyeTexture(stage, nTexIndex));
         // copy the entire eye texture to our output texture.
-        this->renderer_->getImmediateContext()->CopySubresourceRegion(
-            texture.get(), 0, dstx, dsty, 0, src, subresource, nullptr);
+        context->CopySubresourceRegion(texture.get(), 0, dstx, dsty, 0, src,
+                                       subresource, nullptr);
     };
-    uint32_t height = 0, width = 0;
-    GetEyeTextureDimensions(height, width);
+    gpuProfiler_->mark(GpuTimestampBlitBegin);
     switch (m_renderingMode) {
         case EVRStereoRenderingModes::MultiPass:
             // left eye
-            blitIt(0, 0, 0, 0);
+            blitIt(0, 0, 0, 0, 0);
             // right eye
-            blitIt(1, 0, width, 0);
+            blitIt(1, 1, 0, width, 0);
             break;
         case EVRStereoRenderingModes::SinglePassInstanced:
             // Use the left eye texture if we're doing a single pass
             // left eye
-            blitIt(0, 0, 0, 0);
+            blitIt(0, 0, 0, 0, 0);
             // right eye
-            blitIt(0, 1, width, 0);
+            blitIt(1, 0, 1, width, 0);
             break;
         case EVRStereoRenderingModes::SingleCamera:
             // everything in the first layer of the left eye
-            blitIt(0, 0, 0, 0);
+            blitIt(0, 0, 0, 0, 0);
             break;
     }
+    gpuProfiler_->mark(GpuTimestampBlitEnd);
+    WriteTimewarpDepth(stage, sourceRect);
+    gpuProfiler_->mark(GpuTimestampEndFrameBegin);
     renderer_->endFrame();
+    gpuProfiler_->mark(GpuTimestampEndFrameEnd);
+    gpuProfiler_->endFrame();
 }
 
 UnitySubsystemErrorCode OpenVRDisplayProvider::GfxThread_SubmitCurrentFrame() {
     if (!m_bFrameInFlight) return kUnitySubsystemErrorCodeSuccess;
 
     // Get the stage for the current frame
-    int stage = m_nCurFrame % m_nNumStages;
+    int stage = GetCurrentStage();
 
     // Advance frame number
     m_nCurFrame = (m_nCurFrame < UINT32_MAX) ? m_nCurFrame + 1 : 0;
@@ -654,6 +786,9 @@ UnitySubsystemErrorCode OpenVRDisplayProvider::GfxThread_Stop() {
     if (m_pOcclusionMeshRightEye != 0)
         s_pXRDisplay->DestroyOcclusionMesh(s_DisplayHandle,
                                            m_pOcclusionMeshRightEye);
+    m_pOcclusionMeshLeftEye = k_nInvalidUnityXROcclusionMeshId;
+    m_pOcclusionMeshRightEye = k_nInvalidUnityXROcclusionMeshId;
+    m_bOcclusionMeshesBuilt = false;
 
     renderer_->blankScreen();
     return kUnitySubsystemErrorCodeSuccess;
@@ -663,7 +798,14 @@ UnitySubsystemErrorCode OpenVRDisplayProvider::MainThread_UpdateDisplayState(
     UnityXRDisplayState *state) {
     state->displayIsTransparent = true;
 
-    state->reprojectionMode = kUnityXRReprojectionModeNone;
+    if (!m_bTimewarpActive) {
+        state->reprojectionMode = kUnityXRReprojectionModeNone;
+    } else if (TimewarpPositional) {
+        state->reprojectionMode =
+            kUnityXRReprojectionModePositionAndOrientation;
+    } else {
+        state->reprojectionMode = kUnityXRReprojectionModeOrientationOnly;
+    }
     state->focusLost = false;
 
     return kUnitySubsystemErrorCodeSuccess;
@@ -817,29 +959,6 @@ static void OpenVRMatrix3x4ToUnity(const vr::HmdMatrix34_t &ovrm,
 }
 
 void OpenVRDisplayProvider::SetupMirror() {
-#if 0
-    // Set XR Stats
-    if (s_pXRStats) {
-        s_pXRStats->RegisterStatSource(s_DisplayHandle);
-        m_nNumDroppedFrames = s_pXRStats->RegisterStatDefinition(
-            s_DisplayHandle, "OpenVR.DroppedFrames", kUnityXRStatOptionNone);
-        m_nNumFramePresents = s_pXRStats->RegisterStatDefinition(
-            s_DisplayHandle, "OpenVR.FramePresents", kUnityXRStatOptionNone);
-        m_flFrameTimeReference = s_pXRStats->RegisterStatDefinition(
-            s_DisplayHandle, "OpenVR.FrameTimeReferenceSecs",
-            kUnityXRStatOptionNone);
-        m_flGPURenderTimeInMs = s_pXRStats->RegisterStatDefinition(
-            s_DisplayHandle, "OpenVR.GPURenderTimeMs", kUnityXRStatOptionNone);
-        m_flCPURenderTimeInMs = s_pXRStats->RegisterStatDefinition(
-            s_DisplayHandle, "OpenVR.CPURenderTimeMs", kUnityXRStatOptionNone);
-        m_flCPUIdelTimeInMs = s_pXRStats->RegisterStatDefinition(
-            s_DisplayHandle, "OpenVR.CPUIdleTimeMs", kUnityXRStatOptionNone);
-        m_flCompositorRenderTimeInMs = s_pXRStats->RegisterStatDefinition(
-            s_DisplayHandle, "OpenVR.CompositorRenderTimeMs",
-            kUnityXRStatOptionNone);
-    }
-#endif
-
     // Get recommended render target size based on currently active hmd,
     // assuming horizontal side by side.
     GetEyeTextureDimensions(m_nEyeHeight, m_nEyeWidth);
@@ -945,7 +1064,7 @@ void OpenVRDisplayProvider::SetupRenderPass(
     UnityXRNextFrameDesc::UnityXRRenderPass &renderPass =
         pTargetFrame->renderPasses[nRenderPasses];
     renderPass.textureId =
-        m_UnityTextures[m_nCurFrame % m_nNumStages][nRenderPasses];
+        m_UnityTextures[GetCurrentStage()][m_bZeroCopy ? 0 : nRenderPasses];
     renderPass.renderParamsCount = nRenderParamsCount;
     renderPass.cullingPassIndex = nRenderPasses;
 
@@ -953,9 +1072,23 @@ void OpenVRDisplayProvider::SetupRenderPass(
     UnityXRNextFrameDesc::UnityXRRenderPass::UnityXRRenderParams &renderParams =
         renderPass.renderParams[nParamsCount];
     renderParams.deviceAnchorToEyePose = GetEyePose(eEye);
-    renderParams.projection = GetProjection(eEye, pFrameHints->appSetup.zNear,
-                                            pFrameHints->appSetup.zFar);
+    renderParams.projection =
+        GetCachedProjection(eEye, pFrameHints->appSetup.zNear,
+                            pFrameHints->appSetup.zFar)
+            .projection;
     renderParams.viewportRect = {0.0f, 0.0f, 1.0f, 1.0f};
+    if (m_flFrameRenderScale < 1.0f) {
+        // Dynamic resolution: render into the bottom left corner (Unity
+        // viewport origin), SubmitToRenderer scales it back up.
+        renderParams.viewportRect = {0.0f, 0.0f, m_flFrameRenderScale,
+                                     m_flFrameRenderScale};
+    }
+    if (m_bZeroCopy && eEye == EEye::Left) {
+        // Both eyes share the side-by-side swapchain image
+        renderParams.viewportRect = {0.0f, 0.0f, 0.5f, 1.0f};
+    } else if (m_bZeroCopy && eEye == EEye::Right) {
+        renderParams.viewportRect = {0.5f, 0.0f, 0.5f, 1.0f};
+    }
     renderParams.textureArraySlice = nTextureArraySlice;
 
     // Set an occlusion mesh (hidden area mesh) if there's a valid one
@@ -966,80 +1099,77 @@ void OpenVRDisplayProvider::SetupRenderPass(
     }
 }
 
-UnityXROcclusionMeshId OpenVRDisplayProvider::SetupOcclusionMesh(EEye eEye) {
-    return k_nInvalidUnityXROcclusionMeshId;
-#if 0
-    // Grab the hidden area mesh from SteamVR
-    vr::HiddenAreaMesh_t vrHiddenMesh = vr::VRSystem()->GetHiddenAreaMesh(
-        (vr::EVREye)eEye, vr::k_eHiddenAreaMesh_Standard);
+// Whether two sets of camera parameters give the same occlusion meshes
+static bool SameOptics(const CameraParams &a, const CameraParams &b) {
+    return std::memcmp(&a.leftFov, &b.leftFov, sizeof(a.leftFov)) == 0 &&
+           std::memcmp(&a.rightFov, &b.rightFov, sizeof(a.rightFov)) == 0 &&
+           std::memcmp(&a.lensContour, &b.lensContour,
+                       sizeof(a.lensContour)) == 0;
+}
 
-    if (vrHiddenMesh.pVertexData == NULL || vrHiddenMesh.unTriangleCount == 0) {
-        XR_TRACE(PLUGIN_LOG_PREFIX
-                 "No hidden area mesh available for eye[%i] in active "
-                 "hmd\n",
-                 (int)eEye);
-        return k_nInvalidUnityXROcclusionMeshId;
+void OpenVRDisplayProvider::UpdateOcclusionMeshes() {
+    if (m_bOcclusionMeshesBuilt &&
+        SameOptics(m_OcclusionMeshParams, m_CameraParams)) {
+        return;
     }
+    m_pOcclusionMeshLeftEye = SetupOcclusionMesh(EEye::Left);
+    m_pOcclusionMeshRightEye = SetupOcclusionMesh(EEye::Right);
+    m_OcclusionMeshParams = m_CameraParams;
+    m_bOcclusionMeshesBuilt = true;
+}
 
-    // Setup our vertex and index arrays
-    std::vector<uint32_t> vIndices(
-        (long long)vrHiddenMesh.unTriangleCount * (long long)3, UINT32_MAX);
-    std::vector<UnityXRVector2> vVertices;
-    vVertices.reserve(vIndices.size());
+UnityXROcclusionMeshId OpenVRDisplayProvider::SetupOcclusionMesh(EEye eEye) {
+    UnityXROcclusionMeshId meshId = (eEye == EEye::Left)
+                                        ? m_pOcclusionMeshLeftEye
+                                        : m_pOcclusionMeshRightEye;
+    const UnityXRProjectionHalfAngles &fov =
+        (eEye == EEye::Left) ? m_CameraParams.leftFov : m_CameraParams.rightFov;
+    metaview::LensContour contour = m_CameraParams.lensContour;
+    if (eEye == EEye::Right) {
+        contour.centerX = -contour.centerX;
+    }
 
-    for (size_t v1 = 0; v1 < vIndices.size();
-         v1++)  // Go through each vertex from OpenVR (may contain duplicates)
-    {
-        if (vIndices[v1] != UINT32_MAX)  // Skip if already assigned (i.e. was
-                                         // found to be a duplicate)
-            continue;
-
-        uint32_t nIndex = (uint32_t)vVertices.size();  // Record new index
-        vIndices[v1] = nIndex;
-
-        const auto &v = vrHiddenMesh.pVertexData[v1].v;  // Keep this vertex
-        vVertices.push_back({v[0], v[1]});
-
-        for (size_t v2 = v1 + 1; v2 < vVertices.size();
-             v2++)  // Check remaining for duplicate vertices
-        {
-            static const float k_flThreshold = 1e-9f;
-            if (GetDistanceSquared2D(v, vrHiddenMesh.pVertexData[v2].v) <
-                k_flThreshold) {
-                vIndices[v2] = nIndex;  // Remap this index to point to similar
-                                        // earlier vertex
-            }
+    if (!metaview::buildOcclusionMesh(ToEyeFov(fov), contour,
+                                      OcclusionMeshSegments,
+                                      m_OcclusionMesh)) {
+        // The optics show the whole view
+        if (meshId != k_nInvalidUnityXROcclusionMeshId) {
+            s_pXRDisplay->DestroyOcclusionMesh(s_DisplayHandle, meshId);
         }
+        return k_nInvalidUnityXROcclusionMeshId;
     }
 
-    // Create a Unity occlusion mesh
-    UnityXROcclusionMeshId pOcclusionMeshId;
-    UnitySubsystemErrorCode res = s_pXRDisplay->CreateOcclusionMesh(
-        s_DisplayHandle, (uint32_t)vVertices.size(), (uint32_t)vIndices.size(),
-        &pOcclusionMeshId);
-
-    if (res != kUnitySubsystemErrorCodeSuccess) {
-        XR_TRACE(PLUGIN_LOG_PREFIX
-                 "Error creating occlusion mesh for eye[%i]: [%i]\n",
-                 (int)eEye, res);
-        return k_nInvalidUnityXROcclusionMeshId;
+    const uint32_t nVertices =
+        static_cast<uint32_t>(m_OcclusionMesh.vertices.size());
+    const uint32_t nIndices =
+        static_cast<uint32_t>(m_OcclusionMesh.indices.size());
+    UnitySubsystemErrorCode res;
+    if (meshId == k_nInvalidUnityXROcclusionMeshId) {
+        // The counts only depend on OcclusionMeshSegments, so later changes
+        // update this mesh in place
+        res = s_pXRDisplay->CreateOcclusionMesh(s_DisplayHandle, nVertices,
+                                                nIndices, &meshId);
+        if (res != kUnitySubsystemErrorCodeSuccess) {
+            XR_TRACE(PLUGIN_LOG_PREFIX
+                     "Error creating occlusion mesh for eye[%i]: [%i]\n",
+                     (int)eEye, res);
+            return k_nInvalidUnityXROcclusionMeshId;
+        }
     }
 
-    // Setup the Unity occlusion mesh
     res = s_pXRDisplay->SetOcclusionMesh(
-        s_DisplayHandle, pOcclusionMeshId, vVertices.data(),
-        (uint32_t)vVertices.size(), vIndices.data(), (uint32_t)vIndices.size());
-
+        s_DisplayHandle, meshId,
+        reinterpret_cast<UnityXRVector2 *>(m_OcclusionMesh.vertices.data()),
+        nVertices, m_OcclusionMesh.indices.data(), nIndices);
     if (res != kUnitySubsystemErrorCodeSuccess) {
         XR_TRACE(PLUGIN_LOG_PREFIX
-                 "Error creating occlusion mesh for eye[%i]: [%i]\n",
-                 eEye, res);
+                 "Error setting occlusion mesh for eye[%i]: [%i]\n",
+                 (int)eEye, res);
+        s_pXRDisplay->DestroyOcclusionMesh(s_DisplayHandle, meshId);
         return k_nInvalidUnityXROcclusionMeshId;
     }
 
-    // Finally, return the occlusion mesh id to caller
-    return pOcclusionMeshId;
-#endif
+    return meshId;
 }
 
 float OpenVRDisplayProvider::GetDistanceSquared2D(const float *pVector1,
@@ -1065,11 +1195,14 @@ UnityXRPose OpenVRDisplayProvider::GetEyePose(EEye eye) {
     // this actually wants eye to head, I think.
     XRVector3 pos{0, 0, -NominalHeadToEye};
     if (eye != EEye::CenterOrBoth) {
-        pos.x = (eye == EEye::Left) ? LeftEyeX : RightEyeX;
+        const UnityXRVector3 &eyePosition =
+            (eye == EEye::Left) ? m_CameraParams.leftEyePosition
+                                : m_CameraParams.rightEyePosition;
+        pos.x = eyePosition.x;
 
-        pos.y = (eye == EEye::Left) ? -LeftEyeY : -RightEyeY;
+        pos.y = -eyePosition.y;
 
-        pos.z = (eye == EEye::Left) ? -LeftEyeZ : -RightEyeZ;
+        pos.z = -eyePosition.z;
     }
     ret.position = pos;
 
@@ -1221,34 +1354,36 @@ UnityXRProjection OpenVRDisplayProvider::GetProjection(EEye eye, float flNear,
 #else
 
     if (m_renderingMode == EVRStereoRenderingModes::SingleCamera) {
-        ret = makePerspective(SingleCamFov.left, SingleCamFov.right,
-                              SingleCamFov.top, SingleCamFov.bottom, flNear,
+        const UnityXRProjectionHalfAngles &fov = m_CameraParams.singleCameraFov;
+        ret = makePerspective(fov.left, fov.right, fov.top, fov.bottom, flNear,
                               flFar);
 
         return ret;
     }
 #endif
     {
+        const UnityXRProjectionHalfAngles &leftFov = m_CameraParams.leftFov;
+        const UnityXRProjectionHalfAngles &rightFov = m_CameraParams.rightFov;
         float vrL, vrR, vrT, vrB;
         if (eye == EEye::CenterOrBoth) {
             // Calculate combined left + right eye combined projection
             // Use the max extent's for each eye
-            vrL = LeftFovRuntime.left;
-            vrR = RightFovRuntime.right;
-            vrT = RightFovRuntime.top;
-            vrB = LeftFovRuntime.bottom;
+            vrL = leftFov.left;
+            vrR = rightFov.right;
+            vrT = rightFov.top;
+            vrB = leftFov.bottom;
 
         } else if (eye == EEye::Left) {
-            vrL = LeftFovRuntime.left;
-            vrR = LeftFovRuntime.right;
-            vrT = LeftFovRuntime.top;
-            vrB = LeftFovRuntime.bottom;
+            vrL = leftFov.left;
+            vrR = leftFov.right;
+            vrT = leftFov.top;
+            vrB = leftFov.bottom;
 
         } else {
-            vrL = RightFovRuntime.left;
-            vrR = RightFovRuntime.right;
-            vrT = RightFovRuntime.top;
-            vrB = RightFovRuntime.bottom;
+            vrL = rightFov.left;
+            vrR = rightFov.right;
+            vrT = rightFov.top;
+            vrB = rightFov.bottom;
         }
 
 #ifndef NDEBUG
@@ -1262,111 +1397,104 @@ UnityXRProjection OpenVRDisplayProvider::GetProjection(EEye eye, float flNear,
     return ret;
 }
 
+float OpenVRDisplayProvider::GetEyeSeparation() const {
+    return -m_CameraParams.leftEyePosition.x +
+           m_CameraParams.rightEyePosition.x;
+}
+
 static inline float computeEyePullback(float ipd, float vertFovRadians,
                                        float aspect) {
     return 0.5f * ipd / tanf(0.5f * vertFovRadians * aspect);
 }
 
-void OpenVRDisplayProvider::SetupCullingPass(
-    EEye eye, const UnityXRFrameSetupHints *frameHints,
-    UnityXRNextFrameDesc::UnityXRCullingPass &cullingPass) {
-    cullingPass.separation = -LeftEyeX + RightEyeX;
+const OpenVRDisplayProvider::CachedEyeProjection &
+OpenVRDisplayProvider::GetCachedProjection(EEye eye, float flNear,
+                                           float flFar) {
+    CachedEyeProjection &cached = m_CachedProjections[static_cast<int>(eye)];
 
-    UnityXRPose pose = GetEyePose(eye);
-    float eyePullback = 0.f;
-    UnityXRProjection projection;
+    const uint32_t version = m_CameraParams.version;
+    if (cached.bValid && cached.version == version && cached.zNear == flNear &&
+        cached.zFar == flFar && cached.renderingMode == m_renderingMode) {
+        return cached;
+    }
 
-    // clamp unreasonably small values for near/far
-    // Unity will sometimes ask for near/far values of 0, which we must respond
-    // sensibly to.
-    float flNear = (frameHints->appSetup.zNear < k_flNear)
-                       ? k_flNear
-                       : frameHints->appSetup.zNear;
-    float flFar = (frameHints->appSetup.zFar < k_flNear)
-                      ? k_flFar
-                      : frameHints->appSetup.zFar;
+    cached.projection = GetProjection(eye, flNear, flFar);
+    cached.cullingEyePullback = 0.f;
 #ifdef REALORTHO
-    if (m_renderingMode == EVRStereoRenderingModes::SingleCamera) {
-#if 0
-        // Compute a perspective frustum that includes the image plane, since
-        // orthographic culling doesn't work in Unity.
-        float distance = (flNear + flFar) / 2.f;
-        eyePullback = computeEyePullback(cullingPass.separation, 90.f * DEG2RAD,
-                                         AspectRatio);
-
-        projection = makePerspective(
-            // ratio times top divided by distance is ratio times 1
-            -AspectRatio, AspectRatio,
-            // top divided by distance is 1, etc.
-            1.f, -1.f, flNear, flFar);
-#endif
-
-        projection = GetProjection(eye, flNear, flFar);
-    } else
+    if (m_renderingMode != EVRStereoRenderingModes::SingleCamera)
 #endif
     {
-        projection = GetProjection(eye, flNear, flFar);
-        assert(projection.type == kUnityXRProjectionTypeMatrix);
-        float aspect = projection.data.matrix.columns[1].y /
-                       projection.data.matrix.columns[0].x;
+        assert(cached.projection.type == kUnityXRProjectionTypeMatrix);
+        const UnityXRMatrix4x4 &matrix = cached.projection.data.matrix;
+        float aspect = matrix.columns[1].y / matrix.columns[0].x;
 
-        float vertFov =
-            (2.0f * (float)atan(1.0f / projection.data.matrix.columns[1].y));
-        eyePullback =
-            computeEyePullback(cullingPass.separation, vertFov, aspect);
+        float vertFov = (2.0f * (float)atan(1.0f / matrix.columns[1].y));
+        cached.cullingEyePullback =
+            computeEyePullback(GetEyeSeparation(), vertFov, aspect);
     }
 
-    pose.position.z = pose.position.z - eyePullback;
+    cached.bValid = true;
+    cached.version = version;
+    cached.zNear = flNear;
+    cached.zFar = flFar;
+    cached.renderingMode = m_renderingMode;
+    return cached;
+}
+
+void OpenVRDisplayProvider::SetupCullingPass(
+    EEye eye, const UnityXRFrameSetupHints *frameHints,
+    UnityXRNextFrameDesc::UnityXRCullingPass &cullingPass) {
+    cullingPass.separation = GetEyeSeparation();
+
+    const CachedEyeProjection &cached = GetCachedProjection(
+        eye, frameHints->appSetup.zNear, frameHints->appSetup.zFar);
+
+    UnityXRPose pose = GetEyePose(eye);
+    pose.position.z = pose.position.z - cached.cullingEyePullback;
     cullingPass.deviceAnchorToCullingPose = pose;
-    cullingPass.projection = projection;
+    cullingPass.projection = cached.projection;
 }
 
 UnitySubsystemErrorCode OpenVRDisplayProvider::CreateEyeTextures(
     const UnityXRFrameSetupHints *frameHints) {
-    // One texture per eye, per stage
-    int nNumTextures = 2;
-
-    // Grab texture size from renderer
-    uint32_t eyeWidth, eyeHeight;
-    GetEyeTextureDimensions(eyeHeight, eyeWidth);
+    m_textureAllocator.SetBudget(EyeTextureBudgetBytes);
+    if (CanUseZeroCopy(frameHints)) {
+        return CreateZeroCopyEyeTextures(frameHints);
+    }
+    m_bZeroCopy = false;
+    m_nNumStages =
+        renderer_ ? static_cast<int>(renderer_->getSurfaceCount()) : 2;
+
+    // Size the textures for the rendering mode, within the budget
+    uint32_t nDisplayWidth, nDisplayHeight;
+    GetDisplayDimensions(nDisplayHeight, nDisplayWidth);
+    EyeTextureLayout layout = m_textureAllocator.Plan(
+        m_renderingMode, nDisplayWidth, nDisplayHeight,
+        frameHints->appSetup.textureResolutionScale, m_nNumStages);
+    if (layout.resolutionScale <
+        frameHints->appSetup.textureResolutionScale) {
+        XR_TRACE(PLUGIN_LOG_PREFIX
+                 "Eye texture resolution scale lowered from %f to %f to fit "
+                 "the budget\n",
+                 frameHints->appSetup.textureResolutionScale,
+                 layout.resolutionScale);
+    }
 
-    // Apply scale
-    float eyeWidthScaled =
-        eyeWidth * frameHints->appSetup.textureResolutionScale;
-    float eyeHeightScaled =
-        eyeHeight * frameHints->appSetup.textureResolutionScale;
-    eyeWidth = (uint32_t)eyeWidthScaled * 2;
-    eyeHeight = (uint32_t)eyeHeightScaled * 2;
+    EyeTextureKey key;
+    key.width = layout.width;
+    key.height = layout.height;
+    key.colorFormat = kUnityXRRenderTextureFormatRGBA32;
+    key.depthFormat = kUnityXRDepthTextureFormat24bitOrGreater;
+    key.arrayLength = layout.arrayLength;
+    key.sRGB = m_bIsUsingSRGB;
+    m_eyeTextureKey = key;
 
     // Create textures
     for (int stage = 0; stage < m_nNumStages; ++stage) {
-        for (int eye = 0; eye < nNumTextures; ++eye) {
-            UnityXRRenderTextureDesc unityDesc;
-            memset(&unityDesc, 0, sizeof(UnityXRRenderTextureDesc));
-            unityDesc.colorFormat = kUnityXRRenderTextureFormatRGBA32;
-            unityDesc.depthFormat = kUnityXRDepthTextureFormat24bitOrGreater;
-            unityDesc.color.nativePtr = (void *)kUnityXRRenderTextureIdDontCare;
-            unityDesc.depth.nativePtr = (void *)kUnityXRRenderTextureIdDontCare;
-            unityDesc.width = eyeWidth;
-            unityDesc.height = eyeHeight;
-
-            if (m_bIsUsingSRGB) {
-                unityDesc.flags |= kUnityXRRenderTextureFlagsSRGB;
-            }
-
-            if (m_renderingMode ==
-                EVRStereoRenderingModes::SinglePassInstanced) {
-                unityDesc.textureArrayLength = 2;
-            }
-
-            // Create an UnityXRRenderTextureId for the native texture so we can
-            // tell unity to render to it later.
+        for (uint32_t eye = 0; eye < layout.texturesPerStage; ++eye) {
             UnityXRRenderTextureId unityTexId;
-            UnitySubsystemErrorCode res = s_pXRDisplay->CreateTexture(
-                s_DisplayHandle, &unityDesc, &unityTexId);
+            UnitySubsystemErrorCode res = AcquireEyeTexture(key, unityTexId);
             if (res != kUnitySubsystemErrorCodeSuccess) {
-                XR_TRACE(PLUGIN_LOG_PREFIX "Error creating texture: [%i]\n",
-                         res);
                 return res;
             }
 
@@ -1377,23 +1505,209 @@ UnitySubsystemErrorCode OpenVRDisplayProvider::CreateEyeTextures(
             m_pNativeDepthTextures[stage][eye] = nullptr;
         }
     }
+    m_textureAllocator.OnAllocated(layout);
 
     m_bTexturesCreated = true;
     return kUnitySubsystemErrorCodeSuccess;
 }
 
-void OpenVRDisplayProvider::DestroyEyeTextures(UnitySubsystemHandle handle) {
+/// Get the Unity color format matching a swapchain image format.
+/// @return false if Unity can't render into that format (with the requested
+/// sRGB setting)
+static bool GetUnityColorFormat(DXGI_FORMAT format, bool sRGB,
+                                UnityXRRenderTextureFormat &unityFormat) {
+    switch (format) {
+        case DXGI_FORMAT_R8G8B8A8_TYPELESS:
+            unityFormat = kUnityXRRenderTextureFormatRGBA32;
+            return true;
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+            unityFormat = kUnityXRRenderTextureFormatRGBA32;
+            // can't create an sRGB view of a typed texture
+            return !sRGB;
+        case DXGI_FORMAT_B8G8R8A8_TYPELESS:
+            unityFormat = kUnityXRRenderTextureFormatBGRA32;
+            return true;
+        case DXGI_FORMAT_B8G8R8A8_UNORM:
+            unityFormat = kUnityXRRenderTextureFormatBGRA32;
+            return !sRGB;
+        default:
+            return false;
+    }
+}
+
+bool OpenVRDisplayProvider::CanUseZeroCopy(
+    const UnityXRFrameSetupHints *frameHints) const {
+    if (!AllowZeroCopySubmission || !renderer_ || swapchainImages_.empty() ||
+        swapchainImages_.size() > k_nMaxNumStages) {
+        return false;
+    }
+    // Dynamic resolution renders to part of the texture and scales it up
+    if (DynamicResolutionEnabled) {
+        return false;
+    }
+    // Late latching warps the eye textures into the swapchain image
+    if (LateLatchEnabled && !m_bTimewarpActive) {
+        return false;
+    }
+    // Texture arrays can't alias the side-by-side scanout surface
+    if (m_renderingMode == EVRStereoRenderingModes::SinglePassInstanced) {
+        return false;
+    }
+    // A scaled eye texture wouldn't match the scanout surface
+    if (frameHints->appSetup.textureResolutionScale != 1.0f) {
+        return false;
+    }
+    // Can't reduce the resolution to fit the budget either
+    uint32_t nDisplayWidth, nDisplayHeight;
+    GetDisplayDimensions(nDisplayHeight, nDisplayWidth);
+    EyeTextureLayout layout = m_textureAllocator.Plan(
+        m_renderingMode, nDisplayWidth, nDisplayHeight, 1.f,
+        static_cast<uint32_t>(swapchainImages_.size()), false);
+    if (layout.resolutionScale != 1.f) {
+        return false;
+    }
+    D3D11_TEXTURE2D_DESC desc;
+    swapchainImages_[0]->GetDesc(&desc);
+    UnityXRRenderTextureFormat unityFormat;
+    return GetUnityColorFormat(desc.Format, frameHints->appSetup.sRGB,
+                               unityFormat);
+}
+
+int OpenVRDisplayProvider::GetCurrentStage() const {
+    if (m_bZeroCopy) {
+        // The stage is the swapchain image we were handed by waitFrame()
+        return swapchainImageIndex_ < 0 ? 0 : swapchainImageIndex_;
+    }
+    return m_nCurFrame % m_nNumStages;
+}
+
+UnitySubsystemErrorCode OpenVRDisplayProvider::CreateZeroCopyEyeTextures(
+    const UnityXRFrameSetupHints *frameHints) {
+    const int nNumStages = static_cast<int>(swapchainImages_.size());
+    for (int stage = 0; stage < nNumStages; ++stage) {
+        D3D11_TEXTURE2D_DESC desc;
+        swapchainImages_[stage]->GetDesc(&desc);
+
+        UnityXRRenderTextureDesc unityDesc;
+        memset(&unityDesc, 0, sizeof(UnityXRRenderTextureDesc));
+        GetUnityColorFormat(desc.Format, frameHints->appSetup.sRGB,
+                            unityDesc.colorFormat);
+        unityDesc.color.nativePtr = swapchainImages_[stage].get();
+        unityDesc.depthFormat = kUnityXRDepthTextureFormat24bitOrGreater;
+        unityDesc.depth.nativePtr = (void *)kUnityXRRenderTextureIdDontCare;
+        unityDesc.width = desc.Width;
+        unityDesc.height = desc.Height;
+
+        if (m_bIsUsingSRGB) {
+            unityDesc.flags |= kUnityXRRenderTextureFlagsSRGB;
+        }
+
+        UnityXRRenderTextureId unityTexId;
+        UnitySubsystemErrorCode res = s_pXRDisplay->CreateTexture(
+            s_DisplayHandle, &unityDesc, &unityTexId);
+        if (res != kUnitySubsystemErrorCodeSuccess) {
+            XR_TRACE(PLUGIN_LOG_PREFIX
+                     "Error registering swapchain image as texture: [%i]\n",
+                     res);
+            return res;
+        }
+
+        // Both eyes render into the one side-by-side texture.
+        m_UnityTextures[stage][0] = unityTexId;
+        m_UnityTextures[stage][1] = 0;
+        m_pNativeColorTextures[stage][0] = swapchainImages_[stage].get();
+        m_pNativeColorTextures[stage][1] = nullptr;
+        m_pNativeDepthTextures[stage][0] = nullptr;
+        m_pNativeDepthTextures[stage][1] = nullptr;
+    }
+    XR_TRACE(PLUGIN_LOG_PREFIX
+             "Using zero-copy submission with %d swapchain images\n",
+             nNumStages);
+
+    // Only the depth buffers are allocated
+    uint32_t nDisplayWidth, nDisplayHeight;
+    GetDisplayDimensions(nDisplayHeight, nDisplayWidth);
+    m_textureAllocator.OnAllocated(m_textureAllocator.Plan(
+        m_renderingMode, nDisplayWidth, nDisplayHeight, 1.f,
+        static_cast<uint32_t>(nNumStages), false));
+
+    m_nNumStages = nNumStages;
+    m_bZeroCopy = true;
+    m_bTexturesCreated = true;
+    return kUnitySubsystemErrorCodeSuccess;
+}
+
+UnitySubsystemErrorCode OpenVRDisplayProvider::AcquireEyeTexture(
+    const EyeTextureKey &key, UnityXRRenderTextureId &unityTexId) {
+    if (m_texturePool.Acquire(key, unityTexId)) {
+        return kUnitySubsystemErrorCodeSuccess;
+    }
+
+    UnityXRRenderTextureDesc unityDesc;
+    memset(&unityDesc, 0, sizeof(UnityXRRenderTextureDesc));
+    unityDesc.colorFormat = key.colorFormat;
+    unityDesc.depthFormat = key.depthFormat;
+    unityDesc.color.nativePtr = (void *)kUnityXRRenderTextureIdDontCare;
+    unityDesc.depth.nativePtr = (void *)kUnityXRRenderTextureIdDontCare;
+    unityDesc.width = key.width;
+    unityDesc.height = key.height;
+
+    if (key.sRGB) {
+        unityDesc.flags |= kUnityXRRenderTextureFlagsSRGB;
+    }
+
+    if (key.arrayLength > 1) {
+        unityDesc.textureArrayLength = key.arrayLength;
+    }
+
+    // Create an UnityXRRenderTextureId for the native texture so we can
+    // tell unity to render to it later.
+    UnitySubsystemErrorCode res =
+        s_pXRDisplay->CreateTexture(s_DisplayHandle, &unityDesc, &unityTexId);
+    if (res != kUnitySubsystemErrorCodeSuccess) {
+        XR_TRACE(PLUGIN_LOG_PREFIX "Error creating texture: [%i]\n", res);
+    }
+    return res;
+}
+
+void OpenVRDisplayProvider::ReleaseEyeTextures() {
+    // Frames up to this one may still be reading them
+    const uint64_t nFenceValue =
+        renderer_ ? renderer_->getSubmittedFenceValue() : 0;
+    const uint64_t nBytes = m_textureAllocator.GetAllocated().bytesPerTexture;
     for (int i = 0; i < m_nNumStages; ++i) {
         for (int eye = 0; eye < 2; ++eye) {
             if (m_UnityTextures[i][eye] != 0) {
-                s_pXRDisplay->DestroyTexture(handle, m_UnityTextures[i][eye]);
+                if (m_bZeroCopy) {
+                    // Wraps a swapchain image: never reused
+                    m_texturePool.Retire(m_UnityTextures[i][eye], nFenceValue);
+                } else {
+                    m_texturePool.Release(m_eyeTextureKey,
+                                          m_UnityTextures[i][eye], nBytes,
+                                          nFenceValue);
+                }
+                m_UnityTextures[i][eye] = 0;
             }
+            m_EyeTextureViews[i][eye] = nullptr;
+            m_EyeDepthViews[i][eye] = nullptr;
         }
     }
+    m_textureAllocator.OnReleased();
 
     m_bTexturesCreated = false;
 }
 
+void OpenVRDisplayProvider::DestroyEyeTextures(UnitySubsystemHandle handle) {
+    ReleaseEyeTextures();
+    m_texturePool.Clear([handle](UnityXRRenderTextureId id) {
+        s_pXRDisplay->DestroyTexture(handle, id);
+    });
+}
+
+uint64_t OpenVRDisplayProvider::GetCompletedFenceValue() const {
+    return renderer_ ? renderer_->getCompletedFenceValue() : UINT64_MAX;
+}
+
 void *OpenVRDisplayProvider::GetNativeEyeTexture(int stage, int eye) {
     if (m_pNativeColorTextures[stage][eye] == nullptr) {
         UnityXRRenderTextureId unityTexId = m_UnityTextures[stage][eye];
@@ -1420,6 +1734,24 @@ void *OpenVRDisplayProvider::GetNativeEyeTexture(int stage, int eye) {
     return m_pNativeColorTextures[stage][eye];
 }
 
+void *OpenVRDisplayProvider::GetNativeEyeDepthTexture(int stage, int eye) {
+    // Not filled in by GetNativeEyeTexture() for zero-copy textures
+    if (m_pNativeDepthTextures[stage][eye] == nullptr &&
+        m_UnityTextures[stage][eye] != 0) {
+        UnityXRRenderTextureDesc unityDesc;
+        memset(&unityDesc, 0, sizeof(UnityXRRenderTextureDesc));
+
+        UnitySubsystemErrorCode res = s_pXRDisplay->QueryTextureDesc(
+            s_DisplayHandle, m_UnityTextures[stage][eye], &unityDesc);
+        if (res != kUnitySubsystemErrorCodeSuccess) {
+            XR_TRACE(PLUGIN_LOG_PREFIX "Error querying texture: [%i]\n", res);
+            return nullptr;
+        }
+        m_pNativeDepthTextures[stage][eye] = unityDesc.depth.nativePtr;
+    }
+    return m_pNativeDepthTextures[stage][eye];
+}
+
 void OpenVRDisplayProvider::ReleaseOverlayPointers() {
 #ifndef __linux__
     m_pMirrorTextureDX = nullptr;
@@ -1450,18 +1782,301 @@ void OpenVRDisplayProvider::SetupOverlayMirror() {
 
 void OpenVRDisplayProvider::GetEyeTextureDimensions(uint32_t &height,
                                                     uint32_t &width) const {
+    GetDisplayDimensions(height, width);
+    if (m_renderingMode != EVRStereoRenderingModes::SingleCamera) {
+        // side by side: half the width each
+        width /= 2;
+    }
+}
+
+void OpenVRDisplayProvider::GetDisplayDimensions(uint32_t &height,
+                                                 uint32_t &width) const {
     if (renderer_) {
         height = renderer_->getHeight();
-        width = renderer_->getWidth() / 2;
+        width = renderer_->getWidth();
     } else {
         // Hard code a good guess
         height = 1600;
-        width = 1440;
+        width = 2880;
     }
-    if (m_renderingMode == EVRStereoRenderingModes::SingleCamera) {
-        // single texture for full width
-        width *= 2;
+}
+
+ID3D11ShaderResourceView *OpenVRDisplayProvider::GetEyeTextureView(int stage,
+                                                                   int eye) {
+    if (!m_EyeTextureViews[stage][eye]) {
+        auto *texture =
+            static_cast<ID3D11Texture2D *>(GetNativeEyeTexture(stage, eye));
+        if (texture == nullptr || !blitter_) {
+            return nullptr;
+        }
+        m_EyeTextureViews[stage][eye] = blitter_->createSourceView(texture);
+    }
+    return m_EyeTextureViews[stage][eye].get();
+}
+
+ID3D11ShaderResourceView *OpenVRDisplayProvider::GetEyeDepthView(int stage,
+                                                                 int eye) {
+    if (!m_EyeDepthViews[stage][eye]) {
+        auto *texture = static_cast<ID3D11Texture2D *>(
+            GetNativeEyeDepthTexture(stage, eye));
+        if (texture == nullptr || !depthLinearizer_) {
+            return nullptr;
+        }
+        m_EyeDepthViews[stage][eye] =
+            depthLinearizer_->createSourceView(texture);
+    }
+    return m_EyeDepthViews[stage][eye].get();
+}
+
+void OpenVRDisplayProvider::WriteTimewarpDepth(
+    int stage, const metaview::BlitRect &sourceRect) {
+    if (!TimewarpPositional || !renderer_->getTimewarpEnabled()) {
+        return;
+    }
+    if (!depthLinearizer_) {
+        depthLinearizer_ = std::make_unique<metaview::DepthLinearizer>(
+            renderer_->getDevice().get());
+    }
+    auto rtv = renderer_->getTimewarpDepthRTVs()[swapchainImageIndex_];
+    auto context = renderer_->getImmediateContext();
+    uint32_t height = 0, width = 0;
+    GetEyeTextureDimensions(height, width);
+    // Without depth the compositor treats everything as far away, which
+    // amounts to orientation-only timewarp.
+    const float infinity[4] = {0.f, 0.f, 0.f, 0.f};
+    context->ClearRenderTargetView(rtv.get(), infinity);
+    auto linearizeIt = [&](int nTexIndex, int subresource, UINT dstx,
+                           UINT dstWidth, const metaview::BlitRect &rect) {
+        ID3D11ShaderResourceView *view = GetEyeDepthView(stage, nTexIndex);
+        if (view == nullptr) {
+            return;
+        }
+        D3D11_VIEWPORT viewport = {(float)dstx,   0.f, (float)dstWidth,
+                                   (float)height, 0.f, 1.f};
+        depthLinearizer_->linearize(context.get(), view, subresource,
+                                    rtv.get(), viewport, rect, m_flZNear,
+                                    m_flZFar, DepthIsReversedZ);
+    };
+    if (m_bZeroCopy) {
+        // One side-by-side texture
+        linearizeIt(0, 0, 0, 2 * width, sourceRect);
+        return;
+    }
+    switch (m_renderingMode) {
+        case EVRStereoRenderingModes::MultiPass:
+            linearizeIt(0, 0, 0, width, sourceRect);
+            linearizeIt(1, 0, width, width, sourceRect);
+            break;
+        case EVRStereoRenderingModes::SinglePassInstanced:
+            linearizeIt(0, 0, 0, width, sourceRect);
+            linearizeIt(0, 1, width, width, sourceRect);
+            break;
+        case EVRStereoRenderingModes::SingleCamera:
+            linearizeIt(0, 0, 0, 2 * width, sourceRect);
+            break;
+    }
+}
+
+void OpenVRDisplayProvider::UpdateTextureStats() {
+    const float flBytesPerMB = 1024.f * 1024.f;
+    m_stats.Set(DisplayStats::EyeTextureMemoryMB,
+                (float)m_textureAllocator.GetAllocatedBytes() / flBytesPerMB);
+    m_stats.Set(DisplayStats::EyeTextureBudgetMB,
+                (float)m_textureAllocator.GetBudget() / flBytesPerMB);
+    m_stats.Set(DisplayStats::EyeTextureCount,
+                (float)m_textureAllocator.GetAllocatedTextureCount());
+    m_stats.Set(DisplayStats::EyeTextureResolutionScale,
+                m_textureAllocator.GetAllocated().resolutionScale);
+    m_stats.Set(DisplayStats::EyeTexturePoolMemoryMB,
+                (float)m_texturePool.GetIdleBytes() / flBytesPerMB);
+}
+
+void OpenVRDisplayProvider::UpdateGpuTiming() {
+    if (!gpuProfiler_) {
+        gpuTimestamps_ = std::make_unique<metaview::D3D11TimestampSource>(
+            renderer_->getDevice().get(),
+            renderer_->getImmediateContext().get(), GpuTimingDepth,
+            NumGpuTimestamps);
+        gpuProfiler_ = std::make_unique<metaview::GpuTimingProfiler>(
+            *gpuTimestamps_, GpuTimingDepth, NumGpuTimestamps,
+            std::vector<metaview::GpuTimingScope>{
+                {GpuTimestampFrameBegin, GpuTimestampEndFrameEnd},
+                {GpuTimestampBlitBegin, GpuTimestampBlitEnd},
+                {GpuTimestampEndFrameBegin, GpuTimestampEndFrameEnd}});
+    }
+
+    gpuProfiler_->collect([this](size_t scope, double ms) {
+        if (scope == GpuTimingScopeFrame) {
+            m_gpuFrameMs.push_back(ms);
+            m_flLastGpuFrameMs = (float)ms;
+        }
+    });
+
+    metaview::RollingSummary summaries[NumGpuTimingScopes];
+    for (size_t i = 0; i < NumGpuTimingScopes; ++i) {
+        summaries[i] = gpuProfiler_->getSummary(i);
+    }
+    {
+        std::lock_guard<std::mutex> lock(GpuTimingMutex);
+        std::copy(std::begin(summaries), std::end(summaries),
+                  std::begin(GpuTimingSummaries));
+    }
+    // Stats for a scope are laid out as min, avg, p99
+    static constexpr DisplayStats::EStat firstStat[NumGpuTimingScopes] = {
+        DisplayStats::GpuFrameMinMs, DisplayStats::GpuBlitMinMs,
+        DisplayStats::GpuEndFrameMinMs};
+    for (size_t i = 0; i < NumGpuTimingScopes; ++i) {
+        const int stat = firstStat[i];
+        m_stats.Set((DisplayStats::EStat)stat, (float)summaries[i].min);
+        m_stats.Set((DisplayStats::EStat)(stat + 1), (float)summaries[i].avg);
+        m_stats.Set((DisplayStats::EStat)(stat + 2), (float)summaries[i].p99);
+    }
+    m_stats.Set(DisplayStats::GpuTimingSkippedFrames,
+                (float)gpuProfiler_->getRing().getSkippedFrames());
+
+    gpuProfiler_->beginFrame();
+    gpuProfiler_->mark(GpuTimestampFrameBegin);
+}
+
+void OpenVRDisplayProvider::UpdateFrameStats() {
+    const metaview::FrameStatistics &frameStats =
+        renderer_->getFrameStatistics();
+    const metaview::FrameTiming &frame = frameStats.getLastFrame();
+    const metaview::FrameCounters counters = frameStats.getCounters();
+    m_stats.Set(DisplayStats::DroppedFrames, (float)frame.droppedFrames);
+    m_stats.Set(DisplayStats::FramePresents, (float)counters.presents);
+    m_stats.Set(DisplayStats::CpuFrameMs, (float)frame.cpuFrameMs);
+    m_stats.Set(DisplayStats::CpuSubmitMs, (float)frame.cpuSubmitMs);
+    m_stats.Set(DisplayStats::GpuMs, m_flLastGpuFrameMs);
+    m_stats.Set(DisplayStats::VBlankWaitMs, (float)frame.vblankWaitMs);
+    m_stats.Set(DisplayStats::MissedVBlanks, (float)counters.missedVBlanks);
+
+    const metaview::FrameClassifierCounters classified =
+        renderer_->getFrameClassifier().getCounters();
+    m_stats.Set(DisplayStats::OnTimeFrames, (float)classified.onTime);
+    m_stats.Set(DisplayStats::LateFrames, (float)classified.late);
+    m_stats.Set(DisplayStats::RepeatedFrames, (float)classified.repeated);
+}
+
+int OpenVRDisplayProvider::UpdateSwapchainDepth() {
+    if (!renderer_) {
+        return m_nNumStages;
+    }
+    const uint32_t nRequested = RequestedSwapchainDepth;
+    uint32_t nDepth = nRequested;
+    if (nRequested == 0) {
+        const int64_t nPeriodNs = renderer_->getFramePacer().getPeriod();
+        nDepth = swapchainDepth_.update(
+            renderer_->getFrameStatistics().getLastFrame().cpuFrameMs,
+            m_flLastGpuFrameMs, (double)nPeriodNs / 1e6);
+    } else {
+        swapchainDepth_.reset();
+    }
+    if (nDepth != renderer_->getSurfaceCount()) {
+        XR_TRACE(PLUGIN_LOG_PREFIX "Swapchain depth %u -> %u\n",
+                 (uint32_t)renderer_->getSurfaceCount(), nDepth);
+        renderer_->setSurfaceCount(nDepth);
+    }
+    m_stats.Set(DisplayStats::SwapchainDepth,
+                (float)renderer_->getSurfaceCount());
+    return static_cast<int>(renderer_->getSurfaceCount());
+}
+
+void OpenVRDisplayProvider::UpdateFrameInterval() {
+    if (!renderer_) {
+        return;
+    }
+    const uint32_t nRequested = RequestedFrameInterval;
+    uint32_t nInterval = nRequested;
+    if (nRequested == 0) {
+        const metaview::FrameTiming &frame =
+            renderer_->getFrameStatistics().getLastFrame();
+        const int64_t nPeriodNs = renderer_->getFramePacer().getPeriod();
+        nInterval =
+            frameInterval_.update(frame.droppedFrames, frame.cpuFrameMs,
+                                  m_flLastGpuFrameMs, (double)nPeriodNs / 1e6);
+    } else {
+        frameInterval_.reset();
+    }
+    if (nInterval != renderer_->getFrameInterval()) {
+        XR_TRACE(PLUGIN_LOG_PREFIX "Frame interval %u -> %u vblanks\n",
+                 renderer_->getFrameInterval(), nInterval);
+        renderer_->setFrameInterval(nInterval);
+    }
+    m_stats.Set(DisplayStats::FrameInterval,
+                (float)renderer_->getFrameInterval());
+}
+
+void OpenVRDisplayProvider::UpdateTimewarp(
+    const UnityXRFrameSetupHints *frameHints) {
+    if (!renderer_) {
+        return;
+    }
+    m_flZNear = frameHints->appSetup.zNear;
+    m_flZFar = frameHints->appSetup.zFar;
+    renderer_->setTimewarpFov(ToEyeFov(m_CameraParams.leftFov),
+                              ToEyeFov(m_CameraParams.rightFov));
+    // Unity's eye positions (see GetEyePose()), converted to right handed
+    const UnityXRVector3 &left = m_CameraParams.leftEyePosition;
+    const UnityXRVector3 &right = m_CameraParams.rightEyePosition;
+    renderer_->setTimewarpEyeOffsets(Vec3f{left.x, -left.y, left.z},
+                                     Vec3f{right.x, -right.y, right.z});
+    // And each eye camera's roll, if the eyes are rotated: mirroring z keeps
+    // a rotation about z as it is
+    auto toEyeRotation = [](const UnityXRVector4 &q) {
+        return normalize(Quatf{-q.x, -q.y, q.z, q.w});
+    };
+    renderer_->setTimewarpEyeRotations(
+        toEyeRotation(GetEyePose(EEye::Left).rotation),
+        toEyeRotation(GetEyePose(EEye::Right).rotation));
+    renderer_->setTimewarpPositional(TimewarpPositional);
+    // Half rate relies on timewarp for the frames in between
+    const bool bEnable = TimewarpEnabled || renderer_->getFrameInterval() > 1;
+    if (bEnable != renderer_->getTimewarpEnabled()) {
+        XR_TRACE(PLUGIN_LOG_PREFIX "Timewarp %s\n",
+                 bEnable ? "enabled" : "disabled");
+        // Unity's textures may wrap the old swapchain images
+        if (m_bTexturesCreated) {
+            ReleaseEyeTextures();
+
+            m_bTexturesCreated = false;
+        }
+        renderer_->setTimewarpEnabled(bEnable);
+        swapchainImages_ = renderer_->getSwapchainImages();
+        rtvs_ = renderer_->getSwapchainRTVs();
+    }
+    m_bTimewarpActive = bEnable;
+    const TimewarpCompositor *pCompositor = renderer_->getTimewarpCompositor();
+    m_stats.Set(DisplayStats::ReprojectedFrames,
+                pCompositor ? (float)pCompositor->getReprojectedCount() : 0.f);
+}
+
+void OpenVRDisplayProvider::UpdateDynamicResolution() {
+    if (!DynamicResolutionEnabled) {
+        m_gpuFrameMs.clear();
+        dynamicResolution_.reset();
+        m_flFrameRenderScale = 1.0f;
+        m_stats.Set(DisplayStats::DynamicResolutionScale, 1.0f);
+        return;
+    }
+
+    metaview::DynamicResolutionConfig config = dynamicResolution_.getConfig();
+    config.targetFraction = DynamicResolutionTargetFraction;
+    config.minScale = DynamicResolutionMinScale;
+    dynamicResolution_.setConfig(config);
+    const int64_t nPeriodNs = renderer_->getFramePacer().getPeriod();
+    if (nPeriodNs > 0) {
+        dynamicResolution_.setFrameBudget((double)nPeriodNs / 1e6);
+    }
+
+    for (double flGpuMs : m_gpuFrameMs) {
+        dynamicResolution_.update(flGpuMs);
     }
+    m_gpuFrameMs.clear();
+    m_flFrameRenderScale = (float)dynamicResolution_.getScale();
+    m_stats.Set(DisplayStats::DynamicResolutionScale, m_flFrameRenderScale);
+    m_stats.Set(DisplayStats::DynamicResolutionGpuMs,
+                (float)dynamicResolution_.getSmoothedGpuMs());
 }
 
 bool RegisterDisplayLifecycleProvider(
@@ -1500,23 +2115,101 @@ bool RegisterDisplayLifecycleProvider(
 //Han Custom Code
 extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API
 SetParamsForSinglePassInstancedCameraDisplayCPP(float IPD) {
-    SinglePassInstancedCamIPD = IPD;
+    CameraParamBlock::Get().Update(
+        [&](CameraParams &params) { params.ipd = IPD; });
 }
 
 extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API
 SetParamsForSinglePassInstancedCameraPos(float leftEyeX, float rightEyeX,
     float leftEyeY, float rightEyeY,
     float leftEyeZ, float rightEyeZ) {
-    LeftEyeX = leftEyeX;
-    RightEyeX = rightEyeX;
-    LeftEyeY = leftEyeY;
-    RightEyeY = rightEyeY;
-    LeftEyeZ = leftEyeZ;
-    RightEyeZ = rightEyeZ;
+    CameraParamBlock::Get().Update([&](CameraParams &params) {
+        params.leftEyePosition = {leftEyeX, leftEyeY, leftEyeZ};
+        params.rightEyePosition = {rightEyeX, rightEyeY, rightEyeZ};
+    });
 }
 
 extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API
 SetParamsForSinglePassInstancedCameraFOV(float widthHalfAngle, float heightHalfAngle) {
-    LeftFovRuntime = {-widthHalfAngle, widthHalfAngle, heightHalfAngle, -heightHalfAngle};
-    RightFovRuntime = {-widthHalfAngle, widthHalfAngle, heightHalfAngle, -heightHalfAngle};
+    CameraParamBlock::Get().Update([&](CameraParams &params) {
+        params.leftFov = {-widthHalfAngle, widthHalfAngle, heightHalfAngle,
+                          -heightHalfAngle};
+        params.rightFov = params.leftFov;
+    });
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API
+SetFramePacingRunningStart(float milliseconds) {
+    FramePacingRunningStartNs =
+        static_cast<int64_t>(std::max(milliseconds, 0.f) * 1'000'000);
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API
+SetUsePresentThread(uint16_t enable) {
+    UsePresentThread = enable != 0;
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API
+SetAllowZeroCopySubmission(uint16_t allow) {
+    AllowZeroCopySubmission = allow != 0;
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API
+SetEyeTextureBudget(float megabytes) {
+    EyeTextureBudgetBytes =
+        static_cast<uint64_t>(std::max(megabytes, 0.f) * 1024 * 1024);
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API
+SetEyeTexturePoolCapacity(float megabytes) {
+    EyeTexturePoolCapacityBytes =
+        static_cast<uint64_t>(std::max(megabytes, 0.f) * 1024 * 1024);
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API
+SetDynamicResolution(uint16_t enable, float targetFraction, float minScale) {
+    DynamicResolutionEnabled = enable != 0;
+    DynamicResolutionTargetFraction =
+        std::min(std::max(targetFraction, 0.1f), 1.f);
+    DynamicResolutionMinScale = std::min(std::max(minScale, 0.1f), 1.f);
+}
+
+extern "C" uint16_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API
+GetGpuTimingStats(uint32_t scope, float *minMs, float *avgMs, float *p99Ms) {
+    if (scope >= NumGpuTimingScopes || minMs == nullptr ||
+        avgMs == nullptr || p99Ms == nullptr) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(GpuTimingMutex);
+    metaview::RollingSummary const &summary = GpuTimingSummaries[scope];
+    *minMs = (float)summary.min;
+    *avgMs = (float)summary.avg;
+    *p99Ms = (float)summary.p99;
+    return summary.count > 0 ? 1 : 0;
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API
+SetSwapchainDepth(uint32_t depth) {
+    RequestedSwapchainDepth =
+        depth == 0 ? 0 : std::min(std::max(depth, 2u), 3u);
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API
+SetTimewarpEnabled(uint16_t enable) {
+    TimewarpEnabled = enable != 0;
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API
+SetTimewarpPositional(uint16_t enable) {
+    TimewarpPositional = enable != 0;
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API
+SetLateLatchEnabled(uint16_t enable) {
+    LateLatchEnabled = enable != 0;
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API
+SetFrameInterval(uint32_t vblanks) {
+    RequestedFrameInterval = std::min(vblanks, 2u);
 }
@@ -10,10 +10,22 @@
 
 #pragma once
 
+#include <atomic>
 #include <limits>
 #include <vector>
 
+#include "CameraParams.h"
+#include "DisplayStats.h"
+#include "EyeTextureAllocator.h"
+#include "EyeTexturePool.h"
+#include "Model/Blitter.h"
+#include "Model/DepthLinearizer.h"
+#include "Model/DynamicResolution.h"
+#include "Model/FrameIntervalController.h"
+#include "Model/D3D11TimestampSource.h"
+#include "Model/GpuTimingProfiler.h"
 #include "Model/RenderParam.h"
+#include "Model/SwapchainDepthController.h"
 #include "Model/Renderer.h"
 #include "Shared.h"
 #include "UserProjectSettings.h"
@@ -123,12 +135,18 @@ class OpenVRDisplayProvider {
                          const UnityXRFrameSetupHints *pFrameHints,
                          UnityXRNextFrameDesc *pTargetFrame);
 
-    /// Set the occlusion mesh (hidden area mesh) for a given eye
+    /// Build the occlusion mesh (hidden area mesh) for a given eye from the
+    /// frame's FOV and lens contour, and hand it to Unity, reusing the eye's
+    /// current mesh if it has one
     /// @param[in] eEye - Target eye for the occlusion mesh
-    /// @return bool - If we got an occlusion mesh properly setup for the target
-    /// eye
+    /// @return UnityXROcclusionMeshId - The eye's mesh, or
+    /// k_nInvalidUnityXROcclusionMeshId if none is needed or it failed
     UnityXROcclusionMeshId SetupOcclusionMesh(EEye eEye);
 
+    /// Rebuild the occlusion meshes if the FOV or lens contour changed since
+    /// they were last built
+    void UpdateOcclusionMeshes();
+
     /// Get the distance squared between two Vectors
     /// @param[in] pVector1 - The origin vector
     /// @param[in] pVector2 - The target vector
@@ -145,6 +163,10 @@ class OpenVRDisplayProvider {
     /// @return UnityXRPose - Position and Rotation (quaternion)
     UnityXRPose GetEyePose(EEye eye);
 
+    /// Get the distance between the eyes in x, from the frame's camera
+    /// parameters
+    float GetEyeSeparation() const;
+
     /// Helper function to calculate the projection matrix for a given eye
     /// @param[in] eye - 0:Left, 1:Right
     /// @param[in] flNear - the near projection value (clipping area) of
@@ -154,6 +176,32 @@ class OpenVRDisplayProvider {
     /// @return UnityXRProjection
     UnityXRProjection GetProjection(EEye eye, float flNear, float flFar);
 
+    /// Projection and culling parameters for one eye, kept between frames
+    struct CachedEyeProjection {
+        /// Whether these were computed yet
+        bool bValid = false;
+        /// CameraParams version these were computed with
+        uint32_t version = 0;
+        /// The near and far values Unity asked for, before clamping
+        float zNear = 0.f;
+        float zFar = 0.f;
+        EVRStereoRenderingModes renderingMode{
+            EVRStereoRenderingModes::MultiPass};
+        UnityXRProjection projection = {};
+        /// How far the culling pose is pulled back behind the eye pose
+        float cullingEyePullback = 0.f;
+    };
+
+    /// Get the projection and culling parameters for a given eye, only
+    /// recomputing them when the frame's camera parameters, the near/far
+    /// values or the rendering mode changed
+    /// @param[in] eye - 0:Left, 1:Right, 2:Center
+    /// @param[in] flNear - the near value Unity asked for
+    /// @param[in] flFar - the far value Unity asked for
+    /// @return CachedEyeProjection - valid until the next call for this eye
+    const CachedEyeProjection &GetCachedProjection(EEye eye, float flNear,
+                                                   float flFar);
+
     /// Setup the culling pass for this application
     /// @param[in][return] UnityXRNextFrameDesc::UnityXRCullingPass& cullingPass
     void SetupCullingPass(
@@ -167,11 +215,42 @@ class OpenVRDisplayProvider {
     UnitySubsystemErrorCode CreateEyeTextures(
         const UnityXRFrameSetupHints *frameHints);
 
-    /// Destroy the textures Unity uses to submit to the compositor
+    /// Register the renderer's swapchain images as Unity eye textures, one per
+    /// stage, so Unity renders straight into the scanout surfaces.
+    /// @param[in] const UnityXRFrameSetupHints* frameHint - Details about the
+    /// frame
+    /// @return UnitySubsystemErrorCode
+    UnitySubsystemErrorCode CreateZeroCopyEyeTextures(
+        const UnityXRFrameSetupHints *frameHints);
+
+    /// Whether the current configuration allows Unity to render straight
+    /// into the swapchain images
+    bool CanUseZeroCopy(const UnityXRFrameSetupHints *frameHints) const;
+
+    /// Get the stage (index into m_UnityTextures) for the frame being set up
+    int GetCurrentStage() const;
+
+    /// Destroy the textures Unity uses to submit to the compositor, and any
+    /// pooled ones, right away
     /// @param[in] UnitySubsystemHandle handle - The handle for this display
     /// provider
     void DestroyEyeTextures(UnitySubsystemHandle handle);
 
+    /// Stop using the current eye textures, handing them to the pool for
+    /// reuse or deferred destruction
+    void ReleaseEyeTextures();
+
+    /// Get a texture for the given properties, from the pool if possible
+    /// @param[in] key - Texture properties
+    /// @param[out] unityTexId - The texture
+    /// @return UnitySubsystemErrorCode
+    UnitySubsystemErrorCode AcquireEyeTexture(
+        const EyeTextureKey &key, UnityXRRenderTextureId &unityTexId);
+
+    /// Get the fence value the GPU has reached, or UINT64_MAX if the renderer
+    /// isn't up
+    uint64_t GetCompletedFenceValue() const;
+
     /// Destroy the textures Unity uses to submit to the compositor
     /// @param[in] int stage - The stage of the render pass
     /// @param[in] int eye - 0:Left, 1:Right
@@ -179,6 +258,10 @@ class OpenVRDisplayProvider {
     /// compositor
     void *GetNativeEyeTexture(int stage, int eye);
 
+    /// Get the depth texture Unity renders with alongside an eye texture,
+    /// or nullptr if there is none
+    void *GetNativeEyeDepthTexture(int stage, int eye);
+
     void ReleaseOverlayPointers();
 
     bool HasOverlayPointer();
@@ -191,6 +274,47 @@ class OpenVRDisplayProvider {
     /// Get eye texture dimensions, estimated if the render is not yet up.
     void GetEyeTextureDimensions(uint32_t &height, uint32_t &width) const;
 
+    /// Get the dimensions of the whole (side by side) display, estimated if
+    /// the render is not yet up.
+    void GetDisplayDimensions(uint32_t &height, uint32_t &width) const;
+
+    /// Get a shader resource view of an eye texture, for scaled copies
+    ID3D11ShaderResourceView *GetEyeTextureView(int stage, int eye);
+
+    /// Get a shader resource view of an eye depth texture, or nullptr if it
+    /// can't be read
+    ID3D11ShaderResourceView *GetEyeDepthView(int stage, int eye);
+
+    /// Hand this frame's depth to positional timewarp, if enabled
+    /// @param[in] sourceRect The part of each eye texture Unity rendered to
+    void WriteTimewarpDepth(int stage, const metaview::BlitRect &sourceRect);
+
+    /// Publish the eye texture accounting to the XR stats
+    void UpdateTextureStats();
+
+    /// Read back finished GPU timings, publish them and start timing this
+    /// frame
+    void UpdateGpuTiming();
+
+    /// Apply the requested swapchain depth, or pick one in adaptive mode.
+    /// @return the depth in use
+    int UpdateSwapchainDepth();
+
+    /// Apply the requested frame interval, or pick one in automatic mode
+    void UpdateFrameInterval();
+
+    /// Turn timewarp on or off as requested (or when running at half rate),
+    /// and keep its field of view and eye offsets up to date. Releases the
+    /// eye textures when the swapchain images change.
+    void UpdateTimewarp(const UnityXRFrameSetupHints *frameHints);
+
+    /// Publish the renderer's timing of the last frame to the XR stats
+    void UpdateFrameStats();
+
+    /// Feed finished GPU frame times to the dynamic resolution controller
+    /// and pick the render scale for this frame
+    void UpdateDynamicResolution();
+
     /// The occlusion mesh (hidden area mesh) handle for the left eye. 0 if
     /// none.
     UnityXROcclusionMeshId m_pOcclusionMeshLeftEye = 0;
@@ -199,6 +323,14 @@ class OpenVRDisplayProvider {
     /// none.
     UnityXROcclusionMeshId m_pOcclusionMeshRightEye = 0;
 
+    /// Whether the occlusion meshes were built yet, and the camera parameters
+    /// they were built with
+    bool m_bOcclusionMeshesBuilt = false;
+    CameraParams m_OcclusionMeshParams = CameraParams::Defaults();
+
+    /// Scratch space for building occlusion meshes
+    metaview::OcclusionMesh m_OcclusionMesh;
+
     /// The active render device (e.g. an ID3D11Device if using DirectX)
     void *m_pRenderDevice;
 
@@ -263,6 +395,10 @@ class OpenVRDisplayProvider {
     /// (triggers CreateEyeTextures if not)
     bool m_bTexturesCreated = false;
 
+    /// Whether the eye textures are the renderer's swapchain images, so no
+    /// copy is needed at submit time
+    bool m_bZeroCopy = false;
+
     /// Whether the application is using single pass or multi pass (can be
     /// changed in runtime)
     bool m_bUseSinglePass = false;
@@ -272,14 +408,23 @@ class OpenVRDisplayProvider {
 
     EVRStereoRenderingModes m_renderingMode{EVRStereoRenderingModes::MultiPass};
 
+    /// The camera parameters latched for the frame being set up, see
+    /// CameraParamBlock
+    CameraParams m_CameraParams = CameraParams::Defaults();
+
+    /// Projection and culling parameters per eye (EEye), see
+    /// GetCachedProjection
+    CachedEyeProjection m_CachedProjections[3];
+
     /// The current frame number, will revert to 0 at UINT32MAX
     uint32_t m_nCurFrame = 0;
 
     /// The current number of attempts to make to attain a preview window
     uint32_t m_nOpenVRMirrorAttempts = 0;
 
-    /// Maximum number of stages per render pass
-    static const int k_nMaxNumStages = 3;
+    /// Maximum number of stages per render pass: up to three swapchain
+    /// surfaces, plus the spare eye buffer the renderer keeps for timewarp
+    static const int k_nMaxNumStages = 4;
 
     /// The default number of stage per render pass
     int m_nNumStages = 2;
@@ -307,7 +452,55 @@ class OpenVRDisplayProvider {
     /// Single Pass only uses left with texture array size of 2)
     UnityXRRenderTextureId m_UnityTextures[k_nMaxNumStages][2];
 
+    /// Shader resource views of m_pNativeColorTextures, for scaled copies
+    winrt::com_ptr<ID3D11ShaderResourceView>
+        m_EyeTextureViews[k_nMaxNumStages][2];
+
+    /// Shader resource views of m_pNativeDepthTextures, for timewarp
+    winrt::com_ptr<ID3D11ShaderResourceView>
+        m_EyeDepthViews[k_nMaxNumStages][2];
+
+    /// Sizes the eye textures and keeps track of their memory
+    EyeTextureAllocator m_textureAllocator;
+
+    /// Properties of the current eye textures
+    EyeTextureKey m_eyeTextureKey;
+
+    /// Recycles eye textures, and defers their destruction until the GPU is
+    /// done with them
+    EyeTexturePool m_texturePool;
+
+    /// Our XR stats
+    DisplayStats m_stats;
+
     std::unique_ptr<metaview::Renderer> renderer_;
+    /// For copying eye textures that don't match the display size
+    std::unique_ptr<metaview::Blitter> blitter_;
+    /// For handing eye depth to positional timewarp
+    std::unique_ptr<metaview::DepthLinearizer> depthLinearizer_;
+    /// Clip planes Unity renders the current frame with
+    float m_flZNear = 0.1f;
+    float m_flZFar = 1000.f;
+    /// GPU timestamp queries backing gpuProfiler_
+    std::unique_ptr<metaview::D3D11TimestampSource> gpuTimestamps_;
+    /// Times each frame, its blit and its present on the GPU
+    std::unique_ptr<metaview::GpuTimingProfiler> gpuProfiler_;
+    /// GPU frame times read back this frame, not yet seen by dynamic
+    /// resolution
+    std::vector<double> m_gpuFrameMs;
+    /// Most recent GPU frame time read back, in ms
+    float m_flLastGpuFrameMs = 0.f;
+    /// Picks the swapchain depth from CPU and GPU load, in adaptive mode
+    metaview::SwapchainDepthController swapchainDepth_;
+    /// Picks full or half rate from dropped frames, in automatic mode
+    metaview::FrameIntervalController frameInterval_;
+    /// Whether the renderer is reprojecting: requested, or needed to fill in
+    /// at half rate. Read from the main thread.
+    std::atomic_bool m_bTimewarpActive{false};
+    /// Picks the render scale from GPU frame time
+    metaview::DynamicResolutionController dynamicResolution_;
+    /// Fraction of each eye texture's width and height rendered this frame
+    float m_flFrameRenderScale = 1.f;
     std::vector<winrt::com_ptr<ID3D11Texture2D>> swapchainImages_;
     std::vector<winrt::com_ptr<ID3D11RenderTargetView>> rtvs_;
     int swapchainImageIndex_ = -1;
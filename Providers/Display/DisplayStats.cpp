@@ -0,0 +1,73 @@
+// Copyright (c) 2020, Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#include "DisplayStats.h"
+
+/// Stat tags, indexed by DisplayStats::EStat
+static const char *const s_StatTags[DisplayStats::NumStats] = {
+    "MetaView.DroppedFrames",
+    "MetaView.FramePresents",
+    "MetaView.CpuFrameMs",
+    "MetaView.CpuSubmitMs",
+    "MetaView.GpuMs",
+    "MetaView.VBlankWaitMs",
+    "MetaView.MissedVBlanks",
+    "MetaView.OnTimeFrames",
+    "MetaView.LateFrames",
+    "MetaView.RepeatedFrames",
+    "MetaView.SwapchainDepth",
+    "MetaView.EyeTextureMemoryMB",
+    "MetaView.EyeTextureBudgetMB",
+    "MetaView.EyeTextureCount",
+    "MetaView.EyeTextureResolutionScale",
+    "MetaView.EyeTexturePoolMemoryMB",
+    "MetaView.DynamicResolutionScale",
+    "MetaView.DynamicResolutionGpuMs",
+    "MetaView.GpuFrameMinMs",
+    "MetaView.GpuFrameAvgMs",
+    "MetaView.GpuFrameP99Ms",
+    "MetaView.GpuBlitMinMs",
+    "MetaView.GpuBlitAvgMs",
+    "MetaView.GpuBlitP99Ms",
+    "MetaView.GpuEndFrameMinMs",
+    "MetaView.GpuEndFrameAvgMs",
+    "MetaView.GpuEndFrameP99Ms",
+    "MetaView.GpuTimingSkippedFrames",
+    "MetaView.ReprojectedFrames",
+    "MetaView.FrameInterval",
+};
+
+void DisplayStats::Register(IUnityXRStats *pStats,
+                            UnitySubsystemHandle handle) {
+    if (pStats == nullptr || m_pStats != nullptr) {
+        return;
+    }
+    if (pStats->RegisterStatSource(handle) !=
+        kUnitySubsystemErrorCodeSuccess) {
+        return;
+    }
+    for (int i = 0; i < NumStats; ++i) {
+        m_ids[i] = pStats->RegisterStatDefinition(handle, s_StatTags[i],
+                                                  kUnityXRStatOptionNone);
+    }
+    m_handle = handle;
+    m_pStats = pStats;
+}
+
+void DisplayStats::Unregister() {
+    if (m_pStats == nullptr) {
+        return;
+    }
+    m_pStats->UnregisterStatSource(m_handle);
+    m_pStats = nullptr;
+    m_handle = nullptr;
+}
+
+void DisplayStats::Set(EStat eStat, float flValue) {
+    if (m_pStats == nullptr || m_ids[eStat] == kUnityInvalidXRStatId) {
+        return;
+    }
+    m_pStats->SetStatFloat(m_ids[eStat], flValue);
+}
@@ -0,0 +1,101 @@
+// Copyright (c) 2020, Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include "ProviderInterface/IUnityXRStats.h"
+
+/// Publishes display provider statistics through Unity's XR stats interface.
+///
+/// Stat definitions are registered once, so setting a value is just an id
+/// lookup.
+///
+/// Registration happens on the main thread (Lifecycle_Start/Stop); values may
+/// be set from any thread.
+class DisplayStats {
+  public:
+    /// The stats we publish
+    enum EStat {
+        /// Extra vblanks the previous frame was scanned out for
+        DroppedFrames,
+        /// Scanouts scheduled since the renderer started
+        FramePresents,
+        /// CPU time from the end of the frame wait to submission, in ms
+        CpuFrameMs,
+        /// CPU time spent submitting the frame, in ms
+        CpuSubmitMs,
+        /// GPU time of the most recent frame measured, in ms
+        GpuMs,
+        /// CPU time spent waiting for the next frame to start, in ms
+        VBlankWaitMs,
+        /// Frames submitted after the vblank they were aimed at, since the
+        /// renderer started
+        MissedVBlanks,
+        /// Frames shown on the vblank they were aimed at, since the renderer
+        /// started
+        OnTimeFrames,
+        /// Frames shown after the vblank they were aimed at
+        LateFrames,
+        /// Frames shown on time but for more than one refresh
+        RepeatedFrames,
+        /// Number of scanout surfaces cycled through
+        SwapchainDepth,
+        /// Estimated video memory used by eye textures, in MB
+        EyeTextureMemoryMB,
+        /// Video memory budget for eye textures, in MB (0 if unlimited)
+        EyeTextureBudgetMB,
+        /// Number of eye textures allocated
+        EyeTextureCount,
+        /// Eye texture resolution scale after applying the budget
+        EyeTextureResolutionScale,
+        /// Estimated video memory held by idle pooled eye textures, in MB
+        EyeTexturePoolMemoryMB,
+        /// Render scale picked by dynamic resolution (1 if disabled)
+        DynamicResolutionScale,
+        /// Smoothed GPU frame time seen by dynamic resolution, in ms
+        DynamicResolutionGpuMs,
+        /// GPU time from frame setup to present over recent frames (min,
+        /// average, 99th percentile), in ms
+        GpuFrameMinMs,
+        GpuFrameAvgMs,
+        GpuFrameP99Ms,
+        /// GPU time copying eye textures to the scanout surface, in ms
+        GpuBlitMinMs,
+        GpuBlitAvgMs,
+        GpuBlitP99Ms,
+        /// GPU time presenting, in ms
+        GpuEndFrameMinMs,
+        GpuEndFrameAvgMs,
+        GpuEndFrameP99Ms,
+        /// Frames not GPU timed because every query was still in flight
+        GpuTimingSkippedFrames,
+        /// Scanouts where timewarp re-showed an app frame already shown,
+        /// since timewarp was enabled
+        ReprojectedFrames,
+        /// Vblanks each app frame is aimed to last: 1 at full rate, 2 at
+        /// half rate
+        FrameInterval,
+
+        NumStats
+    };
+
+    /// Register our stats for a display subsystem. No-op if stats aren't
+    /// available.
+    void Register(IUnityXRStats *pStats, UnitySubsystemHandle handle);
+
+    /// Unregister our stats, if registered.
+    void Unregister();
+
+    /// Whether stats are registered
+    bool IsRegistered() const { return m_pStats != nullptr; }
+
+    /// Set the value of a stat for this frame. No-op if not registered.
+    void Set(EStat eStat, float flValue);
+
+  private:
+    IUnityXRStats *m_pStats = nullptr;
+    UnitySubsystemHandle m_handle = nullptr;
+    UnityXRStatId m_ids[NumStats] = {};
+};
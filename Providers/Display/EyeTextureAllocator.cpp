@@ -0,0 +1,84 @@
+// Copyright (c) 2020, Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#include "EyeTextureAllocator.h"
+
+#include <algorithm>
+#include <cmath>
+
+EyeTextureLayout EyeTextureAllocator::Plan(EVRStereoRenderingModes eMode,
+                                           uint32_t nDisplayWidth,
+                                           uint32_t nDisplayHeight,
+                                           float flRequestedScale,
+                                           uint32_t nNumStages,
+                                           bool bAllocateColor) const {
+    EyeTextureLayout layout;
+    layout.numStages = nNumStages;
+    float flScale = flRequestedScale > 0.f ? flRequestedScale : 1.f;
+    ComputeLayout(eMode, nDisplayWidth, nDisplayHeight, flScale,
+                  bAllocateColor, layout);
+
+    if (m_nBudgetBytes == 0 || layout.totalBytes <= m_nBudgetBytes) {
+        return layout;
+    }
+
+    // Cost is proportional to the square of the scale.
+    flScale *= std::sqrt(static_cast<double>(m_nBudgetBytes) /
+                         static_cast<double>(layout.totalBytes));
+    flScale = std::max(flScale, k_flMinResolutionScale);
+    ComputeLayout(eMode, nDisplayWidth, nDisplayHeight, flScale,
+                  bAllocateColor, layout);
+
+    // Rounding can leave us slightly over, so step down until we fit.
+    while (layout.totalBytes > m_nBudgetBytes &&
+           flScale > k_flMinResolutionScale) {
+        flScale = std::max(flScale * 0.99f, k_flMinResolutionScale);
+        ComputeLayout(eMode, nDisplayWidth, nDisplayHeight, flScale,
+                      bAllocateColor, layout);
+    }
+    return layout;
+}
+
+void EyeTextureAllocator::ComputeLayout(EVRStereoRenderingModes eMode,
+                                        uint32_t nDisplayWidth,
+                                        uint32_t nDisplayHeight, float flScale,
+                                        bool bAllocateColor,
+                                        EyeTextureLayout &layout) const {
+    // Unscaled size of a single texture
+    uint32_t nWidth = nDisplayWidth / 2;
+    uint32_t nHeight = nDisplayHeight;
+    switch (eMode) {
+        case EVRStereoRenderingModes::MultiPass:
+            // One texture per eye
+            layout.texturesPerStage = 2;
+            layout.arrayLength = 1;
+            break;
+        case EVRStereoRenderingModes::SinglePassInstanced:
+            // One texture array, one slice per eye
+            layout.texturesPerStage = 1;
+            layout.arrayLength = 2;
+            break;
+        case EVRStereoRenderingModes::SingleCamera:
+            // One texture for the whole display
+            layout.texturesPerStage = 1;
+            layout.arrayLength = 1;
+            nWidth = nDisplayWidth;
+            break;
+    }
+
+    layout.resolutionScale = flScale;
+    layout.width = std::max<uint32_t>(
+        1, static_cast<uint32_t>(static_cast<float>(nWidth) * flScale));
+    layout.height = std::max<uint32_t>(
+        1, static_cast<uint32_t>(static_cast<float>(nHeight) * flScale));
+
+    const uint64_t nBytesPerPixel =
+        k_nDepthBytesPerPixel + (bAllocateColor ? k_nColorBytesPerPixel : 0);
+    layout.bytesPerTexture = static_cast<uint64_t>(layout.width) *
+                             layout.height * layout.arrayLength *
+                             nBytesPerPixel;
+    layout.totalBytes = layout.bytesPerTexture * layout.texturesPerStage *
+                        layout.numStages;
+}
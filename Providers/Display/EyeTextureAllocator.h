@@ -0,0 +1,101 @@
+// Copyright (c) 2020, Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include <cstdint>
+
+#include "UserProjectSettings.h"
+
+/// Layout of the eye textures for one configuration, and what it costs.
+struct EyeTextureLayout {
+    /// Size of each texture, in pixels
+    uint32_t width = 0;
+    uint32_t height = 0;
+
+    /// Texture array length (2 for single pass instanced, otherwise 1)
+    uint32_t arrayLength = 1;
+
+    /// Number of textures per stage (2 for multi-pass, otherwise 1)
+    uint32_t texturesPerStage = 0;
+
+    /// Number of stages (frames in flight)
+    uint32_t numStages = 0;
+
+    /// Resolution scale actually used, after applying the budget
+    float resolutionScale = 1.f;
+
+    /// Estimated video memory for a single texture, color and depth
+    uint64_t bytesPerTexture = 0;
+
+    /// Estimated video memory for all the eye textures
+    uint64_t totalBytes = 0;
+};
+
+/// Computes exact eye texture dimensions for each stereo rendering mode,
+/// enforces a video memory budget by lowering the resolution scale, and keeps
+/// track of what is currently allocated.
+///
+/// Pure bookkeeping: the textures themselves are created by the display
+/// provider.
+class EyeTextureAllocator {
+  public:
+    /// Bytes per pixel of the color buffer (RGBA32/BGRA32)
+    static const uint32_t k_nColorBytesPerPixel = 4;
+
+    /// Bytes per pixel of the depth buffer (24 bit or greater: assume 32)
+    static const uint32_t k_nDepthBytesPerPixel = 4;
+
+    /// The budget will never push the resolution scale below this
+    static constexpr float k_flMinResolutionScale = 0.25f;
+
+    /// Set the video memory budget for eye textures
+    /// @param[in] nBytes - Budget in bytes, 0 for unlimited
+    void SetBudget(uint64_t nBytes) { m_nBudgetBytes = nBytes; }
+
+    /// Get the video memory budget for eye textures, 0 if unlimited
+    uint64_t GetBudget() const { return m_nBudgetBytes; }
+
+    /// Work out the eye texture layout for a configuration
+    /// @param[in] eMode - Stereo rendering mode
+    /// @param[in] nDisplayWidth - Width of the whole (side by side) display
+    /// @param[in] nDisplayHeight - Height of the display
+    /// @param[in] flRequestedScale - Resolution scale requested by the app
+    /// @param[in] nNumStages - Number of stages (frames in flight)
+    /// @param[in] bAllocateColor - Whether color buffers are allocated for
+    /// the textures (false if they alias existing surfaces)
+    /// @return EyeTextureLayout - The layout, with the scale reduced if
+    /// needed to fit in the budget
+    EyeTextureLayout Plan(EVRStereoRenderingModes eMode,
+                          uint32_t nDisplayWidth, uint32_t nDisplayHeight,
+                          float flRequestedScale, uint32_t nNumStages,
+                          bool bAllocateColor = true) const;
+
+    /// Record that the textures for a layout were created
+    void OnAllocated(const EyeTextureLayout &layout) { m_allocated = layout; }
+
+    /// Record that all eye textures were destroyed
+    void OnReleased() { m_allocated = EyeTextureLayout{}; }
+
+    /// Get the layout of the currently allocated textures
+    const EyeTextureLayout &GetAllocated() const { return m_allocated; }
+
+    /// Get the estimated video memory currently used by eye textures
+    uint64_t GetAllocatedBytes() const { return m_allocated.totalBytes; }
+
+    /// Get the number of eye textures currently allocated
+    uint32_t GetAllocatedTextureCount() const {
+        return m_allocated.texturesPerStage * m_allocated.numStages;
+    }
+
+  private:
+    /// Fill in the size and cost of a layout for a given scale
+    void ComputeLayout(EVRStereoRenderingModes eMode, uint32_t nDisplayWidth,
+                       uint32_t nDisplayHeight, float flScale,
+                       bool bAllocateColor, EyeTextureLayout &layout) const;
+
+    uint64_t m_nBudgetBytes = 0;
+    EyeTextureLayout m_allocated;
+};
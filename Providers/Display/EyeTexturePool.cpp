@@ -0,0 +1,77 @@
+// Copyright (c) 2020, Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#include "EyeTexturePool.h"
+
+#include <algorithm>
+
+bool EyeTexturePool::Acquire(const EyeTextureKey &key,
+                             UnityXRRenderTextureId &id) {
+    // Prefer the most recently released match
+    auto best = m_idle.end();
+    for (auto it = m_idle.begin(); it != m_idle.end(); ++it) {
+        if (it->key == key &&
+            (best == m_idle.end() || it->nLastUsed > best->nLastUsed)) {
+            best = it;
+        }
+    }
+    if (best == m_idle.end()) {
+        return false;
+    }
+    // Safe to reuse right away: the GPU processes our work in order.
+    id = best->id;
+    m_nIdleBytes -= best->nBytes;
+    m_idle.erase(best);
+    return true;
+}
+
+void EyeTexturePool::Release(const EyeTextureKey &key,
+                             UnityXRRenderTextureId id, uint64_t nBytes,
+                             uint64_t nFenceValue) {
+    m_idle.push_back(
+        IdleTexture{key, id, nBytes, nFenceValue, ++m_nUseCounter});
+    m_nIdleBytes += nBytes;
+}
+
+void EyeTexturePool::Retire(UnityXRRenderTextureId id, uint64_t nFenceValue) {
+    m_retired.push_back(RetiredTexture{id, nFenceValue});
+}
+
+void EyeTexturePool::Collect(uint64_t nCompletedFenceValue,
+                             const DestroyFunc &destroy) {
+    // Evict least recently used idle textures until under the cap
+    while (m_nIdleBytes > m_nCapacityBytes && !m_idle.empty()) {
+        auto lru = std::min_element(m_idle.begin(), m_idle.end(),
+                                    [](const IdleTexture &a,
+                                       const IdleTexture &b) {
+                                        return a.nLastUsed < b.nLastUsed;
+                                    });
+        Retire(lru->id, lru->nFenceValue);
+        m_nIdleBytes -= lru->nBytes;
+        m_idle.erase(lru);
+    }
+
+    // Destroy what the GPU is done with
+    auto done = std::partition(
+        m_retired.begin(), m_retired.end(), [&](const RetiredTexture &tex) {
+            return tex.nFenceValue > nCompletedFenceValue;
+        });
+    for (auto it = done; it != m_retired.end(); ++it) {
+        destroy(it->id);
+    }
+    m_retired.erase(done, m_retired.end());
+}
+
+void EyeTexturePool::Clear(const DestroyFunc &destroy) {
+    for (const auto &tex : m_idle) {
+        destroy(tex.id);
+    }
+    for (const auto &tex : m_retired) {
+        destroy(tex.id);
+    }
+    m_idle.clear();
+    m_retired.clear();
+    m_nIdleBytes = 0;
+}
@@ -0,0 +1,113 @@
+// Copyright (c) 2020, Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "ProviderInterface/IUnityXRDisplay.h"
+
+/// Everything that must match for an eye texture to be reused
+struct EyeTextureKey {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    UnityXRRenderTextureFormat colorFormat = kUnityXRRenderTextureFormatRGBA32;
+    UnityXRDepthTextureFormat depthFormat =
+        kUnityXRDepthTextureFormat24bitOrGreater;
+    uint32_t arrayLength = 1;
+    bool sRGB = false;
+
+    bool operator==(const EyeTextureKey &other) const {
+        return width == other.width && height == other.height &&
+               colorFormat == other.colorFormat &&
+               depthFormat == other.depthFormat &&
+               arrayLength == other.arrayLength && sRGB == other.sRGB;
+    }
+};
+
+/// Keeps eye textures that are no longer in use, so they can be handed back
+/// without reallocating when the same size comes around again (e.g. when the
+/// resolution scale moves back and forth).
+///
+/// Idle textures are evicted least-recently-used first when they exceed the
+/// memory cap. Textures are only ever destroyed once the GPU is done with
+/// them: each carries the renderer fence value that was signaled after its
+/// last use, and is destroyed only once that value is reached.
+///
+/// Gfx thread only.
+class EyeTexturePool {
+  public:
+    /// Called to actually destroy a texture
+    using DestroyFunc = std::function<void(UnityXRRenderTextureId)>;
+
+    /// Set how much memory idle textures may use
+    /// @param[in] nBytes - Cap in bytes, 0 to keep nothing
+    void SetCapacity(uint64_t nBytes) { m_nCapacityBytes = nBytes; }
+
+    /// Get how much memory idle textures may use
+    uint64_t GetCapacity() const { return m_nCapacityBytes; }
+
+    /// Take an idle texture matching the key, if there is one
+    /// @param[in] key - Required texture properties
+    /// @param[out] id - The texture, if found
+    /// @return bool - Whether a texture was found
+    bool Acquire(const EyeTextureKey &key, UnityXRRenderTextureId &id);
+
+    /// Return a texture that is no longer in use, so it can be reused
+    /// @param[in] key - Properties of the texture
+    /// @param[in] id - The texture
+    /// @param[in] nBytes - Estimated memory used by the texture
+    /// @param[in] nFenceValue - Fence value signaled after its last use
+    void Release(const EyeTextureKey &key, UnityXRRenderTextureId id,
+                 uint64_t nBytes, uint64_t nFenceValue);
+
+    /// Schedule a texture for destruction without making it available for
+    /// reuse (e.g. one that wraps a surface we don't own)
+    /// @param[in] id - The texture
+    /// @param[in] nFenceValue - Fence value signaled after its last use
+    void Retire(UnityXRRenderTextureId id, uint64_t nFenceValue);
+
+    /// Evict idle textures over the cap, and destroy any retired textures the
+    /// GPU has finished with. Call once per frame.
+    /// @param[in] nCompletedFenceValue - Fence value the GPU has reached
+    /// @param[in] destroy - Destroys a texture
+    void Collect(uint64_t nCompletedFenceValue, const DestroyFunc &destroy);
+
+    /// Destroy every texture we hold right away, e.g. on shutdown
+    /// @param[in] destroy - Destroys a texture
+    void Clear(const DestroyFunc &destroy);
+
+    /// Get the estimated memory used by idle textures
+    uint64_t GetIdleBytes() const { return m_nIdleBytes; }
+
+    /// Get the number of idle textures
+    size_t GetIdleCount() const { return m_idle.size(); }
+
+    /// Get the number of textures waiting on the GPU to be destroyed
+    size_t GetRetiredCount() const { return m_retired.size(); }
+
+  private:
+    struct IdleTexture {
+        EyeTextureKey key;
+        UnityXRRenderTextureId id;
+        uint64_t nBytes;
+        uint64_t nFenceValue;
+        /// Value of m_nUseCounter when released, for LRU eviction
+        uint64_t nLastUsed;
+    };
+
+    struct RetiredTexture {
+        UnityXRRenderTextureId id;
+        uint64_t nFenceValue;
+    };
+
+    std::vector<IdleTexture> m_idle;
+    std::vector<RetiredTexture> m_retired;
+    uint64_t m_nCapacityBytes = 0;
+    uint64_t m_nIdleBytes = 0;
+    uint64_t m_nUseCounter = 0;
+};
@@ -9,7 +9,11 @@
 
 #include "Input.h"
 
+#include "CameraParams.h"
 #include "Metadata.h"
+#include "Model/PoseKernel.h"
+#include "Model/SharedMemoryTracking.h"
+#include "Model/Timebase.h"
 #include "ProviderInterface/XRMath.h"
 #include "UnityInterfaces.h"
 #include "Util.h"
@@ -18,8 +22,8 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
-#include <chrono>
 #include <sstream>
 
 static constexpr auto ManufacturerName = "Meta View, Inc.";
@@ -35,9 +39,14 @@ int MetaViewInputProvider::trackerFeatureIndices[static_cast<int>(
 
 const static unsigned int kHapticsNumChannels = 1;
 
-// Han Custom Code
-// this IPD can be changed in runtime.
-static float SinglePassInstancedCamIPD = NominalIpd;
+// A device whose newest tracked sample is older than this is reported as not
+// tracked.
+static constexpr int64_t MaxTrackingSampleAgeNs = 100'000'000;
+
+// How poses are predicted to the display time: a metaview::PosePredictorType.
+// Can be changed at runtime.
+static std::atomic<uint32_t> PosePredictionMethod{static_cast<uint32_t>(
+    metaview::PosePredictorType::ConstantAccelerationKalman)};
 
 static UnitySubsystemErrorCode UNITY_INTERFACE_API
 Tick(UnitySubsystemHandle handle, void *userData,
@@ -226,22 +235,30 @@ GetCharacteristicsForDeviceIndex(uint32_t deviceIndex) {
     return kUnityXRInputDeviceCharacteristicsNone;
 }
 
-MetaViewInputProvider::MetaViewInputProvider() {
+MetaViewInputProvider::MetaViewInputProvider()
+    : m_TrackingFeeder(metaview::Timebase::instance()) {
     // we want to add the HMD only right now.
 
     uint32_t index = 0;
 
     m_TrackedDevices.emplace_back(index, index,
                                   GetCharacteristicsForDeviceIndex(index));
+    m_HeadPoseHistory = m_TrackedDevices.back().poseHistory;
+    m_TrackingFeeder.setHistory(index, m_HeadPoseHistory);
+    m_TrackingFeeder.setSource(
+        std::make_unique<metaview::SharedTrackingSource>());
 }
 
 UnitySubsystemErrorCode MetaViewInputProvider::Tick(
     UnitySubsystemHandle handle, UnityXRInputUpdateType updateType) {
     OpenVRSystem::Get().Update();
+    m_TrackingRecorder.recordFrame(OpenVRSystem::Get().GetFrameIndex());
 
     if (updateType == kUnityXRInputUpdateTypeBeforeRender)
         return kUnitySubsystemErrorCodeSuccess;
 
+    metaview::Timebase::instance().syncWallClock();
+
     // Connect/Disconnect devices marked for change
     for (auto deviceIter = m_TrackedDevices.begin();
          deviceIter != m_TrackedDevices.end();) {
@@ -578,119 +595,82 @@ static void OpenVRMatrix3x4ToUnity(const vr::HmdMatrix34_t &ovrm,
     out.columns[3].w = tmpMatrix[(3 * 4) + 3];
 }
 
-static inline XRMatrix4x4 quatToMatrix(XRQuaternion const &q) {
-    //! @todo handedness change needed because of Unity being left-handed?
-    const float w = q.w;
-    const float x = q.x;
-    const float y = q.y;
-    const float z = q.z;
-    const float x2 = x * x;
-    const float y2 = y * y;
-    const float z2 = z * z;
-    const float w2 = w * w;
-    const float xy = x * y;
-    const float xz = x * z;
-    const float wz = w * z;
-    const float yz = y * z;
-    const float wx = w * x;
-    return XRMatrix4x4(1 - 2 * y2 - 2 * z2,    // m00
-                       2 * xy + 2 * wz,        // m01
-                       2 * xz - 2 * w * y,     // m02
-                       0,                      // m03
-                       2 * xy - 2 * wz,        // m10
-                       1.f - 2 * x2 - 2 * z2,  // m11
-                       2 * yz + 2 * wx,        // m12
-                       0,                      // m13
-                       2 * xz + 2 * w * y,     // m20
-                       2 * yz - 2 * wx,        // m21
-                       1.f - 2 * x2 - 2 * y2,  // m22
-                       0,                      // m23
-                       0,                      // m30
-                       0,                      // m31
-                       0,                      // m32
-                       1                       // m33
-    );
+bool MetaViewInputProvider::TrackedDevice::IsHeadMounted() const {
+    return (characteristics & kUnityXRInputDeviceCharacteristicsHeadMounted) ==
+           kUnityXRInputDeviceCharacteristicsHeadMounted;
 }
 
-void MetaViewInputProvider::InternalToUnityTracking(
-    const TrackedPose &internalPose,
-    std::optional<UnityXRMatrix4x4> postTransform, UnityXRVector3 &outPosition,
-    UnityXRVector4 &outRotation, UnityXRVector3 &outVelocity,
-    UnityXRVector3 &outAngularVelocity) {
-    XRMatrix4x4 trackingToReference = quatToMatrix(internalPose.orientation);
-    trackingToReference.SetCol(
-        3, XRVector4(internalPose.position.x, internalPose.position.y,
-                     internalPose.position.z, 1));
-
-    if (postTransform) {
-        trackingToReference *= reinterpret_cast<XRMatrix4x4 &>(*postTransform);
+void MetaViewInputProvider::UnityPoseBatch::Add(const TrackedDevice &device,
+                                                const TrackedPose &pose,
+                                                UnityTrackedPose *out,
+                                                float ipd) {
+    static constexpr EEye Views[] = {EEye::CenterOrBoth, EEye::Left,
+                                     EEye::Right};
+    const size_t viewCount = device.IsHeadMounted() ? std::size(Views) : 1;
+    for (size_t i = 0; i < viewCount; ++i) {
+        // Normalized by the kernel
+        poses.push_back({{pose.orientation.x, pose.orientation.y,
+                          pose.orientation.z, pose.orientation.w},
+                         {pose.position.x, pose.position.y, pose.position.z}});
+        offsets.push_back(GetEyeOffset(Views[i], ipd));
+        sources.push_back(&pose);
+        targets.push_back(&out[static_cast<int>(Views[i])]);
     }
-
-    outPosition = trackingToReference.Translation();
-
-    XRQuaternion xrQuaternion;
-    MatrixToQuaternion(trackingToReference, xrQuaternion);
-    outRotation = xrQuaternion;
-    outRotation.w *= -1;
-
-    //! @todo transform the velocity?
-    outVelocity = internalPose.velocity;
-    outVelocity.z *= -1;
-
-    outAngularVelocity = internalPose.angularVelocity;
-    outAngularVelocity.z *= -1;
 }
 
-static inline XRMatrix4x4 MakeTranslation(float x, float y, float z) {
-    XRMatrix4x4 ret = XRMatrix4x4::identity;
-    ret.SetCol(3, XRVector4(x, y, z, 1.f));
-    return ret;
+void MetaViewInputProvider::UnityPoseBatch::Convert() {
+    metaview::transformPoses(poses.data(), offsets.data(), poses.data(),
+                             poses.size());
+    for (size_t i = 0; i < poses.size(); ++i) {
+        const metaview::Posef pose = metaview::mirrorZ(poses[i]);
+        const TrackedPose &source = *sources[i];
+        UnityTrackedPose &target = *targets[i];
+        target.position =
+            XRVector3(pose.position.x, pose.position.y, pose.position.z);
+        target.rotation = XRQuaternion(pose.orientation.x, pose.orientation.y,
+                                       pose.orientation.z, pose.orientation.w);
+
+        //! @todo transform the velocity?
+        target.velocity = source.velocity;
+        target.velocity.z *= -1;
+
+        // An axis, mirrored like the rotation
+        target.angularVelocity = source.angularVelocity;
+        target.angularVelocity.x *= -1;
+        target.angularVelocity.y *= -1;
+    }
+    poses.clear();
+    offsets.clear();
+    sources.clear();
+    targets.clear();
 }
 
-static inline UnityXRMatrix4x4 GetEyeTransformReal(EEye eye) {
-    assert(eye != EEye::CenterOrBoth);
-    if (eye == EEye::CenterOrBoth) return XRMatrix4x4::identity;
+metaview::Vec3f MetaViewInputProvider::GetEyeOffset(EEye eye, float ipd) {
     switch (eye) {
         case EEye::Left:
-            return MakeTranslation(SinglePassInstancedCamIPD / -2.f, 0, 0);
+            return {ipd / -2.f, 0, 0};
         case EEye::Right:
-            return MakeTranslation(SinglePassInstancedCamIPD / 2.f, 0, 0);
+            return {ipd / 2.f, 0, 0};
         case EEye::CenterOrBoth:
         default:
-            return XRMatrix4x4::identity;
+            return {};
     }
 }
 
-UnityXRMatrix4x4 MetaViewInputProvider::GetEyeTransform(EEye eye) {
-    auto ret = GetEyeTransformReal(eye);
-    assert(isMatrixValid(ret));
-    return ret;
-}
-
-static UnityXRTimeStamp GetCurrentUnityTimestamp() {
-    auto now = std::chrono::system_clock::now();
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                  now.time_since_epoch())
-                  .count();
-    return static_cast<UnityXRTimeStamp>(ms);
-}
-
 UnitySubsystemErrorCode MetaViewInputProvider::Internal_UpdateDeviceState(
     UnitySubsystemHandle handle, const TrackedDevice &device,
-    const TrackedPose &trackingPose, UnityXRInputDeviceState *deviceState,
-    bool updateNonTrackingData) {
+    bool isTracked, const UnityTrackedPose *unityPoses,
+    UnityXRInputDeviceState *deviceState, bool updateNonTrackingData) {
     int trackingState = kUnityXRInputTrackingStatePosition |
                         kUnityXRInputTrackingStateRotation |
                         kUnityXRInputTrackingStateVelocity |
                         kUnityXRInputTrackingStateAngularVelocity;
 
-    if (!trackingPose.isTracked) trackingState = kUnityXRInputTrackingStateNone;
+    if (!isTracked) trackingState = kUnityXRInputTrackingStateNone;
 
-    XRVector3 devicePosition, deviceVelocity, deviceAngularVelocity;
-    XRQuaternion deviceRotation;
-    if ((device.characteristics &
-         kUnityXRInputDeviceCharacteristicsHeadMounted) ==
-        kUnityXRInputDeviceCharacteristicsHeadMounted) {
+    const UnityTrackedPose &devicePose =
+        unityPoses[static_cast<int>(EEye::CenterOrBoth)];
+    if (device.IsHeadMounted()) {
         s_Input->DeviceState_SetDiscreteStateValue(
             deviceState,
             hmdFeatureIndices[static_cast<int>(HMDFeature::TrackingState)],
@@ -698,94 +678,84 @@ UnitySubsystemErrorCode MetaViewInputProvider::Internal_UpdateDeviceState(
         s_Input->DeviceState_SetBinaryValue(
             deviceState,
             hmdFeatureIndices[static_cast<int>(HMDFeature::IsTracked)],
-            trackingPose.isTracked);
+            isTracked);
 
         s_Input->DeviceState_SetAxis3DValue(
             deviceState,
             hmdFeatureIndices[static_cast<int>(HMDFeature::DevicePosition)],
-            devicePosition);
+            devicePose.position);
         s_Input->DeviceState_SetRotationValue(
             deviceState,
             hmdFeatureIndices[static_cast<int>(HMDFeature::DeviceRotation)],
-            deviceRotation);
+            devicePose.rotation);
         s_Input->DeviceState_SetAxis3DValue(
             deviceState,
             hmdFeatureIndices[static_cast<int>(HMDFeature::DeviceVelocity)],
-            deviceVelocity);
+            devicePose.velocity);
         s_Input->DeviceState_SetAxis3DValue(
             deviceState,
             hmdFeatureIndices[static_cast<int>(
                 HMDFeature::DeviceAngularVelocity)],
-            deviceAngularVelocity);
-
-        UnityXRVector3 leftEyePosition, leftEyeVelocity, leftEyeAngularVelocity;
-        UnityXRVector4 leftEyeRotation;
-        UnityXRMatrix4x4 leftEyeTransform = GetEyeTransform(EEye::Left);
-        InternalToUnityTracking(trackingPose, {leftEyeTransform},
-                                leftEyePosition, leftEyeRotation,
-                                leftEyeVelocity, leftEyeAngularVelocity);
+            devicePose.angularVelocity);
+
+        const UnityTrackedPose &leftEye =
+            unityPoses[static_cast<int>(EEye::Left)];
         s_Input->DeviceState_SetAxis3DValue(
             deviceState,
             hmdFeatureIndices[static_cast<int>(HMDFeature::LeftEyePosition)],
-            leftEyePosition);
+            leftEye.position);
         s_Input->DeviceState_SetRotationValue(
             deviceState,
             hmdFeatureIndices[static_cast<int>(HMDFeature::LeftEyeRotation)],
-            leftEyeRotation);
+            leftEye.rotation);
         s_Input->DeviceState_SetAxis3DValue(
             deviceState,
             hmdFeatureIndices[static_cast<int>(HMDFeature::LeftEyeVelocity)],
-            leftEyeVelocity);
+            leftEye.velocity);
         s_Input->DeviceState_SetAxis3DValue(
             deviceState,
             hmdFeatureIndices[static_cast<int>(
                 HMDFeature::LeftEyeAngularVelocity)],
-            leftEyeAngularVelocity);
-
-        UnityXRVector3 rightEyePosition, rightEyeVelocity,
-            rightEyeAngularVelocity;
-        UnityXRVector4 rightEyeRotation;
-        UnityXRMatrix4x4 rightEyeTransform = GetEyeTransform(EEye::Right);
-        InternalToUnityTracking(trackingPose, {rightEyeTransform},
-                                rightEyePosition, rightEyeRotation,
-                                rightEyeVelocity, rightEyeAngularVelocity);
+            leftEye.angularVelocity);
+
+        const UnityTrackedPose &rightEye =
+            unityPoses[static_cast<int>(EEye::Right)];
         s_Input->DeviceState_SetAxis3DValue(
             deviceState,
             hmdFeatureIndices[static_cast<int>(HMDFeature::RightEyePosition)],
-            rightEyePosition);
+            rightEye.position);
         s_Input->DeviceState_SetRotationValue(
             deviceState,
             hmdFeatureIndices[static_cast<int>(HMDFeature::RightEyeRotation)],
-            rightEyeRotation);
+            rightEye.rotation);
         s_Input->DeviceState_SetAxis3DValue(
             deviceState,
             hmdFeatureIndices[static_cast<int>(HMDFeature::RightEyeVelocity)],
-            rightEyeVelocity);
+            rightEye.velocity);
         s_Input->DeviceState_SetAxis3DValue(
             deviceState,
             hmdFeatureIndices[static_cast<int>(
                 HMDFeature::RightEyeAngularVelocity)],
-            rightEyeAngularVelocity);
+            rightEye.angularVelocity);
 
+        // The eyes are offset either side of the device pose
         s_Input->DeviceState_SetAxis3DValue(
             deviceState,
             hmdFeatureIndices[static_cast<int>(HMDFeature::CenterEyePosition)],
-            (leftEyePosition + rightEyePosition) * 0.5f);
+            devicePose.position);
         s_Input->DeviceState_SetRotationValue(
             deviceState,
             hmdFeatureIndices[static_cast<int>(HMDFeature::CenterEyeRotation)],
-            XRQuaternion::Lerp(
-                reinterpret_cast<XRQuaternion &>(leftEyeRotation),
-                reinterpret_cast<XRQuaternion &>(rightEyeRotation), 0.5f));
+            devicePose.rotation);
         s_Input->DeviceState_SetAxis3DValue(
             deviceState,
             hmdFeatureIndices[static_cast<int>(HMDFeature::CenterEyeVelocity)],
-            (rightEyeVelocity + rightEyeVelocity) * 0.5f);
+            devicePose.velocity);
         s_Input->DeviceState_SetAxis3DValue(
             deviceState,
             hmdFeatureIndices[static_cast<int>(
                 HMDFeature::CenterEyeAngularVelocity)],
-            (leftEyeAngularVelocity + rightEyeAngularVelocity) * 0.5f);
+            devicePose.angularVelocity);
     } else if ((device.characteristics &
                 kUnityXRInputDeviceCharacteristicsHeldInHand) ==
                kUnityXRInputDeviceCharacteristicsHeldInHand) {
@@ -798,31 +768,28 @@ UnitySubsystemErrorCode MetaViewInputProvider::Internal_UpdateDeviceState(
             deviceState,
             controllerFeatureIndices[static_cast<int>(
                 ControllerFeature::IsTracked)],
-            trackingPose.isTracked);
+            isTracked);
 
-        InternalToUnityTracking(trackingPose, std::nullopt, devicePosition,
-                                deviceRotation, deviceVelocity,
-                                deviceAngularVelocity);
         s_Input->DeviceState_SetAxis3DValue(
             deviceState,
             controllerFeatureIndices[static_cast<int>(
                 ControllerFeature::DevicePosition)],
-            devicePosition);
+            devicePose.position);
         s_Input->DeviceState_SetRotationValue(
             deviceState,
             controllerFeatureIndices[static_cast<int>(
                 ControllerFeature::DeviceRotation)],
-            deviceRotation);
+            devicePose.rotation);
         s_Input->DeviceState_SetAxis3DValue(
             deviceState,
             controllerFeatureIndices[static_cast<int>(
                 ControllerFeature::DeviceVelocity)],
-            deviceVelocity);
+            devicePose.velocity);
         s_Input->DeviceState_SetAxis3DValue(
             deviceState,
             controllerFeatureIndices[static_cast<int>(
                 ControllerFeature::DeviceAngularVelocity)],
-            deviceAngularVelocity);
+            devicePose.angularVelocity);
     } else if ((device.characteristics &
                 kUnityXRInputDeviceCharacteristicsTrackingReference) ==
                kUnityXRInputDeviceCharacteristicsTrackingReference) {
@@ -834,31 +801,28 @@ UnitySubsystemErrorCode MetaViewInputProvider::Internal_UpdateDeviceState(
         s_Input->DeviceState_SetBinaryValue(
             deviceState,
             trackerFeatureIndices[static_cast<int>(TrackerFeature::IsTracked)],
-            trackingPose.isTracked);
+            isTracked);
 
-        InternalToUnityTracking(trackingPose, std::nullopt, devicePosition,
-                                deviceRotation, deviceVelocity,
-                                deviceAngularVelocity);
         s_Input->DeviceState_SetAxis3DValue(
             deviceState,
             trackerFeatureIndices[static_cast<int>(
                 TrackerFeature::DevicePosition)],
-            devicePosition);
+            devicePose.position);
         s_Input->DeviceState_SetRotationValue(
             deviceState,
             trackerFeatureIndices[static_cast<int>(
                 TrackerFeature::DeviceRotation)],
-            deviceRotation);
+            devicePose.rotation);
         s_Input->DeviceState_SetAxis3DValue(
             deviceState,
             trackerFeatureIndices[static_cast<int>(
                 TrackerFeature::DeviceVelocity)],
-            deviceVelocity);
+            devicePose.velocity);
         s_Input->DeviceState_SetAxis3DValue(
             deviceState,
             trackerFeatureIndices[static_cast<int>(
                 TrackerFeature::DeviceAngularVelocity)],
-            deviceAngularVelocity);
+            devicePose.angularVelocity);
     } else if ((device.characteristics &
                 kUnityXRInputDeviceCharacteristicsTrackedDevice) ==
                kUnityXRInputDeviceCharacteristicsTrackedDevice) {
@@ -870,31 +834,28 @@ UnitySubsystemErrorCode MetaViewInputProvider::Internal_UpdateDeviceState(
         s_Input->DeviceState_SetBinaryValue(
             deviceState,
             trackerFeatureIndices[static_cast<int>(TrackerFeature::IsTracked)],
-            trackingPose.isTracked);
+            isTracked);
 
-        InternalToUnityTracking(trackingPose, std::nullopt, devicePosition,
-                                deviceRotation, deviceVelocity,
-                                deviceAngularVelocity);
         s_Input->DeviceState_SetAxis3DValue(
             deviceState,
             trackerFeatureIndices[static_cast<int>(
                 TrackerFeature::DevicePosition)],
-            devicePosition);
+            devicePose.position);
         s_Input->DeviceState_SetRotationValue(
             deviceState,
             trackerFeatureIndices[static_cast<int>(
                 TrackerFeature::DeviceRotation)],
-            deviceRotation);
+            devicePose.rotation);
         s_Input->DeviceState_SetAxis3DValue(
             deviceState,
             trackerFeatureIndices[static_cast<int>(
                 TrackerFeature::DeviceVelocity)],
-            deviceVelocity);
+            devicePose.velocity);
         s_Input->DeviceState_SetAxis3DValue(
             deviceState,
             trackerFeatureIndices[static_cast<int>(
                 TrackerFeature::DeviceAngularVelocity)],
-            deviceAngularVelocity);
+            devicePose.angularVelocity);
     }
 
     return kUnitySubsystemErrorCodeSuccess;
@@ -906,11 +867,21 @@ UnitySubsystemErrorCode MetaViewInputProvider::UpdateDeviceState(
     auto device = GetTrackedDeviceByDeviceId(deviceId);
     if (!device) return kUnitySubsystemErrorCodeFailure;
 
+    const TrackedPose &trackingPose = device->trackingPose[updateType];
     UnitySubsystemErrorCode errorCode = Internal_UpdateDeviceState(
-        handle, *device, device->trackingPose[updateType], deviceState, true);
+        handle, *device, trackingPose.isTracked,
+        device->unityPose[updateType], deviceState, true);
     if (errorCode != kUnitySubsystemErrorCodeSuccess) return errorCode;
 
-    s_Input->DeviceState_SetDeviceTime(deviceState, GetCurrentUnityTimestamp());
+    if (m_TrackingRecorder.isRecording() && trackingPose.isTracked) {
+        m_TrackingRecorder.recordPose(
+            metaview::tracking_recording::RecordType::Pose,
+            device->nativeDeviceIndex, updateType,
+            ToPoseSample(trackingPose, device->trackingPoseTimeNs));
+    }
+
+    s_Input->DeviceState_SetDeviceTime(
+        deviceState, metaview::Timebase::instance().getUnityTimestamp());
     return kUnitySubsystemErrorCodeSuccess;
 }
 
@@ -1021,31 +992,33 @@ UnitySubsystemErrorCode MetaViewInputProvider::HandleSetTrackingOriginMode(
 UnitySubsystemErrorCode MetaViewInputProvider::TryGetDeviceStateAtTime(
     UnitySubsystemHandle handle, UnityXRTimeStamp time,
     UnityXRInternalInputDeviceId deviceId, UnityXRInputDeviceState *state) {
-    UnityXRTimeStamp currentTimestamp = GetCurrentUnityTimestamp();
-    UnityXRTimeStamp timestampDelta = time - currentTimestamp;
-    constexpr float kMillisecondsInSecond = 1000.0f;
-    float deltaTimeInSeconds =
-        static_cast<float>(timestampDelta) / kMillisecondsInSecond;
-
-    TrackedPose trackedDevicesAtTimestamp[vr::k_unMaxTrackedDeviceCount];
-#if 0
-    vr::ETrackingUniverseOrigin trackingSpace =
-        OpenVRSystem::Get().GetCompositor()->GetTrackingSpace();
-    OpenVRSystem::Get().GetSystem()->GetDeviceToAbsoluteTrackingPose(
-        trackingSpace, deltaTimeInSeconds, trackedDevicesAtTimestamp,
-        vr::k_unMaxTrackedDeviceCount);
-#endif
+    // Unity timestamps are wall clock milliseconds, the history is in
+    // timebase nanoseconds
+    const int64_t timeNs =
+        metaview::Timebase::instance().fromUnityTimestamp(time);
 
     auto device = GetTrackedDeviceByDeviceId(deviceId);
     if (!device) return kUnitySubsystemErrorCodeFailure;
 
-    assert(device->nativeDeviceIndex < vr::k_unMaxTrackedDeviceCount);
-    if (device->nativeDeviceIndex >= vr::k_unMaxTrackedDeviceCount)
-        return kUnitySubsystemErrorCodeFailure;
+    TrackedPose trackedPoseAtTimestamp;
+    metaview::PoseSample sample;
+    if (device->poseHistory->sample(timeNs, sample)) {
+        trackedPoseAtTimestamp = ToTrackedPose(sample);
+        m_TrackingRecorder.recordPose(
+            metaview::tracking_recording::RecordType::PoseAtTime,
+            device->nativeDeviceIndex, 0, sample);
+    }
+
+    // May be called off the graphics thread, so with a batch of its own
+    static thread_local UnityPoseBatch batch;
+    UnityTrackedPose unityPoses[kUnityPoseViewCount];
+    batch.Add(*device, trackedPoseAtTimestamp, unityPoses,
+              CameraParamBlock::Get().GetFrame().ipd);
+    batch.Convert();
 
     UnitySubsystemErrorCode errorCode = Internal_UpdateDeviceState(
-        handle, *device, trackedDevicesAtTimestamp[device->nativeDeviceIndex],
-        state, false);
+        handle, *device, trackedPoseAtTimestamp.isTracked, unityPoses, state,
+        false);
     if (errorCode != kUnitySubsystemErrorCodeSuccess) return errorCode;
 
     s_Input->DeviceState_SetDeviceTime(state, time);
@@ -1095,43 +1068,210 @@ void MetaViewInputProvider::GfxThread_UpdateConnectedDevices(
 }
 
 void MetaViewInputProvider::GfxThread_CopyPoses(
-    const TrackedPose *currentDevicePoses,
-    const TrackedPose *futureDevicePoses) {
+    const TrackedPose *predictedDevicePoses) {
+    // The display provider latched these for the frame being set up
+    const float ipd = CameraParamBlock::Get().GetFrame().ipd;
     for (auto &trackedDevice : m_TrackedDevices) {
-        trackedDevice.trackingPose[kUnityXRInputUpdateTypeDynamic] =
-            futureDevicePoses[trackedDevice.nativeDeviceIndex];
+        // Unity places the cameras from the before render update, so it
+        // gets the prediction too, and renders the frame where the head will
+        // be when it's shown. Late latching corrects from there.
+        const TrackedPose &predicted =
+            predictedDevicePoses[trackedDevice.nativeDeviceIndex];
+        trackedDevice.trackingPose[kUnityXRInputUpdateTypeDynamic] = predicted;
         trackedDevice.trackingPose[kUnityXRInputUpdateTypeBeforeRender] =
-            currentDevicePoses[trackedDevice.nativeDeviceIndex];
+            predicted;
+        for (int type = 0; type < kUnityXRInputUpdateTypeCount; ++type) {
+            m_UnityPoseBatch.Add(trackedDevice,
+                                 trackedDevice.trackingPose[type],
+                                 trackedDevice.unityPose[type], ipd);
+        }
+    }
+    m_UnityPoseBatch.Convert();
+}
+
+metaview::Posef MetaViewInputProvider::ToPosef(const TrackedPose &trackedPose) {
+    metaview::Posef pose;
+    // Untracked poses may carry an all-zero quaternion
+    pose.orientation = metaview::normalize(
+        {trackedPose.orientation.x, trackedPose.orientation.y,
+         trackedPose.orientation.z, trackedPose.orientation.w});
+    pose.position = {trackedPose.position.x, trackedPose.position.y,
+                     trackedPose.position.z};
+    return pose;
+}
+
+metaview::PoseSample MetaViewInputProvider::ToPoseSample(
+    const TrackedPose &trackedPose, int64_t timeNs) {
+    metaview::PoseSample sample;
+    sample.timeNs = timeNs;
+    sample.pose = ToPosef(trackedPose);
+    sample.linearVelocity = {trackedPose.velocity.x, trackedPose.velocity.y,
+                             trackedPose.velocity.z};
+    sample.angularVelocity = {trackedPose.angularVelocity.x,
+                              trackedPose.angularVelocity.y,
+                              trackedPose.angularVelocity.z};
+    return sample;
+}
+
+TrackedPose MetaViewInputProvider::ToTrackedPose(
+    const metaview::PoseSample &sample) {
+    TrackedPose trackedPose;
+    trackedPose.isTracked = true;
+    trackedPose.position = XRVector3(sample.pose.position.x,
+                                     sample.pose.position.y,
+                                     sample.pose.position.z);
+    trackedPose.orientation =
+        XRQuaternion(sample.pose.orientation.x, sample.pose.orientation.y,
+                     sample.pose.orientation.z, sample.pose.orientation.w);
+    trackedPose.velocity =
+        XRVector3(sample.linearVelocity.x, sample.linearVelocity.y,
+                  sample.linearVelocity.z);
+    trackedPose.angularVelocity =
+        XRVector3(sample.angularVelocity.x, sample.angularVelocity.y,
+                  sample.angularVelocity.z);
+    return trackedPose;
+}
+
+bool MetaViewInputProvider::GfxThread_GetRenderHeadPose(
+    metaview::Posef &pose) {
+    const TrackedDevice *hmd =
+        GetTrackedDeviceByNativeIndex(vr::k_unTrackedDeviceIndex_Hmd);
+    if (!hmd) {
+        return false;
+    }
+    // Unity positions the cameras from the before render update, predicted
+    // to the frame's photon time
+    const TrackedPose &trackedPose =
+        hmd->trackingPose[kUnityXRInputUpdateTypeBeforeRender];
+    if (!trackedPose.isTracked) {
+        return false;
+    }
+    pose = ToPosef(trackedPose);
+    return true;
+}
+
+bool MetaViewInputProvider::GetLatestHeadPose(int64_t timeNs,
+                                              metaview::Posef &pose) {
+    metaview::PoseSample sample;
+    if (!m_HeadPoseHistory->sample(timeNs, sample)) {
+        return false;
+    }
+    pose = sample.pose;
+    return true;
+}
+
+void MetaViewInputProvider::GfxThread_UpdatePosePredictors() {
+    const auto type =
+        static_cast<metaview::PosePredictorType>(PosePredictionMethod.load());
+    if (type == m_PosePredictorType) {
+        return;
+    }
+    for (auto &trackedDevice : m_TrackedDevices) {
+        trackedDevice.posePredictor = metaview::makePosePredictor(type);
     }
+    m_PosePredictorType = type;
+}
+
+void MetaViewInputProvider::SetTrackingSource(
+    std::unique_ptr<metaview::ITrackingSource> source) {
+    m_TrackingFeeder.setSource(std::move(source));
+}
+
+bool MetaViewInputProvider::StartTrackingRecording(const std::string &path) {
+    return m_TrackingRecorder.start(path);
+}
+
+void MetaViewInputProvider::StopTrackingRecording() {
+    m_TrackingRecorder.stop();
+}
+
+void MetaViewInputProvider::GfxThread_ReadTrackingSource() {
+    // The feeder already put these in the pose histories
+    size_t count = 0;
+    do {
+        count = m_TrackingFeeder.read(m_TrackingSamples.data(),
+                                      m_TrackingSamples.size());
+        for (size_t i = 0; i < count; ++i) {
+            const metaview::TrackedSample &tracked = m_TrackingSamples[i];
+            TrackedDevice *device =
+                GetTrackedDeviceByNativeIndex(tracked.device);
+            if (!device) {
+                continue;
+            }
+            if (device->posePredictor) {
+                device->posePredictor->update(tracked.sample);
+            }
+            device->latestSample = tracked.sample;
+            device->hasSample = true;
+        }
+    } while (count == m_TrackingSamples.size());
 }
 
 // Called from the graphics thread in post-present to get connected devices and
 // update poses. The graphics thread will have a sync fence with the main loop,
 // so thread synchronization is not further necessary.
-void MetaViewInputProvider::GfxThread_UpdateDevices() {
+void MetaViewInputProvider::GfxThread_UpdateDevices(int64_t photonTimeNs) {
     if (!m_Started) return;
 
     TrackedPose trackedDevicesCurrent[vr::k_unMaxTrackedDeviceCount];
-    TrackedPose trackedDevicesFuture[vr::k_unMaxTrackedDeviceCount];
+    TrackedPose trackedDevicesPredicted[vr::k_unMaxTrackedDeviceCount];
 
-    const size_t n = m_TrackedDevices.size();
-    for (size_t i = 0; i < n; ++i) {
-        //! @todo get tracking here
-        trackedDevicesCurrent[i].isTracked = true;
-        trackedDevicesFuture[i].isTracked = true;
+    const uint64_t sourceChanges = m_TrackingFeeder.getSourceChanges();
+    if (sourceChanges != m_TrackingSourceChanges) {
+        m_TrackingSourceChanges = sourceChanges;
+        for (auto &trackedDevice : m_TrackedDevices) {
+            trackedDevice.hasSample = false;
+        }
+    }
+    GfxThread_UpdatePosePredictors();
+    const bool hasSource = m_TrackingFeeder.isConnected();
+    GfxThread_ReadTrackingSource();
+    const int64_t now = metaview::Timebase::instance().now();
+    for (auto &trackedDevice : m_TrackedDevices) {
+        const uint32_t index = trackedDevice.nativeDeviceIndex;
+        TrackedPose &current = trackedDevicesCurrent[index];
+        metaview::IPosePredictor *predictor = trackedDevice.posePredictor.get();
+        if (!hasSource) {
+            // No tracker: report a fixed pose so apps still render. The
+            // feeder puts the same in the history.
+            current.isTracked = true;
+            if (predictor) {
+                predictor->update(ToPoseSample(current, now));
+            }
+        } else if (trackedDevice.hasSample &&
+                   now - trackedDevice.latestSample.timeNs <=
+                       MaxTrackingSampleAgeNs) {
+            current = ToTrackedPose(trackedDevice.latestSample);
+        }
+        trackedDevicesPredicted[index] = current;
+        trackedDevice.trackingPoseTimeNs = now;
+        if (!current.isTracked) {
+            if (predictor) {
+                predictor->reset();
+            }
+            continue;
+        }
+        metaview::PoseSample predicted;
+        if (predictor && photonTimeNs > now &&
+            predictor->predict(photonTimeNs, predicted)) {
+            trackedDevicesPredicted[index] = ToTrackedPose(predicted);
+            trackedDevice.trackingPoseTimeNs = predicted.timeNs;
+        }
     }
     GfxThread_UpdateConnectedDevices(trackedDevicesCurrent);
-    GfxThread_CopyPoses(trackedDevicesCurrent, trackedDevicesFuture);
+    GfxThread_CopyPoses(trackedDevicesPredicted);
 }
 
 UnitySubsystemErrorCode MetaViewInputProvider::Start() {
     m_Started = true;
+    m_TrackingFeeder.start();
 
     return kUnitySubsystemErrorCodeSuccess;
 }
 
 void MetaViewInputProvider::Stop(UnitySubsystemHandle handle) {
     m_Started = false;
+    m_TrackingFeeder.stop();
 
     for (auto deviceIter = m_TrackedDevices.begin();
          deviceIter != m_TrackedDevices.end();) {
@@ -1217,5 +1357,54 @@ bool RegisterInputLifecycleProvider(
 
 extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API
 SetParamsForSinglePassInstancedCameraInputCPP(float IPD) {
-    SinglePassInstancedCamIPD = IPD;
+    CameraParamBlock::Get().Update(
+        [&](CameraParams &params) { params.ipd = IPD; });
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API
+SetPosePredictionMethod(uint32_t method) {
+    PosePredictionMethod = std::min(
+        method, static_cast<uint32_t>(
+                    metaview::PosePredictorType::DoubleExponential));
+}
+
+extern "C" uint16_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API
+StartTrackingRecording(const char *path) {
+    const bool started =
+        path != nullptr &&
+        MetaViewInputProvider::Get().StartTrackingRecording(path);
+    XR_TRACE(PLUGIN_LOG_PREFIX "Tracking recording to %s %s\n",
+             path ? path : "(null)", started ? "started" : "failed");
+    return started ? 1 : 0;
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API
+StopTrackingRecording() {
+    MetaViewInputProvider::Get().StopTrackingRecording();
+}
+
+extern "C" uint16_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API
+StartTrackingReplay(const char *path, uint16_t loop) {
+    if (path == nullptr) {
+        return 0;
+    }
+    try {
+        metaview::ReplayTrackingSourceConfig config;
+        config.loop = loop != 0;
+        MetaViewInputProvider::Get().SetTrackingSource(
+            std::make_unique<metaview::ReplayTrackingSource>(
+                std::make_shared<metaview::TrackingRecording>(path),
+                metaview::Timebase::instance(), config));
+    } catch (std::exception const &e) {
+        XR_TRACE(PLUGIN_LOG_PREFIX "Tracking replay of %s failed: %s\n", path,
+                 e.what());
+        return 0;
+    }
+    return 1;
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API
+StopTrackingReplay() {
+    MetaViewInputProvider::Get().SetTrackingSource(
+        std::make_unique<metaview::SharedTrackingSource>());
 }
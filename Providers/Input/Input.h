@@ -10,6 +10,11 @@
 #pragma once
 
 #include "CommonTypes.h"
+#include "Model/PoseHistory.h"
+#include "Model/PosePredictor.h"
+#include "Model/TrackingFeeder.h"
+#include "Model/TrackingRecording.h"
+#include "Model/TrackingSource.h"
 #include "OpenVRProviderContext.h"
 #include "OpenVRSystem.h"
 #include "ProviderInterface/IUnityXRInput.h"
@@ -17,6 +22,10 @@
 #include "Shared.h"
 #include "Singleton.h"
 
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <vector>
@@ -32,6 +41,15 @@ struct TrackedPose {
     XRVector3 angularVelocity{};
 };
 
+/// A pose in Unity's (left handed) tracking space, as the device state
+/// features take it.
+struct UnityTrackedPose {
+    XRVector3 position{};
+    XRQuaternion rotation{0, 0, 0, 1};
+    XRVector3 velocity{};
+    XRVector3 angularVelocity{};
+};
+
 class MetaViewInputProvider : public Singleton<MetaViewInputProvider> {
   public:
     MetaViewInputProvider();
@@ -77,7 +95,35 @@ class MetaViewInputProvider : public Singleton<MetaViewInputProvider> {
     UnitySubsystemErrorCode Start();
     void Stop(UnitySubsystemHandle handle);
 
-    void GfxThread_UpdateDevices();
+    /// Sample every device and update the poses handed to Unity. Both
+    /// updates get poses predicted to @p photonTimeNs (metaview::Timebase
+    /// nanoseconds), when the frame being set up should reach the display;
+    /// 0 if unknown, for the newest poses as they are.
+    void GfxThread_UpdateDevices(int64_t photonTimeNs = 0);
+
+    /// Get the head pose Unity renders the current frame with, predicted to
+    /// its photon time and right handed like metaview::Posef. Returns false
+    /// if the head isn't tracked.
+    bool GfxThread_GetRenderHeadPose(metaview::Posef &pose);
+
+    /// Get the head pose at a time (metaview::Timebase nanoseconds) from its
+    /// history, for late latching and timewarp. Has the signature of a
+    /// metaview::PoseProvider and may be called from any thread. Returns false
+    /// if the head hasn't been tracked yet.
+    bool GetLatestHeadPose(int64_t timeNs, metaview::Posef &pose);
+
+    /// Replace where device poses come from; null for none. May be called
+    /// from any thread: the tracking feeder switches over at its next poll.
+    /// Defaults to a metaview::SharedTrackingSource, fed by an external
+    /// tracker process.
+    void SetTrackingSource(std::unique_ptr<metaview::ITrackingSource> source);
+
+    /// Record the poses delivered to Unity, the times they were asked for and
+    /// the frame indices to a file, until StopTrackingRecording(). Call from
+    /// the thread Unity ticks input on. Returns false if the file can't be
+    /// created.
+    bool StartTrackingRecording(const std::string &path);
+    void StopTrackingRecording();
 
   private:
     enum class EDeviceStatus { None, Connect, Disconnect };
@@ -157,6 +203,9 @@ class MetaViewInputProvider : public Singleton<MetaViewInputProvider> {
         controllerFeatureIndices[static_cast<int>(ControllerFeature::Total)];
     static int trackerFeatureIndices[static_cast<int>(TrackerFeature::Total)];
     static const int kUnityXRInputUpdateTypeCount = 2;
+    /// Poses reported per device, indexed by EEye: the eyes (HMDs only) and
+    /// the device itself as EEye::CenterOrBoth.
+    static const int kUnityPoseViewCount = 3;
     bool m_Started = false;
 
     struct TrackedDevice {
@@ -168,6 +217,19 @@ class MetaViewInputProvider : public Singleton<MetaViewInputProvider> {
         EDeviceStatus deviceStatus = EDeviceStatus::None;
         EDeviceStatus deviceChangeForNextUpdate = EDeviceStatus::None;
         TrackedPose trackingPose[kUnityXRInputUpdateTypeCount];
+        /// When trackingPose is for: the photon time if it was predicted.
+        int64_t trackingPoseTimeNs = 0;
+        /// trackingPose converted for Unity.
+        UnityTrackedPose unityPose[kUnityXRInputUpdateTypeCount]
+                                  [kUnityPoseViewCount];
+        /// Timestamped poses for TryGetDeviceStateAtTime, late latching and
+        /// timewarp. Fed by m_TrackingFeeder's thread, read from any.
+        std::shared_ptr<metaview::PoseHistory> poseHistory;
+        /// Predicts the poses handed to Unity, or null for no prediction.
+        std::shared_ptr<metaview::IPosePredictor> posePredictor;
+        /// Newest sample from the tracking source, if hasSample.
+        metaview::PoseSample latestSample;
+        bool hasSample = false;
 
         TrackedDevice(uint32_t index, UnityXRInternalInputDeviceId id,
                       UnityXRInputDeviceCharacteristics characteristics)
@@ -176,13 +238,57 @@ class MetaViewInputProvider : public Singleton<MetaViewInputProvider> {
               characteristics(characteristics),
               deviceStatus(EDeviceStatus::None),
               deviceChangeForNextUpdate(EDeviceStatus::Connect),
-              trackingPose() {}
+              trackingPose(),
+              poseHistory(std::make_shared<metaview::PoseHistory>()) {}
 
         std::optional<std::string> GetDeviceName() const;
+        bool IsHeadMounted() const;
     };
 
     std::vector<MetaViewInputProvider::TrackedDevice> m_TrackedDevices;
 
+    /// The HMD's pose history, kept past the device's removal since it is
+    /// read off the graphics thread.
+    std::shared_ptr<metaview::PoseHistory> m_HeadPoseHistory;
+
+    /// Prediction method the devices' predictors were made for.
+    metaview::PosePredictorType m_PosePredictorType =
+        metaview::PosePredictorType::None;
+
+    /// Polls the tracking source between frames, into the pose histories,
+    /// while the provider is started.
+    metaview::TrackingFeeder m_TrackingFeeder;
+
+    /// The feeder's source changes the devices' samples are from.
+    uint64_t m_TrackingSourceChanges = 0;
+
+    /// Fed from the graphics thread and from whichever threads call
+    /// TryGetDeviceStateAtTime; started and stopped through the managed API.
+    metaview::TrackingRecorder m_TrackingRecorder;
+
+    /// Scratch space for reading the tracking feeder without allocating.
+    std::array<metaview::TrackedSample, 64> m_TrackingSamples;
+
+    /// Converts poses for Unity, all in one pass through the pose kernel:
+    /// queue them up with Add, then Convert. Keeps its capacity, so only the
+    /// first few passes allocate.
+    struct UnityPoseBatch {
+        std::vector<metaview::Posef> poses;
+        std::vector<metaview::Vec3f> offsets;
+        std::vector<const TrackedPose *> sources;
+        std::vector<UnityTrackedPose *> targets;
+
+        /// Queue the views of a device's pose that Unity is given: the device
+        /// itself and, for an HMD, each eye, @p ipd apart. @p out is indexed
+        /// by EEye.
+        void Add(const TrackedDevice &device, const TrackedPose &pose,
+                 UnityTrackedPose *out, float ipd);
+        void Convert();
+    };
+
+    /// For the graphics thread.
+    UnityPoseBatch m_UnityPoseBatch;
+
     inline TrackedDevice *GetTrackedDeviceByDeviceId(
         UnityXRInternalInputDeviceId id) {
         for (auto &trackedDevice : m_TrackedDevices) {
@@ -204,16 +310,16 @@ class MetaViewInputProvider : public Singleton<MetaViewInputProvider> {
 
     void GfxThread_UpdateConnectedDevices(
         const TrackedPose *currentDevicePoses);
-    static UnityXRMatrix4x4 GetEyeTransform(EEye eye);
+    static metaview::Vec3f GetEyeOffset(EEye eye, float ipd);
     UnitySubsystemErrorCode Internal_UpdateDeviceState(
         UnitySubsystemHandle handle, const TrackedDevice &device,
-        const TrackedPose &trackingPose, UnityXRInputDeviceState *deviceState,
-        bool updateNonTrackingData);
-    static void InternalToUnityTracking(
-        const TrackedPose &internalPose,
-        std::optional<UnityXRMatrix4x4> postTransform,
-        UnityXRVector3 &outPosition, UnityXRVector4 &outRotation,
-        UnityXRVector3 &outVelocity, UnityXRVector3 &outAngularVelocity);
-    void GfxThread_CopyPoses(const TrackedPose *currentDevicePoses,
-                             const TrackedPose *futureDevicePoses);
+        bool isTracked, const UnityTrackedPose *unityPoses,
+        UnityXRInputDeviceState *deviceState, bool updateNonTrackingData);
+    void GfxThread_CopyPoses(const TrackedPose *predictedDevicePoses);
+    void GfxThread_UpdatePosePredictors();
+    void GfxThread_ReadTrackingSource();
+    static metaview::Posef ToPosef(const TrackedPose &trackedPose);
+    static metaview::PoseSample ToPoseSample(const TrackedPose &trackedPose,
+                                             int64_t timeNs);
+    static TrackedPose ToTrackedPose(const metaview::PoseSample &sample);
 };
@@ -0,0 +1,124 @@
+// Copyright (c) 2020, Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#include "RuntimeConfig.h"
+
+#include "CameraParams.h"
+#include "CommonTypes.h"
+#include "Metadata.h"
+#include "UnityInterfaces.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+
+static_assert(sizeof(MetaViewRuntimeConfig) % sizeof(uint32_t) == 0,
+              "MetaViewRuntimeConfig is copied in 32-bit words");
+
+// The block managed code writes, and the sequence of the last applied copy.
+// The mutex keeps SetSharedBlock from returning while the block is read.
+static std::mutex SharedBlockMutex;
+static const MetaViewRuntimeConfig *SharedBlock = nullptr;
+static uint32_t SharedBlockAppliedSequence = 0;
+
+bool RuntimeConfig::Apply(const MetaViewRuntimeConfig &config) {
+    if (config.version != MetaViewRuntimeConfigVersion) {
+        XR_TRACE(PLUGIN_LOG_PREFIX
+                 "[Error] Runtime config version %u, expected %u\n",
+                 config.version, MetaViewRuntimeConfigVersion);
+        return false;
+    }
+
+    // Every field lives in the one block, so the whole config applies as one
+    // change, latched by the next frame.
+    CameraParamBlock::Get().Update([&](CameraParams &params) {
+        if (config.fields & RuntimeConfigIpd) {
+            params.ipd = config.ipd;
+        }
+        if (config.fields & RuntimeConfigEyePositions) {
+            params.leftEyePosition = {config.leftEyeX, config.leftEyeY,
+                                      config.leftEyeZ};
+            params.rightEyePosition = {config.rightEyeX, config.rightEyeY,
+                                       config.rightEyeZ};
+        }
+        if (config.fields & RuntimeConfigFov) {
+            params.leftFov = {-config.widthHalfAngle, config.widthHalfAngle,
+                              config.heightHalfAngle, -config.heightHalfAngle};
+            params.rightFov = params.leftFov;
+        }
+        if (config.fields & RuntimeConfigSingleCameraFov) {
+            params.singleCameraFov = {
+                config.singleCameraLeft, config.singleCameraRight,
+                config.singleCameraTop, config.singleCameraBottom};
+        }
+        if (config.fields & RuntimeConfigLensContour) {
+            params.lensContour.centerX = config.lensCenterX;
+            params.lensContour.centerY = config.lensCenterY;
+            params.lensContour.radiusX = config.lensRadiusX;
+            params.lensContour.radiusY = config.lensRadiusY;
+            params.lensContour.exponent = config.lensExponent;
+        }
+        if (config.fields & RuntimeConfigMirrorViewMode) {
+            params.mirrorViewMode = config.mirrorViewMode;
+        }
+        if (config.fields & RuntimeConfigRotateEyes) {
+            params.rotateEyes = config.rotateEyes != 0 ? 1 : 0;
+        }
+    });
+    return true;
+}
+
+void RuntimeConfig::SetSharedBlock(const MetaViewRuntimeConfig *pBlock) {
+    std::lock_guard<std::mutex> lock(SharedBlockMutex);
+    SharedBlock = pBlock;
+    SharedBlockAppliedSequence = 0;
+}
+
+void RuntimeConfig::PollSharedBlock() {
+    std::lock_guard<std::mutex> lock(SharedBlockMutex);
+    if (SharedBlock == nullptr) {
+        return;
+    }
+
+    // Managed code writes the block as a sequence lock writer would; copy
+    // it out word by word, and try again next frame if it was being written.
+    const volatile uint32_t *pWords =
+        reinterpret_cast<const volatile uint32_t *>(SharedBlock);
+    const size_t sequenceIndex =
+        offsetof(MetaViewRuntimeConfig, sequence) / sizeof(uint32_t);
+    const uint32_t sequence = pWords[sequenceIndex];
+    if ((sequence & 1) != 0 || sequence == SharedBlockAppliedSequence) {
+        return;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint32_t words[sizeof(MetaViewRuntimeConfig) / sizeof(uint32_t)];
+    for (size_t i = 0; i < std::size(words); ++i) {
+        words[i] = pWords[i];
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (pWords[sequenceIndex] != sequence) {
+        return;
+    }
+
+    MetaViewRuntimeConfig config;
+    std::memcpy(&config, words, sizeof(config));
+    Apply(config);
+    SharedBlockAppliedSequence = sequence;
+}
+
+extern "C" uint16_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API
+SetRuntimeConfig(const MetaViewRuntimeConfig *config) {
+    if (config == nullptr) {
+        return 0;
+    }
+    return RuntimeConfig::Apply(*config) ? 1 : 0;
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API
+SetSharedRuntimeConfig(const MetaViewRuntimeConfig *block) {
+    RuntimeConfig::SetSharedBlock(block);
+}
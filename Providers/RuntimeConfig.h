@@ -0,0 +1,75 @@
+// Copyright (c) 2020, Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include <cstdint>
+
+/// Layout version of MetaViewRuntimeConfig. Bump on any change to it, along
+/// with com.metavision.unity/Runtime/MetaViewLoader.cs.
+constexpr uint32_t MetaViewRuntimeConfigVersion = 2;
+
+/// Which parts of a MetaViewRuntimeConfig to apply
+enum MetaViewRuntimeConfigFields : uint32_t {
+    RuntimeConfigIpd = 1 << 0,
+    RuntimeConfigEyePositions = 1 << 1,
+    RuntimeConfigFov = 1 << 2,
+    RuntimeConfigSingleCameraFov = 1 << 3,
+    RuntimeConfigMirrorViewMode = 1 << 4,
+    RuntimeConfigRotateEyes = 1 << 5,
+    RuntimeConfigLensContour = 1 << 6,
+};
+
+/// Everything managed code configures at runtime, set in one call (or through
+/// a shared block) instead of one export per field. Laid out for P/Invoke:
+/// must match RuntimeConfig in com.metavision.unity/Runtime/MetaViewLoader.cs.
+struct MetaViewRuntimeConfig {
+    /// MetaViewRuntimeConfigVersion the caller was built with
+    uint32_t version;
+    /// Only for the shared block: odd while managed code is writing it, bumped
+    /// to the next even value when done
+    uint32_t sequence;
+    /// MetaViewRuntimeConfigFields to apply; the rest are ignored
+    uint32_t fields;
+
+    /// As SetParamsForSinglePassInstancedCameraInputCPP
+    float ipd;
+    /// As SetParamsForSinglePassInstancedCameraPos
+    float leftEyeX, leftEyeY, leftEyeZ;
+    float rightEyeX, rightEyeY, rightEyeZ;
+    /// As SetParamsForSinglePassInstancedCameraFOV
+    float widthHalfAngle, heightHalfAngle;
+    /// As SetProjectionParamsForSingleCamera
+    float singleCameraLeft, singleCameraRight, singleCameraTop,
+        singleCameraBottom;
+    /// As SetMirrorViewMode
+    uint16_t mirrorViewMode;
+    /// As TellPluginRotateEyes
+    uint16_t rotateEyes;
+    /// The part of the left eye's view the optics show (see
+    /// metaview::LensContour), mirrored for the right eye. Zero radii for
+    /// none.
+    float lensCenterX, lensCenterY;
+    float lensRadiusX, lensRadiusY;
+    float lensExponent;
+};
+
+class RuntimeConfig {
+  public:
+    /// Apply the fields of a configuration. Camera parameters change as one
+    /// update, and only if they differ from the current ones.
+    /// @return bool - false if the configuration is from another layout
+    /// version
+    static bool Apply(const MetaViewRuntimeConfig &config);
+
+    /// Use a block managed code writes in place, instead of calling Apply.
+    /// The block must stay valid until this is called again.
+    /// @param[in] pBlock - The block, or nullptr to stop polling it
+    static void SetSharedBlock(const MetaViewRuntimeConfig *pBlock);
+
+    /// Apply the shared block if managed code changed it since the last
+    /// call. Graphics thread, once per frame.
+    static void PollSharedBlock();
+};
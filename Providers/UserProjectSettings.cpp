@@ -9,6 +9,7 @@
 
 #include "UserProjectSettings.h"
 
+#include "CameraParams.h"
 #include "CommonTypes.h"
 #include "Display/Display.h"
 #include "Metadata.h"
@@ -46,6 +47,9 @@ typedef struct _UserDefinedSettings {
     unsigned short rotateEyes = 1;
 } UserDefinedSettings;
 
+// Only the stereo rendering mode is read from here. The mirror view mode and
+// eye rotation change at runtime, so live in CameraParamBlock with the other
+// parameters the graphics thread latches per frame.
 static UserDefinedSettings s_UserDefinedSettings;
 static bool bInitialized = false;
 static bool inEditor = true;
@@ -164,7 +168,7 @@ std::string UserProjectSettings::RemoveFileExtension(
 }
 
 bool UserProjectSettings::RotateEyes() {
-    return (bool)s_UserDefinedSettings.rotateEyes;
+    return CameraParamBlock::Get().GetFrame().rotateEyes != 0;
 }
 
 EVRStereoRenderingModes UserProjectSettings::GetStereoRenderingMode() {
@@ -172,7 +176,17 @@ EVRStereoRenderingModes UserProjectSettings::GetStereoRenderingMode() {
 }
 
 EVRMirrorViewMode UserProjectSettings::GetMirrorViewMode() {
-    return (EVRMirrorViewMode)s_UserDefinedSettings.mirrorViewMode;
+    return (EVRMirrorViewMode)CameraParamBlock::Get().GetFrame().mirrorViewMode;
+}
+
+void UserProjectSettings::SetMirrorViewMode(unsigned short mirrorViewMode) {
+    CameraParamBlock::Get().Update(
+        [&](CameraParams &params) { params.mirrorViewMode = mirrorViewMode; });
+}
+
+void UserProjectSettings::SetRotateEyes(bool rotateEyes) {
+    CameraParamBlock::Get().Update(
+        [&](CameraParams &params) { params.rotateEyes = rotateEyes ? 1 : 0; });
 }
 
 int UserProjectSettings::GetUnityMirrorViewMode() {
@@ -248,7 +262,8 @@ bool UserProjectSettings::DirectoryExists(const char *const path) {
 }
 extern "C" uint16_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API
 GetMirrorViewMode() {
-    return s_UserDefinedSettings.mirrorViewMode;
+    return static_cast<uint16_t>(
+        CameraParamBlock::Get().GetLatest().mirrorViewMode);
 }
 
 extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API
@@ -256,7 +271,7 @@ SetMirrorViewMode(uint16_t mirrorViewMode) {
     XR_TRACE(PLUGIN_LOG_PREFIX "Extern SetMirrorViewMode (%s)\n",
              GetMirrorViewModeString(mirrorViewMode));
 
-    s_UserDefinedSettings.mirrorViewMode = mirrorViewMode;
+    UserProjectSettings::SetMirrorViewMode(mirrorViewMode);
 }
 
 extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API
@@ -264,7 +279,7 @@ TellPluginRotateEyes(uint16_t rotateEyes) {
     XR_TRACE(PLUGIN_LOG_PREFIX "Extern TellPluginRotateEyes (%d)\n",
              (int)rotateEyes);
 
-    s_UserDefinedSettings.rotateEyes = rotateEyes;
+    UserProjectSettings::SetRotateEyes(rotateEyes != 0);
 }
 
 extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API
@@ -282,8 +297,10 @@ SetUserDefinedSettings(UserDefinedSettings settings) {
         // it doesn't.
         s_UserDefinedSettings.stereoRenderingMode =
             settings.stereoRenderingMode;
-        s_UserDefinedSettings.mirrorViewMode = settings.mirrorViewMode;
-        s_UserDefinedSettings.rotateEyes = settings.rotateEyes;
+        CameraParamBlock::Get().Update([&](CameraParams &params) {
+            params.mirrorViewMode = settings.mirrorViewMode;
+            params.rotateEyes = settings.rotateEyes != 0 ? 1 : 0;
+        });
         bInitialized = true;
 
     }
@@ -31,6 +31,8 @@ class UserProjectSettings {
     static EVRStereoRenderingModes GetStereoRenderingMode();
     static void Initialize();
     static EVRMirrorViewMode GetMirrorViewMode();
+    static void SetMirrorViewMode(unsigned short mirrorViewMode);
+    static void SetRotateEyes(bool rotateEyes);
     static int GetUnityMirrorViewMode();
     static std::string GetProjectDirectoryPath(bool bAddDataDirectory);
     static std::string GetCurrentWorkingPath();
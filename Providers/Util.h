@@ -6,6 +6,7 @@
 #pragma once
 
 #include <directxmath.h>
+#include <cfloat>
 #include <cmath>
 #include "ProviderInterface/XRMath.h"
 #include "SimpleMath.h"
@@ -28,6 +29,7 @@ static inline DirectX::SimpleMath::Matrix toSimpleMath(
 }
 
 static inline bool isMatrixValid(UnityXRMatrix4x4 const& unityMat) {
-    auto mat = toSimpleMath(unityMat);
-    return std::abs(mat.Determinant()) > FLT_MIN;
+    // Same memory layout, just transposed, which keeps the determinant
+    return std::abs(Determinant(
+               reinterpret_cast<XRMatrix4x4 const&>(unityMat))) > FLT_MIN;
 }
@@ -301,6 +301,7 @@ namespace Unity.XR.MetaView
             CleanupTick();
             CleanupReloadWatcher();
             DestroyMirrorModeWatcher();
+            ReleaseSharedRuntimeConfig();
 
             StopSubsystem<XRInputSubsystem>();
             StopSubsystem<XRDisplaySubsystem>();
@@ -314,6 +315,7 @@ namespace Unity.XR.MetaView
             CleanupTick();
             CleanupReloadWatcher();
             DestroyMirrorModeWatcher();
+            ReleaseSharedRuntimeConfig();
 
             DestroySubsystem<XRInputSubsystem>();
             DestroySubsystem<XRDisplaySubsystem>();
@@ -342,21 +344,337 @@ namespace Unity.XR.MetaView
                 return false;
             }
 
-            SetProjectionParamsForSingleCamera(left, right, top, bottom);
+            RuntimeConfig config = new RuntimeConfig
+            {
+                fields = RuntimeConfigFields.SingleCameraFov,
+                singleCameraLeft = left,
+                singleCameraRight = right,
+                singleCameraTop = top,
+                singleCameraBottom = bottom,
+            };
+            if (!SetRuntimeConfig(config))
+            {
+                return false;
+            }
             Debug.Log($"{PluginMetadata.DebugLogPrefix}Sent single-cam projection parameters to native plugin.");
             return true;
         }
 
         public bool SetupForSinglePassInstancedCamera(float IPD, float widthHalfAngle, float heightHalfAngle, float leftEyeX, float rightEyeX, float leftEyeY, float rightEyeY, float leftEyeZ, float rightEyeZ)
         {
-            SetParamsForSinglePassInstancedCameraInputCPP(IPD);
-            //SetParamsForSinglePassInstancedCameraDisplayCPP(IPD);
-            SetParamsForSinglePassInstancedCameraPos(leftEyeX, rightEyeX, leftEyeY, rightEyeY, leftEyeZ, rightEyeZ);
-            SetParamsForSinglePassInstancedCameraFOV(widthHalfAngle, heightHalfAngle);
+            // One call, so the plugin never renders with some of these changed and not the rest
+            RuntimeConfig config = new RuntimeConfig
+            {
+                fields = RuntimeConfigFields.Ipd | RuntimeConfigFields.EyePositions | RuntimeConfigFields.Fov,
+                ipd = IPD,
+                leftEyeX = leftEyeX,
+                leftEyeY = leftEyeY,
+                leftEyeZ = leftEyeZ,
+                rightEyeX = rightEyeX,
+                rightEyeY = rightEyeY,
+                rightEyeZ = rightEyeZ,
+                widthHalfAngle = widthHalfAngle,
+                heightHalfAngle = heightHalfAngle,
+            };
+            if (!SetRuntimeConfig(config))
+            {
+                return false;
+            }
             Debug.Log($"{PluginMetadata.DebugLogPrefix}Sent single pass instanced camera parameters to native plugin.");
             return true;
         }
 
+        /// <summary>
+        /// Layout version of RuntimeConfig. Must match MetaViewRuntimeConfigVersion in Providers/RuntimeConfig.h.
+        /// </summary>
+        private const uint RuntimeConfigVersion = 2;
+
+        /// <summary>
+        /// Which parts of a RuntimeConfig to apply.
+        /// </summary>
+        [Flags]
+        public enum RuntimeConfigFields : uint
+        {
+            None = 0,
+            /// <summary>ipd</summary>
+            Ipd = 1 << 0,
+            /// <summary>leftEyeX to rightEyeZ</summary>
+            EyePositions = 1 << 1,
+            /// <summary>widthHalfAngle and heightHalfAngle</summary>
+            Fov = 1 << 2,
+            /// <summary>singleCameraLeft to singleCameraBottom</summary>
+            SingleCameraFov = 1 << 3,
+            /// <summary>mirrorViewMode</summary>
+            MirrorViewMode = 1 << 4,
+            /// <summary>rotateEyes</summary>
+            RotateEyes = 1 << 5,
+            /// <summary>lensCenterX to lensExponent</summary>
+            LensContour = 1 << 6,
+            All = Ipd | EyePositions | Fov | SingleCameraFov | MirrorViewMode | RotateEyes | LensContour,
+        }
+
+        /// <summary>
+        /// Everything that can be configured at runtime, set with one call to SetRuntimeConfig or
+        /// WriteSharedRuntimeConfig. Must match MetaViewRuntimeConfig in Providers/RuntimeConfig.h.
+        /// </summary>
+        [StructLayout(LayoutKind.Sequential)]
+        public struct RuntimeConfig
+        {
+            /// <summary>Filled in by the loader.</summary>
+            public uint version;
+            /// <summary>Filled in by the loader.</summary>
+            public uint sequence;
+            /// <summary>Which of the fields below to apply.</summary>
+            public RuntimeConfigFields fields;
+            public float ipd;
+            public float leftEyeX, leftEyeY, leftEyeZ;
+            public float rightEyeX, rightEyeY, rightEyeZ;
+            /// <summary>Tangents of the half field of view, for both eyes.</summary>
+            public float widthHalfAngle, heightHalfAngle;
+            /// <summary>Tangents of the frustum extents in single camera mode, as in SetupForSingleCamera.</summary>
+            public float singleCameraLeft, singleCameraRight, singleCameraTop, singleCameraBottom;
+            public ushort mirrorViewMode;
+            public ushort rotateEyes;
+            /// <summary>
+            /// The part of the left eye's view the lens shows, mirrored for the right eye: a superellipse in the same
+            /// tangent space as the field of view, 2 as the exponent for an ellipse. Everything outside it is left
+            /// unshaded. Zero radii to shade the whole view.
+            /// </summary>
+            public float lensCenterX, lensCenterY;
+            public float lensRadiusX, lensRadiusY;
+            public float lensExponent;
+        }
+
+        /// <summary>
+        /// Apply the chosen fields of a configuration in one call. The camera parameters change together,
+        /// from the next frame on.
+        /// </summary>
+        /// <returns>false if the native plugin doesn't understand this configuration</returns>
+        public bool SetRuntimeConfig(RuntimeConfig config)
+        {
+            config.version = RuntimeConfigVersion;
+            return SetRuntimeConfigNative(ref config) != 0;
+        }
+
+        private IntPtr sharedRuntimeConfig = IntPtr.Zero;
+        private uint sharedRuntimeConfigSequence = 0;
+
+        /// <summary>
+        /// Like SetRuntimeConfig, but through memory shared with the native plugin, which picks the change up
+        /// at the start of its next frame. No call into native code after the first, so cheap enough to use
+        /// every frame.
+        /// </summary>
+        public void WriteSharedRuntimeConfig(RuntimeConfig config)
+        {
+            int size = Marshal.SizeOf(typeof(RuntimeConfig));
+            int sequenceOffset = Marshal.OffsetOf(typeof(RuntimeConfig), "sequence").ToInt32();
+            if (sharedRuntimeConfig == IntPtr.Zero)
+            {
+                sharedRuntimeConfig = Marshal.AllocHGlobal(size);
+                Marshal.StructureToPtr(new RuntimeConfig(), sharedRuntimeConfig, false);
+                sharedRuntimeConfigSequence = 0;
+                SetSharedRuntimeConfigNative(sharedRuntimeConfig);
+            }
+
+            // Odd while writing, so the plugin never applies half of a change
+            config.version = RuntimeConfigVersion;
+            config.sequence = ++sharedRuntimeConfigSequence;
+            Marshal.WriteInt32(sharedRuntimeConfig, sequenceOffset, (int)config.sequence);
+            System.Threading.Thread.MemoryBarrier();
+            Marshal.StructureToPtr(config, sharedRuntimeConfig, false);
+            System.Threading.Thread.MemoryBarrier();
+            Marshal.WriteInt32(sharedRuntimeConfig, sequenceOffset, (int)++sharedRuntimeConfigSequence);
+        }
+
+        /// <summary>
+        /// Stop sharing memory with the native plugin for WriteSharedRuntimeConfig, and free it.
+        /// </summary>
+        public void ReleaseSharedRuntimeConfig()
+        {
+            if (sharedRuntimeConfig == IntPtr.Zero)
+            {
+                return;
+            }
+            // Returns once the plugin no longer reads it
+            SetSharedRuntimeConfigNative(IntPtr.Zero);
+            Marshal.FreeHGlobal(sharedRuntimeConfig);
+            sharedRuntimeConfig = IntPtr.Zero;
+        }
+
+        /// <summary>
+        /// Set how long before the target vblank the native renderer starts each frame.
+        /// </summary>
+        public void SetFramePacingRunningStart(float milliseconds)
+        {
+            SetFramePacingRunningStartNative(milliseconds);
+        }
+
+        /// <summary>
+        /// Choose whether the native renderer schedules scanouts on its own thread rather than the graphics thread.
+        /// </summary>
+        public void SetUsePresentThread(bool enable)
+        {
+            SetUsePresentThreadNative((ushort)(enable ? 1 : 0));
+        }
+
+        /// <summary>
+        /// Choose whether Unity may render straight into the native scanout surfaces, skipping the per-frame copy, when the configuration allows it.
+        /// </summary>
+        public void SetAllowZeroCopySubmission(bool allow)
+        {
+            SetAllowZeroCopySubmissionNative((ushort)(allow ? 1 : 0));
+        }
+
+        /// <summary>
+        /// Set the video memory budget for eye textures. The eye texture resolution is lowered to fit. 0 means unlimited.
+        /// </summary>
+        public void SetEyeTextureBudget(float megabytes)
+        {
+            SetEyeTextureBudgetNative(megabytes);
+        }
+
+        /// <summary>
+        /// Set how much video memory unused eye textures may keep, so they can be reused when the resolution scale changes back.
+        /// </summary>
+        public void SetEyeTexturePoolCapacity(float megabytes)
+        {
+            SetEyeTexturePoolCapacityNative(megabytes);
+        }
+
+        /// <summary>
+        /// Let the native plugin pick the eye render scale from measured GPU frame time.
+        /// </summary>
+        /// <param name="targetFraction">Fraction of the frame budget GPU time should settle at, e.g. 0.85</param>
+        /// <param name="minScale">Lowest render scale to use</param>
+        public void SetDynamicResolution(bool enable, float targetFraction, float minScale)
+        {
+            SetDynamicResolutionNative((ushort)(enable ? 1 : 0), targetFraction, minScale);
+        }
+
+        /// <summary>
+        /// Set how many display surfaces to cycle through: 2 for the lowest latency, 3 so heavy
+        /// frames can overlap scanout, or 0 to switch between them based on measured load.
+        /// </summary>
+        public void SetSwapchainDepth(uint depth)
+        {
+            SetSwapchainDepthNative(depth);
+        }
+
+        /// <summary>
+        /// Choose whether each refresh reprojects the newest finished frame to the latest head orientation,
+        /// so frames that miss a refresh are warped rather than repeated.
+        /// </summary>
+        public void SetTimewarpEnabled(bool enable)
+        {
+            SetTimewarpEnabledNative((ushort)(enable ? 1 : 0));
+        }
+
+        /// <summary>
+        /// Choose whether timewarp also corrects head translation, using the depth buffer.
+        /// Needs depth to be rendered; content without depth is treated as far away.
+        /// </summary>
+        public void SetTimewarpPositional(bool enable)
+        {
+            SetTimewarpPositionalNative((ushort)(enable ? 1 : 0));
+        }
+
+        /// <summary>
+        /// Choose whether the head pose is sampled again just before each frame is submitted, with the eye images
+        /// rotated to match. Cuts latency when timewarp is off, at the cost of an extra copy.
+        /// </summary>
+        public void SetLateLatchEnabled(bool enable)
+        {
+            SetLateLatchEnabledNative((ushort)(enable ? 1 : 0));
+        }
+
+        /// <summary>
+        /// Set how many refreshes each rendered frame lasts: 1 to render at the display rate, 2 to render at
+        /// half rate with reprojected frames in between, or 0 to switch between them based on dropped frames.
+        /// </summary>
+        public void SetFrameInterval(uint vblanks)
+        {
+            SetFrameIntervalNative(vblanks);
+        }
+
+        /// <summary>
+        /// How tracked poses are predicted to the time the frame reaches the display.
+        /// </summary>
+        public enum PosePrediction : uint
+        {
+            /// <summary>No prediction: the latest pose is used.</summary>
+            None = 0,
+            /// <summary>Constant-acceleration Kalman filter, using the reported velocities.</summary>
+            Kalman = 1,
+            /// <summary>Double exponential smoothing of the poses alone.</summary>
+            DoubleExponential = 2,
+        }
+
+        /// <summary>
+        /// Choose how tracked poses are predicted to the time the frame reaches the display.
+        /// </summary>
+        public void SetPosePrediction(PosePrediction method)
+        {
+            SetPosePredictionMethodNative((uint)method);
+        }
+
+        /// <summary>
+        /// Start recording every pose delivered to Unity, with the times they were asked for and the frame
+        /// indices, to a file. Replaces the file if it exists.
+        /// </summary>
+        /// <returns>false if the file couldn't be created</returns>
+        public bool StartTrackingRecording(string path)
+        {
+            return StartTrackingRecordingNative(path) != 0;
+        }
+
+        /// <summary>
+        /// Finish writing the tracking recording.
+        /// </summary>
+        public void StopTrackingRecording()
+        {
+            StopTrackingRecordingNative();
+        }
+
+        /// <summary>
+        /// Drive tracking from a recording made with StartTrackingRecording instead of the tracker, at the speed
+        /// it was recorded.
+        /// </summary>
+        /// <returns>false if the file isn't a tracking recording</returns>
+        public bool StartTrackingReplay(string path, bool loop)
+        {
+            return StartTrackingReplayNative(path, (ushort)(loop ? 1 : 0)) != 0;
+        }
+
+        /// <summary>
+        /// Go back to the tracker after StartTrackingReplay.
+        /// </summary>
+        public void StopTrackingReplay()
+        {
+            StopTrackingReplayNative();
+        }
+
+        /// <summary>
+        /// What GetGpuTimingStats can report on.
+        /// </summary>
+        public enum GpuTimingScope : uint
+        {
+            /// <summary>The whole frame, from setup to present.</summary>
+            Frame = 0,
+            /// <summary>Copying eye textures to the display surface.</summary>
+            Blit = 1,
+            /// <summary>Presenting the frame.</summary>
+            EndFrame = 2,
+        }
+
+        /// <summary>
+        /// Get GPU time statistics over the last couple of seconds of frames.
+        /// </summary>
+        /// <returns>false if nothing was measured yet</returns>
+        public bool GetGpuTimingStats(GpuTimingScope scope, out float minMs, out float avgMs, out float p99Ms)
+        {
+            return GetGpuTimingStatsNative((uint)scope, out minMs, out avgMs, out p99Ms) != 0;
+        }
+
         private static void CleanupTick()
         {
             RegisterTickCallback(null);
@@ -394,6 +712,63 @@ namespace Unity.XR.MetaView
         [DllImport(PluginMetadata.PluginDllName, CharSet = CharSet.Auto)]
         private static extern void SetParamsForSinglePassInstancedCameraFOV(float widthHalfAngle, float heightHalfAngle);
 
+        [DllImport(PluginMetadata.PluginDllName, CharSet = CharSet.Auto, EntryPoint = "SetRuntimeConfig")]
+        private static extern ushort SetRuntimeConfigNative(ref RuntimeConfig config);
+
+        [DllImport(PluginMetadata.PluginDllName, CharSet = CharSet.Auto, EntryPoint = "SetSharedRuntimeConfig")]
+        private static extern void SetSharedRuntimeConfigNative(IntPtr block);
+
+        [DllImport(PluginMetadata.PluginDllName, CharSet = CharSet.Auto, EntryPoint = "SetFramePacingRunningStart")]
+        private static extern void SetFramePacingRunningStartNative(float milliseconds);
+
+        [DllImport(PluginMetadata.PluginDllName, CharSet = CharSet.Auto, EntryPoint = "SetUsePresentThread")]
+        private static extern void SetUsePresentThreadNative(ushort enable);
+
+        [DllImport(PluginMetadata.PluginDllName, CharSet = CharSet.Auto, EntryPoint = "SetAllowZeroCopySubmission")]
+        private static extern void SetAllowZeroCopySubmissionNative(ushort allow);
+
+        [DllImport(PluginMetadata.PluginDllName, CharSet = CharSet.Auto, EntryPoint = "SetEyeTextureBudget")]
+        private static extern void SetEyeTextureBudgetNative(float megabytes);
+
+        [DllImport(PluginMetadata.PluginDllName, CharSet = CharSet.Auto, EntryPoint = "SetEyeTexturePoolCapacity")]
+        private static extern void SetEyeTexturePoolCapacityNative(float megabytes);
+
+        [DllImport(PluginMetadata.PluginDllName, CharSet = CharSet.Auto, EntryPoint = "SetDynamicResolution")]
+        private static extern void SetDynamicResolutionNative(ushort enable, float targetFraction, float minScale);
+
+        [DllImport(PluginMetadata.PluginDllName, CharSet = CharSet.Auto, EntryPoint = "SetSwapchainDepth")]
+        private static extern void SetSwapchainDepthNative(uint depth);
+
+        [DllImport(PluginMetadata.PluginDllName, CharSet = CharSet.Auto, EntryPoint = "SetTimewarpEnabled")]
+        private static extern void SetTimewarpEnabledNative(ushort enable);
+
+        [DllImport(PluginMetadata.PluginDllName, CharSet = CharSet.Auto, EntryPoint = "SetTimewarpPositional")]
+        private static extern void SetTimewarpPositionalNative(ushort enable);
+
+        [DllImport(PluginMetadata.PluginDllName, CharSet = CharSet.Auto, EntryPoint = "SetLateLatchEnabled")]
+        private static extern void SetLateLatchEnabledNative(ushort enable);
+
+        [DllImport(PluginMetadata.PluginDllName, CharSet = CharSet.Auto, EntryPoint = "SetFrameInterval")]
+        private static extern void SetFrameIntervalNative(uint vblanks);
+
+        [DllImport(PluginMetadata.PluginDllName, CharSet = CharSet.Auto, EntryPoint = "SetPosePredictionMethod")]
+        private static extern void SetPosePredictionMethodNative(uint method);
+
+        [DllImport(PluginMetadata.PluginDllName, CharSet = CharSet.Ansi, EntryPoint = "StartTrackingRecording")]
+        private static extern ushort StartTrackingRecordingNative(string path);
+
+        [DllImport(PluginMetadata.PluginDllName, CharSet = CharSet.Auto, EntryPoint = "StopTrackingRecording")]
+        private static extern void StopTrackingRecordingNative();
+
+        [DllImport(PluginMetadata.PluginDllName, CharSet = CharSet.Ansi, EntryPoint = "StartTrackingReplay")]
+        private static extern ushort StartTrackingReplayNative(string path, ushort loop);
+
+        [DllImport(PluginMetadata.PluginDllName, CharSet = CharSet.Auto, EntryPoint = "StopTrackingReplay")]
+        private static extern void StopTrackingReplayNative();
+
+        [DllImport(PluginMetadata.PluginDllName, CharSet = CharSet.Auto, EntryPoint = "GetGpuTimingStats")]
+        private static extern ushort GetGpuTimingStatsNative(uint scope, out float minMs, out float avgMs, out float p99Ms);
+
         [DllImport(PluginMetadata.PluginDllName, CharSet = CharSet.Auto)]
         static extern void RegisterTickCallback([MarshalAs(UnmanagedType.FunctionPtr)] TickCallbackDelegate callbackPointer);
 
@@ -0,0 +1,182 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+//
+// Micro-benchmark of converting device and eye poses for Unity: the matrix
+// round trip the input provider used to make (quaternion to matrix, 4x4
+// multiply by the eye transform, matrix to quaternion) against
+// metaview::transformPoses, scalar and SIMD. Fails if their rotations
+// disagree, or if the SIMD positions disagree with the scalar ones. The old
+// path's positions were wrong (see tests/PoseKernelTest), so are only
+// reported.
+//
+// Usage: PoseKernelBenchmark [poses per batch [iterations]]
+
+#include "Model/PoseKernel.h"
+#include "ProviderInterface/XRMath.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace metaview;
+
+//! Two update types of an HMD (device and eyes) and a few other devices.
+static constexpr size_t DefaultBatch = 2 * (3 + 5);
+static constexpr size_t DefaultIterations = 2'000'000;
+
+//! 1 - |dot| of two orientations: about a tenth of a degree
+static constexpr float RotationTolerance = 1e-6f;
+//! A few ULPs of a position a few metres out
+static constexpr float PositionTolerance = 1e-6f;
+
+// InternalToUnityTracking as it was, minus the velocities: its quatToMatrix
+// is XRMath's QuaternionToMatrix, and the rest were XRMath calls already.
+static void oldInternalToUnityTracking(Posef const& pose,
+                                       XRMatrix4x4 const* postTransform,
+                                       XRVector3& outPosition,
+                                       XRQuaternion& outRotation) {
+    XRMatrix4x4 trackingToReference;
+    QuaternionToMatrix(XRQuaternion(pose.orientation.x, pose.orientation.y,
+                                    pose.orientation.z, pose.orientation.w),
+                       trackingToReference);
+    trackingToReference.SetCol(
+        3, XRVector4(pose.position.x, pose.position.y, pose.position.z, 1));
+    if (postTransform) {
+        trackingToReference *= *postTransform;
+    }
+    outPosition = trackingToReference.Translation();
+    MatrixToQuaternion(trackingToReference, outRotation);
+    outRotation.w *= -1;
+}
+
+// The eye transforms the old path multiplied by
+static XRMatrix4x4 makeTranslation(Vec3f const& offset) {
+    XRMatrix4x4 ret = XRMatrix4x4::identity;
+    ret.SetCol(3, XRVector4(offset.x, offset.y, offset.z, 1.f));
+    return ret;
+}
+
+// The old path's results, in the kernel's convention
+static void matrixRoundTrip(Posef const& pose, XRMatrix4x4 const& eye,
+                            Posef& out) {
+    XRVector3 position;
+    XRQuaternion rotation;
+    oldInternalToUnityTracking(pose, &eye, position, rotation);
+    out.orientation = {rotation.x, rotation.y, rotation.z, -rotation.w};
+    out.position = {position.x, position.y, position.z};
+}
+
+template <typename F>
+static double timeNsPerPose(size_t batch, size_t iterations, F&& f) {
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        f();
+    }
+    const double seconds = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+    return seconds * 1e9 / (static_cast<double>(batch) * iterations);
+}
+
+static float rotationError(Quatf const& a, Quatf const& b) {
+    // q and -q are the same rotation
+    return 1.f - std::abs(dot(a, b));
+}
+
+static float positionError(Vec3f const& a, Vec3f const& b) {
+    const Vec3f d = a - b;
+    return std::sqrt(dot(d, d));
+}
+
+int main(int argc, char* argv[]) {
+    const size_t batch =
+        argc > 1 ? std::strtoul(argv[1], nullptr, 10) : DefaultBatch;
+    const size_t iterations =
+        argc > 2 ? std::strtoul(argv[2], nullptr, 10) : DefaultIterations;
+    if (batch == 0 || iterations == 0) {
+        std::cerr << "Usage: " << argv[0]
+                  << " [poses per batch [iterations]]" << std::endl;
+        return 1;
+    }
+
+    std::mt19937 rng(20200101);
+    std::uniform_real_distribution<float> unit(-1.f, 1.f);
+    std::vector<Posef> poses(batch);
+    std::vector<Vec3f> offsets(batch);
+    std::vector<XRMatrix4x4> eyes(batch);
+    for (size_t i = 0; i < batch; ++i) {
+        poses[i].orientation =
+            normalize({unit(rng), unit(rng), unit(rng), unit(rng)});
+        poses[i].position = {unit(rng), 1.6f + unit(rng), unit(rng)};
+        // Eyes are about 32 mm either side of the head
+        offsets[i] = {0.032f * unit(rng), 0.f, 0.f};
+        eyes[i] = makeTranslation(offsets[i]);
+    }
+
+    std::vector<Posef> matrix(batch), scalar(batch), simd(batch);
+    volatile float sink = 0;
+    const double matrixNs = timeNsPerPose(batch, iterations, [&] {
+        for (size_t i = 0; i < batch; ++i) {
+            matrixRoundTrip(poses[i], eyes[i], matrix[i]);
+        }
+        sink = sink + matrix[0].orientation.w;
+    });
+    const double scalarNs = timeNsPerPose(batch, iterations, [&] {
+        transformPosesScalar(poses.data(), offsets.data(), scalar.data(),
+                             batch);
+        sink = sink + scalar[0].orientation.w;
+    });
+    const double simdNs = timeNsPerPose(batch, iterations, [&] {
+        transformPoses(poses.data(), offsets.data(), simd.data(), batch);
+        sink = sink + simd[0].orientation.w;
+    });
+
+    float matrixRotationError = 0, matrixPositionError = 0,
+          simdRotationError = 0, simdPositionError = 0;
+    for (size_t i = 0; i < batch; ++i) {
+        matrixRotationError =
+            std::max(matrixRotationError,
+                     rotationError(matrix[i].orientation,
+                                   scalar[i].orientation));
+        matrixPositionError = std::max(
+            matrixPositionError,
+            positionError(matrix[i].position, scalar[i].position));
+        simdRotationError = std::max(
+            simdRotationError,
+            rotationError(simd[i].orientation, scalar[i].orientation));
+        simdPositionError = std::max(
+            simdPositionError,
+            positionError(simd[i].position, scalar[i].position));
+    }
+
+    std::cout << batch << " poses per batch, " << iterations
+              << " batches\n"
+              << "  matrix round trip: " << matrixNs << " ns per pose\n"
+              << "  scalar kernel:     " << scalarNs << " ns per pose\n"
+              << "  SIMD kernel:       " << simdNs << " ns per pose\n"
+              << "  max rotation error, matrix vs scalar: "
+              << matrixRotationError << "\n"
+              << "  max position change, matrix vs scalar: "
+              << matrixPositionError << " m (the old path's bug)\n"
+              << "  max rotation error, SIMD vs scalar: " << simdRotationError
+              << "\n"
+              << "  max position error, SIMD vs scalar: " << simdPositionError
+              << " m" << std::endl;
+
+    const bool agree = matrixRotationError <= RotationTolerance &&
+                       simdRotationError <= RotationTolerance &&
+                       simdPositionError <= PositionTolerance;
+    if (!agree) {
+        std::cerr << "FAILED: errors over " << RotationTolerance
+                  << " (rotation) or " << PositionTolerance << " m (position)"
+                  << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,115 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+//
+// Micro-benchmarks of the pose predictors, which run for every tracked device
+// on every input update and again for every frame's prediction. Builds
+// anywhere the model code does, Linux included. Their accuracy is covered by
+// tests/PosePredictorTest.
+//
+// Usage: PosePredictorBenchmark [seconds per benchmark]
+
+#include "Model/PosePredictor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace metaview;
+
+//! Samples cycled through, so results depend on the input.
+static constexpr size_t InputCount = 1024;
+
+static constexpr int64_t SamplePeriodNs = 1'000'000;
+static constexpr int64_t PredictionNs = 22'222'222;
+
+static volatile float sink;
+
+// Runs f for about the given time and reports like google-benchmark does
+static void runBenchmark(std::string const& name, double seconds,
+                         std::function<void(size_t)> const& f) {
+    using Clock = std::chrono::steady_clock;
+    size_t iterations = 1;
+    double elapsed = 0;
+    while (true) {
+        const auto start = Clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            f(i % InputCount);
+        }
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        if (elapsed >= seconds || iterations >= (size_t(1) << 32)) {
+            break;
+        }
+        // Aim past the target, so the next run is the last
+        const double scale =
+            elapsed > 0 ? std::min(1.4 * seconds / elapsed, 10.0) : 10.0;
+        iterations = static_cast<size_t>(iterations * scale) + 1;
+    }
+    std::cout << std::left << std::setw(32) << name << std::right
+              << std::setw(10) << std::fixed << std::setprecision(2)
+              << elapsed * 1e9 / iterations << " ns" << std::setw(14)
+              << iterations << std::endl;
+}
+
+// A second of head motion at 1 kHz: a slow turn and sway
+static std::vector<PoseSample> makeSamples() {
+    std::vector<PoseSample> ret(InputCount);
+    for (size_t i = 0; i < InputCount; ++i) {
+        const float s = static_cast<float>(i) * 1e-3f;
+        const float yaw = 0.5f * std::sin(1.5f * s);
+        PoseSample& sample = ret[i];
+        sample.pose.position = {0.05f * std::sin(3.f * s), 1.6f, 0.f};
+        sample.pose.orientation = fromAxisAngle({0.f, 1.f, 0.f}, yaw);
+        sample.linearVelocity = {0.15f * std::cos(3.f * s), 0.f, 0.f};
+        sample.angularVelocity = {0.f, 0.75f * std::cos(1.5f * s), 0.f};
+    }
+    return ret;
+}
+
+static void benchmarkPredictor(std::string const& name, PosePredictorType type,
+                               std::vector<PoseSample> const& samples,
+                               double seconds) {
+    std::unique_ptr<IPosePredictor> predictor = makePosePredictor(type);
+    // Sample times keep increasing across runs, or updates would be dropped.
+    int64_t timeNs = 0;
+    runBenchmark(name + "/update", seconds, [&](size_t i) {
+        PoseSample sample = samples[i];
+        sample.timeNs = timeNs += SamplePeriodNs;
+        predictor->update(sample);
+    });
+    runBenchmark(name + "/predict", seconds, [&](size_t i) {
+        PoseSample out;
+        predictor->predict(timeNs + PredictionNs - static_cast<int64_t>(i),
+                           out);
+        sink = out.pose.orientation.w;
+    });
+}
+
+int main(int argc, char* argv[]) {
+    const double seconds = argc > 1 ? std::atof(argv[1]) : 0.2;
+    if (seconds <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [seconds per benchmark]"
+                  << std::endl;
+        return 1;
+    }
+    const std::vector<PoseSample> samples = makeSamples();
+
+    std::cout << std::left << std::setw(32) << "Benchmark" << std::right
+              << std::setw(13) << "Time" << std::setw(14) << "Iterations"
+              << "\n"
+              << std::string(59, '-') << std::endl;
+    benchmarkPredictor("Kalman", PosePredictorType::ConstantAccelerationKalman,
+                       samples, seconds);
+    benchmarkPredictor("DoubleExponential",
+                       PosePredictorType::DoubleExponential, samples, seconds);
+    return 0;
+}
@@ -0,0 +1,150 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+//
+// Headless benchmark of the input path: replays a tracking recording through
+// the same steps the input provider takes each frame (pose history, predictor,
+// time queries) on a simulated clock, as fast as possible.
+//
+// Usage: ReplayBenchmark [recording [predictor]]
+// Without a recording, makes a synthetic one first. predictor is a
+// metaview::PosePredictorType value.
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "Model/PosePredictor.h"
+#include "Model/SimulatedVsync.h"
+#include "Model/TrackingRecording.h"
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+using namespace metaview;
+
+static constexpr int64_t FramePeriodNs = 11'111'111;
+//! How far ahead of the newest pose frames are predicted.
+static constexpr int64_t PredictionNs = 2 * FramePeriodNs;
+static constexpr uint32_t MaxDevices = 16;
+
+static constexpr int64_t SyntheticPeriodNs = 1'000'000;
+static constexpr int64_t SyntheticDurationNs = 60'000'000'000;
+
+static void writeSyntheticRecording(std::string const& path) {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        throw std::runtime_error("Could not create " + path);
+    }
+    tracking_recording::Header header = {};
+    header.magic = tracking_recording::Magic;
+    header.version = tracking_recording::Version;
+    header.recordSize = sizeof(tracking_recording::Record);
+    std::fwrite(&header, sizeof(header), 1, file);
+    for (int64_t t = 0; t < SyntheticDurationNs; t += SyntheticPeriodNs) {
+        const float s = static_cast<float>(t) * 1e-9f;
+        const float yaw = 0.5f * std::sin(1.5f * s);
+        tracking_recording::Record record = {};
+        record.type = tracking_recording::RecordType::Pose;
+        record.updateType = tracking_recording::UpdateTypeBeforeRender;
+        record.recordedNs = t;
+        record.timeNs = t;
+        record.position[0] = 0.05f * std::sin(3.f * s);
+        record.position[1] = 1.6f;
+        record.orientation[1] = std::sin(yaw / 2);
+        record.orientation[3] = std::cos(yaw / 2);
+        record.linearVelocity[0] = 0.15f * std::cos(3.f * s);
+        record.angularVelocity[1] = 0.75f * std::cos(1.5f * s);
+        std::fwrite(&record, sizeof(record), 1, file);
+    }
+    std::fclose(file);
+}
+
+int main(int argc, char* argv[]) {
+    std::string path = argc > 1 ? argv[1] : "";
+    const auto type = static_cast<PosePredictorType>(
+        argc > 2 ? std::atoi(argv[2])
+                 : static_cast<int>(
+                       PosePredictorType::ConstantAccelerationKalman));
+    try {
+        if (path.empty()) {
+            path = "synthetic.mvtrack";
+            writeSyntheticRecording(path);
+        }
+        auto recording = std::make_shared<TrackingRecording const>(path);
+        SimulatedClock clock;
+        ReplayTrackingSource source(recording, clock);
+
+        struct Device {
+            PoseHistory history;
+            std::unique_ptr<IPosePredictor> predictor;
+        };
+        std::array<Device, MaxDevices> devices;
+        for (auto& device : devices) {
+            device.predictor = makePosePredictor(type);
+        }
+
+        std::array<TrackedSample, 64> samples;
+        uint64_t sampleCount = 0;
+        uint64_t frameCount = 0;
+        // Sum of predicted positions, to check runs are identical
+        double checksum = 0;
+        const auto start = std::chrono::steady_clock::now();
+        while (source.isConnected()) {
+            clock.advance(FramePeriodNs);
+            size_t count = 0;
+            do {
+                count = source.read(samples.data(), samples.size());
+                for (size_t i = 0; i < count; ++i) {
+                    if (samples[i].device >= MaxDevices) {
+                        continue;
+                    }
+                    Device& device = devices[samples[i].device];
+                    device.history.push(samples[i].sample);
+                    if (device.predictor) {
+                        device.predictor->update(samples[i].sample);
+                    }
+                }
+                sampleCount += count;
+            } while (count == samples.size());
+
+            const int64_t now = clock.now();
+            for (auto& device : devices) {
+                PoseSample pose;
+                // What TryGetDeviceStateAtTime would look up
+                if (!device.history.sample(now - FramePeriodNs, pose)) {
+                    continue;
+                }
+                if (device.predictor &&
+                    device.predictor->predict(now + PredictionNs, pose)) {
+                    checksum += pose.pose.position.x;
+                }
+            }
+            ++frameCount;
+        }
+        const double seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                          start)
+                .count();
+        if (sampleCount == 0) {
+            std::cerr << "No poses to replay in " << path << std::endl;
+            return 1;
+        }
+
+        std::cout << "Replayed " << sampleCount << " samples over "
+                  << frameCount << " frames in " << seconds * 1e3 << " ms\n"
+                  << "  " << seconds * 1e9 / frameCount << " ns per frame, "
+                  << seconds * 1e9 / sampleCount << " ns per sample\n"
+                  << "  checksum " << checksum << std::endl;
+    } catch (std::exception const& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,67 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+//
+// Reference external tracker: publishes a synthetic head pose at 1 kHz
+// through shared memory, for the plugin's SharedTrackingSource to read.
+// A real tracker process writes its poses the same way.
+
+#include "Model/Clock.h"
+#include "Model/SharedMemoryTracking.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+using namespace metaview;
+
+static constexpr int64_t PeriodNs = 1'000'000;
+static constexpr float Pi = 3.14159265f;
+//! Head turn, left and right.
+static constexpr float YawAmplitude = 0.5f;
+static constexpr float YawFrequencyHz = 0.25f;
+//! Side to side sway, in meters.
+static constexpr float SwayAmplitude = 0.05f;
+static constexpr float SwayFrequencyHz = 0.5f;
+static constexpr float EyeHeight = 1.6f;
+
+int main(int argc, char* argv[]) {
+    // Optional duration in seconds; runs until killed otherwise
+    const double duration = argc > 1 ? std::atof(argv[1]) : 0.0;
+
+    SharedTrackingWriter writer;
+    std::cout << "Publishing to \"" << DefaultSharedTrackingName << "\""
+              << std::endl;
+
+    auto& clock = SteadyClock::instance();
+    const int64_t start = clock.now();
+    int64_t wake = start;
+    for (;;) {
+        const int64_t now = clock.now();
+        const float t = static_cast<float>(now - start) * 1e-9f;
+        if (duration > 0 && t > duration) {
+            break;
+        }
+        const float yawPhase = 2 * Pi * YawFrequencyHz * t;
+        const float swayPhase = 2 * Pi * SwayFrequencyHz * t;
+
+        TrackedSample tracked;
+        tracked.device = 0;
+        PoseSample& s = tracked.sample;
+        s.timeNs = now;
+        s.pose.orientation =
+            fromAxisAngle({0, 1, 0}, YawAmplitude * std::sin(yawPhase));
+        s.pose.position = {SwayAmplitude * std::sin(swayPhase), EyeHeight, 0};
+        s.linearVelocity = {SwayAmplitude * 2 * Pi * SwayFrequencyHz *
+                                std::cos(swayPhase),
+                            0, 0};
+        s.angularVelocity = {
+            0, YawAmplitude * 2 * Pi * YawFrequencyHz * std::cos(yawPhase), 0};
+        writer.write(tracked);
+
+        wake += PeriodNs;
+        clock.sleepUntil(wake);
+    }
+    return 0;
+}
@@ -0,0 +1,139 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+//
+// Micro-benchmarks of the XRMath operations on the per-frame path. Builds
+// anywhere XRMath does, Linux included. That the SIMD paths agree with the
+// scalar code they replace is covered by tests/XRMathTest.
+//
+// Usage: XRMathBenchmark [seconds per benchmark]
+
+#include "ProviderInterface/XRMath.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+//! Matrices and quaternions cycled through, so results depend on the input.
+static constexpr size_t InputCount = 256;
+
+static volatile float sink;
+
+// The scalar multiply XRMatrix4x4 used before its SIMD path
+static void referenceMultiply(XRMatrix4x4 const& a, XRMatrix4x4 const& b,
+                              XRMatrix4x4& out) {
+    for (int col = 0; col < 4; ++col) {
+        for (int row = 0; row < 4; ++row) {
+            out.m[row][col] = XRVector4::Dot(a.GetRow(row), b.GetCol(col));
+        }
+    }
+}
+
+static XRMatrix4x4 randomMatrix(std::mt19937& rng) {
+    std::uniform_real_distribution<float> unit(-1.f, 1.f);
+    XRMatrix4x4 m;
+    for (int r = 0; r < 4; ++r) {
+        for (int c = 0; c < 4; ++c) {
+            m.m[r][c] = unit(rng);
+        }
+        // Diagonally dominant, so well conditioned
+        m.m[r][r] += 4.f;
+    }
+    return m;
+}
+
+static XRQuaternion randomRotation(std::mt19937& rng) {
+    std::uniform_real_distribution<float> unit(-1.f, 1.f);
+    return Normalize(XRQuaternion(unit(rng), unit(rng), unit(rng), unit(rng)));
+}
+
+// Runs f for about the given time and reports like google-benchmark does
+static void runBenchmark(std::string const& name, double seconds,
+                         std::function<void(size_t)> const& f) {
+    using Clock = std::chrono::steady_clock;
+    size_t iterations = 1;
+    double elapsed = 0;
+    while (true) {
+        const auto start = Clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            f(i % InputCount);
+        }
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        if (elapsed >= seconds || iterations >= (size_t(1) << 32)) {
+            break;
+        }
+        // Aim past the target, so the next run is the last
+        const double scale =
+            elapsed > 0 ? std::min(1.4 * seconds / elapsed, 10.0) : 10.0;
+        iterations = static_cast<size_t>(iterations * scale) + 1;
+    }
+    std::cout << std::left << std::setw(32) << name << std::right
+              << std::setw(10) << std::fixed << std::setprecision(2)
+              << elapsed * 1e9 / iterations << " ns" << std::setw(14)
+              << iterations << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    const double seconds = argc > 1 ? std::atof(argv[1]) : 0.2;
+    if (seconds <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [seconds per benchmark]"
+                  << std::endl;
+        return 1;
+    }
+
+    std::mt19937 rng(20200101);
+    std::vector<XRMatrix4x4> matrices(InputCount + 1);
+    std::vector<XRQuaternion> rotations(InputCount + 1);
+    std::vector<XRMatrix4x4> rotationMatrices(InputCount);
+    for (size_t i = 0; i <= InputCount; ++i) {
+        matrices[i] = randomMatrix(rng);
+        rotations[i] = randomRotation(rng);
+    }
+    for (size_t i = 0; i < InputCount; ++i) {
+        XRQuaternion const& q = rotations[i];
+        XRMatrix4x4& m = rotationMatrices[i];
+        m = XRMatrix4x4::identity;
+        m.m[0][0] = 1 - 2 * (q.y * q.y + q.z * q.z);
+        m.m[0][1] = 2 * (q.x * q.y + q.w * q.z);
+        m.m[0][2] = 2 * (q.x * q.z - q.w * q.y);
+        m.m[1][0] = 2 * (q.x * q.y - q.w * q.z);
+        m.m[1][1] = 1 - 2 * (q.x * q.x + q.z * q.z);
+        m.m[1][2] = 2 * (q.y * q.z + q.w * q.x);
+        m.m[2][0] = 2 * (q.x * q.z + q.w * q.y);
+        m.m[2][1] = 2 * (q.y * q.z - q.w * q.x);
+        m.m[2][2] = 1 - 2 * (q.x * q.x + q.y * q.y);
+    }
+
+    std::cout << std::left << std::setw(32) << "Benchmark" << std::right
+              << std::setw(13) << "Time" << std::setw(14) << "Iterations"
+              << "\n"
+              << std::string(59, '-') << std::endl;
+    runBenchmark("MultiplyMatrices4x4/reference", seconds, [&](size_t i) {
+        XRMatrix4x4 out;
+        referenceMultiply(matrices[i], matrices[i + 1], out);
+        sink = out.m[3][3];
+    });
+    runBenchmark("MultiplyMatrices4x4", seconds, [&](size_t i) {
+        sink = (matrices[i] * matrices[i + 1]).m[3][3];
+    });
+    runBenchmark("QuaternionMultiplyAssign", seconds, [&](size_t i) {
+        XRQuaternion q = rotations[i];
+        q *= rotations[i + 1];
+        sink = q.w;
+    });
+    runBenchmark("MatrixToQuaternion", seconds, [&](size_t i) {
+        XRQuaternion q;
+        MatrixToQuaternion(rotationMatrices[i], q);
+        sink = q.w;
+    });
+    runBenchmark("Determinant", seconds,
+                 [&](size_t i) { sink = Determinant(matrices[i]); });
+    return 0;
+}
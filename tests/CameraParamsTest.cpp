@@ -0,0 +1,166 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+/**
+ * @file
+ * @brief Checks that CameraParamBlock bumps the version only when an update
+ * changes something, then stresses its sequence locks: a writer sets every
+ * field to the same value, update after update, while the frame is latched
+ * and readers copy the latest and frame parameters, and no copy may mix
+ * fields of two updates.
+ */
+
+#include "TestCheck.h"
+
+#include "Providers/CameraParams.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using namespace metaview;
+
+/**
+ * @brief Set every field of @p params to @p value, the version aside.
+ */
+static void fill(CameraParams& params, uint32_t value) {
+    const float f = static_cast<float>(value);
+    params.ipd = f;
+    for (UnityXRVector3* v :
+         {&params.leftEyePosition, &params.rightEyePosition}) {
+        *v = {f, f, f};
+    }
+    for (UnityXRProjectionHalfAngles* fov :
+         {&params.leftFov, &params.rightFov, &params.singleCameraFov}) {
+        *fov = {f, f, f, f};
+    }
+    params.lensContour = {f, f, f, f, f};
+    params.mirrorViewMode = value;
+    params.rotateEyes = value;
+}
+
+/**
+ * @brief Whether every field of @p params holds the same value, and the
+ * version is one more, for the update before the first fill(): what fill()
+ * wrote, whole.
+ */
+static bool isWhole(CameraParams const& params) {
+    const uint32_t value = params.mirrorViewMode;
+    const float f = static_cast<float>(value);
+    bool same = params.version == value + 1 && params.rotateEyes == value &&
+                params.ipd == f;
+    for (UnityXRVector3 const& v :
+         {params.leftEyePosition, params.rightEyePosition}) {
+        same = same && v.x == f && v.y == f && v.z == f;
+    }
+    for (UnityXRProjectionHalfAngles const& fov :
+         {params.leftFov, params.rightFov, params.singleCameraFov}) {
+        same = same && fov.left == f && fov.right == f && fov.top == f &&
+               fov.bottom == f;
+    }
+    LensContour const& c = params.lensContour;
+    return same && c.centerX == f && c.centerY == f && c.radiusX == f &&
+           c.radiusY == f && c.exponent == f;
+}
+
+/**
+ * @brief Updates that leave the parameters as they were keep the version;
+ * any change bumps it once, however many fields it touches.
+ */
+static void testVersion() {
+    CameraParamBlock block;
+    MV_CHECK(block.GetLatest().version == 0);
+    MV_CHECK(block.GetFrame().version == 0);
+
+    block.Update([](CameraParams&) {});
+    MV_CHECK(block.GetLatest().version == 0);
+    const float ipd = block.GetLatest().ipd;
+    block.Update([&](CameraParams& params) { params.ipd = ipd; });
+    MV_CHECK(block.GetLatest().version == 0);
+
+    block.Update([](CameraParams& params) { params.ipd = 0.07f; });
+    MV_CHECK(block.GetLatest().version == 1);
+    MV_CHECK(block.GetLatest().ipd == 0.07f);
+    block.Update([](CameraParams& params) { fill(params, 5); });
+    MV_CHECK(block.GetLatest().version == 2);
+
+    // Changed and changed back within one update: no change
+    block.Update([](CameraParams& params) {
+        params.rotateEyes = 0;
+        params.rotateEyes = 5;
+    });
+    MV_CHECK(block.GetLatest().version == 2);
+
+    // Until latched, the frame is the latest
+    MV_CHECK(block.GetFrame().version == 2);
+    MV_CHECK(block.LatchFrame().version == 2);
+    block.Update([](CameraParams& params) { params.ipd = 0.06f; });
+    MV_CHECK(block.GetLatest().version == 3);
+    MV_CHECK(block.GetFrame().version == 2);
+    MV_CHECK(block.GetFrame().ipd == 5.f);
+}
+
+/**
+ * @brief A writer updating flat out, a latcher standing in for the graphics
+ * thread, and readers of both: every copy is whole, and versions never go
+ * back. A copy preempted midway is overwritten even on one core, often
+ * enough over this many updates to catch a reader that doesn't retry.
+ */
+static void testConcurrentReaders() {
+    constexpr uint32_t Count = 100'000;
+    constexpr int Readers = 3;
+    CameraParamBlock block;
+    block.Update([](CameraParams& params) { fill(params, 0); });
+    // Until then the frame is the latest, which may get ahead of what the
+    // first latch took
+    block.LatchFrame();
+    std::atomic<bool> done{false};
+
+    std::vector<uint64_t> torn(Readers, 0);
+    std::vector<uint64_t> backwards(Readers, 0);
+    std::vector<std::thread> readers;
+    for (int r = 0; r < Readers; ++r) {
+        readers.emplace_back([&, r] {
+            uint32_t latest = 0;
+            uint32_t frame = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                const CameraParams a = block.GetLatest();
+                const CameraParams b = block.GetFrame();
+                torn[r] += !isWhole(a) + !isWhole(b);
+                backwards[r] += (a.version < latest) + (b.version < frame);
+                latest = a.version;
+                frame = b.version;
+            }
+        });
+    }
+    std::thread latcher([&] {
+        while (!done.load(std::memory_order_relaxed)) {
+            block.LatchFrame();
+            std::this_thread::yield();
+        }
+    });
+    for (uint32_t i = 1; i <= Count; ++i) {
+        block.Update([i](CameraParams& params) { fill(params, i); });
+    }
+    done = true;
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+    latcher.join();
+    for (int r = 0; r < Readers; ++r) {
+        MV_CHECK(torn[r] == 0);
+        MV_CHECK(backwards[r] == 0);
+    }
+    const CameraParams last = block.GetLatest();
+    MV_CHECK(isWhole(last));
+    MV_CHECK(last.version == Count + 1);
+}
+
+int main() {
+    testVersion();
+    testConcurrentReaders();
+    return test::finish("CameraParamsTest");
+}
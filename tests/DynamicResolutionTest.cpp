@@ -0,0 +1,175 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+/**
+ * @file
+ * @brief Replays a GPU timing trace through DynamicResolutionController, in a
+ * closed loop, and checks when and how far it moves the scale.
+ */
+
+#include "TestCheck.h"
+
+#include "Model/DynamicResolution.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace metaview;
+
+static constexpr double Budget90 = 1000.0 / 90.0;
+
+/**
+ * @brief Load a trace: one GPU time per line, at full scale. Lines starting
+ * with '#' are comments.
+ */
+static std::vector<double> loadTrace(char const* path) {
+    std::vector<double> ret;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        ret.push_back(std::stod(line));
+    }
+    return ret;
+}
+
+/**
+ * @brief What happened on one frame of a replay.
+ */
+struct FrameResult {
+    //! Scale the frame was rendered at.
+    double scale;
+    //! Its GPU time at that scale.
+    double gpuMs;
+};
+
+/**
+ * @brief Feed the trace through the controller. Each frame's GPU time is the
+ * trace's full-scale time times the pixel fraction it was rendered at, so the
+ * controller sees the effect of its own choices.
+ */
+static std::vector<FrameResult> replay(DynamicResolutionController& controller,
+                                       std::vector<double> const& trace) {
+    std::vector<FrameResult> ret;
+    ret.reserve(trace.size());
+    double scale = controller.getScale();
+    for (double fullScaleMs : trace) {
+        const double gpuMs = fullScaleMs * scale * scale;
+        ret.push_back({scale, gpuMs});
+        scale = controller.update(gpuMs);
+    }
+    return ret;
+}
+
+static void testTraceReplay(std::vector<double> const& trace) {
+    MV_CHECK(trace.size() == 600);
+    if (trace.size() != 600) {
+        return;
+    }
+    DynamicResolutionController controller;
+    controller.setFrameBudget(Budget90);
+    const DynamicResolutionConfig config = controller.getConfig();
+    const std::vector<FrameResult> frames = replay(controller, trace);
+    const double target = controller.getTargetMs();
+
+    // Every frame within the configured range.
+    for (FrameResult const& f : frames) {
+        MV_CHECK(f.scale >= config.minScale && f.scale <= config.maxScale);
+    }
+
+    // Light scene: nothing to do, at most a brief dip for a spike.
+    for (size_t i = 0; i < 200; ++i) {
+        MV_CHECK(frames[i].scale >= 0.9);
+    }
+    MV_CHECK(frames[199].scale == config.maxScale);
+
+    // Heavy section: lowering happens within a few frames of the load
+    // arriving, as soon as the smoothed time leaves the deadband.
+    size_t firstDrop = 0;
+    for (size_t i = 200; i < 350 && firstDrop == 0; ++i) {
+        if (frames[i].scale < frames[i - 1].scale) {
+            firstDrop = i;
+        }
+    }
+    MV_CHECK(firstDrop >= 201 && firstDrop <= 205);
+
+    // It then settles around the target, and never lets a frame approach
+    // the budget for long.
+    double sum = 0;
+    size_t overBudget = 0;
+    for (size_t i = 260; i < 350; ++i) {
+        sum += frames[i].gpuMs;
+        if (frames[i].gpuMs > Budget90) {
+            ++overBudget;
+        }
+    }
+    MV_CHECK_NEAR(sum / 90, target, target * 0.08);
+    MV_CHECK(overBudget <= 3);
+    // sqrt(target / 14ms) is the scale that exactly fits.
+    MV_CHECK_NEAR(frames[349].scale, 0.82, 0.06);
+
+    // Raises only ever come after the configured run of frames with
+    // headroom since the last change.
+    size_t lastChange = 0;
+    for (size_t i = 1; i < frames.size(); ++i) {
+        if (frames[i].scale == frames[i - 1].scale) {
+            continue;
+        }
+        if (frames[i].scale > frames[i - 1].scale) {
+            MV_CHECK(i - lastChange >= config.raiseDelayFrames);
+        }
+        lastChange = i;
+    }
+
+    // Light again: back to full scale well before the end.
+    MV_CHECK(frames[450].scale == config.maxScale);
+    MV_CHECK(frames.back().scale == config.maxScale);
+}
+
+/**
+ * @brief A load the minimum scale can't fix pins the scale there rather than
+ * stopping short of it by less than the minimum step.
+ */
+static void testPinnedAtMinimum() {
+    DynamicResolutionController controller;
+    controller.setFrameBudget(Budget90);
+    std::vector<double> heavy(40, 60.0);
+    const std::vector<FrameResult> frames = replay(controller, heavy);
+    MV_CHECK(frames.back().scale == controller.getConfig().minScale);
+
+    controller.reset();
+    MV_CHECK(controller.getScale() == controller.getConfig().maxScale);
+    MV_CHECK(controller.getSmoothedGpuMs() == 0);
+}
+
+/**
+ * @brief Inside the deadband nothing moves, in either direction.
+ */
+static void testDeadband() {
+    DynamicResolutionController controller;
+    controller.setFrameBudget(Budget90);
+    const double target = controller.getTargetMs();
+    std::vector<double> steady(100, target * 1.03);
+    const std::vector<FrameResult> frames = replay(controller, steady);
+    for (FrameResult const& f : frames) {
+        MV_CHECK(f.scale == controller.getConfig().maxScale);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::fprintf(stderr, "Usage: %s <GPU timing trace>\n", argv[0]);
+        return 2;
+    }
+    testTraceReplay(loadTrace(argv[1]));
+    testPinnedAtMinimum();
+    testDeadband();
+    return test::finish("DynamicResolutionTest");
+}
@@ -0,0 +1,162 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+/**
+ * @file
+ * @brief Checks EyeTextureAllocator::Plan against layouts worked out by hand
+ * for each stereo rendering mode, then shrinks the budget step by step and
+ * checks every plan fits it, down to the minimum resolution scale.
+ */
+
+#include "TestCheck.h"
+
+#include "Providers/Display/EyeTextureAllocator.h"
+
+#include <cmath>
+#include <cstdint>
+
+using namespace metaview;
+
+//! Both eyes side by side
+static constexpr uint32_t DisplayWidth = 2880;
+static constexpr uint32_t DisplayHeight = 1600;
+static constexpr uint32_t Stages = 3;
+
+static constexpr EVRStereoRenderingModes Modes[] = {
+    EVRStereoRenderingModes::MultiPass,
+    EVRStereoRenderingModes::SinglePassInstanced,
+    EVRStereoRenderingModes::SingleCamera};
+
+/**
+ * @brief Each mode covers the same pixels, laid out its own way: a texture
+ * per eye, one array with a slice per eye, or one texture for the display.
+ */
+static void testModes() {
+    EyeTextureAllocator allocator;
+    // 1440 x 1600, color and depth
+    const uint64_t eyeBytes = 1440ull * 1600 * 8;
+
+    EyeTextureLayout layout = allocator.Plan(
+        EVRStereoRenderingModes::MultiPass, DisplayWidth, DisplayHeight, 1.f,
+        Stages);
+    MV_CHECK(layout.width == 1440 && layout.height == 1600);
+    MV_CHECK(layout.arrayLength == 1 && layout.texturesPerStage == 2);
+    MV_CHECK(layout.numStages == Stages);
+    MV_CHECK(layout.bytesPerTexture == eyeBytes);
+    MV_CHECK(layout.totalBytes == eyeBytes * 2 * Stages);
+
+    layout = allocator.Plan(EVRStereoRenderingModes::SinglePassInstanced,
+                            DisplayWidth, DisplayHeight, 1.f, Stages);
+    MV_CHECK(layout.width == 1440 && layout.height == 1600);
+    MV_CHECK(layout.arrayLength == 2 && layout.texturesPerStage == 1);
+    MV_CHECK(layout.bytesPerTexture == eyeBytes * 2);
+    MV_CHECK(layout.totalBytes == eyeBytes * 2 * Stages);
+
+    layout = allocator.Plan(EVRStereoRenderingModes::SingleCamera,
+                            DisplayWidth, DisplayHeight, 1.f, Stages);
+    MV_CHECK(layout.width == 2880 && layout.height == 1600);
+    MV_CHECK(layout.arrayLength == 1 && layout.texturesPerStage == 1);
+    MV_CHECK(layout.bytesPerTexture == eyeBytes * 2);
+    MV_CHECK(layout.totalBytes == eyeBytes * 2 * Stages);
+}
+
+/**
+ * @brief The requested scale applies to each side, no scale means 1, and
+ * textures aliasing existing color surfaces only cost their depth.
+ */
+static void testScaleAndColor() {
+    EyeTextureAllocator allocator;
+    EyeTextureLayout layout = allocator.Plan(
+        EVRStereoRenderingModes::MultiPass, DisplayWidth, DisplayHeight, 1.5f,
+        Stages);
+    MV_CHECK(layout.width == 2160 && layout.height == 2400);
+    MV_CHECK(layout.resolutionScale == 1.5f);
+
+    layout = allocator.Plan(EVRStereoRenderingModes::SingleCamera,
+                            DisplayWidth, DisplayHeight, 0.f, 2);
+    MV_CHECK(layout.width == 2880 && layout.height == 1600);
+    MV_CHECK(layout.resolutionScale == 1.f);
+
+    layout = allocator.Plan(EVRStereoRenderingModes::SinglePassInstanced,
+                            DisplayWidth, DisplayHeight, 1.f, Stages, false);
+    MV_CHECK(layout.bytesPerTexture == 1440ull * 1600 * 2 * 4);
+}
+
+/**
+ * @brief For every mode, budgets from what the requested scale costs down
+ * to a hundredth of it: the plan fits while the scale can still go down,
+ * doesn't give up more than rounding needs, and stops at the minimum scale
+ * once even that doesn't fit.
+ */
+static void testBudget() {
+    constexpr float MinScale = EyeTextureAllocator::k_flMinResolutionScale;
+    for (EVRStereoRenderingModes mode : Modes) {
+        EyeTextureAllocator allocator;
+        const uint64_t full =
+            allocator.Plan(mode, DisplayWidth, DisplayHeight, 1.f, Stages)
+                .totalBytes;
+        const uint64_t atMin =
+            allocator.Plan(mode, DisplayWidth, DisplayHeight, MinScale, Stages)
+                .totalBytes;
+
+        float previousScale = 1.f;
+        bool fits = true;
+        bool tight = true;
+        bool monotonic = true;
+        for (int percent = 100; percent >= 1; --percent) {
+            const uint64_t budget = full * percent / 100;
+            allocator.SetBudget(budget);
+            const EyeTextureLayout layout =
+                allocator.Plan(mode, DisplayWidth, DisplayHeight, 1.f, Stages);
+            if (budget >= atMin) {
+                fits = fits && layout.totalBytes <= budget;
+                // Cost goes with the square of the scale; allow 2% for
+                // rounding down to whole pixels and the 1% steps
+                const float ideal = std::sqrt(static_cast<float>(budget) /
+                                              static_cast<float>(full));
+                tight = tight && layout.resolutionScale >= ideal * 0.98f;
+            } else {
+                fits = fits && layout.resolutionScale == MinScale;
+            }
+            fits = fits && layout.resolutionScale >= MinScale;
+            monotonic = monotonic && layout.resolutionScale <= previousScale;
+            previousScale = layout.resolutionScale;
+        }
+        MV_CHECK(fits);
+        MV_CHECK(tight);
+        MV_CHECK(monotonic);
+        MV_CHECK(previousScale == MinScale);
+
+        // Unlimited again: the requested scale
+        allocator.SetBudget(0);
+        MV_CHECK(allocator.Plan(mode, DisplayWidth, DisplayHeight, 1.f, Stages)
+                     .totalBytes == full);
+    }
+}
+
+/**
+ * @brief Bookkeeping of what is allocated.
+ */
+static void testAllocated() {
+    EyeTextureAllocator allocator;
+    const EyeTextureLayout layout = allocator.Plan(
+        EVRStereoRenderingModes::MultiPass, DisplayWidth, DisplayHeight, 1.f,
+        Stages);
+    MV_CHECK(allocator.GetAllocatedTextureCount() == 0);
+    allocator.OnAllocated(layout);
+    MV_CHECK(allocator.GetAllocatedTextureCount() == 2 * Stages);
+    MV_CHECK(allocator.GetAllocatedBytes() == layout.totalBytes);
+    allocator.OnReleased();
+    MV_CHECK(allocator.GetAllocatedTextureCount() == 0);
+    MV_CHECK(allocator.GetAllocatedBytes() == 0);
+}
+
+int main() {
+    testModes();
+    testScaleAndColor();
+    testBudget();
+    testAllocated();
+    return test::finish("EyeTextureAllocatorTest");
+}
@@ -0,0 +1,193 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+/**
+ * @file
+ * @brief Drives an EyeTexturePool with a fake destroy callback: Acquire
+ * hands back the most recently released match for a key, Collect evicts the
+ * least recently used textures first, and nothing is destroyed before the
+ * GPU has reached its fence value.
+ */
+
+#include "TestCheck.h"
+
+#include "Providers/Display/EyeTexturePool.h"
+
+#include <cstdint>
+#include <vector>
+
+using namespace metaview;
+
+/**
+ * @brief Stands in for Unity destroying textures: records which, and when
+ * by the GPU's progress, so a test can tell if one went too early.
+ */
+class FakeDestroyer {
+  public:
+    /**
+     * @brief Set the fence value the GPU has reached, and collect.
+     */
+    void collect(EyeTexturePool& pool, uint64_t completedFenceValue) {
+        completed_ = completedFenceValue;
+        pool.Collect(completedFenceValue, func());
+    }
+
+    EyeTexturePool::DestroyFunc func() {
+        return [this](UnityXRRenderTextureId id) {
+            destroyed_.push_back(id);
+            completedAt_.push_back(completed_);
+        };
+    }
+
+    std::vector<UnityXRRenderTextureId> const& destroyed() const {
+        return destroyed_;
+    }
+
+    /**
+     * @brief Fence value reached when each of destroyed() was destroyed.
+     */
+    std::vector<uint64_t> const& completedAt() const { return completedAt_; }
+
+    void clear() {
+        destroyed_.clear();
+        completedAt_.clear();
+    }
+
+  private:
+    uint64_t completed_ = 0;
+    std::vector<UnityXRRenderTextureId> destroyed_;
+    std::vector<uint64_t> completedAt_;
+};
+
+static EyeTextureKey makeKey(uint32_t width, uint32_t height) {
+    EyeTextureKey key;
+    key.width = width;
+    key.height = height;
+    return key;
+}
+
+/**
+ * @brief Of several idle textures for a key, the one released last; none
+ * for a key that differs in anything.
+ */
+static void testAcquireMostRecent() {
+    EyeTexturePool pool;
+    pool.SetCapacity(1000);
+    const EyeTextureKey key = makeKey(1024, 1024);
+    pool.Release(key, 1, 100, 1);
+    pool.Release(makeKey(512, 512), 2, 100, 1);
+    pool.Release(key, 3, 100, 2);
+    pool.Release(key, 4, 100, 3);
+    MV_CHECK(pool.GetIdleCount() == 4);
+    MV_CHECK(pool.GetIdleBytes() == 400);
+
+    EyeTextureKey other = key;
+    other.sRGB = true;
+    UnityXRRenderTextureId id = 0;
+    MV_CHECK(!pool.Acquire(other, id));
+    other = key;
+    other.arrayLength = 2;
+    MV_CHECK(!pool.Acquire(other, id));
+
+    MV_CHECK(pool.Acquire(key, id) && id == 4);
+    MV_CHECK(pool.Acquire(key, id) && id == 3);
+    // Released again: most recent once more
+    pool.Release(key, 4, 100, 4);
+    MV_CHECK(pool.Acquire(key, id) && id == 4);
+    MV_CHECK(pool.Acquire(key, id) && id == 1);
+    MV_CHECK(!pool.Acquire(key, id));
+    MV_CHECK(pool.GetIdleCount() == 1);
+    MV_CHECK(pool.GetIdleBytes() == 100);
+}
+
+/**
+ * @brief Over the cap, the least recently released go first, just enough of
+ * them, and a texture acquired and released again counts as recent.
+ */
+static void testCollectEvictsLeastRecent() {
+    EyeTexturePool pool;
+    FakeDestroyer destroyer;
+    pool.SetCapacity(300);
+    for (UnityXRRenderTextureId id = 1; id <= 3; ++id) {
+        pool.Release(makeKey(id * 100, 100), id, 100, 1);
+    }
+    destroyer.collect(pool, 1);
+    MV_CHECK(destroyer.destroyed().empty());
+
+    // Texture 1 used again: 2 is now the oldest
+    UnityXRRenderTextureId id = 0;
+    MV_CHECK(pool.Acquire(makeKey(100, 100), id) && id == 1);
+    pool.Release(makeKey(100, 100), 1, 100, 1);
+    pool.Release(makeKey(400, 100), 4, 100, 1);
+    pool.Release(makeKey(500, 100), 5, 100, 1);
+    destroyer.collect(pool, 1);
+    MV_CHECK(destroyer.destroyed() ==
+             std::vector<UnityXRRenderTextureId>({2, 3}));
+    MV_CHECK(pool.GetIdleBytes() == 300);
+    MV_CHECK(pool.GetIdleCount() == 3);
+    MV_CHECK(!pool.Acquire(makeKey(200, 100), id));
+    MV_CHECK(pool.Acquire(makeKey(100, 100), id) && id == 1);
+
+    // No cap: everything idle goes, oldest first
+    destroyer.clear();
+    pool.SetCapacity(0);
+    destroyer.collect(pool, 1);
+    MV_CHECK(destroyer.destroyed() ==
+             std::vector<UnityXRRenderTextureId>({4, 5}));
+    MV_CHECK(pool.GetIdleCount() == 0 && pool.GetIdleBytes() == 0);
+}
+
+/**
+ * @brief Evicted and retired textures wait for their own fence value, not
+ * anyone else's; idle ones under the cap are never destroyed by Collect.
+ * Clear destroys everything at once.
+ */
+static void testFences() {
+    EyeTexturePool pool;
+    FakeDestroyer destroyer;
+    pool.SetCapacity(100);
+    pool.Release(makeKey(100, 100), 1, 100, 5);
+    pool.Release(makeKey(200, 100), 2, 100, 8);
+    pool.Retire(3, 6);
+    pool.Retire(4, 3);
+
+    // Texture 1 evicted, but the GPU is short of every fence value but 4's
+    destroyer.collect(pool, 4);
+    MV_CHECK(destroyer.destroyed() == std::vector<UnityXRRenderTextureId>({4}));
+    MV_CHECK(pool.GetIdleCount() == 1);
+    MV_CHECK(pool.GetRetiredCount() == 2);
+    destroyer.collect(pool, 5);
+    destroyer.collect(pool, 5);
+    destroyer.collect(pool, 7);
+    MV_CHECK(destroyer.destroyed() ==
+             std::vector<UnityXRRenderTextureId>({4, 1, 3}));
+    MV_CHECK(pool.GetRetiredCount() == 0);
+
+    // Idle under the cap: kept, whatever the fence
+    destroyer.collect(pool, 100);
+    MV_CHECK(destroyer.destroyed().size() == 3);
+    MV_CHECK(pool.GetIdleCount() == 1);
+
+    const uint64_t fences[] = {3, 5, 6};
+    bool early = false;
+    for (size_t i = 0; i < destroyer.destroyed().size(); ++i) {
+        early = early || destroyer.completedAt()[i] < fences[i];
+    }
+    MV_CHECK(!early);
+
+    pool.Retire(6, 200);
+    destroyer.clear();
+    pool.Clear(destroyer.func());
+    MV_CHECK(destroyer.destroyed().size() == 2);
+    MV_CHECK(pool.GetIdleCount() == 0 && pool.GetRetiredCount() == 0);
+    MV_CHECK(pool.GetIdleBytes() == 0);
+}
+
+int main() {
+    testAcquireMostRecent();
+    testCollectEvictsLeastRecent();
+    testFences();
+    return test::finish("EyeTexturePoolTest");
+}
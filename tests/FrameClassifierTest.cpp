@@ -0,0 +1,256 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+/**
+ * @file
+ * @brief Drives FrameClassifier with synthetic vblank sequences and checks
+ * which frames it calls on time, late, repeated or skipped.
+ */
+
+#include "TestCheck.h"
+
+#include "Model/FrameClassifier.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace metaview;
+
+static constexpr int64_t Period = 11'111'111;
+
+/**
+ * @brief A display and a renderer reduced to timestamps and a fence.
+ */
+class SyntheticDisplay {
+  public:
+    explicit SyntheticDisplay(FrameClassifier& classifier,
+                              int64_t jitterNs = 0)
+        : classifier_(classifier), jitter_(-jitterNs, jitterNs) {}
+
+    /**
+     * @brief Submit a frame aimed @p vblanksAhead vblanks from the last one.
+     */
+    void submit(int64_t vblanksAhead = 1, uint32_t frameInterval = 1) {
+        classifier_.onFrameSubmitted(++fence_,
+                                     lastVBlank_ + vblanksAhead * Period,
+                                     Period, frameInterval);
+    }
+
+    /**
+     * @brief The GPU finishes everything submitted so far.
+     */
+    void complete() { completed_ = fence_; }
+
+    /**
+     * @brief A vblank happens, reported with some timing noise.
+     */
+    void vblank() {
+        trueTime_ += Period;
+        lastVBlank_ = trueTime_ + jitter_(rng_);
+        classifier_.onVBlank(lastVBlank_, completed_);
+    }
+
+    /**
+     * @brief One frame that makes its vblank.
+     */
+    void onTimeFrame(uint32_t frameInterval = 1) {
+        submit(1, frameInterval);
+        complete();
+        for (uint32_t i = 0; i < frameInterval; ++i) {
+            vblank();
+        }
+    }
+
+    /**
+     * @brief One frame aimed at the next vblank that finishes rendering
+     * @p vblanksLate vblanks after it.
+     */
+    void lateFrame(int vblanksLate) {
+        submit(1);
+        for (int i = 0; i < vblanksLate; ++i) {
+            vblank();
+        }
+        complete();
+        vblank();
+    }
+
+  private:
+    FrameClassifier& classifier_;
+    uint64_t fence_ = 0;
+    uint64_t completed_ = 0;
+    int64_t trueTime_ = 1'000'000'000;
+    int64_t lastVBlank_ = 1'000'000'000;
+    std::uniform_int_distribution<int64_t> jitter_;
+    std::minstd_rand rng_{42};
+};
+
+static void testAllOnTime() {
+    FrameClassifier classifier;
+    SyntheticDisplay display(classifier, Period / 5);
+    display.vblank();
+    for (int i = 0; i < 100; ++i) {
+        display.onTimeFrame();
+    }
+    // The last frame is still on screen, so not yet classified.
+    FrameClassifierCounters counters = classifier.getCounters();
+    MV_CHECK(counters.onTime == 99);
+    MV_CHECK(counters.late == 0);
+    MV_CHECK(counters.repeated == 0);
+    MV_CHECK(counters.skipped == 0);
+    MV_CHECK(counters.repeatedVBlanks == 0);
+    MV_CHECK(classifier.getHistogram()[0] == 99);
+    MV_CHECK(classifier.getConsecutiveLate() == 0);
+}
+
+/**
+ * @brief A frame one vblank late: it is late, and the frame before it,
+ * though on time, stayed up an extra refresh so is repeated.
+ */
+static void testLateAndRepeated() {
+    FrameClassifier classifier;
+    SyntheticDisplay display(classifier);
+    display.vblank();
+    display.onTimeFrame();
+    display.onTimeFrame();
+    display.lateFrame(1);
+    display.onTimeFrame();
+    display.onTimeFrame();
+
+    FrameClassifierCounters counters = classifier.getCounters();
+    MV_CHECK(counters.onTime == 2);
+    MV_CHECK(counters.repeated == 1);
+    MV_CHECK(counters.late == 1);
+    MV_CHECK(counters.repeatedVBlanks == 1);
+    FrameClassifier::Histogram histogram = classifier.getHistogram();
+    MV_CHECK(histogram[0] == 3);
+    MV_CHECK(histogram[1] == 1);
+}
+
+/**
+ * @brief How late goes into the histogram, the last bucket catching anything
+ * later still.
+ */
+static void testHistogramBuckets() {
+    FrameClassifier classifier;
+    SyntheticDisplay display(classifier);
+    display.vblank();
+    display.onTimeFrame();
+    display.lateFrame(2);
+    display.lateFrame(3);
+    display.lateFrame(9);
+    display.onTimeFrame();
+
+    FrameClassifier::Histogram histogram = classifier.getHistogram();
+    MV_CHECK(histogram[0] == 1);
+    MV_CHECK(histogram[2] == 1);
+    MV_CHECK(histogram[3] == 1);
+    MV_CHECK(histogram[FrameClassifier::HistogramBuckets - 1] == 1);
+    MV_CHECK(classifier.getCounters().late == 3);
+    MV_CHECK(classifier.getCounters().repeatedVBlanks == 2 + 3 + 9);
+}
+
+/**
+ * @brief The histogram only covers the configured number of recent frames.
+ */
+static void testHistogramWindow() {
+    FrameClassifier classifier(10);
+    SyntheticDisplay display(classifier);
+    display.vblank();
+    for (int i = 0; i < 10; ++i) {
+        display.lateFrame(1);
+    }
+    for (int i = 0; i < 20; ++i) {
+        display.onTimeFrame();
+    }
+    FrameClassifier::Histogram histogram = classifier.getHistogram();
+    MV_CHECK(histogram[0] == 10);
+    MV_CHECK(histogram[1] == 0);
+    // The counters are totals, not windowed.
+    MV_CHECK(classifier.getCounters().late == 10);
+}
+
+/**
+ * @brief Two frames finished between vblanks: only the newer is shown.
+ */
+static void testSkipped() {
+    FrameClassifier classifier;
+    SyntheticDisplay display(classifier);
+    display.vblank();
+    display.onTimeFrame();
+    display.submit(1);
+    display.submit(2);
+    display.complete();
+    display.vblank();
+    display.vblank();
+    display.onTimeFrame();
+
+    FrameClassifierCounters counters = classifier.getCounters();
+    MV_CHECK(counters.skipped == 1);
+    // The second was aimed two vblanks ahead, shown on the first: not late.
+    MV_CHECK(counters.late == 0);
+    MV_CHECK(counters.repeated == 1);
+}
+
+/**
+ * @brief At half rate each frame is meant to stay up for two refreshes,
+ * which is not a repeat; a third refresh is.
+ */
+static void testHalfRate() {
+    FrameClassifier classifier;
+    SyntheticDisplay display(classifier);
+    display.vblank();
+    for (int i = 0; i < 20; ++i) {
+        display.onTimeFrame(2);
+    }
+    FrameClassifierCounters counters = classifier.getCounters();
+    MV_CHECK(counters.onTime == 19);
+    MV_CHECK(counters.repeated == 0);
+    MV_CHECK(counters.repeatedVBlanks == 0);
+
+    display.vblank();
+    display.onTimeFrame(2);
+    counters = classifier.getCounters();
+    MV_CHECK(counters.repeated == 1);
+    MV_CHECK(counters.repeatedVBlanks == 1);
+}
+
+/**
+ * @brief The miss callback fires every time the run of late frames reaches
+ * a multiple of the threshold, and the run resets on an on-time frame.
+ */
+static void testMissCallback() {
+    FrameClassifier classifier;
+    std::vector<uint32_t> calls;
+    classifier.setMissCallback(3, [&](uint32_t n) { calls.push_back(n); });
+    SyntheticDisplay display(classifier, Period / 5);
+    display.vblank();
+    display.onTimeFrame();
+    for (int i = 0; i < 7; ++i) {
+        display.lateFrame(1);
+    }
+    // The seventh is only classified once the next frame shows.
+    display.onTimeFrame();
+    MV_CHECK(classifier.getConsecutiveLate() == 7);
+    MV_CHECK(calls.size() == 2 && calls[0] == 3 && calls[1] == 6);
+
+    display.onTimeFrame();
+    MV_CHECK(classifier.getConsecutiveLate() == 0);
+    display.lateFrame(1);
+    display.lateFrame(1);
+    display.onTimeFrame();
+    MV_CHECK(calls.size() == 2);
+}
+
+int main() {
+    testAllOnTime();
+    testLateAndRepeated();
+    testHistogramBuckets();
+    testHistogramWindow();
+    testSkipped();
+    testHalfRate();
+    testMissCallback();
+    return test::finish("FrameClassifierTest");
+}
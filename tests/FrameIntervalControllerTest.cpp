@@ -0,0 +1,163 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+/**
+ * @file
+ * @brief Feeds FrameIntervalController from a fake frame-time source and
+ * checks it switches to half rate, and back, exactly at its thresholds.
+ */
+
+#include "TestCheck.h"
+
+#include "Model/FrameIntervalController.h"
+
+#include <cstdint>
+
+using namespace metaview;
+
+static constexpr double Period90 = 1000.0 / 90.0;
+
+/**
+ * @brief Stand-in for the renderer's per-frame measurements: a steady CPU
+ * and GPU load, with a dropped vblank on chosen frames.
+ */
+class FakeFrameTimes {
+  public:
+    explicit FakeFrameTimes(FrameIntervalController& controller)
+        : controller_(controller) {}
+
+    //! Set the CPU plus GPU time of the coming frames, as a fraction of the
+    //! period, split evenly.
+    void setLoad(double load) { load_ = load; }
+
+    /**
+     * @brief Run @p count frames, the first @p drops of which drop a vblank.
+     * @return the interval after the last of them.
+     */
+    uint32_t run(uint32_t count, uint32_t drops = 0) {
+        uint32_t interval = controller_.getInterval();
+        for (uint32_t i = 0; i < count; ++i) {
+            const double ms = load_ * Period90 / 2;
+            interval = controller_.update(i < drops ? 1 : 0, ms, ms, Period90);
+            ++frames_;
+        }
+        return interval;
+    }
+
+    uint64_t getFrames() const { return frames_; }
+
+  private:
+    FrameIntervalController& controller_;
+    double load_ = 0.5;
+    uint64_t frames_ = 0;
+};
+
+/**
+ * @brief 10% of a 90 frame window dropped: half rate at the end of the
+ * window, not before. One fewer stays at full rate.
+ */
+static void testThrottleThreshold() {
+    FrameIntervalController controller;
+    FakeFrameTimes frames(controller);
+    frames.setLoad(1.1);
+    MV_CHECK(frames.run(89, 9) == 1);
+    MV_CHECK(frames.run(1) == 2);
+
+    FrameIntervalController below;
+    FakeFrameTimes belowFrames(below);
+    belowFrames.setLoad(1.1);
+    MV_CHECK(belowFrames.run(90, 8) == 1);
+    // Drops don't carry over into the next window.
+    MV_CHECK(belowFrames.run(90, 8) == 1);
+}
+
+/**
+ * @brief Back to full rate after 450 frames in a row under 0.7 of the
+ * period, not one sooner.
+ */
+static void testUnthrottleThreshold() {
+    FrameIntervalController controller;
+    FakeFrameTimes frames(controller);
+    frames.setLoad(1.1);
+    MV_CHECK(frames.run(90, 90) == 2);
+
+    frames.setLoad(0.69);
+    MV_CHECK(frames.run(449) == 2);
+    MV_CHECK(frames.run(1) == 1);
+
+    // Then counting drops afresh.
+    frames.setLoad(0.5);
+    MV_CHECK(frames.run(89, 8) == 1);
+    MV_CHECK(frames.run(1) == 1);
+}
+
+/**
+ * @brief A single frame at or over the load threshold restarts the run.
+ */
+static void testUnthrottleStreakResets() {
+    FrameIntervalController controller;
+    FakeFrameTimes frames(controller);
+    MV_CHECK(frames.run(90, 9) == 2);
+
+    frames.setLoad(0.5);
+    MV_CHECK(frames.run(400) == 2);
+    frames.setLoad(0.7);
+    MV_CHECK(frames.run(1) == 2);
+    frames.setLoad(0.5);
+    MV_CHECK(frames.run(449) == 2);
+    MV_CHECK(frames.run(1) == 1);
+}
+
+/**
+ * @brief Frames without a valid GPU time neither count towards nor break
+ * the run, and a zero period is ignored outright.
+ */
+static void testMissingMeasurements() {
+    FrameIntervalController controller;
+    FakeFrameTimes frames(controller);
+    MV_CHECK(frames.run(90, 90) == 2);
+
+    frames.setLoad(0.5);
+    MV_CHECK(frames.run(200) == 2);
+    for (int i = 0; i < 100; ++i) {
+        MV_CHECK(controller.update(0, 1.0, 0.0, Period90) == 2);
+        MV_CHECK(controller.update(0, 1.0, 1.0, 0.0) == 2);
+    }
+    MV_CHECK(frames.run(249) == 2);
+    MV_CHECK(frames.run(1) == 1);
+
+    controller.reset();
+    MV_CHECK(controller.getInterval() == 1);
+}
+
+/**
+ * @brief Custom thresholds are honoured.
+ */
+static void testConfig() {
+    FrameIntervalConfig config;
+    config.windowFrames = 10;
+    config.throttleDropFraction = 0.5;
+    config.unthrottleLoad = 0.4;
+    config.unthrottleFrames = 20;
+    FrameIntervalController controller(config);
+    FakeFrameTimes frames(controller);
+    MV_CHECK(frames.run(10, 4) == 1);
+    MV_CHECK(frames.run(10, 5) == 2);
+    frames.setLoad(0.45);
+    MV_CHECK(frames.run(100) == 2);
+    frames.setLoad(0.35);
+    MV_CHECK(frames.run(19) == 2);
+    MV_CHECK(frames.run(1) == 1);
+    MV_CHECK(frames.getFrames() == 140);
+}
+
+int main() {
+    testThrottleThreshold();
+    testUnthrottleThreshold();
+    testUnthrottleStreakResets();
+    testMissingMeasurements();
+    testConfig();
+    return test::finish("FrameIntervalControllerTest");
+}
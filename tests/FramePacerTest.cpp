@@ -0,0 +1,231 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+/**
+ * @file
+ * @brief Drives FramePacer from a simulated vsync, and checks the fitted
+ * period and phase and the wake targets it produces.
+ */
+
+#include "TestCheck.h"
+
+#include "Model/FramePacer.h"
+#include "Model/SimulatedVsync.h"
+
+#include <cstdint>
+#include <cstdlib>
+
+using namespace metaview;
+
+//! 90 Hz
+static constexpr int64_t Period90 = 11'111'111;
+//! 60 Hz
+static constexpr int64_t Period60 = 16'666'667;
+static constexpr int64_t Phase = 3'250'000;
+static constexpr int64_t RunningStart = 2'000'000;
+
+/**
+ * @brief Get a time half way between two true vblanks, some periods after
+ * @p timeNs: predictions for it can't round to the neighbouring vblank.
+ */
+static int64_t midway(SimulatedVsync const& vsync, int64_t timeNs,
+                      int64_t periods) {
+    return vsync.vblankAfter(timeNs) + periods * vsync.getPeriod() +
+           vsync.getPeriod() / 2;
+}
+
+/**
+ * @brief Exact timestamps: the fit should be exact too.
+ */
+static void testExactTimestamps() {
+    SimulatedClock clock;
+    SimulatedVsync vsync(clock, Period90, Phase);
+    FramePacerConfig config;
+    config.minSamplesForLock = 8;
+    FramePacer pacer(clock, config);
+
+    for (int i = 0; i < 7; ++i) {
+        pacer.recordVBlank(vsync.waitForVBlank());
+    }
+    MV_CHECK(!pacer.isLocked());
+    pacer.recordVBlank(vsync.waitForVBlank());
+    MV_CHECK(pacer.isLocked());
+    MV_CHECK_NEAR(pacer.getPeriod(), Period90, 1);
+
+    // Phase: predictions land on the true vblanks, near and far ahead.
+    for (int64_t periods : {0, 5, 90}) {
+        const int64_t t = midway(vsync, clock.now(), periods);
+        MV_CHECK_NEAR(pacer.predictVBlankAtOrAfter(t), vsync.vblankAfter(t),
+                      2);
+    }
+}
+
+/**
+ * @brief Timestamps observed late by up to the jitter: the period should
+ * still come out within a microsecond or so, the phase within the jitter.
+ */
+static void testJitter() {
+    constexpr int64_t Jitter = 300'000;
+    SimulatedClock clock;
+    SimulatedVsync vsync(clock, Period90, Phase, Jitter, 1234);
+    FramePacer pacer(clock);
+
+    for (int i = 0; i < 200; ++i) {
+        pacer.recordVBlank(vsync.waitForVBlank());
+        if (i >= 16) {
+            MV_CHECK(pacer.isLocked());
+        }
+    }
+    MV_CHECK_NEAR(pacer.getPeriod(), Period90, 2'000);
+    for (int64_t periods : {0, 9}) {
+        const int64_t t = midway(vsync, clock.now(), periods);
+        MV_CHECK_NEAR(pacer.predictVBlankAtOrAfter(t), vsync.vblankAfter(t),
+                      Jitter);
+    }
+}
+
+/**
+ * @brief Vblanks the observer slept through: single ones, and a run of
+ * several. The indices must account for them, so the period is not
+ * overestimated.
+ */
+static void testMissedVBlanks() {
+    constexpr int64_t Jitter = 100'000;
+    SimulatedClock clock;
+    SimulatedVsync vsync(clock, Period90, Phase, Jitter, 99);
+    FramePacer pacer(clock);
+
+    for (int i = 0; i < 150; ++i) {
+        const int64_t observed = vsync.waitForVBlank();
+        const bool missed = (i % 7 == 3) || (i >= 60 && i < 64);
+        if (!missed) {
+            pacer.recordVBlank(observed);
+        }
+    }
+    MV_CHECK(pacer.isLocked());
+    MV_CHECK_NEAR(pacer.getPeriod(), Period90, 2'000);
+    const int64_t t = midway(vsync, clock.now(), 1);
+    MV_CHECK_NEAR(pacer.predictVBlankAtOrAfter(t), vsync.vblankAfter(t),
+                  Jitter);
+    // Counted from the timestamps, the missed ones included.
+    MV_CHECK(pacer.getVBlankCount() == 150);
+}
+
+/**
+ * @brief Wake targets: each frame wakes the running start before a true
+ * vblank, and consecutive frames never share a vblank, even when the render
+ * thread asks again straight away.
+ */
+static void testWakeTargets() {
+    SimulatedClock clock;
+    SimulatedVsync vsync(clock, Period90, Phase, 50'000, 7);
+    FramePacerConfig config;
+    config.runningStartNs = RunningStart;
+    FramePacer pacer(clock, config);
+    for (int i = 0; i < 32; ++i) {
+        pacer.recordVBlank(vsync.waitForVBlank());
+    }
+    MV_CHECK(pacer.isLocked());
+
+    int64_t previousTarget = 0;
+    for (int frame = 0; frame < 50; ++frame) {
+        const int64_t before = clock.now();
+        const int64_t target = pacer.waitForRunningStart();
+        // Slept exactly to the running start point...
+        MV_CHECK_NEAR(clock.now(), target - RunningStart, 0);
+        MV_CHECK(clock.now() >= before);
+        // ...of a true vblank, the first one there was time for.
+        const int64_t trueTarget = vsync.vblankAfter(target - Period90 / 2);
+        MV_CHECK_NEAR(target, trueTarget, 50'000);
+        if (previousTarget != 0) {
+            MV_CHECK_NEAR(target - previousTarget, Period90, 50'000);
+        } else {
+            MV_CHECK_NEAR(trueTarget, vsync.vblankAfter(before + RunningStart),
+                          0);
+        }
+        previousTarget = target;
+
+        // The vblank thread keeps feeding the pacer as the frame runs.
+        pacer.recordVBlank(vsync.waitForVBlank());
+    }
+
+    // Asking twice without time passing must not aim at the same vblank.
+    int64_t wake1, target1, wake2, target2;
+    pacer.computeWakeTime(clock.now(), wake1, target1);
+    pacer.computeWakeTime(clock.now(), wake2, target2);
+    MV_CHECK_NEAR(target2 - target1, Period90, 50'000);
+    MV_CHECK_NEAR(wake1, target1 - RunningStart, 0);
+    MV_CHECK_NEAR(wake2, target2 - RunningStart, 0);
+}
+
+/**
+ * @brief With a frame interval of 2, targets are two vblanks apart, and
+ * predictNextTarget() agrees with what computeWakeTime() then picks.
+ */
+static void testHalfRateTargets() {
+    SimulatedClock clock;
+    SimulatedVsync vsync(clock, Period90, Phase);
+    FramePacer pacer(clock);
+    for (int i = 0; i < 16; ++i) {
+        pacer.recordVBlank(vsync.waitForVBlank());
+    }
+    pacer.setFrameInterval(2);
+    MV_CHECK(pacer.getFrameInterval() == 2);
+
+    int64_t previousTarget = 0;
+    for (int frame = 0; frame < 20; ++frame) {
+        const int64_t predicted = pacer.predictNextTarget(clock.now());
+        int64_t wake, target;
+        pacer.computeWakeTime(clock.now(), wake, target);
+        MV_CHECK_NEAR(predicted, target, 0);
+        if (previousTarget != 0) {
+            MV_CHECK_NEAR(target - previousTarget, 2 * Period90, 2);
+        }
+        previousTarget = target;
+        clock.sleepUntil(wake);
+        pacer.recordVBlank(vsync.waitForVBlank());
+    }
+}
+
+/**
+ * @brief A refresh rate change: the pacer must notice the old fit no longer
+ * holds and lock onto the new period, without restarting the vblank count.
+ */
+static void testModeChange() {
+    SimulatedClock clock;
+    SimulatedVsync vsync90(clock, Period90, Phase);
+    FramePacer pacer(clock);
+    for (int i = 0; i < 64; ++i) {
+        pacer.recordVBlank(vsync90.waitForVBlank());
+    }
+    MV_CHECK_NEAR(pacer.getPeriod(), Period90, 1);
+
+    MV_CHECK(pacer.getVBlankCount() == 64);
+
+    SimulatedVsync vsync60(clock, Period60, clock.now() + 1'000'000);
+    for (int i = 0; i < 32; ++i) {
+        pacer.recordVBlank(vsync60.waitForVBlank());
+    }
+    const int64_t count = pacer.getVBlankCount();
+    MV_CHECK(count > 64 + 32 - 1);
+    for (int i = 0; i < 32; ++i) {
+        pacer.recordVBlank(vsync60.waitForVBlank());
+    }
+    MV_CHECK(pacer.getVBlankCount() == count + 32);
+    MV_CHECK(pacer.isLocked());
+    MV_CHECK_NEAR(pacer.getPeriod(), Period60, 1);
+    const int64_t t = midway(vsync60, clock.now(), 0);
+    MV_CHECK_NEAR(pacer.predictVBlankAtOrAfter(t), vsync60.vblankAfter(t), 2);
+}
+
+int main() {
+    testExactTimestamps();
+    testJitter();
+    testMissedVBlanks();
+    testWakeTargets();
+    testHalfRateTargets();
+    testModeChange();
+    return test::finish("FramePacerTest");
+}
@@ -0,0 +1,243 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+/**
+ * @file
+ * @brief Tests of TimestampQueryRing and GpuTimingProfiler against
+ * FakeTimestampSource: results still pending on the "GPU", disjoint frames and
+ * invalid timestamps.
+ */
+
+#include "TestCheck.h"
+
+#include "Model/FakeTimestampSource.h"
+#include "Model/GpuTimingProfiler.h"
+#include "Model/TimestampQueryRing.h"
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+using namespace metaview;
+
+//! Fake ticks are nanoseconds.
+static constexpr uint64_t Ms = 1'000'000;
+
+/**
+ * @brief Record one frame with timestamp 0, then 1 @p gpuMs later.
+ */
+static bool recordFrame(TimestampQueryRing& ring, FakeTimestampSource& source,
+                        double gpuMs) {
+    const bool recording = ring.beginFrame();
+    ring.mark(0);
+    source.advance(static_cast<uint64_t>(gpuMs * Ms));
+    ring.mark(1);
+    ring.endFrame();
+    source.advance(2 * Ms);
+    return recording;
+}
+
+/**
+ * @brief Nothing comes back until the fake GPU catches up, the ring skips
+ * frames rather than wait when every slot is pending, and results come back
+ * oldest first.
+ */
+static void testPendingQueries() {
+    FakeTimestampSource source(3, 2);
+    TimestampQueryRing ring(source, 3, 2);
+    std::vector<TimestampFrame> collected;
+    auto onFrame = [&](TimestampFrame const& f) { collected.push_back(f); };
+
+    MV_CHECK(recordFrame(ring, source, 1.0));
+    MV_CHECK(recordFrame(ring, source, 2.0));
+    MV_CHECK(recordFrame(ring, source, 3.0));
+    MV_CHECK(ring.collect(onFrame) == 0);
+
+    // All three slots in flight: the fourth frame is skipped, not waited for.
+    MV_CHECK(!recordFrame(ring, source, 4.0));
+    MV_CHECK(ring.getSkippedFrames() == 1);
+    MV_CHECK(ring.collect(onFrame) == 0);
+
+    // One frame of latency left: only the older two are ready.
+    source.completeAllBut(1);
+    MV_CHECK(ring.collect(onFrame) == 2);
+    MV_CHECK(collected.size() == 2);
+    if (collected.size() == 2) {
+        MV_CHECK(collected[0].frameNumber == 1);
+        MV_CHECK(collected[1].frameNumber == 2);
+        MV_CHECK_NEAR(collected[0].elapsedMs(0, 1), 1.0, 1e-9);
+        MV_CHECK_NEAR(collected[1].elapsedMs(0, 1), 2.0, 1e-9);
+    }
+
+    // Slots freed: recording resumes, and frame numbers count the skip.
+    MV_CHECK(recordFrame(ring, source, 5.0));
+    source.completeAll();
+    MV_CHECK(ring.collect(onFrame) == 2);
+    MV_CHECK(collected.size() == 4);
+    if (collected.size() == 4) {
+        MV_CHECK(collected[2].frameNumber == 3);
+        MV_CHECK(collected[3].frameNumber == 5);
+        MV_CHECK_NEAR(collected[3].elapsedMs(0, 1), 5.0, 1e-9);
+    }
+    MV_CHECK(ring.collect(onFrame) == 0);
+}
+
+/**
+ * @brief Polling every frame never reads more than one slot that isn't
+ * ready, however long the GPU lags.
+ */
+static void testNoExcessivePolling() {
+    FakeTimestampSource source(4, 2);
+    TimestampQueryRing ring(source, 4, 2);
+    uint64_t collected = 0;
+    for (int frame = 0; frame < 1000; ++frame) {
+        recordFrame(ring, source, 1.0);
+        source.completeAllBut(3);
+        const uint64_t readsBefore = source.getReadCount();
+        const size_t count = ring.collect([](TimestampFrame const&) {});
+        MV_CHECK(source.getReadCount() - readsBefore <= count + 1);
+        collected += count;
+    }
+    MV_CHECK(collected == 997);
+    MV_CHECK(ring.getSkippedFrames() == 0);
+}
+
+/**
+ * @brief Disjoint frames are read back, freeing their slot, but never
+ * reported.
+ */
+static void testDisjoint() {
+    FakeTimestampSource source(4, 2);
+    TimestampQueryRing ring(source, 4, 2);
+    recordFrame(ring, source, 1.0);
+    source.setNextDisjoint();
+    recordFrame(ring, source, 50.0);
+    recordFrame(ring, source, 3.0);
+    source.completeAll();
+
+    std::vector<uint64_t> frames;
+    MV_CHECK(ring.collect([&](TimestampFrame const& f) {
+        frames.push_back(f.frameNumber);
+    }) == 2);
+    MV_CHECK(frames.size() == 2 && frames[0] == 1 && frames[1] == 3);
+    MV_CHECK(ring.getDisjointFrames() == 1);
+}
+
+/**
+ * @brief Scopes missing a timestamp, or running backwards, give no sample;
+ * the others in the same frame still do.
+ */
+static void testInvalidTimestamps() {
+    FakeTimestampSource source(2, 4);
+    GpuTimingProfiler profiler(source, 2, 4, {{0, 1}, {1, 2}, {2, 3}});
+
+    profiler.beginFrame();
+    profiler.mark(0);
+    source.advance(2 * Ms);
+    profiler.mark(1);
+    // Point 2 never marked; point 3 marked.
+    source.advance(1 * Ms);
+    profiler.mark(3);
+    profiler.endFrame();
+    source.completeAll();
+
+    std::vector<size_t> scopes;
+    std::vector<double> values;
+    auto onSample = [&](size_t scope, double ms) {
+        scopes.push_back(scope);
+        values.push_back(ms);
+    };
+    MV_CHECK(profiler.collect(onSample) == 1);
+    MV_CHECK(scopes.size() == 1 && scopes[0] == 0);
+    MV_CHECK(values.size() == 1 && values[0] == 2.0);
+
+    // Timestamps marked out of order: the later point reads earlier.
+    profiler.beginFrame();
+    profiler.mark(1);
+    source.advance(1 * Ms);
+    profiler.mark(0);
+    profiler.mark(2);
+    profiler.mark(3);
+    profiler.endFrame();
+    source.completeAll();
+    scopes.clear();
+    values.clear();
+    MV_CHECK(profiler.collect(onSample) == 1);
+    // (0, 1) runs backwards; (1, 2) is 1 ms; (2, 3) is zero.
+    MV_CHECK(scopes.size() == 2);
+    if (scopes.size() == 2) {
+        MV_CHECK(scopes[0] == 1 && values[0] == 1.0);
+        MV_CHECK(scopes[1] == 2 && values[1] == 0.0);
+    }
+    MV_CHECK(profiler.getSummary(0).count == 1);
+
+    // Unrecorded points and an unknown frequency give no duration.
+    TimestampFrame frame;
+    frame.writtenMask = 1u;
+    frame.ticks = {5, 0};
+    frame.frequency = 1000;
+    MV_CHECK(frame.elapsedMs(0, 1) < 0);
+    frame.frequency = 0;
+    frame.writtenMask = 3u;
+    MV_CHECK(frame.elapsedMs(0, 1) < 0);
+}
+
+/**
+ * @brief Rolling min/avg/p99 over the scopes, as exported through the stats.
+ */
+static void testSummary() {
+    FakeTimestampSource source(3, 2);
+    GpuTimingProfiler profiler(source, 3, 2, {{0, 1}}, 100);
+    for (int frame = 1; frame <= 300; ++frame) {
+        profiler.beginFrame();
+        profiler.mark(0);
+        // 1..100 ms, repeating, so the last window is exactly 1..100
+        source.advance(static_cast<uint64_t>(((frame - 1) % 100) + 1) * Ms);
+        profiler.mark(1);
+        profiler.endFrame();
+        source.completeAllBut(2);
+        profiler.collect([](size_t, double) {});
+    }
+    // The last two frames are still in flight.
+    RollingSummary summary = profiler.getSummary(0);
+    MV_CHECK(summary.count == 100);
+    MV_CHECK_NEAR(summary.min, 1.0, 1e-9);
+    // Window holds 99, 100, 1..98
+    MV_CHECK_NEAR(summary.avg, 50.5, 1e-9);
+    // Nearest rank: the 99th of 100
+    MV_CHECK_NEAR(summary.p99, 99.0, 1e-9);
+
+    profiler.clearStats();
+    MV_CHECK(profiler.getSummary(0).count == 0);
+}
+
+static void testLimits() {
+    FakeTimestampSource source(2, 33);
+    bool threw = false;
+    try {
+        TimestampQueryRing ring(source, 2, 33);
+    } catch (std::invalid_argument const&) {
+        threw = true;
+    }
+    MV_CHECK(threw);
+
+    threw = false;
+    try {
+        GpuTimingProfiler profiler(source, 2, 2, {{0, 2}});
+    } catch (std::invalid_argument const&) {
+        threw = true;
+    }
+    MV_CHECK(threw);
+}
+
+int main() {
+    testPendingQueries();
+    testNoExcessivePolling();
+    testDisjoint();
+    testInvalidTimestamps();
+    testSummary();
+    testLimits();
+    return test::finish("GpuTimingTest");
+}
@@ -0,0 +1,190 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+/**
+ * @file
+ * @brief Checks buildOcclusionMesh against areas worked out by hand: the
+ * view minus an ellipse or a superellipse, within what sampling the contour
+ * at the given segments loses. Also that every mesh of a segment count has
+ * the same vertex and index counts, as updating a mesh in place needs, that
+ * the triangles all wind the same way, and that no mesh is built when the
+ * contour hides nothing.
+ */
+
+#include "TestCheck.h"
+
+#include "Model/OcclusionMesh.h"
+
+#include <cmath>
+#include <cstdint>
+
+using namespace metaview;
+
+static constexpr uint32_t Segments = 64;
+
+/**
+ * @brief Twice the signed area of a triangle, positive if counter-clockwise
+ * in the viewport (y up).
+ */
+static double signedArea2(OcclusionMeshVertex const& a,
+                          OcclusionMeshVertex const& b,
+                          OcclusionMeshVertex const& c) {
+    const double abx = static_cast<double>(b.x) - a.x;
+    const double aby = static_cast<double>(b.y) - a.y;
+    const double acx = static_cast<double>(c.x) - a.x;
+    const double acy = static_cast<double>(c.y) - a.y;
+    return abx * acy - acx * aby;
+}
+
+/**
+ * @brief Area of the mesh, as a fraction of the viewport, or -1 if any
+ * triangle winds clockwise or an index is out of range.
+ */
+static double meshArea(OcclusionMesh const& mesh) {
+    double area = 0.0;
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+        for (size_t k = 0; k < 3; ++k) {
+            if (mesh.indices[i + k] >= mesh.vertices.size()) {
+                return -1.0;
+            }
+        }
+        const double a = signedArea2(mesh.vertices[mesh.indices[i]],
+                                     mesh.vertices[mesh.indices[i + 1]],
+                                     mesh.vertices[mesh.indices[i + 2]]);
+        if (a < -1e-9) {
+            return -1.0;
+        }
+        area += a / 2;
+    }
+    return area;
+}
+
+/**
+ * @brief Area inside a superellipse: 4 a b Gamma(1 + 1/e)^2 / Gamma(1 + 2/e).
+ */
+static double contourArea(LensContour const& contour) {
+    const double e = contour.exponent;
+    const double g = std::tgamma(1.0 + 1.0 / e);
+    return 4.0 * contour.radiusX * contour.radiusY * g * g /
+           std::tgamma(1.0 + 2.0 / e);
+}
+
+/**
+ * @brief A contour inside the view hides the rest of it. Sampled, the
+ * contour is a polygon inscribed in it, so the mesh covers a little more;
+ * at 64 segments under 0.2% of the contour's area, and it closes in as the
+ * segments go up.
+ */
+static void testArea() {
+    const EyeFov fov{-1.f, 1.f, 1.f, -1.f};
+    const double viewArea = 4.0;
+    for (float exponent : {2.f, 4.f}) {
+        LensContour contour;
+        contour.centerX = 0.1f;
+        contour.centerY = -0.05f;
+        contour.radiusX = 0.8f;
+        contour.radiusY = 0.6f;
+        contour.exponent = exponent;
+        const double hidden = 1.0 - contourArea(contour) / viewArea;
+
+        OcclusionMesh mesh;
+        MV_CHECK(buildOcclusionMesh(fov, contour, Segments, mesh));
+        const double area = meshArea(mesh);
+        MV_CHECK(area >= hidden - 1e-6);
+        MV_CHECK(area - hidden <= 0.002 * contourArea(contour) / viewArea);
+
+        MV_CHECK(buildOcclusionMesh(fov, contour, 1024, mesh));
+        MV_CHECK_NEAR(meshArea(mesh), hidden, 1e-4);
+    }
+
+    // An off-center view: the ellipse is placed in tangent space, not the
+    // viewport, and is still hidden around exactly
+    const EyeFov wide{-1.5f, 0.5f, 1.f, -0.5f};
+    LensContour contour;
+    contour.centerX = -0.5f;
+    contour.centerY = 0.25f;
+    contour.radiusX = 0.9f;
+    contour.radiusY = 0.7f;
+    OcclusionMesh mesh;
+    MV_CHECK(buildOcclusionMesh(wide, contour, 1024, mesh));
+    MV_CHECK_NEAR(meshArea(mesh), 1.0 - contourArea(contour) / 3.0, 1e-4);
+}
+
+/**
+ * @brief Whatever the view and contour, including a contour partly outside
+ * the view and one centered outside it, the same segment count gives the
+ * same vertex and index counts, every triangle counter-clockwise, and the
+ * mesh within the viewport.
+ */
+static void testConstantCounts() {
+    struct Params {
+        EyeFov fov;
+        LensContour contour;
+    };
+    const Params params[] = {
+        {{-1.f, 1.f, 1.f, -1.f}, {0.f, 0.f, 0.9f, 0.9f, 2.f}},
+        {{-1.2f, 0.8f, 1.1f, -0.9f}, {0.2f, 0.f, 0.5f, 0.7f, 3.f}},
+        // Wider than the view: only top and bottom hidden
+        {{-1.f, 1.f, 1.f, -1.f}, {0.f, 0.f, 2.f, 0.5f, 2.f}},
+        // Centered outside the view
+        {{-1.f, 1.f, 1.f, -1.f}, {1.5f, 0.f, 1.f, 1.f, 2.f}},
+    };
+    const size_t vertexCount = 2 * (Segments + 4);
+    const size_t indexCount = 6 * (Segments + 4);
+    OcclusionMesh mesh;
+    for (Params const& p : params) {
+        MV_CHECK(buildOcclusionMesh(p.fov, p.contour, Segments, mesh));
+        MV_CHECK(mesh.vertices.size() == vertexCount);
+        MV_CHECK(mesh.indices.size() == indexCount);
+        const double area = meshArea(mesh);
+        MV_CHECK(area > 0.0 && area < 1.0);
+        bool inside = true;
+        for (OcclusionMeshVertex const& v : mesh.vertices) {
+            inside = inside && v.x >= -1e-6f && v.x <= 1.f + 1e-6f &&
+                     v.y >= -1e-6f && v.y <= 1.f + 1e-6f;
+        }
+        MV_CHECK(inside);
+    }
+}
+
+/**
+ * @brief No mesh when nothing is hidden: no contour, a contour covering the
+ * whole view, or too few segments to make one.
+ */
+static void testNothingHidden() {
+    const EyeFov fov{-1.f, 1.f, 1.f, -1.f};
+    OcclusionMesh mesh;
+    mesh.vertices.resize(3);
+    mesh.indices.resize(3);
+    MV_CHECK(!buildOcclusionMesh(fov, LensContour{}, Segments, mesh));
+    MV_CHECK(mesh.vertices.empty() && mesh.indices.empty());
+
+    // Reaching past the corners, at sqrt(2)
+    LensContour covering;
+    covering.radiusX = 1.5f;
+    covering.radiusY = 1.5f;
+    MV_CHECK(!buildOcclusionMesh(fov, covering, Segments, mesh));
+    MV_CHECK(mesh.vertices.empty() && mesh.indices.empty());
+
+    // A squarer superellipse just past the edges, corners included: at
+    // (1, 1), 2 / 1.05^16 < 1
+    covering.radiusX = 1.05f;
+    covering.radiusY = 1.05f;
+    covering.exponent = 16.f;
+    MV_CHECK(!buildOcclusionMesh(fov, covering, Segments, mesh));
+
+    LensContour small;
+    small.radiusX = 0.5f;
+    small.radiusY = 0.5f;
+    MV_CHECK(!buildOcclusionMesh(fov, small, 2, mesh));
+    MV_CHECK(buildOcclusionMesh(fov, small, 3, mesh));
+}
+
+int main() {
+    testArea();
+    testConstantCounts();
+    testNothingHidden();
+    return test::finish("OcclusionMeshTest");
+}
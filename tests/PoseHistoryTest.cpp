@@ -0,0 +1,216 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+/**
+ * @file
+ * @brief Checks PoseHistory lookups against poses worked out by hand:
+ * interpolation, the oldest sample before the history starts, extrapolation
+ * up to its limit, and clear(). Then one writer and several readers at once,
+ * on a ring small enough that they race.
+ */
+
+#include "TestCheck.h"
+
+#include "Model/PoseHistory.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using namespace metaview;
+
+static constexpr int64_t NsPerMs = 1'000'000;
+static constexpr float Pi = 3.14159265358979f;
+
+/**
+ * @brief A sample at @p timeNs whose position, in x, is the time in
+ * milliseconds, and whose velocity keeps it so.
+ */
+static PoseSample makeSample(int64_t timeNs) {
+    const float ms = static_cast<float>(timeNs) / NsPerMs;
+    PoseSample ret;
+    ret.timeNs = timeNs;
+    ret.pose.position = {ms, ms + 1, ms + 2};
+    ret.linearVelocity = {1000.f, 1000.f, 1000.f};
+    return ret;
+}
+
+static void testEmpty() {
+    PoseHistory history;
+    PoseSample out;
+    MV_CHECK(!history.sample(0, out));
+    MV_CHECK(!history.newest(out));
+    MV_CHECK(history.capacity() == 256);
+}
+
+/**
+ * @brief Halfway between two samples: positions halfway, orientation half of
+ * the turn between them, and the time asked for.
+ */
+static void testInterpolation() {
+    PoseHistory history;
+    PoseSample a = makeSample(10 * NsPerMs);
+    PoseSample b = makeSample(20 * NsPerMs);
+    b.pose.orientation = fromAxisAngle({0.f, 1.f, 0.f}, Pi / 2);
+    MV_CHECK(history.push(a));
+    MV_CHECK(history.push(b));
+
+    PoseSample out;
+    MV_CHECK(history.sample(15 * NsPerMs, out));
+    MV_CHECK(out.timeNs == 15 * NsPerMs);
+    MV_CHECK_NEAR(out.pose.position.x, 15.0, 1e-5);
+    MV_CHECK_NEAR(out.pose.position.z, 17.0, 1e-5);
+    const Quatf expected = fromAxisAngle({0.f, 1.f, 0.f}, Pi / 4);
+    MV_CHECK_NEAR(std::abs(dot(out.pose.orientation, expected)), 1.0, 1e-6);
+
+    // On a sample: that sample
+    MV_CHECK(history.sample(10 * NsPerMs, out));
+    MV_CHECK_NEAR(out.pose.position.x, 10.0, 1e-6);
+    MV_CHECK(history.newest(out));
+    MV_CHECK(out.timeNs == 20 * NsPerMs);
+}
+
+/**
+ * @brief Before the oldest sample, the oldest sample, including once older
+ * ones have been evicted.
+ */
+static void testBeforeOldest() {
+    PoseHistory history(4);
+    MV_CHECK(history.capacity() == 4);
+    for (int64_t ms = 1; ms <= 10; ++ms) {
+        MV_CHECK(history.push(makeSample(ms * NsPerMs)));
+    }
+    PoseSample out;
+    MV_CHECK(history.sample(0, out));
+    MV_CHECK(out.timeNs == 7 * NsPerMs);
+    MV_CHECK_NEAR(out.pose.position.x, 7.0, 1e-6);
+    MV_CHECK(history.sample(7'500'000, out));
+    MV_CHECK_NEAR(out.pose.position.x, 7.5, 1e-5);
+}
+
+/**
+ * @brief Past the newest sample, along its velocities, up to the limit and
+ * no further.
+ */
+static void testExtrapolation() {
+    PoseHistory history(16, 50 * NsPerMs);
+    PoseSample sample = makeSample(100 * NsPerMs);
+    sample.angularVelocity = {0.f, Pi, 0.f};
+    MV_CHECK(history.push(sample));
+
+    PoseSample out;
+    MV_CHECK(history.sample(110 * NsPerMs, out));
+    MV_CHECK(out.timeNs == 110 * NsPerMs);
+    MV_CHECK_NEAR(out.pose.position.x, 110.0, 1e-3);
+    // Half a turn a second, for 10 ms
+    const Quatf expected = fromAxisAngle({0.f, 1.f, 0.f}, Pi / 100);
+    MV_CHECK_NEAR(std::abs(dot(out.pose.orientation, expected)), 1.0, 1e-6);
+
+    MV_CHECK(history.sample(1000 * NsPerMs, out));
+    MV_CHECK(out.timeNs == 150 * NsPerMs);
+    MV_CHECK_NEAR(out.pose.position.x, 150.0, 1e-3);
+
+    PoseHistory noExtrapolation(16, 0);
+    MV_CHECK(noExtrapolation.push(sample));
+    MV_CHECK(noExtrapolation.sample(110 * NsPerMs, out));
+    MV_CHECK(out.timeNs == 100 * NsPerMs);
+    MV_CHECK_NEAR(out.pose.position.x, 100.0, 1e-6);
+}
+
+/**
+ * @brief Samples not newer than the newest are dropped; clear() forgets
+ * everything, after which any time goes again.
+ */
+static void testOrderAndClear() {
+    PoseHistory history(8);
+    MV_CHECK(history.push(makeSample(20 * NsPerMs)));
+    MV_CHECK(!history.push(makeSample(20 * NsPerMs)));
+    MV_CHECK(!history.push(makeSample(10 * NsPerMs)));
+
+    history.clear();
+    PoseSample out;
+    MV_CHECK(!history.sample(20 * NsPerMs, out));
+    MV_CHECK(!history.newest(out));
+
+    MV_CHECK(history.push(makeSample(5 * NsPerMs)));
+    MV_CHECK(history.sample(20 * NsPerMs, out));
+    MV_CHECK_NEAR(out.pose.position.x, 20.0, 1e-3);
+    MV_CHECK(history.newest(out));
+    MV_CHECK(out.timeNs == 5 * NsPerMs);
+}
+
+/**
+ * @brief A writer pushing flat out into a 16 sample ring while readers look
+ * up times among the newest and oldest: whatever a lookup returns is whole,
+ * its position matching its time, however often the writer laps it. Copies
+ * overwritten midway need the threads on different cores; on one core this
+ * mostly checks that lookups keep succeeding.
+ */
+static void testConcurrentReaders() {
+    constexpr int64_t Count = 200'000;
+    constexpr int Readers = 3;
+    PoseHistory history(16);
+    std::atomic<bool> done{false};
+
+    std::vector<uint64_t> found(Readers, 0);
+    std::vector<uint64_t> torn(Readers, 0);
+    std::vector<std::thread> readers;
+    for (int r = 0; r < Readers; ++r) {
+        readers.emplace_back([&, r] {
+            uint64_t step = static_cast<uint64_t>(r);
+            while (!done.load(std::memory_order_relaxed)) {
+                PoseSample newest;
+                if (!history.newest(newest)) {
+                    continue;
+                }
+                // Somewhere up to 20 ms back, in quarter milliseconds
+                step = step * 6364136223846793005u + 1442695040888963407u;
+                const int64_t back = static_cast<int64_t>(step >> 33) % 80;
+                PoseSample out;
+                if (!history.sample(newest.timeNs - back * NsPerMs / 4, out)) {
+                    continue;
+                }
+                ++found[r];
+                const float ms = static_cast<float>(out.timeNs) / NsPerMs;
+                const Vec3f p = out.pose.position;
+                if (std::abs(p.x - ms) > 0.05f ||
+                    std::abs(p.y - p.x - 1.f) > 0.05f ||
+                    std::abs(p.z - p.x - 2.f) > 0.05f ||
+                    out.linearVelocity.x != 1000.f) {
+                    ++torn[r];
+                }
+            }
+        });
+    }
+    for (int64_t i = 1; i <= Count; ++i) {
+        history.push(makeSample(i * NsPerMs));
+    }
+    done = true;
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+    uint64_t totalFound = 0;
+    for (int r = 0; r < Readers; ++r) {
+        totalFound += found[r];
+        MV_CHECK(torn[r] == 0);
+    }
+    MV_CHECK(totalFound > 0);
+
+    PoseSample out;
+    MV_CHECK(history.newest(out));
+    MV_CHECK(out.timeNs == Count * NsPerMs);
+}
+
+int main() {
+    testEmpty();
+    testInterpolation();
+    testBeforeOldest();
+    testExtrapolation();
+    testOrderAndClear();
+    testConcurrentReaders();
+    return test::finish("PoseHistoryTest");
+}
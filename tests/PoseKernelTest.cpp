@@ -0,0 +1,163 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+/**
+ * @file
+ * @brief Checks transformPoses, SIMD and scalar, against poses worked out by
+ * hand: eye positions a few centimetres off head positions metres from the
+ * origin, where the old matrix path reported zero.
+ */
+
+#include "TestCheck.h"
+
+#include "Model/PoseKernel.h"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+using namespace metaview;
+
+//! A few ULPs of a position a few metres out
+static constexpr float PositionTolerance = 1e-6f;
+static constexpr float RotationTolerance = 1e-6f;
+
+static constexpr float HalfPi = 1.57079632679f;
+
+/**
+ * @brief A pose to offset, and the result worked out by hand.
+ */
+struct Case {
+    Posef pose;
+    Vec3f offset;
+    Posef expected;
+};
+
+static std::vector<Case> makeCases() {
+    const Quatf identity{0, 0, 0, 1};
+    const Quatf yaw90 = fromAxisAngle({0, 1, 0}, HalfPi);
+    const Quatf pitch180{1, 0, 0, 0};
+    std::vector<Case> ret;
+    // Left eye of an upright head
+    ret.push_back({{identity, {1.f, 1.6f, -2.f}},
+                   {-0.032f, 0, 0},
+                   {identity, {0.968f, 1.6f, -2.f}}});
+    // Turned left a quarter: the right eye ends up in front, towards -z
+    ret.push_back({{yaw90, {1.f, 2.f, 3.f}},
+                   {0.032f, 0, 0},
+                   {yaw90, {1.f, 2.f, 2.968f}}});
+    // Upside down: up and back become down and forward
+    ret.push_back({{pitch180, {0, 1.5f, 0}},
+                   {0, 0.1f, 0.2f},
+                   {pitch180, {0, 1.4f, -0.2f}}});
+    // Not normalized: comes out normalized
+    ret.push_back({{{0, 2 * yaw90.y, 0, 2 * yaw90.w}, {-4.f, 0.5f, 7.f}},
+                   {0, 0, -1.f},
+                   {yaw90, {-5.f, 0.5f, 7.f}}});
+    // An untracked pose's all-zero orientation: identity
+    ret.push_back({{{0, 0, 0, 0}, {3.f, 1.f, 0}},
+                   {0.5f, 0.25f, 0},
+                   {identity, {3.5f, 1.25f, 0}}});
+    // No offset: the pose as is
+    ret.push_back({{yaw90, {-1.f, 1.7f, 0.25f}},
+                   {0, 0, 0},
+                   {yaw90, {-1.f, 1.7f, 0.25f}}});
+    return ret;
+}
+
+static bool matches(Posef const& actual, Posef const& expected) {
+    const Vec3f d = actual.position - expected.position;
+    // q and -q are the same rotation
+    const float rotationError =
+        1.f - std::abs(dot(actual.orientation, expected.orientation));
+    return std::abs(d.x) <= PositionTolerance &&
+           std::abs(d.y) <= PositionTolerance &&
+           std::abs(d.z) <= PositionTolerance &&
+           rotationError <= RotationTolerance &&
+           std::abs(dot(actual.orientation, actual.orientation) - 1.f) <=
+               RotationTolerance;
+}
+
+/**
+ * @brief Run the cases @p copies times over in one batch, so each goes down
+ * the SIMD path and, for a count that isn't a multiple of four, the tail.
+ * @return how many came out wrong.
+ */
+template <typename Transform>
+static size_t countWrong(std::vector<Case> const& cases, size_t copies,
+                         bool inPlace, Transform transform) {
+    std::vector<Posef> poses;
+    std::vector<Vec3f> offsets;
+    for (size_t copy = 0; copy < copies; ++copy) {
+        for (Case const& c : cases) {
+            poses.push_back(c.pose);
+            offsets.push_back(c.offset);
+        }
+    }
+    std::vector<Posef> out(poses.size());
+    Posef* target = inPlace ? poses.data() : out.data();
+    transform(poses.data(), offsets.data(), target, poses.size());
+    size_t wrong = 0;
+    for (size_t i = 0; i < poses.size(); ++i) {
+        if (!matches(target[i], cases[i % cases.size()].expected)) {
+            ++wrong;
+        }
+    }
+    return wrong;
+}
+
+static void testHandWorkedPoses() {
+    const std::vector<Case> cases = makeCases();
+    for (size_t copies : {1, 2, 3}) {
+        for (bool inPlace : {false, true}) {
+            MV_CHECK(countWrong(cases, copies, inPlace, transformPoses) == 0);
+            MV_CHECK(countWrong(cases, copies, inPlace,
+                                transformPosesScalar) == 0);
+        }
+    }
+}
+
+/**
+ * @brief A head rolled left, mirrored into Unity's space: the left eye,
+ * offset on this side of the mirror, lands where the mirrored head puts the
+ * mirrored offset. Rolling doesn't survive conjugating the orientation the
+ * way turning and nodding do, so this is what catches it.
+ */
+static void testMirroredRoll() {
+    const float roll = HalfPi / 3;
+    const float halfIpd = 0.032f;
+    const Posef head{fromAxisAngle({0, 0, 1}, roll), {0.5f, 1.6f, -2.f}};
+    const Vec3f offset{-halfIpd, 0, 0};
+    Posef eye;
+    transformPoses(&head, &offset, &eye, 1);
+
+    // Worked out by hand: the left eye drops as the head rolls left
+    const Posef unityEye = mirrorZ(eye);
+    MV_CHECK_NEAR(unityEye.position.x, 0.5 - halfIpd * std::cos(roll), 1e-6);
+    MV_CHECK_NEAR(unityEye.position.y, 1.6 - halfIpd * std::sin(roll), 1e-6);
+    MV_CHECK_NEAR(unityEye.position.z, 2.0, 1e-6);
+
+    const Posef unityHead = mirrorZ(head);
+    const Vec3f fromHead =
+        unityHead.position +
+        rotate(unityHead.orientation, {offset.x, offset.y, -offset.z});
+    MV_CHECK_NEAR(fromHead.x, unityEye.position.x, 1e-6);
+    MV_CHECK_NEAR(fromHead.y, unityEye.position.y, 1e-6);
+    MV_CHECK_NEAR(fromHead.z, unityEye.position.z, 1e-6);
+    MV_CHECK_NEAR(
+        std::abs(dot(unityEye.orientation, unityHead.orientation)), 1.0,
+        1e-6);
+
+    // Mirroring twice is the pose again
+    const Posef back = mirrorZ(unityEye);
+    MV_CHECK(back.position.z == eye.position.z &&
+             back.orientation.x == eye.orientation.x);
+}
+
+int main() {
+    testHandWorkedPoses();
+    testMirroredRoll();
+    return test::finish("PoseKernelTest");
+}
@@ -0,0 +1,183 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+/**
+ * @file
+ * @brief Replays a head motion trace through the pose predictors and bounds
+ * their error against the trace itself, 10 to 50 ms ahead.
+ */
+
+#include "TestCheck.h"
+
+#include "Model/PosePredictor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace metaview;
+
+/**
+ * @brief Load a motion trace: one sample per line, "time_ns px py pz qx qy
+ * qz qw vx vy vz wx wy wz". Lines starting with '#' are comments.
+ */
+static std::vector<PoseSample> loadTrace(char const* path) {
+    std::vector<PoseSample> ret;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        PoseSample s;
+        Posef& p = s.pose;
+        fields >> s.timeNs >> p.position.x >> p.position.y >> p.position.z >>
+            p.orientation.x >> p.orientation.y >> p.orientation.z >>
+            p.orientation.w >> s.linearVelocity.x >> s.linearVelocity.y >>
+            s.linearVelocity.z >> s.angularVelocity.x >>
+            s.angularVelocity.y >> s.angularVelocity.z;
+        if (fields) {
+            ret.push_back(s);
+        }
+    }
+    return ret;
+}
+
+static double angleBetween(Quatf const& a, Quatf const& b) {
+    const double d = std::min(1.0, std::fabs(static_cast<double>(dot(a, b))));
+    return 2.0 * std::acos(d);
+}
+
+static double distance(Vec3f const& a, Vec3f const& b) {
+    const Vec3f d = a - b;
+    return std::sqrt(static_cast<double>(dot(d, d)));
+}
+
+/**
+ * @brief Errors of predictions made at every sample for one horizon.
+ */
+struct PredictionErrors {
+    //! Millimeters
+    double rmsPosition = 0;
+    double maxPosition = 0;
+    //! Degrees
+    double rmsAngle = 0;
+    double maxAngle = 0;
+};
+
+//! Samples fed before predictions are scored, to let the filters settle.
+static constexpr size_t WarmUp = 100;
+
+/**
+ * @brief Feed the trace through a predictor, and at each sample compare the
+ * prediction @p horizonMs ahead with the sample actually there. With no
+ * predictor, the "prediction" is the newest sample as is.
+ */
+static PredictionErrors measure(std::vector<PoseSample> const& trace,
+                                IPosePredictor* predictor, int horizonMs) {
+    PredictionErrors ret;
+    double sumPosition = 0;
+    double sumAngle = 0;
+    size_t count = 0;
+    // The trace is at 1 kHz.
+    const size_t ahead = static_cast<size_t>(horizonMs);
+    for (size_t i = 0; i + ahead < trace.size(); ++i) {
+        PoseSample predicted = trace[i];
+        if (predictor != nullptr) {
+            predictor->update(trace[i]);
+            if (!predictor->predict(trace[i].timeNs + horizonMs * 1'000'000,
+                                    predicted)) {
+                MV_CHECK(false);
+                return ret;
+            }
+        }
+        if (i < WarmUp) {
+            continue;
+        }
+        PoseSample const& actual = trace[i + ahead];
+        const double mm =
+            1000.0 * distance(predicted.pose.position, actual.pose.position);
+        const double deg =
+            angleBetween(predicted.pose.orientation, actual.pose.orientation) *
+            180.0 / 3.14159265358979;
+        sumPosition += mm * mm;
+        sumAngle += deg * deg;
+        ret.maxPosition = std::max(ret.maxPosition, mm);
+        ret.maxAngle = std::max(ret.maxAngle, deg);
+        ++count;
+    }
+    ret.rmsPosition = std::sqrt(sumPosition / count);
+    ret.rmsAngle = std::sqrt(sumAngle / count);
+    return ret;
+}
+
+/**
+ * @brief Error bounds for one predictor at one horizon: RMS position (mm),
+ * max position (mm), RMS angle (degrees), max angle (degrees).
+ */
+struct Bounds {
+    int horizonMs;
+    double rmsPosition;
+    double maxPosition;
+    double rmsAngle;
+    double maxAngle;
+};
+
+static void checkPredictor(char const* name,
+                           std::vector<PoseSample> const& trace,
+                           PosePredictorType type,
+                           std::vector<Bounds> const& bounds) {
+    for (Bounds const& b : bounds) {
+        std::unique_ptr<IPosePredictor> predictor = makePosePredictor(type);
+        const PredictionErrors e = measure(trace, predictor.get(), b.horizonMs);
+        const PredictionErrors none = measure(trace, nullptr, b.horizonMs);
+        std::printf("%s %2d ms: position rms %.2f max %.2f mm (unpredicted "
+                    "%.2f), angle rms %.3f max %.3f deg (unpredicted %.3f)\n",
+                    name, b.horizonMs, e.rmsPosition, e.maxPosition,
+                    none.rmsPosition, e.rmsAngle, e.maxAngle, none.rmsAngle);
+        MV_CHECK(e.rmsPosition <= b.rmsPosition);
+        MV_CHECK(e.maxPosition <= b.maxPosition);
+        MV_CHECK(e.rmsAngle <= b.rmsAngle);
+        MV_CHECK(e.maxAngle <= b.maxAngle);
+        // Predicting must beat not predicting, by a wide margin.
+        MV_CHECK(e.rmsPosition < none.rmsPosition / 2);
+        MV_CHECK(e.rmsAngle < none.rmsAngle / 2);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::fprintf(stderr, "Usage: %s <motion trace>\n", argv[0]);
+        return 2;
+    }
+    const std::vector<PoseSample> trace = loadTrace(argv[1]);
+    MV_CHECK(trace.size() == 2000);
+    if (trace.size() != 2000) {
+        return test::finish("PosePredictorTest");
+    }
+    // About one and a half times what each predictor achieves on the trace:
+    // tight enough to catch a regression, loose enough for other compilers.
+    checkPredictor("Kalman", trace,
+                   PosePredictorType::ConstantAccelerationKalman,
+                   {{10, 0.3, 0.6, 0.07, 0.2},
+                    {20, 0.35, 0.8, 0.08, 0.25},
+                    {30, 0.45, 1.1, 0.12, 0.35},
+                    {40, 0.6, 1.4, 0.22, 0.65},
+                    {50, 0.9, 2.0, 0.36, 1.0}});
+    checkPredictor("DoubleExponential", trace,
+                   PosePredictorType::DoubleExponential,
+                   {{10, 0.6, 1.2, 0.2, 0.5},
+                    {20, 1.1, 2.0, 0.4, 0.95},
+                    {30, 1.75, 3.0, 0.65, 1.65},
+                    {40, 2.6, 4.1, 1.0, 2.5},
+                    {50, 3.6, 5.5, 1.45, 3.6}});
+    return test::finish("PosePredictorTest");
+}
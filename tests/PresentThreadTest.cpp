@@ -0,0 +1,288 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+/**
+ * @file
+ * @brief Stress tests of SpscQueue and PresentThread: a producer and a
+ * consumer running concurrently must hand over every record exactly once, in
+ * order. Also that a present thread gone to sleep wakes for every submit,
+ * and that a submit to a full queue waits for a stalled present thread.
+ */
+
+#include "TestCheck.h"
+
+#include "Model/PresentThread.h"
+#include "Model/SpscQueue.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using namespace metaview;
+
+/**
+ * @brief A record spanning several words, whose parts can be checked against
+ * each other to catch a torn copy.
+ */
+struct Payload {
+    uint64_t sequence = 0;
+    uint64_t check = 0;
+    uint32_t small = 0;
+};
+
+static Payload makePayload(uint64_t sequence) {
+    Payload p;
+    p.sequence = sequence;
+    p.check = ~sequence * 0x9E3779B97F4A7C15ULL;
+    p.small = static_cast<uint32_t>(sequence % 7919);
+    return p;
+}
+
+/**
+ * @brief Raw queue: tiny capacity, so the producer keeps finding it full and
+ * the consumer keeps finding it empty.
+ */
+static void testQueueStress() {
+    constexpr uint64_t Count = 2'000'000;
+    SpscQueue<Payload> queue(4);
+    MV_CHECK(queue.capacity() == 4);
+
+    std::thread producer([&] {
+        for (uint64_t i = 0; i < Count; ++i) {
+            const Payload p = makePayload(i);
+            while (!queue.tryPush(p)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint64_t expected = 0;
+    uint64_t outOfOrder = 0;
+    uint64_t torn = 0;
+    Payload p;
+    while (expected < Count) {
+        if (!queue.tryPop(p)) {
+            std::this_thread::yield();
+            continue;
+        }
+        const Payload reference = makePayload(p.sequence);
+        if (p.check != reference.check || p.small != reference.small) {
+            ++torn;
+        }
+        if (p.sequence != expected) {
+            ++outOfOrder;
+        }
+        expected = p.sequence + 1;
+    }
+    producer.join();
+
+    MV_CHECK(torn == 0);
+    MV_CHECK(outOfOrder == 0);
+    MV_CHECK(queue.empty());
+    MV_CHECK(!queue.tryPop(p));
+}
+
+/**
+ * @brief Stand-in for the display task path: records what it was given and on
+ * which thread, and sometimes stalls like a real scanout scheduler does.
+ */
+class MockSink : public IPresentSink {
+  public:
+    void onPresentThreadStart() override {
+        ++starts;
+        thread = std::this_thread::get_id();
+        if (!fences.empty()) {
+            ++callsOutsideThread;
+        }
+    }
+
+    void present(PresentRecord const& record) override {
+        if (std::this_thread::get_id() != thread || stops != 0) {
+            ++callsOutsideThread;
+        }
+        fences.push_back(record.fenceValue);
+        if (record.surfaceIndex !=
+            static_cast<int32_t>(record.fenceValue % 3)) {
+            ++mismatched;
+        }
+        if (record.fenceValue % 4096 == 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+
+    void onPresentThreadStop() override { ++stops; }
+
+    std::thread::id thread;
+    int starts = 0;
+    int stops = 0;
+    int callsOutsideThread = 0;
+    uint64_t mismatched = 0;
+    std::vector<uint64_t> fences;
+};
+
+/**
+ * @brief Submit many records through the present thread, with flushes and
+ * stalls mixed in, then check the sink saw each exactly once, in order.
+ */
+static void testPresentThreadStress() {
+    constexpr uint64_t Count = 200'000;
+    MockSink sink;
+    sink.fences.reserve(Count);
+    {
+        PresentThread presenter(sink, 4);
+        for (uint64_t fence = 1; fence <= Count; ++fence) {
+            PresentRecord record;
+            record.surfaceIndex = static_cast<int32_t>(fence % 3);
+            record.fenceValue = fence;
+            presenter.submit(record);
+            if (fence % 10'000 == 0) {
+                presenter.flush();
+                MV_CHECK(presenter.getPresentedCount() == fence);
+            }
+        }
+        // Destruction must present whatever is still queued.
+    }
+
+    MV_CHECK(sink.starts == 1);
+    MV_CHECK(sink.stops == 1);
+    MV_CHECK(sink.callsOutsideThread == 0);
+    MV_CHECK(sink.thread != std::this_thread::get_id());
+    MV_CHECK(sink.mismatched == 0);
+    MV_CHECK(sink.fences.size() == Count);
+    uint64_t outOfOrder = 0;
+    for (size_t i = 0; i < sink.fences.size(); ++i) {
+        if (sink.fences[i] != i + 1) {
+            ++outOfOrder;
+        }
+    }
+    MV_CHECK(outOfOrder == 0);
+}
+
+/**
+ * @brief Stopping straight after a burst of submits loses nothing.
+ */
+static void testStopDrains() {
+    for (int round = 0; round < 200; ++round) {
+        MockSink sink;
+        {
+            PresentThread presenter(sink, 8);
+            for (uint64_t fence = 1; fence <= 8; ++fence) {
+                PresentRecord record;
+                record.surfaceIndex = static_cast<int32_t>(fence % 3);
+                record.fenceValue = fence;
+                presenter.submit(record);
+            }
+        }
+        MV_CHECK(sink.fences.size() == 8);
+        MV_CHECK(sink.stops == 1);
+    }
+}
+
+/**
+ * @brief Wait up to a second for @p presenter to have presented @p count
+ * records.
+ */
+static bool waitPresented(PresentThread const& presenter, uint64_t count) {
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (presenter.getPresentedCount() < count) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+/**
+ * @brief One record at a time, each waited for before the next, so the
+ * present thread goes to sleep in between: each must wake it on its own,
+ * with no later submit to come along and do it instead.
+ */
+static void testWakeEachSubmit() {
+    constexpr uint64_t Count = 20'000;
+    MockSink sink;
+    PresentThread presenter(sink, 4);
+    uint64_t lost = 0;
+    for (uint64_t fence = 1; fence <= Count && lost == 0; ++fence) {
+        PresentRecord record;
+        record.surfaceIndex = static_cast<int32_t>(fence % 3);
+        record.fenceValue = fence;
+        presenter.submit(record);
+        if (!waitPresented(presenter, fence)) {
+            ++lost;
+        }
+    }
+    MV_CHECK(lost == 0);
+}
+
+/**
+ * @brief A sink that holds the present thread in present() until let go,
+ * like a stalled scanout scheduler.
+ */
+class StalledSink : public IPresentSink {
+  public:
+    void present(PresentRecord const& record) override {
+        ++entered;
+        while (stalled.load()) {
+            std::this_thread::yield();
+        }
+        fences.push_back(record.fenceValue);
+    }
+
+    std::atomic_bool stalled{true};
+    std::atomic<int> entered{0};
+    std::vector<uint64_t> fences;
+};
+
+/**
+ * @brief With the present thread stalled and the queue full, a submit waits
+ * until the stall ends, then goes through in order.
+ */
+static void testFullQueueWaits() {
+    StalledSink sink;
+    {
+        PresentThread presenter(sink, 2);
+        PresentRecord record;
+        // The present thread takes the first and stalls; two fill the queue
+        record.fenceValue = 1;
+        presenter.submit(record);
+        while (sink.entered.load() == 0) {
+            std::this_thread::yield();
+        }
+        for (uint64_t fence = 2; fence <= 3; ++fence) {
+            record.fenceValue = fence;
+            presenter.submit(record);
+        }
+        std::atomic_bool submitted{false};
+        std::thread submitter([&] {
+            PresentRecord last;
+            last.fenceValue = 4;
+            presenter.submit(last);
+            submitted = true;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        MV_CHECK(!submitted.load());
+        MV_CHECK(presenter.getPresentedCount() == 0);
+
+        sink.stalled = false;
+        submitter.join();
+        MV_CHECK(submitted.load());
+        MV_CHECK(waitPresented(presenter, 4));
+    }
+    MV_CHECK(sink.fences == std::vector<uint64_t>({1, 2, 3, 4}));
+}
+
+int main() {
+    testQueueStress();
+    // Before anything that would hang on a lost wakeup
+    testWakeEachSubmit();
+    testPresentThreadStress();
+    testStopDrains();
+    testFullQueueWaits();
+    return test::finish("PresentThreadTest");
+}
@@ -0,0 +1,354 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+/**
+ * @file
+ * @brief Checks the CPU reference warps against images worked out by hand:
+ * an orientation warp of a colour ramp for a known yaw, and a positional warp
+ * of a square in front of a wall for a known sideways step, and both for an
+ * eye camera rolled against the head.
+ */
+
+#include "TestCheck.h"
+
+#include "Model/Reprojection.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+using namespace metaview;
+
+static constexpr uint32_t Size = 128;
+static constexpr float Pi = 3.14159265358979f;
+
+/**
+ * @brief A Size x Size RGBA image in memory.
+ */
+struct TestImage {
+    std::vector<uint8_t> pixels = std::vector<uint8_t>(Size * Size * 4, 0);
+
+    ImageView view() { return {pixels.data(), Size, Size, Size * 4}; }
+
+    uint8_t* at(uint32_t x, uint32_t y) {
+        return pixels.data() + (y * Size + x) * 4;
+    }
+};
+
+static bool isBlack(uint8_t const* p) {
+    return p[0] == 0 && p[1] == 0 && p[2] == 0 && p[3] == 255;
+}
+
+/**
+ * @brief Red and green rising two steps per pixel across and down: bilinear
+ * sampling of it is exact, so a sample tells where it was taken from.
+ */
+static TestImage makeRamp() {
+    TestImage ret;
+    for (uint32_t y = 0; y < Size; ++y) {
+        for (uint32_t x = 0; x < Size; ++x) {
+            uint8_t* p = ret.at(x, y);
+            p[0] = static_cast<uint8_t>(2 * x);
+            p[1] = static_cast<uint8_t>(2 * y);
+            p[2] = 0;
+            p[3] = 255;
+        }
+    }
+    return ret;
+}
+
+/**
+ * @brief With no rotation between the images, the warp does nothing.
+ */
+static void testIdentityWarp() {
+    EyeFov fov;
+    fov.left = -1.2f;
+    fov.right = 0.9f;
+    fov.top = 1.1f;
+    fov.bottom = -1.0f;
+    const Quatf orientation =
+        normalize(fromAxisAngle({0.6f, 0.8f, 0.f}, 0.7f));
+    const Mat3f warp = computeOrientationWarp(orientation, orientation, fov);
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) {
+            MV_CHECK_NEAR(warp.m[r][c], r == c ? 1.0 : 0.0, 1e-5);
+        }
+    }
+
+    // Projection and unprojection are inverses.
+    const Mat3f round =
+        makeTextureProjection(fov) * makeTextureUnprojection(fov);
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) {
+            MV_CHECK_NEAR(round.m[r][c], r == c ? 1.0 : 0.0, 1e-6);
+        }
+    }
+}
+
+/**
+ * @brief Turning the head left by @p yaw: the centre of the display shows
+ * what was tan(yaw) to the left of the centre of the rendered image.
+ */
+static void testYawCentre() {
+    const float yaw = 10.f * Pi / 180.f;
+    const Mat3f warp = computeOrientationWarp(
+        Quatf{}, fromAxisAngle({0.f, 1.f, 0.f}, yaw), EyeFov{});
+    const Vec3f s = warp * Vec3f{0.5f, 0.5f, 1.f};
+    MV_CHECK(s.z > 0.f);
+    MV_CHECK_NEAR(s.x / s.z, 0.5 - std::tan(yaw) / 2, 1e-6);
+    MV_CHECK_NEAR(s.y / s.z, 0.5, 1e-6);
+}
+
+/**
+ * @brief Warp the ramp for a yaw and pitch, and compare every pixel with
+ * where the rotation, done here with plain trigonometry, says it comes from.
+ */
+static void testOrientationImage() {
+    const float yaw = 10.f * Pi / 180.f;
+    const float pitch = -4.f * Pi / 180.f;
+    const Quatf display = fromAxisAngle({0.f, 1.f, 0.f}, yaw) *
+                          fromAxisAngle({1.f, 0.f, 0.f}, pitch);
+    TestImage src = makeRamp();
+    TestImage dst;
+    warpImageCpu(src.view(), dst.view(),
+                 computeOrientationWarp(Quatf{}, display, EyeFov{}));
+
+    uint32_t checked = 0;
+    uint32_t black = 0;
+    uint32_t wrong = 0;
+    for (uint32_t y = 0; y < Size; ++y) {
+        for (uint32_t x = 0; x < Size; ++x) {
+            // Display pixel centre to a direction, FOV 90 degrees square
+            const double dx = 2.0 * (x + 0.5) / Size - 1.0;
+            const double dy = 1.0 - 2.0 * (y + 0.5) / Size;
+            const double dz = -1.0;
+            // Pitch about X, then yaw about Y, into the rendered eye
+            const double y1 = dy * std::cos(pitch) - dz * std::sin(pitch);
+            const double z1 = dy * std::sin(pitch) + dz * std::cos(pitch);
+            const double x2 = dx * std::cos(yaw) + z1 * std::sin(yaw);
+            const double z2 = -dx * std::sin(yaw) + z1 * std::cos(yaw);
+            const double su = (x2 / -z2 + 1.0) / 2.0;
+            const double sv = (1.0 - y1 / -z2) / 2.0;
+            uint8_t const* p = dst.at(x, y);
+            if (su < 0.0 || su > 1.0 || sv < 0.0 || sv > 1.0) {
+                // Keep clear of the boundary, where rounding could go
+                // either way.
+                if (su < -1e-3 || su > 1.001 || sv < -1e-3 || sv > 1.001) {
+                    ++black;
+                    wrong += isBlack(p) ? 0 : 1;
+                }
+                continue;
+            }
+            // Texel coordinates; outside [0, Size - 1] the edge clamps.
+            const double fx = su * Size - 0.5;
+            const double fy = sv * Size - 0.5;
+            if (fx < 0.0 || fx > Size - 1 || fy < 0.0 || fy > Size - 1) {
+                continue;
+            }
+            ++checked;
+            if (std::fabs(p[0] - 2.0 * fx) > 1.01 ||
+                std::fabs(p[1] - 2.0 * fy) > 1.01) {
+                ++wrong;
+            }
+        }
+    }
+    MV_CHECK(wrong == 0);
+    // Most of the image is compared, and the yaw uncovers a strip on the
+    // left.
+    MV_CHECK(checked > Size * Size * 3 / 4);
+    MV_CHECK(black > Size * 8);
+}
+
+/**
+ * @brief Turned right round, nothing rendered is in view.
+ */
+static void testBehind() {
+    TestImage src = makeRamp();
+    TestImage dst;
+    warpImageCpu(src.view(), dst.view(),
+                 computeOrientationWarp(
+                     Quatf{}, fromAxisAngle({0.f, 1.f, 0.f}, Pi), EyeFov{}));
+    uint32_t notBlack = 0;
+    for (uint32_t y = 0; y < Size; ++y) {
+        for (uint32_t x = 0; x < Size; ++x) {
+            notBlack += isBlack(dst.at(x, y)) ? 0 : 1;
+        }
+    }
+    MV_CHECK(notBlack == 0);
+}
+
+//! Depths of the synthetic scene, in meters.
+static constexpr float WallDepth = 2.f;
+static constexpr float SquareDepth = 0.5f;
+//! The square covers source pixels [SquareMin, SquareMax) in x and y.
+static constexpr uint32_t SquareMin = 40;
+static constexpr uint32_t SquareMax = 72;
+
+/**
+ * @brief A wall, textured with the ramp, and a square in front of it, with
+ * the ramp in red and full green.
+ */
+static void makeScene(TestImage& color, std::vector<float>& depth) {
+    color = makeRamp();
+    depth.assign(Size * Size, WallDepth);
+    for (uint32_t y = 0; y < Size; ++y) {
+        for (uint32_t x = 0; x < Size; ++x) {
+            uint8_t* p = color.at(x, y);
+            p[1] = 0;
+            if (x >= SquareMin && x < SquareMax && y >= SquareMin &&
+                y < SquareMax) {
+                p[1] = 200;
+                depth[y * Size + x] = SquareDepth;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Step the eye 12.5 cm to the left between render and display. With a
+ * 90 degree FOV over 128 pixels everything moves right by 8 px / depth: the
+ * wall by 4 pixels, the square by 16, so the square slides over the wall and
+ * must stay in front of it.
+ */
+static void testPositionalTranslation() {
+    TestImage src;
+    std::vector<float> depthBuffer;
+    makeScene(src, depthBuffer);
+    const ConstDepthView depth{depthBuffer.data(), Size, Size,
+                               Size * sizeof(float)};
+    Posef displayEye;
+    displayEye.position = {-0.125f, 0.f, 0.f};
+    const Posef delta = computeEyeDelta(Posef{}, displayEye);
+
+    // A single texel, by hand first
+    float u = 0.f, v = 0.f, outDepth = 0.f;
+    MV_CHECK(reprojectTexel(0.5f, 0.25f, WallDepth, delta, EyeFov{}, u, v,
+                            outDepth));
+    MV_CHECK_NEAR(u * Size, 0.5 * Size + 4, 1e-3);
+    MV_CHECK_NEAR(v, 0.25, 1e-6);
+    MV_CHECK_NEAR(outDepth, WallDepth, 1e-6);
+
+    TestImage dst;
+    warpImagePositionalCpu(src.view(), depth, dst.view(), delta, EyeFov{});
+
+    const uint32_t wallShift = 4;
+    const uint32_t squareShift = 16;
+    uint32_t wrongSquare = 0;
+    uint32_t wrongWall = 0;
+    uint32_t wrongEdge = 0;
+    for (uint32_t y = 0; y < Size; ++y) {
+        for (uint32_t x = 0; x < Size; ++x) {
+            uint8_t const* p = dst.at(x, y);
+            if (x < wallShift - 1) {
+                // Uncovered at the left edge
+                wrongEdge += isBlack(p) ? 0 : 1;
+            } else if (x >= SquareMax + wallShift + 6 && x < Size - 4) {
+                // Wall right of the square, moved by the wall's amount
+                if (p[1] != 0 ||
+                    std::abs(p[0] - 2 * static_cast<int>(x - wallShift)) >
+                        1) {
+                    ++wrongWall;
+                }
+            }
+            // Square interior, leaving a pixel for the bilinear edges. Its
+            // right end overlaps the mesh folding back to the wall, which
+            // the depth test must hide.
+            if (x > SquareMin + squareShift && x < SquareMax + 7 &&
+                y > SquareMin + 1 && y < SquareMax - 10) {
+                if (p[1] != 200 ||
+                    std::abs(p[0] - 2 * static_cast<int>(x - squareShift)) >
+                        1) {
+                    ++wrongSquare;
+                }
+            }
+        }
+    }
+    MV_CHECK(wrongSquare == 0);
+    MV_CHECK(wrongWall == 0);
+    MV_CHECK(wrongEdge == 0);
+}
+
+/**
+ * @brief Points at infinity don't move with translation: with no depth at
+ * all the image comes through unchanged.
+ */
+static void testPositionalInfinity() {
+    TestImage src = makeRamp();
+    const std::vector<float> depthBuffer(Size * Size, 0.f);
+    const ConstDepthView depth{depthBuffer.data(), Size, Size,
+                               Size * sizeof(float)};
+    Posef displayEye;
+    displayEye.position = {0.3f, -0.2f, 0.1f};
+    TestImage dst;
+    warpImagePositionalCpu(src.view(), depth, dst.view(),
+                           computeEyeDelta(Posef{}, displayEye), EyeFov{});
+    uint32_t wrong = 0;
+    for (uint32_t y = 0; y < Size; ++y) {
+        for (uint32_t x = 0; x < Size; ++x) {
+            uint8_t const* a = src.at(x, y);
+            uint8_t const* b = dst.at(x, y);
+            if (std::abs(a[0] - b[0]) > 1 || std::abs(a[1] - b[1]) > 1) {
+                ++wrong;
+            }
+        }
+    }
+    MV_CHECK(wrong == 0);
+}
+
+/**
+ * @brief Eye cameras rolled a quarter turn against the head, as for panels
+ * mounted sideways: a head yaw moves the image up or down the eye buffer,
+ * and a sideways step moves the wall along the same axis.
+ */
+static void testRolledEye() {
+    const float yaw = 10.f * Pi / 180.f;
+    const Quatf headYaw = fromAxisAngle({0.f, 1.f, 0.f}, yaw);
+    // The left eye's X points up the head, the right eye's down
+    const Quatf roll[2] = {fromAxisAngle({0.f, 0.f, 1.f}, Pi / 2),
+                           fromAxisAngle({0.f, 0.f, 1.f}, -Pi / 2)};
+    const float expectedV[2] = {0.5f - std::tan(yaw) / 2,
+                                0.5f + std::tan(yaw) / 2};
+    for (int eye = 0; eye < 2; ++eye) {
+        const Mat3f warp =
+            computeOrientationWarp(Quatf{}, headYaw, roll[eye], EyeFov{});
+        const Vec3f s = warp * Vec3f{0.5f, 0.5f, 1.f};
+        MV_CHECK(s.z > 0.f);
+        MV_CHECK_NEAR(s.x / s.z, 0.5, 1e-6);
+        MV_CHECK_NEAR(s.y / s.z, expectedV[eye], 1e-6);
+        // The same as warping the eye orientations directly
+        const Mat3f direct =
+            computeOrientationWarp(roll[eye], headYaw * roll[eye], EyeFov{});
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 3; ++c) {
+                MV_CHECK_NEAR(warp.m[r][c], direct.m[r][c], 1e-6);
+            }
+        }
+    }
+
+    // The head steps 12.5 cm left: the wall 2 m away moves 4 pixels towards
+    // the head's right, which is down the left eye's image.
+    Posef displayHead;
+    displayHead.position = {-0.125f, 0.f, 0.f};
+    const Posef leftEye{roll[0], {-0.032f, 0.f, 0.f}};
+    const Posef delta = computeEyeDelta(Posef{}, displayHead, leftEye);
+    float u = 0.f, v = 0.f, outDepth = 0.f;
+    MV_CHECK(reprojectTexel(0.5f, 0.5f, WallDepth, delta, EyeFov{}, u, v,
+                            outDepth));
+    MV_CHECK_NEAR(u, 0.5, 1e-6);
+    MV_CHECK_NEAR(v * Size, 0.5 * Size + 4, 1e-3);
+    MV_CHECK_NEAR(outDepth, WallDepth, 1e-6);
+}
+
+int main() {
+    testIdentityWarp();
+    testYawCentre();
+    testOrientationImage();
+    testBehind();
+    testPositionalTranslation();
+    testPositionalInfinity();
+    testRolledEye();
+    return test::finish("ReprojectionTest");
+}
@@ -0,0 +1,357 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+/**
+ * @file
+ * @brief Runs a SharedTrackingWriter in a forked child process and a
+ * SharedTrackingSource in this one, and checks what arrives: order, lost
+ * sample counts, rejection of records caught mid-write, and picking up a
+ * writer that restarted.
+ */
+
+#include "TestCheck.h"
+
+#include "Model/Clock.h"
+#include "Model/SharedMemoryTracking.h"
+
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace metaview;
+
+//! How long to wait for the other process before giving up.
+static constexpr int TimeoutMs = 10'000;
+
+/**
+ * @brief A child process running a writer, and two pipes to step it along.
+ */
+class WriterProcess {
+  public:
+    //! What the child does: gets the pipes to wait for the parent's go
+    //! ahead and to report back. Returns its exit code.
+    using Body = std::function<int(WriterProcess&)>;
+
+    explicit WriterProcess(Body const& body) {
+        int toChild[2];
+        int toParent[2];
+        if (pipe(toChild) != 0 || pipe(toParent) != 0) {
+            MV_CHECK(false);
+            return;
+        }
+        pid_ = fork();
+        if (pid_ == 0) {
+            ::close(toChild[1]);
+            ::close(toParent[0]);
+            in_ = toChild[0];
+            out_ = toParent[1];
+            _exit(body(*this));
+        }
+        ::close(toChild[0]);
+        ::close(toParent[1]);
+        in_ = toParent[0];
+        out_ = toChild[1];
+    }
+
+    //! Wait for the child to exit, and get its exit code.
+    int join() {
+        ::close(out_);
+        int status = 0;
+        if (waitpid(pid_, &status, 0) != pid_ || !WIFEXITED(status)) {
+            return -1;
+        }
+        ::close(in_);
+        return WEXITSTATUS(status);
+    }
+
+    //! Tell the other side to carry on.
+    void signal() {
+        const char c = 1;
+        MV_CHECK(write(out_, &c, 1) == 1);
+    }
+
+    /**
+     * @brief Wait for the other side's signal, calling @p idle every few
+     * milliseconds meanwhile.
+     */
+    bool wait(std::function<void()> const& idle = {}) {
+        for (int waited = 0; waited < TimeoutMs; waited += 10) {
+            pollfd fd = {in_, POLLIN, 0};
+            if (poll(&fd, 1, 10) == 1) {
+                char c = 0;
+                return read(in_, &c, 1) == 1;
+            }
+            if (idle) {
+                idle();
+            }
+        }
+        return false;
+    }
+
+  private:
+    pid_t pid_ = -1;
+    int in_ = -1;
+    int out_ = -1;
+};
+
+/**
+ * @brief A sample whose fields all derive from its index, so a copy mixing
+ * two writes is caught. The time is real: the writer's heartbeat is the
+ * newest sample time.
+ */
+static TrackedSample makeSample(uint32_t device, uint64_t index) {
+    const float f = static_cast<float>(index);
+    TrackedSample ret;
+    ret.device = device;
+    PoseSample& s = ret.sample;
+    s.timeNs = SteadyClock::instance().now();
+    s.pose.position = {f, f + 1, f + 2};
+    s.pose.orientation = {f + 3, f + 4, f + 5, f + 6};
+    s.linearVelocity = {f + 7, f + 8, f + 9};
+    s.angularVelocity = {f + 10, f + 11, f + 12};
+    return ret;
+}
+
+//! Index of a sample from makeSample(), or -1 if its fields disagree.
+static int64_t indexOf(TrackedSample const& sample) {
+    PoseSample const& s = sample.sample;
+    const float f = s.pose.position.x;
+    const bool consistent =
+        s.pose.position.y == f + 1 && s.pose.position.z == f + 2 &&
+        s.pose.orientation.x == f + 3 && s.pose.orientation.y == f + 4 &&
+        s.pose.orientation.z == f + 5 && s.pose.orientation.w == f + 6 &&
+        s.linearVelocity.x == f + 7 && s.linearVelocity.y == f + 8 &&
+        s.linearVelocity.z == f + 9 && s.angularVelocity.x == f + 10 &&
+        s.angularVelocity.y == f + 11 && s.angularVelocity.z == f + 12;
+    return consistent ? static_cast<int64_t>(f) : -1;
+}
+
+static std::string blockName(char const* test) {
+    return std::string("MetaViewTrackingTest") + test +
+           std::to_string(getpid());
+}
+
+//! Read everything there is, returning the indices of what came.
+static std::vector<int64_t> readAll(SharedTrackingSource& source,
+                                    uint32_t device) {
+    std::vector<int64_t> ret;
+    TrackedSample buffer[8];
+    size_t n;
+    while ((n = source.read(buffer, 8)) != 0) {
+        for (size_t i = 0; i < n; ++i) {
+            MV_CHECK(buffer[i].device == device);
+            ret.push_back(indexOf(buffer[i]));
+        }
+    }
+    return ret;
+}
+
+static std::vector<int64_t> range(int64_t first, int64_t last) {
+    std::vector<int64_t> ret;
+    for (int64_t i = first; i <= last; ++i) {
+        ret.push_back(i);
+    }
+    return ret;
+}
+
+/**
+ * @brief Everything written arrives in order while the ring holds it. A
+ * record still being written is skipped and counted lost, and so is whatever
+ * the writer laps before the reader gets there.
+ */
+static void testOrderAndLoss() {
+    const std::string name = blockName("Order");
+    constexpr uint32_t Capacity = 16;
+    WriterProcess child([&](WriterProcess& parent) {
+        SharedTrackingWriter writer(name, Capacity);
+        parent.signal();
+        if (!parent.wait()) {
+            return 1;
+        }
+        for (uint64_t i = 0; i < 6; ++i) {
+            writer.write(makeSample(1, i));
+        }
+        // Record 6 as a writer leaves it mid-write: odd sequence number,
+        // already counted.
+        SharedMemoryRegion raw;
+        if (!raw.create(name, shared_tracking::blockSize(Capacity))) {
+            return 2;
+        }
+        auto* header = static_cast<shared_tracking::Header*>(raw.data());
+        auto* records = reinterpret_cast<shared_tracking::Record*>(
+            static_cast<char*>(raw.data()) + shared_tracking::blockSize(0));
+        records[6].sequence.store(2 * 6 + 1);
+        header->writeCount.store(7);
+        for (uint64_t i = 7; i <= 12; ++i) {
+            writer.write(makeSample(1, i));
+        }
+        parent.signal();
+
+        // A hundred more while the reader isn't looking.
+        if (!parent.wait()) {
+            return 1;
+        }
+        for (uint64_t i = 13; i <= 112; ++i) {
+            writer.write(makeSample(1, i));
+        }
+        parent.signal();
+        parent.wait();
+        return 0;
+    });
+
+    SharedTrackingSource source(name);
+    MV_CHECK(child.wait());
+    MV_CHECK(source.isConnected());
+    child.signal();
+    MV_CHECK(child.wait());
+
+    // All still in the ring, bar the one never finished.
+    std::vector<int64_t> expected = range(0, 5);
+    const std::vector<int64_t> after = range(7, 12);
+    expected.insert(expected.end(), after.begin(), after.end());
+    MV_CHECK(readAll(source, 1) == expected);
+    MV_CHECK(source.getLostSamples() == 1);
+
+    child.signal();
+    MV_CHECK(child.wait());
+    // Of the 100 written since, only the newest ring's worth are left.
+    MV_CHECK(readAll(source, 1) == range(113 - Capacity, 112));
+    MV_CHECK(source.getLostSamples() == 1 + 100 - Capacity);
+
+    child.signal();
+    MV_CHECK(child.join() == 0);
+}
+
+/**
+ * @brief The writer flat out on a tiny ring, the reader racing it: every
+ * sample that arrives is whole and newer than the last, and every one
+ * written either arrives or is counted lost. Overwrites in the middle of a
+ * copy need the two processes on different cores; on one core this mostly
+ * checks the accounting.
+ */
+static void testRacingWriter() {
+    const std::string name = blockName("Race");
+    constexpr uint64_t Count = 500'000;
+    WriterProcess child([&](WriterProcess& parent) {
+        SharedTrackingWriter writer(name, 8);
+        parent.signal();
+        if (!parent.wait()) {
+            return 1;
+        }
+        for (uint64_t i = 0; i < Count; ++i) {
+            writer.write(makeSample(3, i));
+        }
+        parent.wait();
+        return 0;
+    });
+
+    SharedTrackingSource source(name);
+    MV_CHECK(child.wait());
+    MV_CHECK(source.isConnected());
+    child.signal();
+
+    uint64_t received = 0;
+    uint64_t torn = 0;
+    uint64_t outOfOrder = 0;
+    int64_t last = -1;
+    TrackedSample buffer[4];
+    const int64_t deadline =
+        SteadyClock::instance().now() + int64_t(TimeoutMs) * 1'000'000;
+    while (received + source.getLostSamples() < Count &&
+           SteadyClock::instance().now() < deadline) {
+        const size_t n = source.read(buffer, 4);
+        for (size_t i = 0; i < n; ++i) {
+            const int64_t index = indexOf(buffer[i]);
+            if (index < 0) {
+                ++torn;
+            } else if (index <= last) {
+                ++outOfOrder;
+            } else {
+                last = index;
+            }
+        }
+        received += n;
+    }
+    MV_CHECK(torn == 0);
+    MV_CHECK(outOfOrder == 0);
+    MV_CHECK(received + source.getLostSamples() == Count);
+    MV_CHECK(last == int64_t(Count) - 1);
+
+    child.signal();
+    MV_CHECK(child.join() == 0);
+}
+
+/**
+ * @brief A writer that exits and a new one under the same name: the reader
+ * notices the old one went quiet and follows the new block.
+ */
+static void testWriterRestart() {
+    const std::string name = blockName("Restart");
+    auto writerBody = [&](uint32_t device) {
+        return [&name, device](WriterProcess& parent) {
+            SharedTrackingWriter writer(name, 16);
+            auto heartbeat = [&] {
+                writer.heartbeat(SteadyClock::instance().now());
+            };
+            parent.signal();
+            if (!parent.wait(heartbeat)) {
+                return 1;
+            }
+            for (uint64_t i = 0; i < 5; ++i) {
+                writer.write(makeSample(device, i));
+            }
+            parent.signal();
+            parent.wait(heartbeat);
+            return 0;
+        };
+    };
+
+    SharedTrackingSource source(name);
+    WriterProcess first(writerBody(1));
+    MV_CHECK(first.wait());
+    MV_CHECK(source.isConnected());
+    first.signal();
+    MV_CHECK(first.wait());
+    MV_CHECK(readAll(source, 1) == range(0, 4));
+    first.signal();
+    MV_CHECK(first.join() == 0);
+
+    // The old block lingers, mapped, until its heartbeat goes stale.
+    const int64_t deadline =
+        SteadyClock::instance().now() + int64_t(TimeoutMs) * 1'000'000;
+    while (source.isConnected() && SteadyClock::instance().now() < deadline) {
+        usleep(10'000);
+    }
+    MV_CHECK(!source.isConnected());
+
+    WriterProcess second(writerBody(2));
+    MV_CHECK(second.wait());
+    bool reconnected = false;
+    while (!reconnected && SteadyClock::instance().now() < deadline) {
+        usleep(10'000);
+        reconnected = source.isConnected();
+    }
+    MV_CHECK(reconnected);
+    second.signal();
+    MV_CHECK(second.wait());
+    // From the start of the new block, none lost across the restart.
+    MV_CHECK(readAll(source, 2) == range(0, 4));
+    MV_CHECK(source.getLostSamples() == 0);
+    second.signal();
+    MV_CHECK(second.join() == 0);
+}
+
+int main() {
+    testOrderAndLoss();
+    testRacingWriter();
+    testWriterRestart();
+    return test::finish("SharedMemoryTrackingTest");
+}
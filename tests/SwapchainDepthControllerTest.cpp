@@ -0,0 +1,135 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+/**
+ * @file
+ * @brief Feeds SwapchainDepthController a steady frame load and checks it
+ * goes to triple buffering, and back, exactly at its streak thresholds.
+ */
+
+#include "TestCheck.h"
+
+#include "Model/SwapchainDepthController.h"
+
+#include <cstdint>
+
+using namespace metaview;
+
+static constexpr double Period90 = 1000.0 / 90.0;
+
+/**
+ * @brief Run @p count frames whose CPU plus GPU time is @p load of the
+ * period, split evenly.
+ * @return the depth after the last of them.
+ */
+static uint32_t run(SwapchainDepthController& controller, double load,
+                    uint32_t count) {
+    uint32_t depth = controller.getDepth();
+    const double ms = load * Period90 / 2;
+    for (uint32_t i = 0; i < count; ++i) {
+        depth = controller.update(ms, ms, Period90);
+    }
+    return depth;
+}
+
+/**
+ * @brief Triple buffered after 30 frames in a row over 0.9 of the period,
+ * not one sooner; a frame at the threshold restarts the streak.
+ */
+static void testRaiseThreshold() {
+    SwapchainDepthController controller;
+    MV_CHECK(controller.getDepth() == 2);
+    MV_CHECK(run(controller, 0.95, 29) == 2);
+    MV_CHECK(run(controller, 0.9, 1) == 2);
+    MV_CHECK(run(controller, 0.95, 29) == 2);
+    MV_CHECK(run(controller, 0.95, 1) == 3);
+    MV_CHECK_NEAR(controller.getLoad(), 0.95, 1e-9);
+}
+
+/**
+ * @brief Back to double buffering after 300 frames in a row under 0.7 of
+ * the period, not one sooner; a frame at the threshold restarts the streak,
+ * and loads between the thresholds hold either depth.
+ */
+static void testLowerThreshold() {
+    SwapchainDepthController controller;
+    MV_CHECK(run(controller, 1.2, 30) == 3);
+    MV_CHECK(run(controller, 0.8, 1000) == 3);
+
+    MV_CHECK(run(controller, 0.5, 200) == 3);
+    MV_CHECK(run(controller, 0.7, 1) == 3);
+    MV_CHECK(run(controller, 0.5, 299) == 3);
+    MV_CHECK(run(controller, 0.5, 1) == 2);
+
+    // Then counting towards raising afresh
+    MV_CHECK(run(controller, 0.8, 1000) == 2);
+    MV_CHECK(run(controller, 0.95, 29) == 2);
+    MV_CHECK(run(controller, 0.95, 1) == 3);
+}
+
+/**
+ * @brief Frames without a valid GPU time or period neither count towards
+ * nor break the streak.
+ */
+static void testMissingMeasurements() {
+    SwapchainDepthController controller;
+    MV_CHECK(run(controller, 0.95, 20) == 2);
+    for (int i = 0; i < 100; ++i) {
+        MV_CHECK(controller.update(Period90, 0.0, Period90) == 2);
+        MV_CHECK(controller.update(Period90, Period90, 0.0) == 2);
+        MV_CHECK(controller.update(-1.0, Period90, Period90) == 2);
+    }
+    MV_CHECK_NEAR(controller.getLoad(), 0.95, 1e-9);
+    MV_CHECK(run(controller, 0.95, 9) == 2);
+    MV_CHECK(run(controller, 0.95, 1) == 3);
+}
+
+/**
+ * @brief reset() goes back to the shallow depth and forgets the streak and
+ * the load.
+ */
+static void testReset() {
+    SwapchainDepthController controller;
+    MV_CHECK(run(controller, 1.2, 30) == 3);
+    MV_CHECK(run(controller, 0.5, 299) == 3);
+    controller.reset();
+    MV_CHECK(controller.getDepth() == 2);
+    MV_CHECK(controller.getLoad() == 0);
+
+    // A raise streak under way is forgotten too
+    MV_CHECK(run(controller, 0.95, 29) == 2);
+    controller.reset();
+    MV_CHECK(run(controller, 0.95, 29) == 2);
+    MV_CHECK(run(controller, 0.95, 1) == 3);
+}
+
+/**
+ * @brief Custom depths and thresholds are honoured.
+ */
+static void testConfig() {
+    SwapchainDepthConfig config;
+    config.minDepth = 1;
+    config.maxDepth = 4;
+    config.raiseLoad = 0.5;
+    config.raiseFrames = 5;
+    config.lowerLoad = 0.25;
+    config.lowerFrames = 10;
+    SwapchainDepthController controller(config);
+    MV_CHECK(controller.getDepth() == 1);
+    MV_CHECK(run(controller, 0.6, 4) == 1);
+    MV_CHECK(run(controller, 0.6, 1) == 4);
+    MV_CHECK(run(controller, 0.3, 100) == 4);
+    MV_CHECK(run(controller, 0.2, 9) == 4);
+    MV_CHECK(run(controller, 0.2, 1) == 1);
+}
+
+int main() {
+    testRaiseThreshold();
+    testLowerThreshold();
+    testMissingMeasurements();
+    testReset();
+    testConfig();
+    return test::finish("SwapchainDepthControllerTest");
+}
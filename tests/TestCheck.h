@@ -0,0 +1,67 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+
+namespace metaview {
+namespace test {
+
+/**
+ * @brief Count of failed checks in this test executable.
+ */
+inline int& failureCount() {
+    static int count = 0;
+    return count;
+}
+
+/**
+ * @brief Report a failed check.
+ */
+inline void fail(char const* file, int line, char const* what) {
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, what);
+    ++failureCount();
+}
+
+/**
+ * @brief Print a summary and get the process exit code: non-zero if any check
+ * failed.
+ */
+inline int finish(char const* name) {
+    if (failureCount() != 0) {
+        std::fprintf(stderr, "%s: %d check(s) failed\n", name,
+                     failureCount());
+        return 1;
+    }
+    std::printf("%s: all checks passed\n", name);
+    return 0;
+}
+
+}  // namespace test
+}  // namespace metaview
+
+//! Check that a condition holds, recording a failure (but carrying on) if not.
+#define MV_CHECK(cond)                                                   \
+    do {                                                                 \
+        if (!(cond)) {                                                   \
+            ::metaview::test::fail(__FILE__, __LINE__, #cond);           \
+        }                                                                \
+    } while (0)
+
+//! Check that two numbers are within a tolerance of each other.
+#define MV_CHECK_NEAR(a, b, tolerance)                                   \
+    do {                                                                 \
+        const double mvCheckA = static_cast<double>(a);                  \
+        const double mvCheckB = static_cast<double>(b);                  \
+        if (!(std::fabs(mvCheckA - mvCheckB) <=                          \
+              static_cast<double>(tolerance))) {                         \
+            std::fprintf(stderr, "%s:%d: %s = %.9g, %s = %.9g\n",        \
+                         __FILE__, __LINE__, #a, mvCheckA, #b, mvCheckB); \
+            ::metaview::test::fail(__FILE__, __LINE__,                   \
+                                   #a " near " #b " within " #tolerance);  \
+        }                                                                \
+    } while (0)
@@ -0,0 +1,149 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+/**
+ * @file
+ * @brief Drives Timebase from a simulated clock: Unity timestamps following
+ * a wall clock that is set and that drifts, and vblank conversions taken
+ * from an attached FramePacer.
+ */
+
+#include "TestCheck.h"
+
+#include "Model/FramePacer.h"
+#include "Model/SimulatedVsync.h"
+#include "Model/Timebase.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+using namespace metaview;
+
+static constexpr int64_t NsPerMs = 1'000'000;
+//! Far enough from today that the first sync always steps.
+static constexpr int64_t Epoch = 1'000'000'000'000'000'000;
+//! 90 Hz
+static constexpr int64_t Period90 = 11'111'111;
+
+//! Unix epoch time minus timebase time, as the timebase maps it.
+static int64_t offsetOf(Timebase const& timebase) {
+    return -timebase.fromUnityTimestamp(0);
+}
+
+/**
+ * @brief The wall clock set: conversions follow it at once, to the
+ * millisecond and back.
+ */
+static void testWallClockStep() {
+    SimulatedClock clock(5'000'000'000);
+    Timebase timebase(clock);
+    timebase.syncWallClock(clock.now(), Epoch);
+    MV_CHECK(offsetOf(timebase) == Epoch - clock.now());
+    MV_CHECK(timebase.getUnityTimestamp() == Epoch / NsPerMs);
+    MV_CHECK(timebase.toUnityTimestamp(clock.now() + 1'600'000) ==
+             Epoch / NsPerMs + 2);
+    MV_CHECK(timebase.fromUnityTimestamp(Epoch / NsPerMs + 7) ==
+             clock.now() + 7 * NsPerMs);
+
+    clock.advance(NsPerMs);
+    timebase.syncWallClock(clock.now(), Epoch + NsPerMs + 3'600'000'000'000);
+    MV_CHECK(offsetOf(timebase) == Epoch - 5'000'000'000 + 3'600'000'000'000);
+}
+
+/**
+ * @brief A wall clock running 100 ppm fast, then set 50 ms ahead: the
+ * mapping slews after it, never by more than the limit per sync, so
+ * converted times stay monotonic.
+ */
+static void testWallClockSlew() {
+    SimulatedClock clock;
+    TimebaseConfig config;
+    Timebase timebase(clock, config);
+    timebase.syncWallClock(0, Epoch);
+
+    constexpr int64_t SyncPeriod = 10 * NsPerMs;
+    int64_t setAhead = 0;
+    int64_t largestMove = 0;
+    // Sync for a minute, returning the last offset.
+    auto run = [&] {
+        int64_t last = offsetOf(timebase);
+        for (int i = 0; i < 6000; ++i) {
+            clock.advance(SyncPeriod);
+            const int64_t t = clock.now();
+            timebase.syncWallClock(t, Epoch + setAhead + t + t / 10'000);
+            const int64_t offset = offsetOf(timebase);
+            largestMove = std::max(largestMove, std::abs(offset - last));
+            last = offset;
+        }
+        return last;
+    };
+    // Settles to a sixteenth-gain loop's lag behind 1 us drift per sync.
+    MV_CHECK_NEAR(run(), Epoch + clock.now() / 10'000, 20'000);
+    MV_CHECK(largestMove < 2'000);
+
+    setAhead = 50 * NsPerMs;
+    MV_CHECK_NEAR(run(), Epoch + setAhead + clock.now() / 10'000, 20'000);
+    MV_CHECK(largestMove == config.maxWallClockSlewNs);
+    MV_CHECK(largestMove < SyncPeriod);
+}
+
+/**
+ * @brief Vblank conversions come from the attached pacer once it locks,
+ * count the vblanks nobody observed, and stop when it is detached.
+ */
+static void testVBlankModel() {
+    constexpr int64_t Jitter = 100'000;
+    SimulatedClock clock;
+    SimulatedVsync vsync(clock, Period90, 3'250'000, Jitter, 7);
+    Timebase timebase(clock);
+    FramePacer pacer(clock);
+    timebase.attachVBlankModel(&pacer);
+    MV_CHECK(!timebase.hasVBlankModel());
+    MV_CHECK(timebase.predictVBlankAtOrAfter(clock.now()) == 0);
+
+    int64_t first = 0;
+    for (int i = 0; i < 150; ++i) {
+        const int64_t observed = vsync.waitForVBlank();
+        if (i == 0) {
+            first = observed;
+        }
+        const bool missed = (i % 7 == 3) || (i >= 60 && i < 64);
+        if (!missed) {
+            pacer.recordVBlank(observed);
+        }
+    }
+    MV_CHECK(timebase.hasVBlankModel());
+    MV_CHECK_NEAR(timebase.getVBlankPeriod(), Period90, 2'000);
+    // The first vblank is number 1, and the 150th the last: the missed ones
+    // were counted.
+    const int64_t next = vsync.vblankAfter(clock.now());
+    MV_CHECK_NEAR(timebase.vblankToTime(1), first, Jitter);
+    MV_CHECK_NEAR(timebase.vblankToTime(150), next - Period90, Jitter);
+    MV_CHECK_NEAR(timebase.vblankToTime(240), next + 89 * Period90, Jitter);
+    MV_CHECK(std::abs(timebase.timeToVBlank(timebase.vblankToTime(200)) -
+                      200) < 1e-3);
+    const int64_t t = clock.now() + Period90 / 2;
+    MV_CHECK(timebase.predictVBlankAtOrAfter(t) ==
+             pacer.predictVBlankAtOrAfter(t));
+
+    // Only the pacer attached can be detached.
+    FramePacer other(clock);
+    timebase.detachVBlankModel(&other);
+    MV_CHECK(timebase.hasVBlankModel());
+    timebase.detachVBlankModel(&pacer);
+    MV_CHECK(!timebase.hasVBlankModel());
+    MV_CHECK(timebase.getVBlankPeriod() == 0);
+    MV_CHECK(timebase.vblankToTime(150) == 0);
+    MV_CHECK(timebase.predictVBlankAtOrAfter(t) == 0);
+}
+
+int main() {
+    testWallClockStep();
+    testWallClockSlew();
+    testVBlankModel();
+    return test::finish("TimebaseTest");
+}
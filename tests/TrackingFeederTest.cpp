@@ -0,0 +1,236 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+/**
+ * @file
+ * @brief Drives a TrackingFeeder from a fake tracking source: samples reach
+ * the pose histories at each poll and are queued for the graphics thread, a
+ * full queue drops only from the queue, the fixed pose fills in while the
+ * source is disconnected, and the feeder's own thread keeps a history
+ * current without anyone reading the queue.
+ */
+
+#include "TestCheck.h"
+
+#include "Model/SimulatedVsync.h"
+#include "Model/TrackingFeeder.h"
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace metaview;
+
+static constexpr int64_t NsPerMs = 1'000'000;
+
+/**
+ * @brief Hands out whatever the test queued, from any thread.
+ */
+class FakeTrackingSource : public ITrackingSource {
+  public:
+    void add(uint32_t device, int64_t timeNs) {
+        TrackedSample sample;
+        sample.device = device;
+        sample.sample.timeNs = timeNs;
+        sample.sample.pose.position = {static_cast<float>(timeNs), 0.f, 0.f};
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.push_back(sample);
+    }
+
+    void setConnected(bool connected) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connected_ = connected;
+    }
+
+    bool isConnected() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return connected_;
+    }
+
+    size_t read(TrackedSample* out, size_t capacity) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t count = 0;
+        while (count < capacity && !pending_.empty()) {
+            out[count++] = pending_.front();
+            pending_.pop_front();
+        }
+        return count;
+    }
+
+  private:
+    std::mutex mutex_;
+    std::deque<TrackedSample> pending_;
+    bool connected_ = true;
+};
+
+static std::vector<TrackedSample> readAll(TrackingFeeder& feeder) {
+    std::vector<TrackedSample> ret;
+    TrackedSample buffer[16];
+    size_t count;
+    while ((count = feeder.read(buffer, 16)) != 0) {
+        ret.insert(ret.end(), buffer, buffer + count);
+    }
+    return ret;
+}
+
+/**
+ * @brief One poll moves everything that arrived, more than a read of the
+ * source holds, into the device's history and the queue, in order. Devices
+ * without a history are only queued.
+ */
+static void testPoll() {
+    SimulatedClock clock(1000 * NsPerMs);
+    TrackingFeeder feeder(clock);
+    auto history = std::make_shared<PoseHistory>();
+    feeder.setHistory(0, history);
+
+    // No source yet: the fixed pose, at the clock's time
+    feeder.poll();
+    MV_CHECK(!feeder.isConnected());
+    PoseSample newest;
+    MV_CHECK(history->newest(newest));
+    MV_CHECK(newest.timeNs == clock.now());
+    MV_CHECK(readAll(feeder).empty());
+
+    auto source = std::make_unique<FakeTrackingSource>();
+    FakeTrackingSource& fake = *source;
+    for (int64_t i = 1; i <= 150; ++i) {
+        fake.add(0, clock.now() + i * NsPerMs);
+    }
+    fake.add(5, clock.now() + 151 * NsPerMs);
+    feeder.setSource(std::move(source));
+    MV_CHECK(feeder.getSourceChanges() == 0);
+    feeder.poll();
+    MV_CHECK(feeder.getSourceChanges() == 1);
+    MV_CHECK(feeder.isConnected());
+    MV_CHECK(history->newest(newest));
+    MV_CHECK(newest.timeNs == clock.now() + 150 * NsPerMs);
+
+    const std::vector<TrackedSample> samples = readAll(feeder);
+    MV_CHECK(samples.size() == 151);
+    bool ordered = true;
+    for (size_t i = 0; i + 1 < samples.size(); ++i) {
+        ordered = ordered &&
+                  samples[i].sample.timeNs < samples[i + 1].sample.timeNs;
+    }
+    MV_CHECK(ordered);
+    MV_CHECK(samples.back().device == 5);
+    MV_CHECK(feeder.getDroppedSamples() == 0);
+}
+
+/**
+ * @brief A reader that falls behind loses samples from the queue, but the
+ * history still gets every one.
+ */
+static void testQueueFull() {
+    SimulatedClock clock;
+    TrackingFeederConfig config;
+    config.queueCapacity = 4;
+    TrackingFeeder feeder(clock, config);
+    auto history = std::make_shared<PoseHistory>(16);
+    feeder.setHistory(0, history);
+    auto source = std::make_unique<FakeTrackingSource>();
+    for (int64_t i = 1; i <= 10; ++i) {
+        source->add(0, i * NsPerMs);
+    }
+    feeder.setSource(std::move(source));
+    feeder.poll();
+
+    const std::vector<TrackedSample> samples = readAll(feeder);
+    MV_CHECK(samples.size() == 4);
+    MV_CHECK(samples.size() == 4 && samples[3].sample.timeNs == 4 * NsPerMs);
+    MV_CHECK(feeder.getDroppedSamples() == 6);
+    PoseSample out;
+    MV_CHECK(history->sample(2'500'000, out));
+    MV_CHECK_NEAR(out.pose.position.x, 2'500'000.0, 1.0);
+    MV_CHECK(history->newest(out));
+    MV_CHECK(out.timeNs == 10 * NsPerMs);
+}
+
+/**
+ * @brief While the source is disconnected, the history gets the fixed pose,
+ * and nothing is read from the source.
+ */
+static void testDisconnected() {
+    SimulatedClock clock;
+    TrackingFeeder feeder(clock);
+    auto history = std::make_shared<PoseHistory>();
+    feeder.setHistory(0, history);
+    auto source = std::make_unique<FakeTrackingSource>();
+    FakeTrackingSource& fake = *source;
+    fake.add(0, 5 * NsPerMs);
+    feeder.setSource(std::move(source));
+    feeder.poll();
+    MV_CHECK(readAll(feeder).size() == 1);
+
+    fake.setConnected(false);
+    fake.add(0, 6 * NsPerMs);
+    clock.advance(20 * NsPerMs);
+    feeder.poll();
+    MV_CHECK(!feeder.isConnected());
+    MV_CHECK(readAll(feeder).empty());
+    PoseSample out;
+    MV_CHECK(history->newest(out));
+    MV_CHECK(out.timeNs == 20 * NsPerMs);
+    MV_CHECK(out.pose.position.x == 0.f);
+
+    // Back again: the sample that waited comes through, though too old for
+    // the history now.
+    fake.setConnected(true);
+    feeder.poll();
+    const std::vector<TrackedSample> samples = readAll(feeder);
+    MV_CHECK(samples.size() == 1);
+    MV_CHECK(history->newest(out));
+    MV_CHECK(out.timeNs == 20 * NsPerMs);
+}
+
+/**
+ * @brief On its own thread, the feeder keeps the history current while
+ * nobody reads the queue, as between two frames.
+ */
+static void testThread() {
+    TrackingFeeder feeder(SteadyClock::instance());
+    auto history = std::make_shared<PoseHistory>();
+    feeder.setHistory(0, history);
+    auto source = std::make_unique<FakeTrackingSource>();
+    FakeTrackingSource& fake = *source;
+    feeder.setSource(std::move(source));
+    feeder.start();
+    feeder.start();
+    MV_CHECK(feeder.isRunning());
+
+    const int64_t start = SteadyClock::instance().now();
+    bool caughtUp = true;
+    for (int64_t i = 1; i <= 20; ++i) {
+        const int64_t timeNs = start + i * NsPerMs;
+        fake.add(0, timeNs);
+        PoseSample out;
+        bool seen = false;
+        for (int wait = 0; wait < 1000 && !seen; ++wait) {
+            seen = history->newest(out) && out.timeNs == timeNs;
+            if (!seen) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        caughtUp = caughtUp && seen;
+    }
+    MV_CHECK(caughtUp);
+    feeder.stop();
+    feeder.stop();
+    MV_CHECK(!feeder.isRunning());
+    MV_CHECK(readAll(feeder).size() == 20);
+}
+
+int main() {
+    testPoll();
+    testQueueFull();
+    testDisconnected();
+    testThread();
+    return test::finish("TrackingFeederTest");
+}
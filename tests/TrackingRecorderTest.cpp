@@ -0,0 +1,189 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+/**
+ * @file
+ * @brief Records from several threads at once, and starts and stops
+ * recording while they do, then reads the files back with
+ * TrackingRecording.
+ */
+
+#include "TestCheck.h"
+
+#include "Model/TrackingRecording.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace metaview;
+using tracking_recording::Record;
+using tracking_recording::RecordType;
+
+static constexpr uint32_t Producers = 4;
+
+/**
+ * @brief A pose whose fields all derive from its sequence number.
+ */
+static PoseSample makeSample(uint64_t sequence) {
+    const float f = static_cast<float>(sequence);
+    PoseSample ret;
+    ret.timeNs = static_cast<int64_t>(sequence);
+    ret.pose.position = {f, f + 1, f + 2};
+    ret.linearVelocity = {f + 3, f + 4, f + 5};
+    return ret;
+}
+
+static bool isWhole(Record const& record) {
+    const float f = static_cast<float>(record.timeNs);
+    return record.position[0] == f && record.position[1] == f + 1 &&
+           record.position[2] == f + 2 && record.linearVelocity[0] == f + 3 &&
+           record.linearVelocity[1] == f + 4 &&
+           record.linearVelocity[2] == f + 5;
+}
+
+/**
+ * @brief What a recording holds, checked record by record: whole, in
+ * recordedNs order, and in order per producer.
+ */
+struct FileCheck {
+    size_t poses = 0;
+    size_t frames = 0;
+    size_t torn = 0;
+    size_t outOfOrder = 0;
+};
+
+static FileCheck checkFile(std::string const& path) {
+    FileCheck ret;
+    TrackingRecording recording(path);
+    std::vector<int64_t> last(Producers, -1);
+    int64_t lastRecordedNs = 0;
+    for (size_t i = 0; i < recording.size(); ++i) {
+        Record const& record = recording[i];
+        if (record.recordedNs < lastRecordedNs) {
+            ++ret.outOfOrder;
+        }
+        lastRecordedNs = record.recordedNs;
+        if (record.type == RecordType::Frame) {
+            ++ret.frames;
+            continue;
+        }
+        ++ret.poses;
+        if (!isWhole(record) || record.device >= Producers) {
+            ++ret.torn;
+            continue;
+        }
+        if (record.timeNs <= last[record.device]) {
+            ++ret.outOfOrder;
+        }
+        last[record.device] = record.timeNs;
+    }
+    return ret;
+}
+
+/**
+ * @brief Producers on several threads: every record is either in the file
+ * or counted dropped, whole, and in order.
+ */
+static void testConcurrentProducers() {
+    constexpr uint64_t PerProducer = 20'000;
+    const std::string path = "TrackingRecorderTest-producers.mvtrack";
+    uint64_t dropped = 0;
+    {
+        TrackingRecorder recorder(1024);
+        MV_CHECK(recorder.start(path));
+        MV_CHECK(recorder.isRecording());
+        std::vector<std::thread> threads;
+        for (uint32_t device = 0; device < Producers; ++device) {
+            threads.emplace_back([&recorder, device] {
+                for (uint64_t i = 0; i < PerProducer; ++i) {
+                    if (device == 0 && i % 100 == 0) {
+                        recorder.recordFrame(i);
+                    }
+                    recorder.recordPose(RecordType::Pose, device,
+                                        tracking_recording::UpdateTypeDynamic,
+                                        makeSample(i));
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        recorder.stop();
+        MV_CHECK(!recorder.isRecording());
+        dropped = recorder.getDroppedRecords();
+    }
+    const FileCheck check = checkFile(path);
+    MV_CHECK(check.torn == 0);
+    MV_CHECK(check.outOfOrder == 0);
+    MV_CHECK(check.poses + check.frames + dropped ==
+             Producers * PerProducer + PerProducer / 100);
+    std::remove(path.c_str());
+}
+
+/**
+ * @brief Start and stop over and over while the producers keep going: no
+ * crash, no record after stop() got through, and every file is valid.
+ */
+static void testStartStopWhileRecording() {
+    const std::string paths[2] = {"TrackingRecorderTest-a.mvtrack",
+                                  "TrackingRecorderTest-b.mvtrack"};
+    TrackingRecorder recorder(256);
+    std::atomic<bool> done{false};
+    std::vector<std::thread> threads;
+    for (uint32_t device = 0; device < Producers; ++device) {
+        threads.emplace_back([&recorder, &done, device] {
+            uint64_t i = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                recorder.recordPose(RecordType::PoseAtTime, device, 0,
+                                    makeSample(i++));
+            }
+        });
+    }
+
+    size_t torn = 0;
+    size_t outOfOrder = 0;
+    size_t records = 0;
+    for (int round = 0; round < 100; ++round) {
+        std::string const& path = paths[round % 2];
+        MV_CHECK(recorder.start(path));
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+        // A second thread stopping at the same time as this one
+        std::thread stopper([&recorder] { recorder.stop(); });
+        recorder.stop();
+        stopper.join();
+        MV_CHECK(!recorder.isRecording());
+
+        const FileCheck check = checkFile(path);
+        torn += check.torn;
+        outOfOrder += check.outOfOrder;
+        records += check.poses;
+    }
+    done = true;
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    MV_CHECK(torn == 0);
+    MV_CHECK(outOfOrder == 0);
+    MV_CHECK(records > 0);
+
+    // Stopped: nothing more is written.
+    const size_t before = TrackingRecording(paths[1]).size();
+    recorder.recordPose(RecordType::Pose, 0, 0, makeSample(1));
+    recorder.recordFrame(1);
+    MV_CHECK(TrackingRecording(paths[1]).size() == before);
+    std::remove(paths[0].c_str());
+    std::remove(paths[1].c_str());
+}
+
+int main() {
+    testConcurrentProducers();
+    testStartStopWhileRecording();
+    return test::finish("TrackingRecorderTest");
+}
@@ -0,0 +1,257 @@
+// Copyright 2020 Meta View, Inc.
+//
+// All rights reserved.
+// SPDX-License-Identifier: UNLICENSED
+
+/**
+ * @file
+ * @brief Checks the SIMD paths of XRMath against the scalar code they
+ * replaced: matrix multiply and quaternion *= to 0 ULP, as XRMath.cpp
+ * promises, and Determinant against a double precision reference.
+ */
+
+#include "TestCheck.h"
+
+#include "ProviderInterface/XRMath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <utility>
+#include <vector>
+
+//! The SIMD paths do the scalar code's operations in its order, unfused.
+static constexpr uint32_t MaxMultiplyUlps = 0;
+static constexpr uint32_t MaxQuaternionUlps = 0;
+
+//! Largest relative error the float determinant may have against a double
+//! one, for well conditioned matrices.
+static constexpr double MaxDeterminantError = 1e-5;
+
+static constexpr size_t RandomCount = 1000;
+
+// The scalar multiply XRMatrix4x4 used before its SIMD path
+static void referenceMultiply(XRMatrix4x4 const& a, XRMatrix4x4 const& b,
+                              XRMatrix4x4& out) {
+    for (int col = 0; col < 4; ++col) {
+        for (int row = 0; row < 4; ++row) {
+            out.m[row][col] = XRVector4::Dot(a.GetRow(row), b.GetCol(col));
+        }
+    }
+}
+
+// The scalar XRQuaternion::operator*=, which operator* still is
+static XRQuaternion referenceMultiply(XRQuaternion const& lhs,
+                                      XRQuaternion const& rhs) {
+    return XRQuaternion(
+        lhs.w * rhs.x + lhs.x * rhs.w + lhs.y * rhs.z - lhs.z * rhs.y,
+        lhs.w * rhs.y + lhs.y * rhs.w + lhs.z * rhs.x - lhs.x * rhs.z,
+        lhs.w * rhs.z + lhs.z * rhs.w + lhs.x * rhs.y - lhs.y * rhs.x,
+        lhs.w * rhs.w - lhs.x * rhs.x - lhs.y * rhs.y - lhs.z * rhs.z);
+}
+
+static double referenceDeterminant(XRMatrix4x4 const& m) {
+    // Gaussian elimination in double, with partial pivoting
+    double a[4][4];
+    for (int r = 0; r < 4; ++r) {
+        for (int c = 0; c < 4; ++c) {
+            a[r][c] = m.m[r][c];
+        }
+    }
+    double det = 1;
+    for (int i = 0; i < 4; ++i) {
+        int pivot = i;
+        for (int r = i + 1; r < 4; ++r) {
+            if (std::abs(a[r][i]) > std::abs(a[pivot][i])) {
+                pivot = r;
+            }
+        }
+        if (a[pivot][i] == 0) {
+            return 0;
+        }
+        if (pivot != i) {
+            std::swap(a[pivot], a[i]);
+            det = -det;
+        }
+        det *= a[i][i];
+        for (int r = i + 1; r < 4; ++r) {
+            const double f = a[r][i] / a[i][i];
+            for (int c = i; c < 4; ++c) {
+                a[r][c] -= f * a[i][c];
+            }
+        }
+    }
+    return det;
+}
+
+//! Distance between two floats in units in the last place.
+static uint32_t ulpDistance(float a, float b) {
+    int32_t ia, ib;
+    std::memcpy(&ia, &a, sizeof(ia));
+    std::memcpy(&ib, &b, sizeof(ib));
+    // Order negative floats below positive ones, as integers
+    if (ia < 0) {
+        ia = INT32_MIN - ia;
+    }
+    if (ib < 0) {
+        ib = INT32_MIN - ib;
+    }
+    return static_cast<uint32_t>(std::abs(static_cast<int64_t>(ia) - ib));
+}
+
+static uint32_t ulpDistance(XRMatrix4x4 const& a, XRMatrix4x4 const& b) {
+    uint32_t ret = 0;
+    for (int r = 0; r < 4; ++r) {
+        for (int c = 0; c < 4; ++c) {
+            ret = std::max(ret, ulpDistance(a.m[r][c], b.m[r][c]));
+        }
+    }
+    return ret;
+}
+
+static XRMatrix4x4 randomMatrix(std::mt19937& rng) {
+    std::uniform_real_distribution<float> unit(-1.f, 1.f);
+    XRMatrix4x4 m;
+    for (int r = 0; r < 4; ++r) {
+        for (int c = 0; c < 4; ++c) {
+            m.m[r][c] = unit(rng);
+        }
+        // Diagonally dominant, so well conditioned
+        m.m[r][r] += 4.f;
+    }
+    return m;
+}
+
+//! Entries of wildly different magnitudes and signs, to make any change in
+//! the order of operations round differently.
+static XRMatrix4x4 randomWideMatrix(std::mt19937& rng) {
+    std::uniform_real_distribution<float> unit(-1.f, 1.f);
+    std::uniform_int_distribution<int> exponent(-20, 20);
+    XRMatrix4x4 m;
+    for (int r = 0; r < 4; ++r) {
+        for (int c = 0; c < 4; ++c) {
+            m.m[r][c] = std::ldexp(unit(rng), exponent(rng));
+        }
+    }
+    return m;
+}
+
+static XRQuaternion randomQuaternion(std::mt19937& rng) {
+    std::uniform_real_distribution<float> unit(-1.f, 1.f);
+    std::uniform_int_distribution<int> exponent(-10, 10);
+    return XRQuaternion(std::ldexp(unit(rng), exponent(rng)),
+                        std::ldexp(unit(rng), exponent(rng)),
+                        std::ldexp(unit(rng), exponent(rng)),
+                        std::ldexp(unit(rng), exponent(rng)));
+}
+
+static void testMatrixMultiply() {
+    std::mt19937 rng(20200101);
+    uint32_t ulps = 0;
+    for (size_t i = 0; i < RandomCount; ++i) {
+        const bool wide = i % 2 != 0;
+        const XRMatrix4x4 a = wide ? randomWideMatrix(rng) : randomMatrix(rng);
+        const XRMatrix4x4 b = wide ? randomWideMatrix(rng) : randomMatrix(rng);
+        XRMatrix4x4 expected;
+        referenceMultiply(a, b, expected);
+        ulps = std::max(ulps, ulpDistance(a * b, expected));
+        XRMatrix4x4 product = a;
+        product *= b;
+        ulps = std::max(ulps, ulpDistance(product, expected));
+    }
+    MV_CHECK(ulps <= MaxMultiplyUlps);
+
+    // A pose times an eye offset: exact
+    XRMatrix4x4 pose = XRMatrix4x4::identity;
+    pose.SetCol(3, XRVector4(1.f, 2.f, 3.f, 1.f));
+    XRMatrix4x4 eye = XRMatrix4x4::identity;
+    eye.SetCol(3, XRVector4(-0.5f, 0.f, 0.25f, 1.f));
+    pose *= eye;
+    const XRVector4 translation = pose.GetCol(3);
+    MV_CHECK(translation.x == 0.5f && translation.y == 2.f &&
+             translation.z == 3.25f && translation.w == 1.f);
+    MV_CHECK(ulpDistance(XRMatrix4x4::identity * eye, eye) == 0);
+}
+
+static void testQuaternionMultiply() {
+    std::mt19937 rng(20200102);
+    uint32_t ulps = 0;
+    for (size_t i = 0; i < RandomCount; ++i) {
+        const XRQuaternion lhs = randomQuaternion(rng);
+        const XRQuaternion rhs = randomQuaternion(rng);
+        const XRQuaternion expected = referenceMultiply(lhs, rhs);
+        XRQuaternion q = lhs;
+        q *= rhs;
+        ulps = std::max({ulps, ulpDistance(q.x, expected.x),
+                         ulpDistance(q.y, expected.y),
+                         ulpDistance(q.z, expected.z),
+                         ulpDistance(q.w, expected.w)});
+    }
+    MV_CHECK(ulps <= MaxQuaternionUlps);
+
+    // i * j = k, and j * i = -k
+    XRQuaternion q(1.f, 0.f, 0.f, 0.f);
+    q *= XRQuaternion(0.f, 1.f, 0.f, 0.f);
+    MV_CHECK(q.x == 0.f && q.y == 0.f && q.z == 1.f && q.w == 0.f);
+    q = XRQuaternion(0.f, 1.f, 0.f, 0.f);
+    q *= XRQuaternion(1.f, 0.f, 0.f, 0.f);
+    MV_CHECK(q.x == 0.f && q.y == 0.f && q.z == -1.f && q.w == 0.f);
+}
+
+static void testDeterminant() {
+    std::mt19937 rng(20200103);
+    double error = 0;
+    for (size_t i = 0; i < RandomCount; ++i) {
+        const XRMatrix4x4 m = randomMatrix(rng);
+        const double expected = referenceDeterminant(m);
+        error = std::max(error, std::abs((Determinant(m) - expected) /
+                                         expected));
+    }
+    MV_CHECK(error <= MaxDeterminantError);
+
+    MV_CHECK(Determinant(XRMatrix4x4::identity) == 1.f);
+    MV_CHECK(Determinant(XRMatrix4x4(2, 0, 0, 0,  //
+                                     0, 3, 0, 0,  //
+                                     0, 0, 4, 0,  //
+                                     0, 0, 0, 5)) == 120.f);
+    // Two rows swapped
+    MV_CHECK(Determinant(XRMatrix4x4(0, 1, 0, 0,  //
+                                     1, 0, 0, 0,  //
+                                     0, 0, 1, 0,  //
+                                     0, 0, 0, 1)) == -1.f);
+    // Two rows the same
+    MV_CHECK(Determinant(XRMatrix4x4(1, 2, 3, 4,  //
+                                     5, 6, 7, 8,  //
+                                     1, 2, 3, 4,  //
+                                     0, 0, 0, 1)) == 0.f);
+}
+
+/**
+ * @brief QuaternionToMatrix and MatrixToQuaternion undo each other, up to
+ * the sign of the quaternion.
+ */
+static void testQuaternionMatrixRoundTrip() {
+    std::mt19937 rng(20200104);
+    std::uniform_real_distribution<float> unit(-1.f, 1.f);
+    float error = 0;
+    for (size_t i = 0; i < RandomCount; ++i) {
+        const XRQuaternion q = Normalize(
+            XRQuaternion(unit(rng), unit(rng), unit(rng), unit(rng)));
+        XRMatrix4x4 m;
+        QuaternionToMatrix(q, m);
+        XRQuaternion back;
+        MatrixToQuaternion(m, back);
+        error = std::max(error, 1.f - std::abs(XRQuaternion::Dot(q, back)));
+    }
+    MV_CHECK(error <= 1e-6f);
+}
+
+int main() {
+    testMatrixMultiply();
+    testQuaternionMultiply();
+    testDeterminant();
+    testQuaternionMatrixRoundTrip();
+    return metaview::test::finish("XRMathTest");
+}